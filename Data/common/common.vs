@@ -1,4 +1,6 @@
-uniform vec4 ProjectionScale;
+#ifndef TINY2D_FRAME_CONSTANT_ProjectionScale
+uniform vec4 ProjectionScale; // Injected by the engine for techniques declaring frameConstants="ProjectionScale"
+#endif
 
 vec4 GetPosition()
 {
@@ -52,6 +52,33 @@ void tex_vcol_vs()
 
 #version 130
 
+// Batched sprites: up to MAX_BATCHED_SPRITES quads per draw; quad vertex position is its corner in [0..1] range and instance index comes from the second texture coordinate
+
+#define MAX_BATCHED_SPRITES 32
+
+out vec2 TEXCOORD0;
+out vec4 COLOR0;
+
+uniform vec4 SpriteSize;
+uniform vec4 SpriteTransforms[MAX_BATCHED_SPRITES];	// center x, center y, scale * cos(rotation), scale * sin(rotation)
+uniform vec4 SpriteColors[MAX_BATCHED_SPRITES];
+
+void tex_batch_vs()
+{
+	int index = int(gl_MultiTexCoord1.x);
+	vec4 transform = SpriteTransforms[index];
+	vec2 offset = (gl_Vertex.xy - vec2(0.5, 0.5)) * SpriteSize.xy;
+	vec2 position = transform.xy + vec2(offset.x * transform.z - offset.y * transform.w, offset.y * transform.z + offset.x * transform.w);
+
+	gl_Position = vec4(position.x * ProjectionScale.x + ProjectionScale.z, position.y * ProjectionScale.y + ProjectionScale.w, 0.0, 1.0);
+	TEXCOORD0 = gl_MultiTexCoord0.xy;
+	COLOR0 = SpriteColors[index];
+}
+
+###splitter###
+
+#version 130
+
 in vec2 TEXCOORD0;
 
 uniform sampler2D ColorMap;
@@ -60,6 +87,13 @@ uniform vec4 Color;
 void tex_col_fs()
 {
 	gl_FragColor = texture2D(ColorMap, TEXCOORD0) * Color;
+#ifdef ALPHA_TEST
+	if (gl_FragColor.a < 0.5)
+		discard;
+#endif
+#ifdef PREMULTIPLIED_ALPHA
+	gl_FragColor.rgb *= gl_FragColor.a;
+#endif
 }
 
 ###splitter###
@@ -74,6 +108,13 @@ uniform sampler2D ColorMap;
 void tex_vcol_fs()
 {
 	gl_FragColor = texture2D(ColorMap, TEXCOORD0) * COLOR0;
+#ifdef ALPHA_TEST
+	if (gl_FragColor.a < 0.5)
+		discard;
+#endif
+#ifdef PREMULTIPLIED_ALPHA
+	gl_FragColor.rgb *= gl_FragColor.a;
+#endif
 }
 
 ###splitter###
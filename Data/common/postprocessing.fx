@@ -3,8 +3,6 @@
 out vec4 TEXCOORD0;
 out vec4 TEXCOORD1;
 
-uniform vec4 ScreenSize;
-
 void downsample2x2_vs()
 {
 	gl_Position = gl_Vertex;
@@ -112,7 +110,6 @@ void horizontal_blur_fs()
 
 #version 130
 
-uniform vec4 ScreenSize;
 uniform float Time;
 
 uniform float OverExposureAmount;
@@ -2,7 +2,6 @@
 
 uniform sampler2D ColorMap;
 uniform float BlurKernel;
-uniform vec4 ScreenSize;
 
 in vec2 TEXCOORD0;
 
@@ -27,7 +27,30 @@
 //! Tiny2D game library namespace
 namespace Tiny2D
 {
-	//! File handle
+	//! Read-only view of the whole file contents; memory mapped or pointing into mounted pack file where possible (see File::Map)
+	class FileView
+	{
+	public:
+		//! Constructs empty file view
+		FileView();
+		//! Destructs file view
+		~FileView();
+		//! Unmaps the view
+		void		Unmap();
+		//! Gets whether the view is mapped
+		bool		IsValid() const;
+		//! Gets file contents; valid until the view gets unmapped
+		const void*	GetData() const;
+		//! Gets file size
+		size_t		GetSize() const;
+	private:
+		FileView(const FileView&);
+		void operator = (const FileView&);
+		FileViewObj* view;
+		friend class File;
+	};
+
+	//! File handle; reads and writes go through internal buffer (see App::StartupParams::fileBufferSize)
 	class File
 	{
 	public:
@@ -40,24 +63,50 @@ namespace Tiny2D
 			OpenMode_COUNT
 		};
 
+		//! Destination buffer of a vectored read (see ReadAt)
+		struct Buffer
+		{
+			void* dst;		//!< Destination memory
+			size_t size;	//!< Number of bytes to read into destination memory
+		};
+
+		//! Asynchronous read function; invoked on job thread with null terminated data (NULL on failure); data is freed after the call unless the function takes over its ownership (by setting it to NULL and later calling free())
+		typedef void (*ReadFunc)(void*& data, size_t size, void* userData);
+		//! Asynchronous read completion function; invoked on main thread after ReadFunc (see Jobs::DoneFunc)
+		typedef void (*ReadDoneFunc)(bool canceled, void* userData);
+
 		//! Constructs empty file handle
 		File();
 		//! Destructs file handle
 		~File();
 		//! Opens file at given path in given mode
 		bool	Open(const std::string& path, OpenMode openMode);
-		//! Closes file
+		//! Closes file (flushing buffered writes)
 		void	Close();
 		//! Gets opened file size (only valid after file has been successfully opened)
-		int		GetSize();
+		long long GetSize();
 		//! Seeks to given offset within a file (relative to file beginning)
-		void	Seek(int offset);
+		void	Seek(long long offset);
 		//! Gets current file offset
-		int		GetOffset();
-		//! Reads 'size' number of bytes from file into 'dst' buffer; returns true on success
-		bool	Read(void* dst, int size);
+		long long GetOffset();
+		//! Sets the size of the internal read / write buffer in bytes (0 disables buffering)
+		void	SetBufferSize(size_t size);
+		//! Reads up to 'size' number of bytes from file into 'dst' buffer; returns number of bytes actually read (less than 'size' only at the end of file or on error)
+		size_t	Read(void* dst, size_t size);
+		//! Reads up to 'size' number of bytes at given offset without moving current file offset; safe to call from multiple threads at once; returns number of bytes actually read
+		size_t	ReadAt(long long offset, void* dst, size_t size);
+		//! Reads consecutive file data starting at given offset into multiple buffers without moving current file offset; safe to call from multiple threads at once; returns total number of bytes read
+		size_t	ReadAt(long long offset, const Buffer* buffers, int numBuffers);
 		//! Writes 'size' number of bytes from 'src' buffer to file; returns true on success
-		bool	Write(const void* src, int size);
+		bool	Write(const void* src, size_t size);
+		//! Writes out buffered data; returns true on success
+		bool	Flush();
+		//! Asynchronously reads up to 'size' number of bytes (0 means until the end of file) at given offset; file must stay open until the read is done; returns job id to be used with Jobs::WaitForJob or Jobs::CancelJob
+		int		ReadAsync(long long offset, size_t size, ReadFunc readFunc, ReadDoneFunc doneFunc, void* userData);
+		//! Maps whole file at given path for reading without copying it into a separate buffer; returns true on success
+		static bool Map(const std::string& path, FileView& view);
+		//! Asynchronously reads up to 'size' number of bytes (0 means until the end of file) at given offset of file at given path; returns job id to be used with Jobs::WaitForJob or Jobs::CancelJob
+		static int ReadAsync(const std::string& path, long long offset, size_t size, ReadFunc readFunc, ReadDoneFunc doneFunc, void* userData);
 	private:
 		File(const File&);
 		void operator = (const File&);
@@ -292,11 +341,23 @@ namespace Tiny2D
 			WrapMode_COUNT
 		};
 
+		//! Mip-map filtering modes
+		enum MipFilter
+		{
+			MipFilter_None = 0,		//!< Mip-maps aren't used
+			MipFilter_Nearest,		//!< Samples nearest mip-map level
+			MipFilter_Linear,		//!< Linearly interpolates between 2 nearest mip-map levels
+
+			MipFilter_COUNT
+		};
+
 		static Sampler Default;				//!< Default sampler (for use with 2D sprite style graphics)
 		static Sampler DefaultPostprocess;	//!< Default sampler for use with postprocessing (both min and mag linear filtering disabled)
 
 		bool minFilterLinear;	//!< Indicates whether minimization filter shall be linear (nearest otherwise); defaults to true
 		bool magFilterLinear;	//!< Indicates whether maximization filter shall be linear (nearest otherwise); defaults to true
+		MipFilter mipFilter;	//!< Mip-map filter; mip-maps are generated on first use (render targets never use mip-maps); defaults to MipFilter_None
+		float maxAnisotropy;	//!< Max. anisotropy; values above 1 enable anisotropic filtering where supported (clamped to max. supported value); defaults to 1.0f
 		WrapMode uWrapMode;		//!< U wrapping mode; defaults to WrapMode_Clamp
 		WrapMode vWrapMode;		//!< V wrapping mode; defaults to WrapMode_Clamp
 		Color borderColor;		//!< Border color; defaults to Color::White; unused on mobile platforms (OpenGL ES does not support WrapMode_ClampToBorder)
@@ -305,6 +366,8 @@ namespace Tiny2D
 		Sampler();
 		//! Sets minimization and magnification filtering to linear (true) or nearest (false)
 		inline void SetFiltering(bool minLinear, bool magLinear) { minFilterLinear = minLinear; magFilterLinear = magLinear; }
+		//! Sets mip-map filtering mode and max. anisotropy
+		inline void SetMipFiltering(MipFilter mipFilter, float maxAnisotropy = 1.0f) { this->mipFilter = mipFilter; this->maxAnisotropy = maxAnisotropy; }
 		//! Sets wrap mode for U and V texture coordinates; also sets optional borderColor
 		inline void SetWrapMode(WrapMode u, WrapMode v, const Color& borderColor = Color::White) { uWrapMode = u; vWrapMode = v; this->borderColor = borderColor; }
 	};
@@ -350,6 +413,21 @@ namespace Tiny2D
 		void Draw(const Shape::DrawParams* params, const Sampler& sampler = Sampler::Default);
 		//! Draws texture
 		void Draw(const Vec2& position = Vec2(0.0f, 0.0f), float rotation = 0.0f, float scale = 1.0f, const Color& color = Color::White);
+
+		//! Single texture instance to be drawn via DrawBatch()
+		struct BatchInstance
+		{
+			Vec2 position;		//!< Left top coordinate; defaults to (0.0f, 0.0f)
+			float rotation;		//!< Rotation; defaults to 0.0f
+			float scale;		//!< Scale; defaults to 1.0f
+			Color color;		//!< Color; defaults to Color::White
+
+			//! Constructs default batch instance
+			BatchInstance();
+		};
+
+		//! Draws multiple instances of the texture (each one same as Draw(position, rotation, scale, color)) using as few draw calls as possible; instance transforms and colors are passed via uniform arrays, so it works without hardware instancing
+		void DrawBatch(const BatchInstance* instances, int numInstances);
 		//! Draws result of blending between 2 textures (useful when rendering animated objects)
 		static void DrawBlended(Texture& texture0, Texture& texture1, const Shape::DrawParams* params, float scale);
 		//! Gets texture width (note: applies fake scaling if the texture was loaded as part of non-default texture version set - see App::DisplayParameters::textureVersionSizeMultiplier)
@@ -390,34 +468,60 @@ namespace Tiny2D
 		bool operator == (const Material& other) const;
 		//! Inequality operator
 		bool operator != (const Material& other) const;
-		//! Creates material from a material file; expects name.material.xml file to be present; 'immediate' set to true indicates to load it synchronously
+		//! Creates material from a material file; expects name.material.xml file to be present; 'immediate' set to true indicates to load it synchronously, otherwise drawing is skipped until GetState() returns ResourceState_Created
 		bool Create(const std::string& name, bool immediate = true);
 		//! Destroys material
 		void Destroy();
 		//! Gets index of the technique within material or -1 if not found
 		int GetTechniqueIndex(const std::string& name);
+		//! Gets index of the technique within material or -1 if not found
+		int GetTechniqueIndex(StringId name);
 		//! Sets current technique by index
 		void SetTechnique(int index);
 		//! Sets current technique by name
 		void SetTechnique(const std::string& name);
+		//! Sets current technique by name
+		void SetTechnique(StringId name);
+		//! Gets bit mask of given space separated shader keywords (declared via 'keywords' attribute of material techniques); returns 0 until material gets created
+		unsigned int GetKeywordMask(const std::string& keywords);
+		//! Sets shader keywords (obtained via GetKeywordMask()) to be #defined for subsequent draws; shader program variant for each used combination is compiled on first use and base variant is used until then
+		void SetKeywordMask(unsigned int mask);
+		//! Sets space separated shader keywords to be #defined for subsequent draws; prefer SetKeywordMask() for frequent changes
+		void SetKeywords(const std::string& keywords);
 		//! Gets material parameter index or -1 if not found
 		int GetParameterIndex(const std::string& name);
+		//! Gets material parameter index or -1 if not found
+		int GetParameterIndex(StringId name);
 		//! Sets integer parameter by index
 		void SetIntParameter(int index, const int* value, int count = 1);
 		//! Sets integer parameter by name
 		void SetIntParameter(const std::string& name, const int* value, int count = 1);
+		//! Sets integer parameter by name
+		void SetIntParameter(StringId name, const int* value, int count = 1);
 		//! Sets float parameter by index
 		void SetFloatParameter(int index, const float* value, int count = 1);
 		//! Sets float parameter by name
 		void SetFloatParameter(const std::string& name, const float* value, int count = 1);
+		//! Sets float parameter by name
+		void SetFloatParameter(StringId name, const float* value, int count = 1);
 		//! Sets single float parameter by index
 		void SetFloatParameter(int index, float value);
 		//! Sets single float parameter by value
 		void SetFloatParameter(const std::string& name, float value);
+		//! Sets single float parameter by value
+		void SetFloatParameter(StringId name, float value);
+		//! Sets float array parameter by index; 'count' is number of floats per array element and 'numElements' is the number of leading array elements to set (all of them get uploaded in one call when drawing)
+		void SetFloatArrayParameter(int index, const float* value, int count, int numElements);
+		//! Sets float array parameter by name; 'count' is number of floats per array element and 'numElements' is the number of leading array elements to set (all of them get uploaded in one call when drawing)
+		void SetFloatArrayParameter(const std::string& name, const float* value, int count, int numElements);
+		//! Sets float array parameter by name; 'count' is number of floats per array element and 'numElements' is the number of leading array elements to set
+		void SetFloatArrayParameter(StringId name, const float* value, int count, int numElements);
 		//! Sets texture parameter by index
 		void SetTextureParameter(int index, Texture& value, const Sampler& sampler = Sampler::Default);
 		//! Sets texture parameter by name
 		void SetTextureParameter(const std::string& name, Texture& value, const Sampler& sampler = Sampler::Default);
+		//! Sets texture parameter by name
+		void SetTextureParameter(StringId name, Texture& value, const Sampler& sampler = Sampler::Default);
 		//! Draws shape described using given parameters using current technique with currently set parameters
 		void Draw(const Shape::DrawParams* params);
 		//! Draws fullscreen quad using current technique with currently set parameters
@@ -484,6 +588,8 @@ namespace Tiny2D
 		void Update(float deltaTime);
 		//! Plays an animation of given name
 		void PlayAnimation(const std::string& name = std::string() /* Default animation */, AnimationMode mode = AnimationMode_Loop, float transitionTime = 0.0f);
+		//! Plays animation identified by interned name (empty for default animation)
+		void PlayAnimation(StringId name, AnimationMode mode = AnimationMode_Loop, float transitionTime = 0.0f);
 		//! Draws the sprite
 		void Draw(const DrawParams* params);
 		//! Draws the sprite
@@ -566,14 +672,16 @@ namespace Tiny2D
 		ResourceState GetState() const;
 		//! Copy operator; internally only increases reference count of the font resource
 		void operator = (const Font& other);
-		//! Creates font from TTF file; 'size' indicates font size in pixels @see enum Flags; 'immediate' set to true indicates to load it synchronously
+		//! Creates font from TTF file; 'size' indicates font size in pixels @see enum Flags; 'immediate' set to true indicates to load it synchronously; prebaked <path>_<size>_<flags>.font/.png files (see Tools/FontBaker) are used instead of TTF when present
 		bool Create(const std::string& path, int size, unsigned int flags = 0, bool immediate = true);
 		//! Destroys the font
 		void Destroy();
-		//! Caches glyphs from given text, so that consecutive calls to Draw() are faster
+		//! Requests glyphs from given text to be cached (rasterized in the background), so that consecutive calls to Draw() don't miss them
 		void CacheGlyphs(const std::string& text);
-		//! Caches glyphs from given text file, so that consecutive calls to Draw() are faster
+		//! Requests glyphs from given text file to be cached (rasterized in the background), so that consecutive calls to Draw() don't miss them
 		void CacheGlyphsFromFile(const std::string& path);
+		//! Requests glyphs for given characters (UTF-32 code points) to be cached (rasterized in the background), so that consecutive calls to Draw() don't miss them
+		void CacheGlyphs(const std::vector<unsigned int>& codePoints);
 		//! Draws text
 		void Draw(const Text::DrawParams* params);
 		//! Draws text
@@ -648,6 +756,63 @@ namespace Tiny2D
 		EffectObj* obj;
 	};
 
+	//! Group of resources loaded asynchronously together (e.g. all resources of a level); sprite and effect files get parsed on job threads and all of their dependencies get loaded in parallel; resources already present (e.g. loaded by another group) are shared
+	class LoadGroup
+	{
+	public:
+		//! Loading progress
+		struct Progress
+		{
+			int numItems;			//!< Number of resources in the group including dependencies discovered so far
+			int numItemsDone;		//!< Number of resources done loading (successfully or not)
+			int numItemsFailed;		//!< Number of resources that failed to load
+			long long numBytes;		//!< Total size of files being read so far
+			long long numBytesDone;	//!< Number of bytes read so far
+		};
+
+		//! Completion callback; invoked on main thread once all resources in the group are done loading (again if more resources get added afterwards)
+		typedef void (*DoneCallback)(LoadGroup* group, bool success, void* userData);
+
+		//! Constructs an empty load group
+		LoadGroup();
+		//! Destroys the load group; see Clear()
+		~LoadGroup();
+		//! Starts loading texture
+		void	AddTexture(const std::string& name);
+		//! Starts loading material
+		void	AddMaterial(const std::string& name);
+		//! Starts loading sprite and its material and textures
+		void	AddSprite(const std::string& name);
+		//! Starts loading sound
+		void	AddSound(const std::string& path, bool isMusic = false);
+		//! Starts loading font
+		void	AddFont(const std::string& path, int size, unsigned int flags = 0);
+		//! Starts loading particle effect and its materials and textures
+		void	AddEffect(const std::string& path);
+		//! Sets completion callback
+		void	SetDoneCallback(DoneCallback callback, void* userData);
+		//! Gets whether all resources in the group are done loading (successfully or not; see HasFailed)
+		bool	IsReady();
+		//! Gets whether any of the resources failed to load
+		bool	HasFailed();
+		//! Gets loading progress
+		void	GetProgress(Progress& progress);
+		//! Releases group's references to all resources (resources loaded meanwhile via regular Create() calls stay alive); cancels loading of resource files not yet parsed
+		void	Clear();
+		//! Starts loading all resources listed in a manifest file (see StartRecordingManifest) in recorded order; while the group exists, resources requested elsewhere that aren't listed in any of its manifests get reported as missing; returns false if manifest couldn't be loaded
+		bool	AddManifest(const std::string& path);
+		//! Gets resources requested outside of load groups that weren't listed in any of this group's manifests; each formatted as "type:name"
+		void	GetMissingResources(std::vector<std::string>& resources);
+		//! Starts recording all resources requested from now on (e.g. right before a scene transition)
+		static void StartRecordingManifest();
+		//! Stops recording and saves recorded resources, in order of first request, to manifest file at given path (e.g. "scenes/level1.manifest.xml"); returns true on success
+		static bool StopRecordingManifest(const std::string& path);
+	private:
+		LoadGroup(const LoadGroup&);
+		void operator = (const LoadGroup&);
+		LoadGroupObj* obj;
+	};
+
 	//! Application/base functionality
 	class App
 	{
@@ -681,7 +846,9 @@ namespace Tiny2D
 		{
 			std::string name;				//!< Application name
 			std::vector<std::string> rootDataDirs;		//!< Root data directories listed in order from the highest to lowest priority
+			std::vector<std::string> packFiles;			//!< Pack files (built with Tools/PackBuilder) listed in order from the highest to lowest priority; looked up in root data directories and searched after loose files; defaults to empty
 			std::string languageSymbol;		//!< Language symbol (used for text localization); defaults to "EN"
+			std::vector<std::string> localizationSets;	//!< Text localization sets loaded at app startup in parallel with other initialization (see Localization::LoadSet); defaults to empty
 			std::string defaultMaterialName;//!< Name of the default material to be loaded at app startup; defaults to "common/default"
 			std::string defaultFontName;	//!< Name of the default font to be loaded at app startup; defaults to "common/courbd.ttf"
 			int defaultFontSize;			//!< Default font size; defaults to 16
@@ -691,6 +858,14 @@ namespace Tiny2D
 			bool exitOnError;				//!< Exit app on error?; defaults to false in release and true in debug
 			bool emulateTouchpadWithMouse;	//!< Emulate touchpad with mouse? Only used on desktop platforms; defaults to true on desktop platforms
 			bool supportAsynchronousResourceLoading; //!< Support asynchronous resource loading?; defaults to true
+			bool looseFilesOverridePacks;	//!< Look for loose files in root data directories before searching packs? Disable to avoid per file directory probing when shipping packs only; defaults to true
+			int fileBufferSize;				//!< Size in bytes of the internal read / write buffer of each File (0 disables buffering); defaults to 64 KB
+			int glyphCachePageSize;			//!< Width and height of a single glyph cache texture page (shared by all TTF fonts); defaults to 512
+			int glyphCacheMaxMemory;		//!< Max. memory in bytes used by glyph cache texture pages; defaults to 16 MB
+			int glyphCacheMinUnusedFrames;	//!< Min. number of frames a glyph must not be drawn before it can be evicted from glyph cache; defaults to 60
+			bool enableShaderCache;			//!< Store linked shader program binaries on disk to speed up consecutive app startups?; defaults to true
+			std::string shaderCacheDir;		//!< Directory to store shader program binaries in; empty indicates internal storage on Android and per-user preferences directory (see SDL_GetPrefPath) elsewhere; defaults to empty
+			bool enableHotReload;			//!< Watch root data directories for modified files and reload affected resources in place? Only supported on desktop platforms; defaults to true in debug desktop builds
 
 			//! Constructs default startup parameters
 			StartupParams();
@@ -806,7 +981,7 @@ namespace Tiny2D
 			Param(const std::string& name, const std::string& value);
 		};
 
-		//! Loads text localization set (loads file named 'name'.translations.xml)
+		//! Loads text localization set (loads file named 'name'.translations.xml); glyphs used by the set get precached in the background for all registered fonts
 		static bool					LoadSet(const std::string& name);
 		//! Unloads specific text localization set
 		static void					UnloadSet(const std::string& name);
@@ -814,6 +989,14 @@ namespace Tiny2D
 		static void					UnloadAllSets();
 		//! Localizes given string (with optional parameters)
 		static const std::string	Get(const char* stringName, const Param* params = NULL, int numParams = 0);
+		//! Localizes string identified by interned name (with optional parameters)
+		static const std::string	Get(StringId stringName, const Param* params = NULL, int numParams = 0);
+		//! Gets sorted distinct characters (UTF-32 code points) used by loaded text localization set
+		static const std::vector<unsigned int>& GetSetCodePoints(const std::string& name);
+		//! Registers font to have glyphs used by all loaded (now and later) text localization sets precached in the background
+		static void					RegisterFont(Font& font);
+		//! Unregisters font previously registered via RegisterFont()
+		static void					UnregisterFont(Font& font);
 	};
 
 	//! Defines application callback class
@@ -854,6 +1037,8 @@ namespace Tiny2D
 		static void		CancelJob(JobID id);
 		//! Waits for all jobs to complete
 		static void		WaitForAllJobs();
+		//! Gets number of threads performing jobs in parallel
+		static int		GetNumWorkerThreads();
 	};
 
 	//! Time related functionality
@@ -45,6 +45,42 @@ namespace Tiny2D
 	//! String formatting helper function
 	std::string string_format(const char* format, ...);
 
+	//! Interned string identifier; all equal strings share the same id so comparisons, copying and map lookups are O(1); interning is thread-safe
+	struct StringId
+	{
+		//! Constructs empty string id
+		inline StringId() : id(0) {}
+		//! Constructs string id from string (interns the string if it wasn't interned before)
+		explicit StringId(const char* str);
+		//! Constructs string id from string (interns the string if it wasn't interned before)
+		explicit StringId(const std::string& str);
+		//! Gets string id of already interned string without interning it; returns empty string id if string wasn't interned before
+		static StringId Find(const char* str);
+		//! Gets string id of already interned string without interning it; returns empty string id if string wasn't interned before
+		static StringId Find(const std::string& str);
+
+		//! Gets unique id of the interned string; 0 for empty string
+		inline unsigned int GetId() const { return id; }
+		//! Gets precomputed hash of the interned string
+		unsigned int GetHash() const;
+		//! Gets interned string
+		const std::string& GetString() const;
+		//! Gets interned string as C string
+		inline const char* c_str() const { return GetString().c_str(); }
+		//! Gets whether string is empty
+		inline bool IsEmpty() const { return id == 0; }
+
+		//! Compares string ids for equality
+		inline bool operator == (const StringId& other) const { return id == other.id; }
+		//! Compares string ids for inequality
+		inline bool operator != (const StringId& other) const { return id != other.id; }
+		//! Orders string ids by their ids (not alphabetically); for use as a key of sorted containers
+		inline bool operator < (const StringId& other) const { return id < other.id; }
+
+	private:
+		unsigned int id;
+	};
+
 	// Forward declarations of internal object types
 	struct TextureObj;
 	struct EffectObj;
@@ -53,7 +89,9 @@ namespace Tiny2D
 	struct MaterialObj;
 	struct SpriteObj;
 	struct FileObj;
+	struct FileViewObj;
 	struct XMLDocObj;
+	struct LoadGroupObj;
 
 	//! Color with RGBA components
 	struct Color
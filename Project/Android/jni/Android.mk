@@ -26,6 +26,9 @@ LOCAL_SRC_FILES := $(SDL_PATH)/fullsrc/SDL2/src/main/android/SDL_android_main.c
 	$(LIB_PATH)/Src/Tiny2D_CPPWrappers.cpp \
 	$(LIB_PATH)/Src/Tiny2D_Shape.cpp \
 	$(LIB_PATH)/Src/Tiny2D_Localization.cpp \
+	$(LIB_PATH)/Src/Tiny2D_LZ4.cpp \
+	$(LIB_PATH)/Src/Tiny2D_LoadGroup.cpp \
+	$(LIB_PATH)/Src/Tiny2D_HotReload.cpp \
 	$(LIB_PATH)/Src/SDL/Tiny2D_SDL.cpp \
 	$(LIB_PATH)/Src/OpenGL/Tiny2D_OpenGL.cpp \
 	$(LIB_PATH)/Src/OpenGL/Tiny2D_OpenGLES.cpp \
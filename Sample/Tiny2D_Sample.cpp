@@ -19,6 +19,10 @@ public:
 			outParams.textureVersionSizeMultiplier = 0.5f;
 			outParams.textureVersion = "@2x";
 		}
+
+		// Load texts in parallel with engine initialization
+
+		outParams.localizationSets.push_back("texts");
 		return true;
 	}
 
@@ -58,8 +62,6 @@ public:
 		step.Create("step.wav", false, false);
 		stepTimer = 1.0f;
 
-		Localization::LoadSet("texts");
-
 		// Create render target
 
 		renderTexture.CreateRenderTarget(256, 256);
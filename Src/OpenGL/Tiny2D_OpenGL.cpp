@@ -8,6 +8,16 @@ extern GLuint g_fbo;
 float g_screenSizeMaterialParam[4];
 float g_projectionScaleMaterialParam[4];
 
+// Names of default material techniques and parameters used when drawing textures
+
+const StringId g_texColTechniqueName("tex_col");
+const StringId g_texBatchTechniqueName("tex_batch");
+const StringId g_colorMapParameterName("ColorMap");
+const StringId g_colorParameterName("Color");
+const StringId g_spriteSizeParameterName("SpriteSize");
+const StringId g_spriteTransformsParameterName("SpriteTransforms");
+const StringId g_spriteColorsParameterName("SpriteColors");
+
 ResourceState Texture_GetState(TextureObj* texture)
 {
 	return texture->state;
@@ -110,12 +120,96 @@ void Texture_Draw(TextureObj* texture, const Shape::DrawParams* params, const Sa
 {
 	MaterialObj* material = Material_Get(App::GetDefaultMaterial());
 
-	Material_SetTechnique(material, "tex_col");
-	Material_SetTextureParameter(material, "ColorMap", texture, sampler);
-	Material_SetFloatParameter(material, "Color", (const float*) &params->color, 4);
+	Material_SetTechnique(material, g_texColTechniqueName);
+	Material_SetTextureParameter(material, g_colorMapParameterName, texture, sampler);
+	Material_SetFloatParameter(material, g_colorParameterName, (const float*) &params->color, 4);
 	Material_Draw(material, params);
 }
 
+void Texture_DrawBatch(TextureObj* texture, const Texture::BatchInstance* instances, int numInstances)
+{
+	MaterialObj* material = Material_Get(App::GetDefaultMaterial());
+
+	Material_SetTechnique(material, g_texBatchTechniqueName);
+	const int transformsIndex = Material_GetParameterIndex(material, g_spriteTransformsParameterName);
+	const int colorsIndex = Material_GetParameterIndex(material, g_spriteColorsParameterName);
+	if (transformsIndex == -1 || colorsIndex == -1)
+	{
+		// Batching technique not available (or not yet loaded) - draw one by one
+
+		for (int i = 0; i < numInstances; i++)
+			Texture_Draw(texture, instances[i].position, instances[i].rotation, instances[i].scale, instances[i].color);
+		return;
+	}
+
+	// Max batch size is determined by the size of uniform arrays in the shader
+
+	const int maxBatchSize = min(material->parameters[transformsIndex].shaderParameterDescription->arraySize, material->parameters[colorsIndex].shaderParameterDescription->arraySize);
+
+	// Static geometry: quad per instance; local corner position in [0..1] range, texture coordinates and instance index
+
+	static std::vector<float> xy;
+	static std::vector<float> uv;
+	static std::vector<float> instanceIndices;
+	static std::vector<unsigned short> indices;
+	if ((int) instanceIndices.size() < maxBatchSize * 4)
+	{
+		const float corners[8] = { 0, 0, 1, 0, 1, 1, 0, 1 };
+		xy.clear();
+		uv.clear();
+		instanceIndices.clear();
+		indices.clear();
+		for (int i = 0; i < maxBatchSize; i++)
+		{
+			xy.insert(xy.end(), corners, corners + 8);
+			uv.insert(uv.end(), corners, corners + 8);
+			for (int j = 0; j < 4; j++)
+				instanceIndices.push_back((float) i);
+
+			const unsigned short quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+			for (int j = 0; j < 6; j++)
+				indices.push_back((unsigned short) (i * 4 + quadIndices[j]));
+		}
+	}
+
+	const float size[4] = { (float) texture->width, (float) texture->height, 0, 0 };
+	Material_SetTextureParameter(material, g_colorMapParameterName, texture, Sampler::Default);
+	Material_SetFloatParameter(material, g_spriteSizeParameterName, size, 4);
+
+	std::vector<float> transforms(maxBatchSize * 4);
+	std::vector<float> colors(maxBatchSize * 4);
+
+	for (int batchStart = 0; batchStart < numInstances; batchStart += maxBatchSize)
+	{
+		const int batchSize = min(maxBatchSize, numInstances - batchStart);
+
+		// Each instance is described by (center x, center y, scaled cos, scaled sin) and color
+
+		for (int i = 0; i < batchSize; i++)
+		{
+			const Texture::BatchInstance& instance = instances[batchStart + i];
+			float* transform = &transforms[i * 4];
+			transform[0] = instance.position.x + size[0] * 0.5f;
+			transform[1] = instance.position.y + size[1] * 0.5f;
+			transform[2] = cosf(instance.rotation) * instance.scale;
+			transform[3] = sinf(instance.rotation) * instance.scale;
+			memcpy(&colors[i * 4], &instance.color, sizeof(float) * 4);
+		}
+
+		Material_SetFloatArrayParameter(material, transformsIndex, &transforms[0], 4, batchSize);
+		Material_SetFloatArrayParameter(material, colorsIndex, &colors[0], 4, batchSize);
+
+		Shape::DrawParams params;
+		params.SetGeometryType(Shape::Geometry::Type_Triangles);
+		params.SetNumVerts(batchSize * 4);
+		params.SetIndices(batchSize * 6, &indices[0]);
+		params.SetPosition(&xy[0]);
+		params.SetTexCoord(&uv[0]);
+		params.SetTexCoord(&instanceIndices[0], 1, sizeof(float), Shape::VertexFormat_Float32, 1);
+		Material_Draw(material, &params);
+	}
+}
+
 int Texture_GetWidth(TextureObj* texture)
 {
 	if (texture->sizeScale != 1.0f)
@@ -156,7 +250,7 @@ TextureObj* Texture_CreateRenderTarget(int width, int height)
 	texture->format = format;
 	texture->internalFormat = internalFormat;
 	texture->hasAlpha = true;
-	texture->refCount = 1;
+	SDL_AtomicSet(&texture->refCount, 1);
 	texture->isRenderTarget = true;
 
 	GL(glGenTextures(1, &texture->handle));
@@ -228,6 +322,8 @@ void Texture_BeginDrawing(TextureObj* texture, const Color* clearColor)
 	g_projectionScaleMaterialParam[2] = -1.0f;
 	g_projectionScaleMaterialParam[3] = isMainRenderTarget ? 1.0f : -1.0f;
 
+	FrameConstants_Update();
+
 	// Bind fbo
 
 	if (App::GetMainRenderTarget() == texture)
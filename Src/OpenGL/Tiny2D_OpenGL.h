@@ -23,6 +23,14 @@
 	};
 	#include "SDL_opengles2.h"
 
+	// GL_OES_get_program_binary (loaded at startup; NULL if unsupported)
+	extern PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOESProc;
+	extern PFNGLPROGRAMBINARYOESPROC glProgramBinaryOESProc;
+	#define glGetProgramBinary glGetProgramBinaryOESProc
+	#define glProgramBinary glProgramBinaryOESProc
+	#define GL_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+	#define GL_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS_OES
+
 	#define glActiveTextureARB glActiveTexture
 	#define glGenFramebuffersEXT glGenFramebuffers
 	#define glDeleteFramebuffersEXT glDeleteFramebuffers
@@ -69,6 +77,7 @@
 	#define GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT_EXT GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT
 	#define GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS_EXT GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS
 	#define GL_FRAMEBUFFER_INCOMPLETE_FORMATS_EXT GL_FRAMEBUFFER_INCOMPLETE_FORMATS
+	#define glGenerateMipmapEXT glGenerateMipmap
 #else
 	#include "SDL_opengl.h"
 	#if defined(WIN32) && defined(_MSC_VER)
@@ -82,6 +91,24 @@
 	#undef GL_PROC
 #endif
 
+// GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile (loaded at startup; NULL if unsupported)
+#ifndef GL_COMPLETION_STATUS_KHR
+	#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+	#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+#ifdef OPENGL_ES
+	typedef void (GL_APIENTRYP PFNTINY2DMAXSHADERCOMPILERTHREADSPROC) (GLuint count);
+#else
+	typedef void (APIENTRYP PFNTINY2DMAXSHADERCOMPILERTHREADSPROC) (GLuint count);
+#endif
+extern PFNTINY2DMAXSHADERCOMPILERTHREADSPROC glMaxShaderCompilerThreadsProc;
+
+// GL_EXT_texture_filter_anisotropic
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+	#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+	#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+
 #ifndef OPENGL_ES
 	#define glEnableTexture2D() GL(glEnable(GL_TEXTURE_2D));
 	#define glDisableTexture2D() GL(glDisable(GL_TEXTURE_2D));
@@ -110,6 +137,30 @@ namespace Tiny2D
 	#define GLR(call) call
 #endif
 
+	// Sampler state as applied to OpenGL; kept by each texture (last applied texture parameters) and used as a key for cached sampler objects
+
+	struct SamplerState
+	{
+		GLint minFilter;
+		GLint magFilter;
+		GLint wrapS;
+		GLint wrapT;
+		float maxAnisotropy;
+		Color borderColor;
+
+		inline bool operator == (const SamplerState& other) const
+		{
+			return minFilter == other.minFilter && magFilter == other.magFilter &&
+				wrapS == other.wrapS && wrapT == other.wrapT &&
+				maxAnisotropy == other.maxAnisotropy &&
+				borderColor.r == other.borderColor.r && borderColor.g == other.borderColor.g && borderColor.b == other.borderColor.b && borderColor.a == other.borderColor.a;
+		}
+		inline bool operator != (const SamplerState& other) const { return !(*this == other); }
+	};
+
+	void Samplers_Init();
+	void Samplers_Deinit();
+
 	struct TextureObj : Resource
 	{
 		GLuint handle;
@@ -121,6 +172,10 @@ namespace Tiny2D
 		bool isRenderTarget;
 		bool isLoaded;
 		float sizeScale;
+		bool hasMipmaps;
+
+		bool isSamplerStateValid;	// Indicates whether samplerState matches texture parameters currently set on the texture
+		SamplerState samplerState;
 
 		TextureObj() :
 			Resource("texture"),
@@ -131,7 +186,9 @@ namespace Tiny2D
 			height(0),
 			isRenderTarget(false),
 			isLoaded(false),
-			sizeScale(1.0f)
+			sizeScale(1.0f),
+			hasMipmaps(false),
+			isSamplerStateValid(false)
 		{}
 	};
 
@@ -148,13 +205,71 @@ namespace Tiny2D
 		Type type;
 		GLuint handle;
 
-		std::string sourceCode;
+		std::string sourceCode;	// Kept until compile status gets checked (or always in DEBUG)
 
 		Shader() : Resource("shader") {}
 	};
 
 	void Shader_Destroy(Shader* shader);
 
+	// Shader compiler; shaders and programs are submitted to the driver without waiting for compilation and linking to finish
+
+	extern bool g_supportsParallelShaderCompile;
+
+	void ShaderCompiler_Init();
+
+	// Shader source (.fx) file consists of sections separated with SHADER_SPLITTER_STRING; shader entry is looked up by name among sections
+	// Preprocessed shader file (.fx + SHADER_PREPROCESSED_SUFFIX) generated offline by Tools/ShaderCompiler starts with "SHADER_SOURCE_HASH_MARKER <hex hash>" line
+	// followed by ready-to-compile entries (#includes expanded, entry renamed to main), each preceded by "SHADER_ENTRY_MARKER <entry>" line
+
+	#define SHADER_SPLITTER_STRING "###splitter###"
+	#define SHADER_ENTRY_MARKER "###entry###"
+	#define SHADER_SOURCE_HASH_MARKER "###sourcehash###"
+	#define SHADER_PREPROCESSED_SUFFIX "c"
+
+	// Hash of the .fx file and all files it (recursively) #includes; used to detect preprocessed files that are out of date with respect to their sources
+
+	inline bool ShaderSource_CalcHashRec(const std::string& path, bool (*loadFunc)(const std::string& path, std::string& content), unsigned long long& hash, std::vector<std::string>& visitedPaths)
+	{
+		static const char* includePrefix = "#include \"";
+		static const size_t includePrefixLength = strlen(includePrefix);
+
+		for (size_t i = 0; i < visitedPaths.size(); i++)
+			if (visitedPaths[i] == path)
+				return true;
+		visitedPaths.push_back(path);
+
+		std::string content;
+		if (!loadFunc(path, content))
+			return false;
+		hash = hash_fnv1a64(path, hash);
+		hash = hash_fnv1a64(content, hash);
+
+		size_t includeStart = 0;
+		while ((includeStart = content.find(includePrefix, includeStart)) != std::string::npos)
+		{
+			includeStart += includePrefixLength;
+			const size_t includeEnd = content.find('\"', includeStart);
+			if (includeEnd == std::string::npos ||
+				!ShaderSource_CalcHashRec(content.substr(includeStart, includeEnd - includeStart), loadFunc, hash, visitedPaths))
+				return false;
+		}
+		return true;
+	}
+
+	inline bool ShaderSource_CalcHash(const std::string& path, bool (*loadFunc)(const std::string& path, std::string& content), unsigned long long& hashOut)
+	{
+		std::vector<std::string> visitedPaths;
+		hashOut = hash_fnv1a64(NULL, 0);
+		return ShaderSource_CalcHashRec(path, loadFunc, hashOut, visitedPaths);
+	}
+
+	// Shader source cache; keeps loaded .fx files (and their includes) in memory so that each file is only loaded and parsed once; safe to use from job threads
+
+	void ShaderSourceCache_Init(); // Doesn't require OpenGL context, so that materials can be loaded in parallel with its creation
+	void ShaderSourceCache_Deinit();
+	void ShaderSourceCache_Clear();
+
 	class ShaderPtr
 	{
 	public:
@@ -185,16 +300,18 @@ namespace Tiny2D
 			Type_COUNT
 		};
 
-		std::string name;
+		StringId name;
 		Type type;
 		GLint count;
+		GLint arraySize;	// Number of array elements; 1 if parameter is not an array
 
 		inline bool operator != (const ShaderParameterDescription& other) const
 		{
 			return
 				name != other.name ||
 				type != other.type ||
-				count != other.count;
+				count != other.count ||
+				arraySize != other.arraySize;
 		}
 	};
 
@@ -203,19 +320,70 @@ namespace Tiny2D
 		GLint location;
 	};
 
+	// Frame constants; engine provided uniforms shared by all shader programs and updated whenever render target changes
+	// Stored in a uniform buffer where supported (desktop GL), otherwise each program re-uploads them only when they changed since it was last used
+	// Techniques declare frame constants they use (via 'frameConstants' attribute) and get their declarations injected into shader source code
+	// along with "#define FRAME_CONSTANT_DEFINE_PREFIX<name>" for each of them, so shared shader code can declare them itself only when not injected
+
+	#define FRAME_CONSTANT_DEFINE_PREFIX "TINY2D_FRAME_CONSTANT_"
+
+	enum FrameConstant
+	{
+		FrameConstant_ScreenSize = 0,
+		FrameConstant_ProjectionScale,
+
+		FrameConstant_COUNT
+	};
+
+	extern unsigned int g_frameConstantsVersion; // Incremented on every frame constants update
+
+	void FrameConstants_Init();
+	void FrameConstants_Deinit();
+	void FrameConstants_Update();
+	int FrameConstant_FromName(const char* name);
+
 	struct ShaderProgram : Resource
 	{
 		GLuint handle;
 
-		Shader* vs;
-		Shader* fs;
+		Shader* vs;	// NULL if program was restored from program binary cache
+		Shader* fs;	// NULL if program was restored from program binary cache
 
 		std::vector<ShaderAttribute> attributes;
 		std::vector<ShaderParameter> parameters;
 
-		ShaderProgram() : Resource("shader program") {}
+		GLint frameConstantLocations[FrameConstant_COUNT];	// -1 if unused or stored in uniform buffer
+		unsigned int frameConstantsVersion;					// Version of frame constants last uploaded to this program
+
+		Time::Ticks compileStartTicks;
+		unsigned long long cacheKey;
+
+		ShaderProgram() :
+			Resource("shader program"),
+			handle(0),
+			vs(NULL),
+			fs(NULL),
+			frameConstantsVersion(0),
+			compileStartTicks(0),
+			cacheKey(0)
+		{
+			for (int i = 0; i < FrameConstant_COUNT; i++)
+				frameConstantLocations[i] = -1;
+		}
 	};
 
+	bool ShaderProgram_IsLinkComplete(ShaderProgram* program);
+	bool ShaderProgram_Finalize(ShaderProgram* program);
+
+	// Shader program binary cache
+
+	extern std::string g_shaderCacheDir; // Empty if shader program binary cache is disabled
+
+	void ShaderProgramCache_Init();
+	void ShaderProgramCache_LogStats();
+	bool ShaderProgramCache_LoadFile(const std::string& fileName, std::vector<unsigned char>& data);
+	bool ShaderProgramCache_SaveFile(const std::string& fileName, const std::vector<unsigned char>& data);
+
 	struct MaterialParameter
 	{
 		ShaderParameterDescription* shaderParameterDescription;
@@ -228,8 +396,12 @@ namespace Tiny2D
 		};
 		Sampler sampler;
 
+		std::vector<float> floatArrayValue;	// Values of float array parameter (arraySize * count floats)
+		int numArrayElements;				// Number of (leading) array elements set and uploaded on draw
+
 		MaterialParameter() :
-			shaderParameterDescription(NULL)
+			shaderParameterDescription(NULL),
+			numArrayElements(0)
 		{
 			textureValue = NULL;
 		}
@@ -240,38 +412,91 @@ namespace Tiny2D
 		std::vector<MaterialParameter> parameters;
 	};
 
-	struct MaterialTechnique
+	#define MATERIAL_MAX_KEYWORDS 32
+
+	// Shader program compiled with a subset of technique's keywords #defined
+	struct MaterialTechniqueVariant
 	{
-		std::string name;
+		unsigned int keywordMask;
 		ShaderProgram* shaderProgram;
 		std::vector<int> materialParameterIndices;
+		ResourceState state;
+
+		MaterialTechniqueVariant() :
+			keywordMask(0),
+			shaderProgram(NULL),
+			state(ResourceState_Uninitialized)
+		{}
+	};
+
+	struct MaterialTechnique
+	{
+		StringId name;
+		std::string vsPath;
+		std::string vsEntry;
+		std::string fsPath;
+		std::string fsEntry;
+		unsigned int keywordMask;		// Material keywords declared by this technique
+		unsigned int frameConstantMask;	// Frame constants declared by this technique; bit (1u << FrameConstant_*)
+		std::vector<MaterialTechniqueVariant> variants;	// First one is the base variant (no keywords); others get added on first use
 		Shape::Blending blending;
 
 		MaterialTechnique() :
-			shaderProgram(NULL),
+			keywordMask(0),
+			frameConstantMask(0),
 			blending(Shape::Blending_Default)
 		{}
 	};
 
+	struct MaterialObj;
+
 	struct MaterialResource : Resource, MaterialBase
 	{
 		std::vector<MaterialTechnique> techniques;
+		std::vector<std::string> keywords;	// Shader keywords declared by all techniques; keyword at index i corresponds to bit (1u << i) of keyword mask
+		bool shaderProgramsSubmitted;	// Set once (asynchronously loaded) material has submitted all of its shader programs for compilation
+		MaterialObj* firstInstance;		// List of material instances; used to re-initialize them on hot reload
+
+		MaterialResource() :
+			Resource("material"),
+			shaderProgramsSubmitted(false),
+			firstInstance(NULL)
+		{}
+	};
 
-		MaterialResource() : Resource("material") {}
+	// Parameter value set by name while the material was still being created; applied once it gets created
+	struct MaterialPendingParameter
+	{
+		StringId name;
+		ShaderParameterDescription::Type type;
+		int count;
+		MaterialParameter value;
 	};
 
 	struct MaterialObj : MaterialBase
 	{
 		MaterialTechnique* currentTechnique;
 		MaterialResource* resource;
-		int screenSizeParamIndex;
-		int projectionScaleParamIndex;
+		bool isInitialized;			// Set once material resource got created and the instance picked its technique and parameters
+
+		unsigned int keywordMask;
+		int currentVariantIndex;	// Index of current technique's variant matching keyword mask or -1 if not yet looked up
+
+		StringId pendingTechniqueName;
+		std::string pendingKeywords;
+		std::vector<MaterialPendingParameter> pendingParameters;
+
+		MaterialObj* prevInstance;	// Previous instance of the same material resource
+		MaterialObj* nextInstance;	// Next instance of the same material resource
 
 		MaterialObj() :
 			currentTechnique(NULL),
 			resource(NULL),
-			screenSizeParamIndex(-1),
-			projectionScaleParamIndex(-1)
+			isInitialized(false),
+			keywordMask(0),
+			currentVariantIndex(-1),
+			prevInstance(NULL),
+			nextInstance(NULL)
 		{}
 	};
 
@@ -189,7 +189,7 @@ void OpenGLES_ConvertFromOpenGL(std::string& code)
 	for (int i = 0; i < (int) ARRAYSIZE(attributes); i++)
 		if (strstr(code.c_str(), attributes[i]))
 		{
-			insert_after_pragmas(code, string_format("attribute vec4 %s;\r\n", attributes[i]));
+			insert_after_pragmas(code, std::string("attribute vec4 ") + attributes[i] + ";\r\n");
 			string_replace_all(code, attributes[i], attributes[i] + 3);
 		}
 	string_replace_all(code, "out ", "varying ");
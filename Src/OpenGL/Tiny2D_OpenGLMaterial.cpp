@@ -1,25 +1,197 @@
 #include "Tiny2D_OpenGL.h"
+#include "SDL_mutex.h"
 
 namespace Tiny2D
 {
 
 int g_maxTextureUnitSet = -1;
 
+// Shader source cache
+
+struct ShaderSourceFile
+{
+	bool isPreprocessed;								// Loaded from preprocessed file; sections are ready-to-compile entries
+	std::string sourceCode;								// Raw file content (without #includes expanded)
+	std::vector<std::pair<int, int> > sections;			// Offset and length of each ###splitter### separated section (or preprocessed entry)
+	std::map<std::string, int> entryToSection;			// Index of the section containing given entry
+};
+
+std::map<std::string, ShaderSourceFile*> g_shaderSourceFiles;	// NULL for files known not to exist
+std::map<std::string, std::string> g_shaderEntrySourceCode;		// Final, ready to compile source code by "path:entry"
+SDL_mutex* g_shaderSourceCacheMutex = NULL; // Guards shader source cache; shader source code gets loaded on job threads by asynchronously created materials
+
+bool ShaderSourceCache_LoadFileContent(const std::string& path, std::string& content)
+{
+	File file;
+	if (!file.Open(path, File::OpenMode_Read))
+		return false;
+	content.resize((size_t) file.GetSize());
+	return content.empty() || file.Read(&content[0], content.size()) == content.size();
+}
+
+void ShaderSourceCache_IndexPreprocessedEntries(ShaderSourceFile* file)
+{
+	static const int entryMarkerLength = strlen(SHADER_ENTRY_MARKER);
+
+	size_t markerStart = file->sourceCode.find(SHADER_ENTRY_MARKER);
+	while (markerStart != std::string::npos)
+	{
+		const size_t nameStart = markerStart + entryMarkerLength + 1;
+		size_t nameEnd = file->sourceCode.find('\n', nameStart);
+		if (nameEnd == std::string::npos)
+			nameEnd = file->sourceCode.length();
+		std::string name = file->sourceCode.substr(nameStart, nameEnd - nameStart);
+		string_replace_all(name, "\r", "");
+
+		const size_t start = min(nameEnd + 1, file->sourceCode.length());
+		markerStart = file->sourceCode.find(SHADER_ENTRY_MARKER, start);
+		const size_t end = markerStart == std::string::npos ? file->sourceCode.length() : markerStart;
+
+		file->entryToSection[name] = (int) file->sections.size();
+		file->sections.push_back(std::make_pair((int) start, (int) (end - start)));
+	}
+}
+
+ShaderSourceFile* ShaderSourceCache_GetFile(const std::string& path, bool isPreprocessed = false);
+
+bool ShaderSourceCache_GetFileContent(const std::string& path, std::string& content)
+{
+	ShaderSourceFile* file = ShaderSourceCache_GetFile(path);
+	if (!file)
+		return false;
+	content = file->sourceCode;
+	return true;
+}
+
+bool ShaderSourceCache_IsPreprocessedFileUpToDate(const std::string& path, const std::string& content)
+{
+	const std::string sourcePath = path.substr(0, path.length() - strlen(SHADER_PREPROCESSED_SUFFIX));
+
+	unsigned long long sourceHash;
+	if (!ShaderSource_CalcHash(sourcePath, ShaderSourceCache_GetFileContent, sourceHash))
+		return true; // Source files not available (e.g. not shipped), so use preprocessed file as is
+
+	static const size_t hashMarkerLength = strlen(SHADER_SOURCE_HASH_MARKER);
+
+	unsigned long long storedHash = 0;
+	if (content.compare(0, hashMarkerLength, SHADER_SOURCE_HASH_MARKER) ||
+		sscanf_s(content.c_str() + hashMarkerLength, " %llx", &storedHash) != 1 ||
+		storedHash != sourceHash)
+	{
+		Log::Warn(string_format("Ignoring preprocessed shader %s, reason: it is out of date with %s or its includes; rerun ShaderCompiler tool", path.c_str(), sourcePath.c_str()));
+		return false;
+	}
+	return true;
+}
+
+ShaderSourceFile* ShaderSourceCache_GetFile(const std::string& path, bool isPreprocessed)
+{
+	std::map<std::string, ShaderSourceFile*>::iterator it = g_shaderSourceFiles.find(path);
+	if (it != g_shaderSourceFiles.end())
+		return it->second;
+
+	// Load file content
+
+	ShaderSourceFile* file = new ShaderSourceFile();
+	file->isPreprocessed = isPreprocessed;
+	if (!ShaderSourceCache_LoadFileContent(path, file->sourceCode))
+	{
+		delete file;
+		g_shaderSourceFiles[path] = NULL;
+		return NULL;
+	}
+
+	if (isPreprocessed)
+	{
+		if (!ShaderSourceCache_IsPreprocessedFileUpToDate(path, file->sourceCode))
+		{
+			delete file;
+			g_shaderSourceFiles[path] = NULL;
+			return NULL;
+		}
+
+		ShaderSourceCache_IndexPreprocessedEntries(file);
+		g_shaderSourceFiles[path] = file;
+		return file;
+	}
+
+	// Split into sections
+
+	static const int splitterStringLength = strlen(SHADER_SPLITTER_STRING);
+
+	size_t start = 0;
+	while (true)
+	{
+		const size_t end = file->sourceCode.find(SHADER_SPLITTER_STRING, start);
+		const size_t sectionEnd = end == std::string::npos ? file->sourceCode.length() : end;
+		file->sections.push_back(std::make_pair((int) start, (int) (sectionEnd - start)));
+		if (end == std::string::npos)
+			break;
+		start = end + splitterStringLength;
+	}
+
+	g_shaderSourceFiles[path] = file;
+	return file;
+}
+
+int ShaderSourceCache_FindEntrySection(ShaderSourceFile* file, const std::string& entry)
+{
+	std::map<std::string, int>::iterator it = file->entryToSection.find(entry);
+	if (it != file->entryToSection.end())
+		return it->second;
+	if (file->isPreprocessed)
+		return -1;	// All preprocessed entries are indexed on load
+
+	for (int i = 0; i < (int) file->sections.size(); i++)
+	{
+		const std::pair<int, int>& section = file->sections[i];
+		const size_t pos = file->sourceCode.find(entry, section.first);
+		if (pos != std::string::npos && pos + entry.length() <= (size_t) (section.first + section.second))
+		{
+			file->entryToSection[entry] = i;
+			return i;
+		}
+	}
+	return -1;
+}
+
+void ShaderSourceCache_Init()
+{
+	g_shaderSourceCacheMutex = SDL_CreateMutex();
+}
+
+void ShaderSourceCache_Deinit()
+{
+	ShaderSourceCache_Clear();
+	SDL_DestroyMutex(g_shaderSourceCacheMutex);
+	g_shaderSourceCacheMutex = NULL;
+}
+
+void ShaderSourceCache_Clear()
+{
+	SDL_LockMutex(g_shaderSourceCacheMutex);
+	for (std::map<std::string, ShaderSourceFile*>::iterator it = g_shaderSourceFiles.begin(); it != g_shaderSourceFiles.end(); ++it)
+		if (it->second)
+			delete it->second;
+	g_shaderSourceFiles.clear();
+	g_shaderEntrySourceCode.clear();
+	SDL_UnlockMutex(g_shaderSourceCacheMutex);
+}
+
 // Shader
 
 bool Shader_LoadSourceCodeFromString(const std::string& path, std::string& sourceCodeOut);
 
 bool Shader_LoadSourceCode(const std::string& path, std::string& sourceCodeOut)
 {
-	char* sourceCode = NULL;
-	int sourceCodeSize = 0;
-	if (!File_Load(path, (void*&) sourceCode, sourceCodeSize))
+	ShaderSourceFile* file = ShaderSourceCache_GetFile(path);
+	if (!file)
 	{
 		Log::Error(string_format("Failed to load shader %s", path.c_str()));
 		return false;
 	}
 
-	sourceCodeOut = sourceCode;
+	sourceCodeOut = file->sourceCode;
 	return Shader_LoadSourceCodeFromString(path, sourceCodeOut);
 }
 
@@ -49,6 +221,7 @@ bool Shader_LoadSourceCodeFromString(const std::string& path, std::string& sourc
 			return false;
 		}
 
+		HotReload_AddInclude(includePath, path);
 		sourceCodeOut.replace((int) (includeStart - sourceCodeOut.c_str()), (int) (includeEnd - includeStart + 1), includeFileContent);
 	}
 
@@ -57,11 +230,21 @@ bool Shader_LoadSourceCodeFromString(const std::string& path, std::string& sourc
 
 bool Shader_LoadShaderCode(const std::string& path, const std::string& entry, std::string& sourceCodeOut)
 {
-	// Load file content
+	// Prefer preprocessed file generated by the ShaderCompiler tool (skips #include expansion and entry lookup); fall back to the original file if it's out of date or for entries it doesn't contain
+
+	if (ShaderSourceFile* preprocessedFile = ShaderSourceCache_GetFile(path + SHADER_PREPROCESSED_SUFFIX, true))
+	{
+		const int sectionIndex = ShaderSourceCache_FindEntrySection(preprocessedFile, entry);
+		if (sectionIndex >= 0)
+		{
+			const std::pair<int, int>& section = preprocessedFile->sections[sectionIndex];
+			sourceCodeOut = preprocessedFile->sourceCode.substr(section.first, section.second);
+			return true;
+		}
+	}
 
-	char* sourceCode = NULL;
-	int sourceCodeSize = 0;
-	if (!File_Load(path, (void*&) sourceCode, sourceCodeSize))
+	ShaderSourceFile* file = ShaderSourceCache_GetFile(path);
+	if (!file)
 	{
 		Log::Error(string_format("Failed to load shader from %s", path.c_str()));
 		return false;
@@ -69,34 +252,18 @@ bool Shader_LoadShaderCode(const std::string& path, const std::string& entry, st
 
 	// Find source code part containing desired entry function
 
-	static const char* splitterString = "###splitter###";
-	static const int splitterStringLength = strlen(splitterString);
-
-	char* start = sourceCode;
-	char* end = sourceCode;
-	bool done = false;
-	while (!done)
+	const int sectionIndex = ShaderSourceCache_FindEntrySection(file, entry);
+	if (sectionIndex < 0)
 	{
-		end = strstr(start, splitterString);
-		if (!end)
-		{
-			end = sourceCode + sourceCodeSize;
-			done = true;
-		}
-		*end = '\0';
-		if (strstr(start, entry.c_str()))
-		{
-			sourceCodeOut = start;
-			if (entry != "main")
-				string_replace_all(sourceCodeOut, entry, "main");
-			return Shader_LoadSourceCodeFromString(path, sourceCodeOut);
-		}
-
-		start = end + splitterStringLength;
+		Log::Error(string_format("Failed to find entry %s in shader %s", entry.c_str(), path.c_str()));
+		return false;
 	}
 
-	Log::Error(string_format("Failed to find entry %s in shader %s", entry.c_str(), path.c_str()));
-	return false;
+	const std::pair<int, int>& section = file->sections[sectionIndex];
+	sourceCodeOut = file->sourceCode.substr(section.first, section.second);
+	if (entry != "main")
+		string_replace_all(sourceCodeOut, entry, "main");
+	return Shader_LoadSourceCodeFromString(path, sourceCodeOut);
 }
 
 struct line_replace_callback
@@ -113,249 +280,946 @@ struct line_replace_callback
 	}
 };
 
-Shader* Shader_Create(const std::string& path, Shader::Type type, const std::string& entry)
+bool Shader_GetSourceCodeLocked(const std::string& path, const std::string& entry, std::string& sourceCodeOut)
+{
+	const std::string key = path + ":" + entry;
+	std::map<std::string, std::string>::iterator it = g_shaderEntrySourceCode.find(key);
+	if (it != g_shaderEntrySourceCode.end())
+	{
+		sourceCodeOut = it->second;
+		return true;
+	}
+
+	if (!Shader_LoadShaderCode(path, entry, sourceCodeOut))
+		return false;
+#ifdef OPENGL_ES
+	OpenGLES_ConvertFromOpenGL(sourceCodeOut);
+#endif
+
+	g_shaderEntrySourceCode[key] = sourceCodeOut;
+	return true;
+}
+
+bool Shader_GetSourceCode(const std::string& path, const std::string& entry, std::string& sourceCodeOut)
+{
+	SDL_LockMutex(g_shaderSourceCacheMutex);
+	const bool result = Shader_GetSourceCodeLocked(path, entry, sourceCodeOut);
+	SDL_UnlockMutex(g_shaderSourceCacheMutex);
+	return result;
+}
+
+void Shader_InsertAfterVersion(std::string& sourceCode, const std::string& code)
+{
+	// Injected code must follow #version directive (if any)
+
+	size_t insertPos = 0;
+	const size_t versionPos = sourceCode.find("#version");
+	if (versionPos != std::string::npos)
+	{
+		const size_t versionEnd = sourceCode.find('\n', versionPos);
+		insertPos = versionEnd == std::string::npos ? sourceCode.length() : versionEnd + 1;
+	}
+	sourceCode.insert(insertPos, code);
+}
+
+void Shader_AddKeywordDefines(std::string& sourceCode, const std::string& keywords)
+{
+	if (keywords.empty())
+		return;
+
+	std::vector<std::string> keywordNames;
+	string_split(keywordNames, keywords);
+
+	std::string defines;
+	for (std::vector<std::string>::iterator it = keywordNames.begin(); it != keywordNames.end(); ++it)
+		defines += "#define " + *it + " 1\n";
+	Shader_InsertAfterVersion(sourceCode, defines);
+}
+
+std::string Shader_GetName(const std::string& path, Shader::Type type, const std::string& entry, const std::string& variant)
+{
+	std::string name = path + ":" + entry + (type == Shader::Type_Vertex ? ":vs" : ":fs");
+	if (!variant.empty())
+		name += "[" + variant + "]";
+	return name;
+}
+
+Shader* Shader_CreateFromSourceCode(const std::string& path, Shader::Type type, const std::string& entry, const std::string& variant, const std::string& sourceCode)
 {
-	const std::string name = path + ":" + entry;
+	const std::string name = Shader_GetName(path, type, entry, variant);
 
-	Shader* shader = static_cast<Shader*>(Resource_Find("shader", name));
+	Shader* shader = static_cast<Shader*>(Resource_FindAndIncRefCount("shader", name));
 	if (!shader)
 	{
-		std::string sourceCode;
-		if (!Shader_LoadShaderCode(path, entry, sourceCode))
+		GLuint handle = GLR(glCreateShaderObjectARB(type == Shader::Type_Vertex ? GL_VERTEX_SHADER_ARB : GL_FRAGMENT_SHADER_ARB));
+		if (!handle)
+		{
+			Log::Error("glCreateShaderObject returned invalid handle");
 			return NULL;
+		}
+
+		const char* sourceCodeChars = sourceCode.c_str();
+
+		GL(glShaderSourceARB(handle, 1, (const GLcharARB**) &sourceCodeChars, NULL));
+		GL(glCompileShaderARB(handle));
+
+		// Compile status is only checked when the program gets finalized so that the driver can compile in the background
+
+		shader = new Shader();
+		shader->name = name;
+		shader->type = type;
+		shader->handle = handle;
+		shader->state = ResourceState_Creating;
+		shader->sourceCode = sourceCode;
+
+		Shader* registered = static_cast<Shader*>(Resource_FindOrRegister(shader));
+		if (registered != shader)
+		{
+			Shader_Destroy(shader);
+			shader = registered;
+		}
+	}
+
+	return shader;
+}
+
+Shader* Shader_Create(const std::string& path, Shader::Type type, const std::string& entry)
+{
+	Shader* shader = static_cast<Shader*>(Resource_FindAndIncRefCount("shader", Shader_GetName(path, type, entry, std::string())));
+	if (shader)
+		return shader;
+
+	std::string sourceCode;
+	if (!Shader_GetSourceCode(path, entry, sourceCode))
+		return NULL;
+	return Shader_CreateFromSourceCode(path, type, entry, std::string(), sourceCode);
+}
+
+bool Shader_CheckCompileStatus(Shader* shader)
+{
+	if (shader->state != ResourceState_Creating)
+		return shader->state == ResourceState_Created;
+
+	GLint compileResult = 0;
+	GL(glGetShaderiv(shader->handle, GL_OBJECT_COMPILE_STATUS_ARB, &compileResult));
+	if (!compileResult)
+	{
+		GLsizei logSize;
+		GLcharARB log[1 << 16];
 #ifdef OPENGL_ES
-		OpenGLES_ConvertFromOpenGL(sourceCode);
+		GL(glGetShaderInfoLog(shader->handle, ARRAYSIZE(log), &logSize, log));
+#else
+		GL(glGetInfoLogARB(shader->handle, ARRAYSIZE(log), &logSize, log));
+#endif
+		std::string sourceWithLineNumbers = std::string("1: ") + shader->sourceCode;
+		line_replace_callback replaceCallback(2);
+		string_replace_all_pred<line_replace_callback>(sourceWithLineNumbers, (const std::string&) std::string("\n"), replaceCallback);
+		Log::Error(string_format("Failed to compile shader %s, reason:\n%s\nGLSL source code:\n%s", shader->name.c_str(), log, sourceWithLineNumbers.c_str()));
+
+		shader->state = ResourceState_AsyncError;
+		return false;
+	}
+
+#ifndef DEBUG
+	std::string().swap(shader->sourceCode);
 #endif
+	shader->state = ResourceState_Created;
+	return true;
+}
+
+void Shader_Destroy(Shader* shader)
+{
+	if (!Resource_DecRefCount(shader))
+	{
+		GL(glDeleteShader(shader->handle));
+		delete shader;
+	}
+}
+
+// Shader compiler
+
+bool g_supportsParallelShaderCompile = false;
+
+void ShaderCompiler_Init()
+{
+	g_supportsParallelShaderCompile = false;
+
+	const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+	if (!glMaxShaderCompilerThreadsProc || !extensions ||
+		(!strstr(extensions, "GL_KHR_parallel_shader_compile") && !strstr(extensions, "GL_ARB_parallel_shader_compile")))
+	{
+		Log::Info("Parallel shader compilation not supported by OpenGL driver");
+		return;
+	}
+
+	// Let the driver pick the number of compiler threads
+
+	GL(glMaxShaderCompilerThreadsProc(0xFFFFFFFF));
+	g_supportsParallelShaderCompile = true;
+	Log::Info("Parallel shader compilation enabled");
+}
+
+// Frame constants
+
+#define FRAME_CONSTANTS_BLOCK_NAME "FrameConstants"
+#define FRAME_CONSTANTS_BINDING 0
+
+const char* g_frameConstantNames[FrameConstant_COUNT] =
+{
+	"ScreenSize",
+	"ProjectionScale"
+};
+
+unsigned int g_frameConstantsVersion = 1;
+GLuint g_frameConstantsBuffer = 0; // Uniform buffer object; 0 if not supported
+
+const float* FrameConstant_GetValue(int frameConstant)
+{
+	switch (frameConstant)
+	{
+		case FrameConstant_ScreenSize: return App_GetScreenSizeMaterialParam();
+		case FrameConstant_ProjectionScale: return App_GetProjectionScaleMaterialParam();
+		default: return NULL;
+	}
+}
+
+int FrameConstant_FromName(const char* name)
+{
+	for (int i = 0; i < FrameConstant_COUNT; i++)
+		if (!strcmp(g_frameConstantNames[i], name))
+			return i;
+	return -1;
+}
+
+void FrameConstants_Init()
+{
+	g_frameConstantsBuffer = 0;
+
+#ifndef OPENGL_ES
+	const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+	if (!extensions || !strstr(extensions, "GL_ARB_uniform_buffer_object") ||
+		!glGenBuffers || !glBindBuffer || !glBufferData || !glBufferSubData || !glBindBufferBase || !glGetUniformBlockIndex || !glUniformBlockBinding)
+	{
+		Log::Info("Uniform buffers not supported by OpenGL driver; frame constants will be uploaded per shader program");
+		return;
+	}
+
+	// Every frame constant is a vec4 (std140 layout)
+
+	GL(glGenBuffers(1, &g_frameConstantsBuffer));
+	GL(glBindBuffer(GL_UNIFORM_BUFFER, g_frameConstantsBuffer));
+	GL(glBufferData(GL_UNIFORM_BUFFER, FrameConstant_COUNT * 4 * sizeof(float), NULL, GL_DYNAMIC_DRAW));
+	GL(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+	GL(glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, g_frameConstantsBuffer));
+	Log::Info("Frame constants stored in uniform buffer");
+#else
+	Log::Info("Frame constants will be uploaded per shader program");
+#endif
+}
+
+void FrameConstants_Deinit()
+{
+#ifndef OPENGL_ES
+	if (g_frameConstantsBuffer)
+	{
+		GL(glDeleteBuffers(1, &g_frameConstantsBuffer));
+		g_frameConstantsBuffer = 0;
+	}
+#endif
+}
+
+void FrameConstants_Update()
+{
+	g_frameConstantsVersion++;
+
+#ifndef OPENGL_ES
+	if (g_frameConstantsBuffer)
+	{
+		float data[FrameConstant_COUNT * 4];
+		for (int i = 0; i < FrameConstant_COUNT; i++)
+			memcpy(data + i * 4, FrameConstant_GetValue(i), 4 * sizeof(float));
+
+		GL(glBindBuffer(GL_UNIFORM_BUFFER, g_frameConstantsBuffer));
+		GL(glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), data));
+		GL(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+	}
+#endif
+}
+
+void Shader_AddFrameConstantDeclarations(std::string& sourceCode, unsigned int frameConstantMask)
+{
+	if (!frameConstantMask)
+		return;
+
+	std::string declarations;
+	if (g_frameConstantsBuffer)
+	{
+		// Uniform block layout must match the buffer, so it always contains all frame constants
+
+		declarations = "#extension GL_ARB_uniform_buffer_object : enable\nlayout(std140) uniform " FRAME_CONSTANTS_BLOCK_NAME "\n{\n";
+		for (int i = 0; i < FrameConstant_COUNT; i++)
+			declarations += std::string("\tvec4 ") + g_frameConstantNames[i] + ";\n";
+		declarations += "};\n";
+		for (int i = 0; i < FrameConstant_COUNT; i++)
+			declarations += std::string("#define " FRAME_CONSTANT_DEFINE_PREFIX) + g_frameConstantNames[i] + "\n";
+	}
+	else
+	{
+		for (int i = 0; i < FrameConstant_COUNT; i++)
+			if (frameConstantMask & (1u << i))
+				declarations += std::string("uniform vec4 ") + g_frameConstantNames[i] + ";\n#define " FRAME_CONSTANT_DEFINE_PREFIX + g_frameConstantNames[i] + "\n";
+	}
+
+	Shader_InsertAfterVersion(sourceCode, declarations);
+}
+
+void ShaderProgram_CommitFrameConstants(ShaderProgram* program)
+{
+	for (int i = 0; i < FrameConstant_COUNT; i++)
+		if (program->frameConstantLocations[i] != -1)
+			GL(glUniform4fv(program->frameConstantLocations[i], 1, FrameConstant_GetValue(i)));
+	program->frameConstantsVersion = g_frameConstantsVersion;
+}
+
+// Samplers
+
+struct SamplerObject
+{
+	SamplerState state;
+	GLuint handle;
+};
+
+#define SAMPLER_MAX_TEXTURE_UNITS 16
+
+bool g_samplerObjectsSupported = false;
+std::vector<SamplerObject> g_samplerObjects; // Cached sampler objects; number of unique sampler states is typically small, so linear search is fine
+GLuint g_boundSamplerObjects[SAMPLER_MAX_TEXTURE_UNITS];
+float g_maxAnisotropy = 1.0f; // 1 if anisotropic filtering isn't supported
+
+void Samplers_Init()
+{
+	g_samplerObjectsSupported = false;
+	g_maxAnisotropy = 1.0f;
+	memset(g_boundSamplerObjects, 0, sizeof(g_boundSamplerObjects));
+
+	const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+	if (extensions && strstr(extensions, "GL_EXT_texture_filter_anisotropic"))
+		GL(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &g_maxAnisotropy));
+
+#ifndef OPENGL_ES
+	g_samplerObjectsSupported =
+		extensions && strstr(extensions, "GL_ARB_sampler_objects") &&
+		glGenSamplers && glDeleteSamplers && glBindSampler && glSamplerParameteri && glSamplerParameterf && glSamplerParameterfv;
+#endif
+
+	Log::Info(g_samplerObjectsSupported ?
+		"Sampler state stored in sampler objects" :
+		"Sampler objects not supported by OpenGL driver; sampler state will be set via texture parameters");
+}
+
+void Samplers_Deinit()
+{
+#ifndef OPENGL_ES
+	for (std::vector<SamplerObject>::iterator it = g_samplerObjects.begin(); it != g_samplerObjects.end(); ++it)
+		GL(glDeleteSamplers(1, &it->handle));
+#endif
+	g_samplerObjects.clear();
+	memset(g_boundSamplerObjects, 0, sizeof(g_boundSamplerObjects));
+}
+
+bool Texture_CanHaveMipmaps(TextureObj* texture)
+{
+	if (texture->isRenderTarget || !texture->handle)
+		return false;
+#ifdef OPENGL_ES
+	// OpenGL ES 2.0 doesn't support mip-maps for non power of 2 textures
+
+	if ((texture->width & (texture->width - 1)) || (texture->height & (texture->height - 1)))
+		return false;
+#else
+	if (!glGenerateMipmapEXT)
+		return false;
+#endif
+	return true;
+}
+
+void SamplerState_FromSampler(SamplerState& state, const Sampler& sampler, bool hasMipmaps)
+{
+	switch (hasMipmaps ? sampler.mipFilter : Sampler::MipFilter_None)
+	{
+		case Sampler::MipFilter_Nearest: state.minFilter = sampler.minFilterLinear ? GL_LINEAR_MIPMAP_NEAREST : GL_NEAREST_MIPMAP_NEAREST; break;
+		case Sampler::MipFilter_Linear: state.minFilter = sampler.minFilterLinear ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR; break;
+		default: state.minFilter = sampler.minFilterLinear ? GL_LINEAR : GL_NEAREST; break;
+	}
+	state.magFilter = sampler.magFilterLinear ? GL_LINEAR : GL_NEAREST;
+	state.wrapS = Sampler_WrapMode_ToOpenGL(sampler.uWrapMode);
+	state.wrapT = Sampler_WrapMode_ToOpenGL(sampler.vWrapMode);
+	state.maxAnisotropy = max(1.0f, min(sampler.maxAnisotropy, g_maxAnisotropy));
+#ifdef OPENGL_ES
+	state.borderColor = Color::White; // Unused
+#else
+	state.borderColor = sampler.borderColor;
+#endif
+}
+
+#ifndef OPENGL_ES
+
+GLuint SamplerObject_Get(const SamplerState& state)
+{
+	for (std::vector<SamplerObject>::iterator it = g_samplerObjects.begin(); it != g_samplerObjects.end(); ++it)
+		if (it->state == state)
+			return it->handle;
+
+	SamplerObject samplerObject;
+	samplerObject.state = state;
+	GL(glGenSamplers(1, &samplerObject.handle));
+	GL(glSamplerParameteri(samplerObject.handle, GL_TEXTURE_MIN_FILTER, state.minFilter));
+	GL(glSamplerParameteri(samplerObject.handle, GL_TEXTURE_MAG_FILTER, state.magFilter));
+	GL(glSamplerParameteri(samplerObject.handle, GL_TEXTURE_WRAP_S, state.wrapS));
+	GL(glSamplerParameteri(samplerObject.handle, GL_TEXTURE_WRAP_T, state.wrapT));
+	GL(glSamplerParameterfv(samplerObject.handle, GL_TEXTURE_BORDER_COLOR, (const float*) &state.borderColor));
+	if (g_maxAnisotropy > 1.0f)
+		GL(glSamplerParameterf(samplerObject.handle, GL_TEXTURE_MAX_ANISOTROPY_EXT, state.maxAnisotropy));
+
+	g_samplerObjects.push_back(samplerObject);
+	return samplerObject.handle;
+}
+
+#endif
+
+void Sampler_Apply(int textureUnit, TextureObj* texture, const Sampler& sampler)
+{
+	// Generate mip-maps on first use with mip-map filtering
+
+	if (texture && !texture->hasMipmaps && sampler.mipFilter != Sampler::MipFilter_None && Texture_CanHaveMipmaps(texture))
+	{
+		GL(glGenerateMipmapEXT(GL_TEXTURE_2D));
+		texture->hasMipmaps = true;
+	}
+
+	SamplerState state;
+	SamplerState_FromSampler(state, sampler, texture && texture->hasMipmaps);
+
+#ifndef OPENGL_ES
+	if (g_samplerObjectsSupported && textureUnit < SAMPLER_MAX_TEXTURE_UNITS)
+	{
+		const GLuint handle = SamplerObject_Get(state);
+		if (g_boundSamplerObjects[textureUnit] != handle)
+		{
+			GL(glBindSampler(textureUnit, handle));
+			g_boundSamplerObjects[textureUnit] = handle;
+		}
+		return;
+	}
+#endif
+
+	if (!texture)
+		return;
+
+	// Only set texture parameters that differ from the ones last applied to this texture
+
+	SamplerState& current = texture->samplerState;
+	const bool forceAll = !texture->isSamplerStateValid;
+	if (forceAll || current.minFilter != state.minFilter)
+		GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, state.minFilter));
+	if (forceAll || current.magFilter != state.magFilter)
+		GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, state.magFilter));
+	if (forceAll || current.wrapS != state.wrapS)
+		GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, state.wrapS));
+	if (forceAll || current.wrapT != state.wrapT)
+		GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, state.wrapT));
+	if (g_maxAnisotropy > 1.0f && (forceAll || current.maxAnisotropy != state.maxAnisotropy))
+		GL(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, state.maxAnisotropy));
+#ifndef OPENGL_ES
+	if (forceAll || current.borderColor.r != state.borderColor.r || current.borderColor.g != state.borderColor.g || current.borderColor.b != state.borderColor.b || current.borderColor.a != state.borderColor.a)
+		GL(glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, (const float*) &state.borderColor));
+#endif
+	current = state;
+	texture->isSamplerStateValid = true;
+}
+
+// Shader program binary cache
+
+#define SHADER_PROGRAM_CACHE_MAGIC 0x50533254 // "T2SP"
+#define SHADER_PROGRAM_CACHE_VERSION 1
+
+struct ShaderProgramCacheHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned long long key;
+	unsigned int binaryFormat;
+	unsigned int binarySize;
+	float compileTime;		// Time (in seconds) it took to compile and link the program from source code
+};
+
+std::string g_shaderCacheDir;
+
+bool g_shaderCacheSupported = false;
+std::string g_shaderCacheDriverId;
+int g_shaderCacheHits = 0;
+int g_shaderCacheMisses = 0;
+float g_shaderCacheTimeSaved = 0.0f;
+
+void ShaderProgramCache_Init()
+{
+	g_shaderCacheSupported = false;
+	if (g_shaderCacheDir.empty())
+		return;
+
+	const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+#ifdef OPENGL_ES
+	if (!glGetProgramBinary || !glProgramBinary || !extensions || !strstr(extensions, "GL_OES_get_program_binary"))
+#else
+	int majorVersion = 0, minorVersion = 0;
+	const char* version = (const char*) glGetString(GL_VERSION);
+	if (version)
+		sscanf_s(version, "%d.%d", &majorVersion, &minorVersion);
+	const bool hasCoreSupport = majorVersion > 4 || (majorVersion == 4 && minorVersion >= 1);
+	if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri || (!hasCoreSupport && (!extensions || !strstr(extensions, "GL_ARB_get_program_binary"))))
+#endif
+	{
+		Log::Info("Shader program binary cache disabled, reason: program binaries not supported by OpenGL driver");
+		return;
+	}
+
+	GLint numFormats = 0;
+	GL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats));
+	if (numFormats <= 0)
+	{
+		Log::Info("Shader program binary cache disabled, reason: OpenGL driver supports no program binary formats");
+		return;
+	}
+
+	// Cached binaries are only valid for the driver that produced them
+
+	const char* vendor = (const char*) glGetString(GL_VENDOR);
+	const char* renderer = (const char*) glGetString(GL_RENDERER);
+	const char* driverVersion = (const char*) glGetString(GL_VERSION);
+	g_shaderCacheDriverId = string_format("%s|%s|%s", vendor ? vendor : "", renderer ? renderer : "", driverVersion ? driverVersion : "");
+
+	g_shaderCacheSupported = true;
+	Log::Info(string_format("Shader program binary cache enabled (directory = '%s')", g_shaderCacheDir.c_str()));
+}
+
+void ShaderProgramCache_LogStats()
+{
+	if (!g_shaderCacheSupported)
+		return;
+	Log::Info(string_format("Shader program binary cache: %d hits, %d misses, %.3f seconds of compilation saved", g_shaderCacheHits, g_shaderCacheMisses, g_shaderCacheTimeSaved));
+}
+
+unsigned long long ShaderProgramCache_GetKey(const std::string& vsSourceCode, const std::string& fsSourceCode)
+{
+	unsigned long long key = hash_fnv1a64(g_shaderCacheDriverId);
+	key = hash_fnv1a64(vsSourceCode, key);
+	key = hash_fnv1a64(fsSourceCode, key);
+	return key;
+}
+
+std::string ShaderProgramCache_GetFileName(unsigned long long key)
+{
+	return string_format("shadercache_%016llx.bin", key);
+}
+
+GLuint ShaderProgramCache_Load(unsigned long long key)
+{
+	const std::string fileName = ShaderProgramCache_GetFileName(key);
+
+	std::vector<unsigned char> data;
+	if (!ShaderProgramCache_LoadFile(fileName, data))
+	{
+		g_shaderCacheMisses++;
+		return 0;
+	}
+
+	const Time::Ticks startTicks = Time::GetTicks();
+
+	const ShaderProgramCacheHeader* header = (const ShaderProgramCacheHeader*) &data[0];
+	if (data.size() < sizeof(ShaderProgramCacheHeader) ||
+		header->magic != SHADER_PROGRAM_CACHE_MAGIC ||
+		header->version != SHADER_PROGRAM_CACHE_VERSION ||
+		header->key != key ||
+		data.size() != sizeof(ShaderProgramCacheHeader) + header->binarySize)
+	{
+		g_shaderCacheMisses++;
+		return 0;
+	}
+
+	GLuint handle = GLR(glCreateProgramObjectARB());
+	if (!handle)
+	{
+		g_shaderCacheMisses++;
+		return 0;
+	}
+
+	// Driver may reject binaries (e.g. after driver update); not an error - program simply gets recompiled
+
+	glProgramBinary(handle, header->binaryFormat, &data[sizeof(ShaderProgramCacheHeader)], header->binarySize);
+	while (glGetError() != GL_NO_ERROR) {}
+
+	GLint linkResult = 0;
+	GL(glGetProgramiv(handle, GL_OBJECT_LINK_STATUS_ARB, &linkResult));
+	if (!linkResult)
+	{
+		Log::Info(string_format("Cached shader program binary %s rejected by OpenGL driver", fileName.c_str()));
+		GL(glDeleteProgram(handle));
+		g_shaderCacheMisses++;
+		return 0;
+	}
+
+	g_shaderCacheHits++;
+	g_shaderCacheTimeSaved += max(0.0f, header->compileTime - Time::SecondsSince(startTicks));
+	return handle;
+}
+
+void ShaderProgramCache_Save(unsigned long long key, GLuint handle, float compileTime)
+{
+	GLint binarySize = 0;
+	GL(glGetProgramiv(handle, GL_PROGRAM_BINARY_LENGTH, &binarySize));
+	if (binarySize <= 0)
+		return;
+
+	std::vector<unsigned char> data(sizeof(ShaderProgramCacheHeader) + binarySize);
+
+	GLenum binaryFormat = 0;
+	GLsizei length = 0;
+	GL(glGetProgramBinary(handle, binarySize, &length, &binaryFormat, &data[sizeof(ShaderProgramCacheHeader)]));
+	if (length <= 0)
+		return;
+	data.resize(sizeof(ShaderProgramCacheHeader) + length);
+
+	ShaderProgramCacheHeader* header = (ShaderProgramCacheHeader*) &data[0];
+	header->magic = SHADER_PROGRAM_CACHE_MAGIC;
+	header->version = SHADER_PROGRAM_CACHE_VERSION;
+	header->key = key;
+	header->binaryFormat = binaryFormat;
+	header->binarySize = length;
+	header->compileTime = compileTime;
+
+	ShaderProgramCache_SaveFile(ShaderProgramCache_GetFileName(key), data);
+}
+
+// Shader program
+
+GLuint ShaderProgram_Link(Shader* vs, Shader* fs)
+{
+	GLuint handle = GLR(glCreateProgramObjectARB());
+	if (!handle)
+	{
+		Log::Error("glCreateProgramObject returned invalid handle");
+		return 0;
+	}
+
+	GL(glAttachObjectARB(handle, vs->handle));
+	GL(glAttachObjectARB(handle, fs->handle));
+
+#ifndef OPENGL_ES
+	if (g_shaderCacheSupported)
+		GL(glProgramParameteri(handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+#endif
+
+	GL(glLinkProgramARB(handle));
+
+	// Link status is only checked when the program gets finalized so that the driver can link in the background
+
+	return handle;
+}
+
+bool ShaderProgram_Reflect(ShaderProgram* program)
+{
+	const GLuint handle = program->handle;
+	const std::string& name = program->name;
 
-		GLuint handle = GLR(glCreateShaderObjectARB(type == Shader::Type_Vertex ? GL_VERTEX_SHADER_ARB : GL_FRAGMENT_SHADER_ARB));
-		if (!handle)
-		{
-			Log::Error("glCreateShaderObject returned invalid handle");
-			return NULL;
-		}
+	// Collect attributes
 
-		const char* sourceCodeChars = sourceCode.c_str();
+	GL(glUseProgram(handle));
 
-		GL(glShaderSourceARB(handle, 1, (const GLcharARB**) &sourceCodeChars, NULL));
-		GL(glCompileShaderARB(handle));
+	GLint attrCount;
+	GL(glGetProgramiv(handle, GL_OBJECT_ACTIVE_ATTRIBUTES_ARB, &attrCount));
+
+	GLenum attrType;
+	GLint attrNameLength;
+	GLint attrSize;
+	GLchar attrName[128];
+
+	for (GLint i = 0; i < attrCount; i++)
+	{
+		GL(glGetActiveAttribARB(handle, i, ARRAYSIZE(attrName), &attrNameLength, &attrSize, &attrType, attrName));
 
-		GLint compileResult = 0;
-		GL(glGetShaderiv(handle, GL_OBJECT_COMPILE_STATUS_ARB, &compileResult));
-		if (!compileResult)
-		{
-			GLsizei logSize;
-			GLcharARB log[1 << 16];
 #ifdef OPENGL_ES
-			GL(glGetShaderInfoLog(handle, ARRAYSIZE(log), &logSize, log));
+	#define ATTRIBUTE(name) name
 #else
-			GL(glGetInfoLogARB(handle, ARRAYSIZE(log), &logSize, log));
+	#define ATTRIBUTE(name) "gl_"name
 #endif
-			std::string sourceWithLineNumbers = std::string("1: ") + sourceCode;
-			line_replace_callback replaceCallback(2);
-			string_replace_all_pred<line_replace_callback>(sourceWithLineNumbers, (const std::string&) std::string("\n"), replaceCallback);
-			Log::Error(string_format("Failed to compile shader program %s:%s, reason:\n%s\nGLSL source code:\n%s", path.c_str(), entry.c_str(), log, sourceWithLineNumbers.c_str()));
 
-			GL(glDeleteShader(handle));
-			return NULL;
+		Shape::VertexUsage usage;
+		GLint usageIndex;
+		if (!strcmp(attrName, ATTRIBUTE("Vertex"))) { usage = Shape::VertexUsage_Position; usageIndex = 0; }
+		else if (!strcmp(attrName, ATTRIBUTE("MultiTexCoord0")) || !strcmp(attrName, ATTRIBUTE("TexCoord"))) { usage = Shape::VertexUsage_TexCoord; usageIndex = 0; }
+		else if (!strcmp(attrName, ATTRIBUTE("MultiTexCoord1"))) { usage = Shape::VertexUsage_TexCoord; usageIndex = 1; }
+		else if (!strcmp(attrName, ATTRIBUTE("Color"))) { usage = Shape::VertexUsage_Color; usageIndex = 0; }
+		else
+		{
+			Log::Error(string_format("Unsupported input shader semantic (name = '%s') in program %s", attrName, name.c_str()));
+			GL(glUseProgram(0));
+			return false;
 		}
 
-		shader = new Shader();
-		shader->name = name;
-		shader->type = type;
-		shader->handle = handle;
-#ifdef DEBUG
-		shader->sourceCode = sourceCode;
-#endif
+		ShaderAttribute& attribute = vector_add(program->attributes);
+		attribute.location = GLR(glGetAttribLocation(handle, attrName));
+		attribute.usage = usage;
+		attribute.usageIndex = usageIndex;
 	}
 
-	Resource_IncRefCount(shader);
-	return shader;
-}
+	// Collect uniforms
 
-void Shader_Destroy(Shader* shader)
-{
-	if (!Resource_DecRefCount(shader))
+	GLint uniformCount;
+	GL(glGetProgramiv(handle, GL_OBJECT_ACTIVE_UNIFORMS_ARB, &uniformCount));
+
+	GLenum uniformType;
+	GLint uniformNameLength;
+	GLint uniformSize;
+	GLchar uniformName[128];
+
+	GLint samplerIndex = 0;
+	for (GLint i = 0; i < uniformCount; i++)
 	{
-		GL(glDeleteShader(shader->handle));
-		delete shader;
-	}
-}
+		GL(glGetActiveUniformARB(handle, i, ARRAYSIZE(uniformName), &uniformNameLength, &uniformSize, &uniformType, uniformName));
 
-// Shader program
+		// Frame constants are set by the engine rather than by material (location is -1 when stored in uniform buffer)
 
-ShaderProgram* ShaderProgram_Create(const std::string& vertexShader, const std::string& vertexShaderEntry, const std::string& fragmentShader, const std::string& fragmentShaderEntry)
-{
-	const std::string name = "VS:" + vertexShader + ":" + vertexShaderEntry + " FS:" + fragmentShader + ":" + fragmentShaderEntry;
+		const int frameConstant = FrameConstant_FromName(uniformName);
+		if (frameConstant != -1)
+		{
+			program->frameConstantLocations[frameConstant] = GLR(glGetUniformLocationARB(handle, uniformName));
+			continue;
+		}
 
-	ShaderProgram* program = static_cast<ShaderProgram*>(Resource_Find("shader program", name));
-	if (!program)
-	{
-		ShaderPtr vs = Shader_Create(vertexShader, Shader::Type_Vertex, vertexShaderEntry);
-		ShaderPtr fs = Shader_Create(fragmentShader, Shader::Type_Fragment, fragmentShaderEntry);
-		if (!*vs || !*fs)
-			return NULL;
+		ShaderParameter::Type type;
+		GLint count;
+		switch (uniformType)
+		{
+		case GL_INT: type = ShaderParameter::Type_Int; count = 1; break;
+		case GL_FLOAT: type = ShaderParameter::Type_Float; count = 1; break;
+		case 0x8b50: type = ShaderParameter::Type_Float; count = 2; break;
+		case 0x8b51: type = ShaderParameter::Type_Float; count = 3; break;
+		case 0x8b52: type = ShaderParameter::Type_Float; count = 4; break;
+		case GL_SAMPLER_2D: type = ShaderParameter::Type_Texture; count = 1; break;
+		default:
+			Log::Error(string_format("Uniform variable %s of unsupported type detected in %s shader program", uniformName, name.c_str()));
+			GL(glUseProgram(0));
+			return false;
+		}
 
-		// Build program
+		// Array uniforms are reported as "name[0]"
 
-		GLuint handle = GLR(glCreateProgramObjectARB());
-		if (!handle)
+		if (uniformSize != 1)
 		{
-			Log::Error("glCreateProgramObject returned invalid handle");
-			return NULL;
+			if (type != ShaderParameter::Type_Float)
+			{
+				Log::Error(string_format("Uniform variable %s in %s shader program is an array (size = %d) but only float arrays are supported", uniformName, name.c_str(), uniformSize));
+				GL(glUseProgram(0));
+				return false;
+			}
+
+			if (char* arraySuffix = strstr(uniformName, "[0]"))
+				*arraySuffix = 0;
 		}
 
-		GL(glAttachObjectARB(handle, vs->handle));
-		GL(glAttachObjectARB(handle, fs->handle));
+		ShaderParameter& parameter = vector_add(program->parameters);
+		parameter.name = StringId(uniformName);
+		parameter.count = count;
+		parameter.type = type;
+		parameter.arraySize = uniformSize;
 
-		// Link program
+		// Assign consecutive sampler index to sampler uniform
 
-		GL(glLinkProgramARB(handle));
+		const GLint location = GLR(glGetUniformLocationARB(handle, uniformName));
 
-		GLint linkResult;
-		GL(glGetProgramiv(handle, GL_OBJECT_LINK_STATUS_ARB, &linkResult));
-		if (!linkResult)
+		if (parameter.type == ShaderParameter::Type_Texture)
 		{
-			GLsizei logSize;
-			GLcharARB log[1 << 16];
-#ifdef OPENGL_ES
-			GL(glGetShaderInfoLog(handle, ARRAYSIZE(log), &logSize, log));
-#else
-			GL(glGetInfoLogARB(handle, ARRAYSIZE(log), &logSize, log));
+			parameter.location = samplerIndex++;
+			GL(glUniform1i(location, parameter.location));
+		}
+		else
+			parameter.location = location;
+	}
+
+#ifndef OPENGL_ES
+	if (g_frameConstantsBuffer)
+	{
+		const GLuint blockIndex = glGetUniformBlockIndex(handle, FRAME_CONSTANTS_BLOCK_NAME);
+		if (blockIndex != GL_INVALID_INDEX)
+			GL(glUniformBlockBinding(handle, blockIndex, FRAME_CONSTANTS_BINDING));
+	}
 #endif
-			Log::Error(string_format("Failed to link shader program %s, reason: %s", name.c_str(), log));
 
-			GL(glDeleteProgram(handle));
-			return NULL;
-		}
+	GL(glUseProgram(0));
+	return true;
+}
 
-		// Create the actual resource
+void ShaderProgram_Destroy(ShaderProgram* program);
 
-		program = new ShaderProgram();
-		program->name = name;
-		program->vs = *vs;
-		program->fs = *fs;
-		program->handle = handle;
+ShaderProgram* ShaderProgram_Create(const std::string& vertexShader, const std::string& vertexShaderEntry, const std::string& fragmentShader, const std::string& fragmentShaderEntry, const std::string& keywords, unsigned int frameConstantMask)
+{
+	// Variant identifies preprocessor setup of shaders built from the same entries
 
-		Resource_IncRefCount(program->vs);
-		Resource_IncRefCount(program->fs);
+	std::string variant = keywords;
+	if (frameConstantMask)
+		variant += string_format("%sFRAMECONSTANTS:%x", variant.empty() ? "" : " ", frameConstantMask);
 
-		// Collect attributes
+	std::string name = "VS:" + vertexShader + ":" + vertexShaderEntry + " FS:" + fragmentShader + ":" + fragmentShaderEntry;
+	if (!variant.empty())
+		name += " " + variant;
 
-		GL(glUseProgram(handle));
+	ShaderProgram* program = static_cast<ShaderProgram*>(Resource_FindAndIncRefCount("shader program", name));
+	if (!program)
+	{
+		std::string vsSourceCode, fsSourceCode;
+		if (!Shader_GetSourceCode(vertexShader, vertexShaderEntry, vsSourceCode) ||
+			!Shader_GetSourceCode(fragmentShader, fragmentShaderEntry, fsSourceCode))
+			return NULL;
 
-		GLint attrCount;
-		GL(glGetProgramiv(handle, GL_OBJECT_ACTIVE_ATTRIBUTES_ARB, &attrCount));
+		Shader_AddKeywordDefines(vsSourceCode, keywords);
+		Shader_AddKeywordDefines(fsSourceCode, keywords);
+		Shader_AddFrameConstantDeclarations(vsSourceCode, frameConstantMask);
+		Shader_AddFrameConstantDeclarations(fsSourceCode, frameConstantMask);
 
-		GLenum attrType;
-		GLint attrNameLength;
-		GLint attrSize;
-		GLchar attrName[128];
+		// Try to restore program from binary cache
 
-		for (GLint i = 0; i < attrCount; i++)
+		GLuint handle = 0;
+		unsigned long long cacheKey = 0;
+		if (g_shaderCacheSupported)
 		{
-			GL(glGetActiveAttribARB(handle, i, ARRAYSIZE(attrName), &attrNameLength, &attrSize, &attrType, attrName));
+			cacheKey = ShaderProgramCache_GetKey(vsSourceCode, fsSourceCode);
+			handle = ShaderProgramCache_Load(cacheKey);
+		}
 
-#ifdef OPENGL_ES
-	#define ATTRIBUTE(name) name
-#else
-	#define ATTRIBUTE(name) "gl_"name
-#endif
+		if (handle)
+		{
+			program = new ShaderProgram();
+			program->name = name;
+			program->handle = handle;
+			program->state = ResourceState_Created;
 
-			Shape::VertexUsage usage;
-			GLint usageIndex;
-			if (!strcmp(attrName, ATTRIBUTE("Vertex"))) { usage = Shape::VertexUsage_Position; usageIndex = 0; }
-			else if (!strcmp(attrName, ATTRIBUTE("MultiTexCoord0")) || !strcmp(attrName, ATTRIBUTE("TexCoord"))) { usage = Shape::VertexUsage_TexCoord; usageIndex = 0; }
-			else if (!strcmp(attrName, ATTRIBUTE("MultiTexCoord1"))) { usage = Shape::VertexUsage_TexCoord; usageIndex = 1; }
-			else if (!strcmp(attrName, ATTRIBUTE("Color"))) { usage = Shape::VertexUsage_Color; usageIndex = 0; }
-			else
+			if (!ShaderProgram_Reflect(program))
 			{
 				GL(glDeleteProgram(handle));
-
-				Log::Error(string_format("Unsupported input shader semantic (name = '%s') in program %s", attrName, name.c_str()));
+				delete program;
 				return NULL;
 			}
-
-			ShaderAttribute& attribute = vector_add(program->attributes);
-			attribute.location = GLR(glGetAttribLocation(handle, attrName));
-			attribute.usage = usage;
-			attribute.usageIndex = usageIndex;
 		}
 
-		// Collect uniforms
+		// Submit program compilation and linking from source code; finalized by ShaderProgram_Finalize()
 
-		GLint uniformCount;
-		GL(glGetProgramiv(handle, GL_OBJECT_ACTIVE_UNIFORMS_ARB, &uniformCount));
-
-		GLenum uniformType;
-		GLint uniformNameLength;
-		GLint uniformSize;
-		GLchar uniformName[128];
-
-		GLint samplerIndex = 0;
-		for (GLint i = 0; i < uniformCount; i++)
+		else
 		{
-			GL(glGetActiveUniformARB(handle, i, ARRAYSIZE(uniformName), &uniformNameLength, &uniformSize, &uniformType, uniformName));
+			const Time::Ticks startTicks = Time::GetTicks();
 
-			if (uniformSize != 1)
+			Shader* vs = Shader_CreateFromSourceCode(vertexShader, Shader::Type_Vertex, vertexShaderEntry, variant, vsSourceCode);
+			Shader* fs = Shader_CreateFromSourceCode(fragmentShader, Shader::Type_Fragment, fragmentShaderEntry, variant, fsSourceCode);
+			if (vs && fs)
+				handle = ShaderProgram_Link(vs, fs);
+			if (!handle)
 			{
-				GL(glDeleteProgram(handle));
-				Log::Error(string_format("Uniform variable %s in %s shader program is an array (size = %d) but arrays are not supported", uniformName, name.c_str(), uniformSize));
+				if (vs) Shader_Destroy(vs);
+				if (fs) Shader_Destroy(fs);
 				return NULL;
 			}
 
-			ShaderParameter::Type type;
-			GLint count;
-			switch (uniformType)
-			{
-			case GL_INT: type = ShaderParameter::Type_Int; count = 1; break;
-			case GL_FLOAT: type = ShaderParameter::Type_Float; count = 1; break;
-			case 0x8b50: type = ShaderParameter::Type_Float; count = 2; break;
-			case 0x8b51: type = ShaderParameter::Type_Float; count = 3; break;
-			case 0x8b52: type = ShaderParameter::Type_Float; count = 4; break;
-			case GL_SAMPLER_2D: type = ShaderParameter::Type_Texture; count = 1; break;
-			default:
-				GL(glDeleteProgram(handle));
-				Log::Error(string_format("Uniform variable %s of unsupported type detected in %s shader program", uniformName, name.c_str()));
-				return NULL;
-			}
+			program = new ShaderProgram();
+			program->name = name;
+			program->vs = vs;
+			program->fs = fs;
+			program->handle = handle;
+			program->state = ResourceState_Creating;
+			program->compileStartTicks = startTicks;
+			program->cacheKey = cacheKey;
+		}
 
-			ShaderParameter& parameter = vector_add(program->parameters);
-			parameter.name = uniformName;
-			parameter.count = count;
-			parameter.type = type;
+		ShaderProgram* registered = static_cast<ShaderProgram*>(Resource_FindOrRegister(program));
+		if (registered != program)
+		{
+			ShaderProgram_Destroy(program);
+			program = registered;
+		}
+	}
 
-			// Assign consecutive sampler index to sampler uniform
+	return program;
+}
 
-			const GLint location = GLR(glGetUniformLocationARB(handle, uniformName));
+bool ShaderProgram_IsLinkComplete(ShaderProgram* program)
+{
+	if (program->state != ResourceState_Creating || !g_supportsParallelShaderCompile)
+		return true;
 
-			if (parameter.type == ShaderParameter::Type_Texture)
-			{
-				parameter.location = samplerIndex++;
-				GL(glUniform1i(location, parameter.location));
-			}
-			else
-				parameter.location = location;
-		}
+	GLint isComplete = GL_FALSE;
+	GL(glGetProgramiv(program->handle, GL_COMPLETION_STATUS_KHR, &isComplete));
+	return isComplete == GL_TRUE;
+}
 
-		GL(glUseProgram(0));
+bool ShaderProgram_Finalize(ShaderProgram* program)
+{
+	if (program->state != ResourceState_Creating)
+		return program->state == ResourceState_Created;
+
+	// Check compilation and link results (blocks until driver is done, unless ShaderProgram_IsLinkComplete() returned true)
+
+	const bool vsCompiled = Shader_CheckCompileStatus(program->vs);
+	const bool fsCompiled = Shader_CheckCompileStatus(program->fs);
+	if (!vsCompiled || !fsCompiled)
+	{
+		program->state = ResourceState_AsyncError;
+		return false;
 	}
 
-	Resource_IncRefCount(program);
-	return program;
+	GLint linkResult;
+	GL(glGetProgramiv(program->handle, GL_OBJECT_LINK_STATUS_ARB, &linkResult));
+	if (!linkResult)
+	{
+		GLsizei logSize;
+		GLcharARB log[1 << 16];
+#ifdef OPENGL_ES
+		GL(glGetShaderInfoLog(program->handle, ARRAYSIZE(log), &logSize, log));
+#else
+		GL(glGetInfoLogARB(program->handle, ARRAYSIZE(log), &logSize, log));
+#endif
+		Log::Error(string_format("Failed to link shader program %s, reason: %s", program->name.c_str(), log));
+
+		program->state = ResourceState_AsyncError;
+		return false;
+	}
+
+	if (g_shaderCacheSupported)
+		ShaderProgramCache_Save(program->cacheKey, program->handle, Time::SecondsSince(program->compileStartTicks));
+
+	// Collect attributes and uniforms
+
+	if (!ShaderProgram_Reflect(program))
+	{
+		program->state = ResourceState_AsyncError;
+		return false;
+	}
+
+	program->state = ResourceState_Created;
+	return true;
 }
 
 void ShaderProgram_Destroy(ShaderProgram* program)
 {
 	if (!Resource_DecRefCount(program))
 	{
-		Shader_Destroy(program->vs);
-		Shader_Destroy(program->fs);
+		if (program->vs)
+			Shader_Destroy(program->vs);
+		if (program->fs)
+			Shader_Destroy(program->fs);
 		GL(glDeleteProgram(program->handle));
 		delete program;
 	}
 }
 
-ShaderParameter* ShaderProgram_GetParameter(ShaderProgram* program, const std::string& name)
+ShaderParameter* ShaderProgram_GetParameter(ShaderProgram* program, StringId name)
 {
 	for (std::vector<ShaderParameter>::iterator it = program->parameters.begin(); it != program->parameters.end(); ++it)
 		if (it->name == name)
@@ -365,8 +1229,11 @@ ShaderParameter* ShaderProgram_GetParameter(ShaderProgram* program, const std::s
 
 // Material
 
+bool MaterialResource_CheckCreated(MaterialResource* resource);
+
 ResourceState Material_GetState(MaterialObj* material)
 {
+	MaterialResource_CheckCreated(material->resource);
 	return material->resource->state;
 }
 
@@ -381,6 +1248,8 @@ int Material_AddParameter(MaterialResource* resource, ShaderParameter* shaderPar
 		break;
 	case ShaderParameterDescription::Type_Float:
 		memset(materialParameter.floatValue, 0, sizeof(materialParameter.floatValue));
+		if (shaderParameter->arraySize != 1)
+			materialParameter.floatArrayValue.resize(shaderParameter->arraySize * shaderParameter->count, 0.0f);
 		break;
 	case ShaderParameterDescription::Type_Texture:
 		materialParameter.textureValue = NULL;
@@ -394,7 +1263,7 @@ int Material_AddParameter(MaterialResource* resource, ShaderParameter* shaderPar
 
 bool Material_LoadTechnique(MaterialResource* resource, XMLNode* techniqueNode, MaterialTechnique& technique)
 {
-	technique.name = XMLNode_GetAttributeValue(techniqueNode, "name");
+	technique.name = StringId(XMLNode_GetAttributeValue(techniqueNode, "name"));
 
 	if (const char* blending = XMLNode_GetAttributeValue(techniqueNode, "blending"))
 	{
@@ -404,6 +1273,49 @@ bool Material_LoadTechnique(MaterialResource* resource, XMLNode* techniqueNode,
 		else if (!strcmp(blending, "default")) technique.blending = Shape::Blending_Default;
 	}
 
+	// Register shader keywords; the same keyword used by multiple techniques maps to the same bit
+
+	if (const char* keywords = XMLNode_GetAttributeValue(techniqueNode, "keywords"))
+	{
+		std::vector<std::string> keywordNames;
+		string_split(keywordNames, keywords);
+		for (std::vector<std::string>::iterator it = keywordNames.begin(); it != keywordNames.end(); ++it)
+		{
+			unsigned int index = 0;
+			while (index < resource->keywords.size() && resource->keywords[index] != *it)
+				index++;
+			if (index == resource->keywords.size())
+			{
+				if (index == MATERIAL_MAX_KEYWORDS)
+				{
+					Log::Error(string_format("Failed to load material %s technique %s, reason: too many shader keywords (max is %d)", resource->name.c_str(), technique.name.c_str(), MATERIAL_MAX_KEYWORDS));
+					return false;
+				}
+				resource->keywords.push_back(*it);
+			}
+			Assert(index < sizeof(technique.keywordMask) * 8);
+			technique.keywordMask |= 1u << index;
+		}
+	}
+
+	// Get frame constants used by the technique
+
+	if (const char* frameConstants = XMLNode_GetAttributeValue(techniqueNode, "frameConstants"))
+	{
+		std::vector<std::string> frameConstantNames;
+		string_split(frameConstantNames, frameConstants);
+		for (std::vector<std::string>::iterator it = frameConstantNames.begin(); it != frameConstantNames.end(); ++it)
+		{
+			const int frameConstant = FrameConstant_FromName(it->c_str());
+			if (frameConstant == -1)
+			{
+				Log::Error(string_format("Failed to load material %s technique %s, reason: unknown frame constant %s", resource->name.c_str(), technique.name.c_str(), it->c_str()));
+				return false;
+			}
+			technique.frameConstantMask |= 1u << frameConstant;
+		}
+	}
+
 	// Load shader program
 
 	const char* vsPath = NULL;
@@ -443,121 +1355,429 @@ bool Material_LoadTechnique(MaterialResource* resource, XMLNode* techniqueNode,
 		}
 	}
 
-	if (!vsPath || !fsPath)
+	if (!vsPath || !fsPath)
+	{
+		Log::Error(string_format("Failed to load material %s technique %s, reason: material doesn't specify both vertex and fragment shaders", resource->name.c_str(), technique.name.c_str()));
+		return false;
+	}
+
+	technique.vsPath = vsPath;
+	technique.vsEntry = vsEntry;
+	technique.fsPath = fsPath;
+	technique.fsEntry = fsEntry;
+
+	HotReload_AddFile("material", resource->name, vsPath);
+	HotReload_AddFile("material", resource->name, fsPath);
+	HotReload_AddFile("material", resource->name, std::string(vsPath) + SHADER_PREPROCESSED_SUFFIX);
+	HotReload_AddFile("material", resource->name, std::string(fsPath) + SHADER_PREPROCESSED_SUFFIX);
+
+	// Load shader source code (from job thread in case of asynchronous loading); compilation happens later on main thread
+
+	std::string sourceCode;
+	if (!Shader_GetSourceCode(vsPath, vsEntry, sourceCode) ||
+		!Shader_GetSourceCode(fsPath, fsEntry, sourceCode))
+	{
+		Log::Error(string_format("Failed to load material %s technique %s, reason: failed to load source code of vertex shader %s or fragment shader %s", resource->name.c_str(), technique.name.c_str(), vsPath, fsPath));
+		return false;
+	}
+
+	return true;
+}
+
+std::string Material_GetPath(MaterialResource* resource)
+{
+	return resource->name + ".material.xml";
+}
+
+bool Material_LoadFromNode(MaterialResource* resource, XMLNode* docNode)
+{
+	XMLNode* rootNode = docNode->GetFirstNode("material");
+	if (!rootNode)
+	{
+		Log::Error(string_format("Failed to load material %s, reason: root 'material' node not found", resource->name.c_str()));
+		return false;
+	}
+
+	// Load techniques
+
+	for (XMLNode* techniqueNode = XMLNode_GetFirstNode(rootNode, "technique"); techniqueNode; techniqueNode = XMLNode_GetNext(techniqueNode, "technique"))
+		if (!Material_LoadTechnique(resource, techniqueNode, vector_add(resource->techniques)))
+			return false;
+
+	// Load default material parameter values
+
+	// TODO
+
+	return true;
+}
+
+bool Material_Load(MaterialResource* resource)
+{
+	const std::string path = Material_GetPath(resource);
+
+	XMLDoc doc;
+	if (!doc.Load(path))
+	{
+		Log::Error(string_format("Failed to load material from %s", path.c_str()));
+		return false;
+	}
+
+	return Material_LoadFromNode(resource, doc.AsNode());
+}
+
+bool Material_SubmitShaderPrograms(MaterialResource* resource)
+{
+	// Submits all shader programs before waiting for any of them, so the driver can compile them in parallel
+
+	for (std::vector<MaterialTechnique>::iterator it = resource->techniques.begin(); it != resource->techniques.end(); ++it)
+	{
+		MaterialTechniqueVariant& baseVariant = vector_add(it->variants);
+		baseVariant.shaderProgram = ShaderProgram_Create(it->vsPath, it->vsEntry, it->fsPath, it->fsEntry, std::string(), it->frameConstantMask);
+		if (!baseVariant.shaderProgram)
+		{
+			Log::Error(string_format("Failed to load material %s technique %s, reason: failed to build shader program from vertex shader %s and fragment shader %s", resource->name.c_str(), it->name.c_str(), it->vsPath.c_str(), it->fsPath.c_str()));
+			return false;
+		}
+		baseVariant.state = ResourceState_Creating;
+	}
+
+	resource->shaderProgramsSubmitted = true;
+	return true;
+}
+
+bool Material_FinalizeVariant(MaterialResource* resource, MaterialTechnique& technique, MaterialTechniqueVariant& variant)
+{
+	if (!ShaderProgram_Finalize(variant.shaderProgram))
+	{
+		Log::Error(string_format("Failed to load material %s technique %s, reason: failed to build shader program %s", resource->name.c_str(), technique.name.c_str(), variant.shaderProgram->name.c_str()));
+		variant.state = ResourceState_AsyncError;
+		return false;
+	}
+
+	// Update material parameters from shader parameters
+
+	for (std::vector<ShaderParameter>::iterator it = variant.shaderProgram->parameters.begin(); it != variant.shaderProgram->parameters.end(); ++it)
+	{
+		int materialParameterIndex = -1;
+		for (unsigned int i = 0; i < resource->parameters.size(); i++)
+			if (resource->parameters[i].shaderParameterDescription->name == it->name)
+			{
+				MaterialParameter& materialParameter = resource->parameters[i];
+				if (*materialParameter.shaderParameterDescription != *static_cast<ShaderParameterDescription*>(&(*it)))
+				{
+					Log::Error(string_format("Shader parameter %s in material %s exists in at least 2 different setups - once as type %d count %d and now (in shader program %s) as type %d count %d",
+						it->name.c_str(), resource->name.c_str(),
+						materialParameter.shaderParameterDescription->type, materialParameter.shaderParameterDescription->count,
+						technique.name.c_str(),
+						it->type, it->count));
+					variant.materialParameterIndices.clear();
+					variant.state = ResourceState_AsyncError;
+					return false;
+				}
+
+				materialParameterIndex = i;
+				break;
+			}
+
+		if (materialParameterIndex == -1)
+			materialParameterIndex = Material_AddParameter(resource, &(*it));
+
+		variant.materialParameterIndices.push_back(materialParameterIndex);
+	}
+
+	variant.state = ResourceState_Created;
+	return true;
+}
+
+bool Material_FinalizeTechniques(MaterialResource* resource)
+{
+	for (std::vector<MaterialTechnique>::iterator it = resource->techniques.begin(); it != resource->techniques.end(); ++it)
+		if (!Material_FinalizeVariant(resource, *it, it->variants[0]))
+			return false;
+	return true;
+}
+
+void MaterialResource_DestroyShaderPrograms(MaterialResource* resource)
+{
+	for (std::vector<MaterialTechnique>::iterator it = resource->techniques.begin(); it != resource->techniques.end(); ++it)
+	{
+		for (std::vector<MaterialTechniqueVariant>::iterator variantIt = it->variants.begin(); variantIt != it->variants.end(); ++variantIt)
+			if (variantIt->shaderProgram)
+				ShaderProgram_Destroy(variantIt->shaderProgram);
+		it->variants.clear();
+	}
+}
+
+int MaterialTechnique_GetVariantIndex(MaterialResource* resource, MaterialTechnique* technique, unsigned int keywordMask)
+{
+	for (unsigned int i = 0; i < technique->variants.size(); i++)
+		if (technique->variants[i].keywordMask == keywordMask)
+			return i;
+
+	// Submit new variant for compilation; finalized by Material_GetCurrentVariant() once the driver is done with it
+
+	std::string keywords;
+	for (unsigned int i = 0; i < resource->keywords.size(); i++)
+		if (keywordMask & (1u << i))
+		{
+			if (!keywords.empty())
+				keywords += " ";
+			keywords += resource->keywords[i];
+		}
+
+	MaterialTechniqueVariant& variant = vector_add(technique->variants);
+	variant.keywordMask = keywordMask;
+	variant.shaderProgram = ShaderProgram_Create(technique->vsPath, technique->vsEntry, technique->fsPath, technique->fsEntry, keywords, technique->frameConstantMask);
+	if (variant.shaderProgram)
+		variant.state = ResourceState_Creating;
+	else
+	{
+		Log::Error(string_format("Failed to build material %s technique %s variant with keywords: %s", resource->name.c_str(), technique->name.c_str(), keywords.c_str()));
+		variant.state = ResourceState_AsyncError;
+	}
+
+	return technique->variants.size() - 1;
+}
+
+bool MaterialResource_CheckCreated(MaterialResource* resource)
+{
+	if (resource->state != ResourceState_Creating)
+		return resource->state == ResourceState_Created;
+
+	// Wait for the job to load material file and for the driver to compile all shader programs
+
+	if (!resource->shaderProgramsSubmitted)
+		return false;
+	for (std::vector<MaterialTechnique>::iterator it = resource->techniques.begin(); it != resource->techniques.end(); ++it)
+		if (!ShaderProgram_IsLinkComplete(it->variants[0].shaderProgram))
+			return false;
+
+	if (!Material_FinalizeTechniques(resource))
 	{
-		Log::Error(string_format("Failed to load material %s technique %s, reason: material doesn't specify both vertex and fragment shaders", resource->name.c_str(), technique.name.c_str()));
+		resource->state = ResourceState_AsyncError;
+		Log::Error(string_format("Material %s async loading failed", resource->name.c_str()));
 		return false;
 	}
 
-	technique.shaderProgram = ShaderProgram_Create(vsPath, vsEntry, fsPath, fsEntry);
-	if (!technique.shaderProgram)
+	resource->state = ResourceState_Created;
+	Log::Info(string_format("Material %s finished async loading", resource->name.c_str()));
+	return true;
+}
+
+MaterialPendingParameter& Material_AddPendingParameter(MaterialObj* material, StringId name, ShaderParameterDescription::Type type, int count)
+{
+	MaterialPendingParameter* pending = NULL;
+	for (std::vector<MaterialPendingParameter>::iterator it = material->pendingParameters.begin(); it != material->pendingParameters.end(); ++it)
+		if (it->name == name)
+		{
+			pending = &(*it);
+			break;
+		}
+	if (!pending)
 	{
-		Log::Error(string_format("Failed to load material %s technique %s, reason: failed to build shader program from vertex shader %s and fragment shader %s", resource->name.c_str(), technique.name.c_str(), vsPath, fsPath));
-		return false;
+		pending = &vector_add(material->pendingParameters);
+		pending->name = name;
 	}
+	else if (pending->type == ShaderParameterDescription::Type_Texture && pending->value.textureValue)
+		Texture_Destroy(pending->value.textureValue);
+
+	pending->type = type;
+	pending->count = count;
+	pending->value.textureValue = NULL;
+	pending->value.floatArrayValue.clear();
+	pending->value.numArrayElements = 0;
+	return *pending;
+}
 
-	// Update material parameters from shader parameters
+void Material_ReleasePendingParameters(MaterialObj* material)
+{
+	for (std::vector<MaterialPendingParameter>::iterator it = material->pendingParameters.begin(); it != material->pendingParameters.end(); ++it)
+		if (it->type == ShaderParameterDescription::Type_Texture && it->value.textureValue)
+			Texture_Destroy(it->value.textureValue);
+	material->pendingParameters.clear();
+}
 
-	for (std::vector<ShaderParameter>::iterator it = technique.shaderProgram->parameters.begin(); it != technique.shaderProgram->parameters.end(); ++it)
-	{
-		int materialParameterIndex = -1;
-		for (unsigned int i = 0; i < resource->parameters.size(); i++)
-			if (resource->parameters[i].shaderParameterDescription->name == it->name)
-			{
-				MaterialParameter& materialParameter = resource->parameters[i];
-				if (*materialParameter.shaderParameterDescription != *static_cast<ShaderParameterDescription*>(&(*it)))
-				{
-					Log::Error(string_format("Shader parameter %s in material %s exists in at least 2 different setups - once as type %d count %d and now (in shader program %s) as type %d count %d",
-						it->name.c_str(), resource->name.c_str(),
-						materialParameter.shaderParameterDescription->type, materialParameter.shaderParameterDescription->count,
-						technique.name.c_str(),
-						it->type, it->count));
-					return false;
-				}
+void Material_ApplyPendingParameters(MaterialObj* material)
+{
+	for (std::vector<MaterialPendingParameter>::iterator it = material->pendingParameters.begin(); it != material->pendingParameters.end(); ++it)
+		switch (it->type)
+		{
+		case ShaderParameterDescription::Type_Int: Material_SetIntParameter(material, it->name, it->value.intValue, it->count); break;
+		case ShaderParameterDescription::Type_Float:
+			if (it->value.numArrayElements)
+				Material_SetFloatArrayParameter(material, it->name, &it->value.floatArrayValue[0], it->count, it->value.numArrayElements);
+			else
+				Material_SetFloatParameter(material, it->name, it->value.floatValue, it->count);
+			break;
+		case ShaderParameterDescription::Type_Texture: Material_SetTextureParameter(material, it->name, it->value.textureValue, it->value.sampler); break;
+		default: break;
+		}
+	Material_ReleasePendingParameters(material);
+}
 
-				materialParameterIndex = i;
-				break;
-			}
+bool Material_CheckCreated(MaterialObj* material)
+{
+	if (material->isInitialized)
+		return true;
+	if (!MaterialResource_CheckCreated(material->resource))
+		return false;
 
-		if (materialParameterIndex == -1)
-			materialParameterIndex = Material_AddParameter(resource, &(*it));
+	material->isInitialized = true;
+
+	if (material->pendingTechniqueName.IsEmpty() || Material_GetTechniqueIndex(material, material->pendingTechniqueName) == -1)
+		Material_SetTechnique(material, 0);
+	else
+		Material_SetTechnique(material, material->pendingTechniqueName);
+	material->pendingTechniqueName = StringId();
 
-		technique.materialParameterIndices.push_back(materialParameterIndex);
+	if (!material->pendingKeywords.empty())
+	{
+		Material_SetKeywords(material, material->pendingKeywords);
+		material->pendingKeywords.clear();
 	}
 
+	Material_ApplyPendingParameters(material);
 	return true;
 }
 
+void MaterialResource_AddInstance(MaterialResource* resource, MaterialObj* material)
+{
+	material->nextInstance = resource->firstInstance;
+	if (resource->firstInstance)
+		resource->firstInstance->prevInstance = material;
+	resource->firstInstance = material;
+}
+
+void MaterialResource_RemoveInstance(MaterialResource* resource, MaterialObj* material)
+{
+	if (material->prevInstance)
+		material->prevInstance->nextInstance = material->nextInstance;
+	else
+		resource->firstInstance = material->nextInstance;
+	if (material->nextInstance)
+		material->nextInstance->prevInstance = material->prevInstance;
+}
+
 MaterialObj* Material_Clone(MaterialObj* other)
 {
 	MaterialObj* material = new MaterialObj();
 	material->resource = other->resource;
 	Resource_IncRefCount(material->resource);
-	Material_SetTechnique(material, 0);
-	material->screenSizeParamIndex = other->screenSizeParamIndex;
-	material->projectionScaleParamIndex = other->projectionScaleParamIndex;
+	MaterialResource_AddInstance(material->resource, material);
+	if (other->isInitialized)
+	{
+		material->isInitialized = true;
+		Material_SetTechnique(material, 0);
+	}
+	else
+		Material_CheckCreated(material);
 	return material;
 }
 
+struct MaterialJobData
+{
+	MaterialResource* resource;
+	bool success;
+};
 
-MaterialObj* Material_Create(const std::string& name, bool immediate)
+void Material_ReadFunc(void*& data, size_t size, void* userData)
 {
-	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	MaterialJobData* jobData = (MaterialJobData*) userData;
 
-	MaterialResource* resource = static_cast<MaterialResource*>(Resource_Find("material", name));
-	if (!resource)
+	// Parse in place (or use cooked material if up to date); document takes ownership of the data
+
+	XMLDocObj* doc = XMLDoc_LoadFromFileData(Material_GetPath(jobData->resource), (char*) data, size);
+	data = NULL;
+	if (!doc)
+	{
+		Log::Error(string_format("Failed to load material from %s", Material_GetPath(jobData->resource).c_str()));
+		return;
+	}
+
+	jobData->success = Material_LoadFromNode(jobData->resource, XMLDoc_AsNode(doc));
+	XMLDoc_Destroy(doc);
+}
+
+void Material_DoneFunc(bool canceled, void* userData)
+{
+	MaterialJobData* jobData = (MaterialJobData*) userData;
+	MaterialResource* resource = jobData->resource;
+	resource->jobID = 0;
+
+	if (canceled)
+	{
+		resource->state = ResourceState_AsyncError;
+		Log::Info(string_format("Material %s async loading was canceled", resource->name.c_str()));
+	}
+	else if (!jobData->success || !Material_SubmitShaderPrograms(resource))
 	{
-		const std::string path = name + ".material.xml";
+		resource->state = ResourceState_AsyncError;
+		Log::Error(string_format("Material %s async loading failed", resource->name.c_str()));
+	}
 
-		XMLDoc doc;
-		if (!doc.Load(path))
-		{
-			Log::Error(string_format("Failed to load material from %s", path.c_str()));
-			return NULL;
-		}
+	// Shader programs are finalized by MaterialResource_CheckCreated() once the driver is done with them
 
-		XMLNode* rootNode = doc.AsNode()->GetFirstNode("material");
-		if (!rootNode)
-		{
-			Log::Error(string_format("Failed to load material %s, reason: root 'material' node not found", name.c_str()));
-			return NULL;
-		}
+	delete jobData;
+}
 
-		// Create resource
+void Material_ReleaseTextures(MaterialBase* material);
 
+MaterialObj* Material_Create(const std::string& name, bool immediate)
+{
+	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	LoadGroup_OnResourceRequested(LoadGroupItemType_Material, name);
+
+	MaterialResource* resource = static_cast<MaterialResource*>(Resource_FindAndIncRefCount("material", name));
+	if (!resource)
+	{
 		resource = new MaterialResource();
 		resource->name = name;
-		resource->state = ResourceState_Created;
 
-		// Load techniques
-
-		for (XMLNode* techniqueNode = XMLNode_GetFirstNode(rootNode, "technique"); techniqueNode; techniqueNode = XMLNode_GetNext(techniqueNode, "technique"))
-			if (!Material_LoadTechnique(resource, techniqueNode, vector_add(resource->techniques)))
+		if (immediate)
+		{
+			if (!Material_Load(resource) ||
+				!Material_SubmitShaderPrograms(resource) ||
+				!Material_FinalizeTechniques(resource))
 			{
-				for (std::vector<MaterialTechnique>::iterator it = resource->techniques.begin(); it != resource->techniques.end(); ++it)
-					if (it->shaderProgram)
-						ShaderProgram_Destroy(it->shaderProgram);
-
+				MaterialResource_DestroyShaderPrograms(resource);
+				delete resource;
 				return NULL;
 			}
+			resource->state = ResourceState_Created;
+		}
+		else
+			resource->state = ResourceState_Creating;
+
+		// Register before kicking off asynchronous load, so that concurrent requests share it
 
-		// Load default material parameter values
+		MaterialResource* registered = static_cast<MaterialResource*>(Resource_FindOrRegister(resource));
+		if (registered != resource)
+		{
+			Material_ReleaseTextures(resource);
+			MaterialResource_DestroyShaderPrograms(resource);
+			delete resource;
+			resource = registered;
+		}
+		else
+		{
+			if (!immediate)
+			{
+				MaterialJobData* jobData = new MaterialJobData();
+				jobData->resource = resource;
+				jobData->success = false;
+				resource->jobID = File_ReadAsync(Material_GetPath(resource), NULL, 0, 0, Material_ReadFunc, Material_DoneFunc, jobData);
+			}
 
-		// TODO
+			HotReload_AddFile("material", name, Material_GetPath(resource));
+		}
 	}
-	Resource_IncRefCount(resource);
 
 	// Create material
 
 	MaterialObj* material = new MaterialObj();
 	material->resource = resource;
-	Material_SetTechnique(material, 0);
-
-	// Get screen size parameter index
-
-	material->screenSizeParamIndex = Material_GetParameterIndex(material, "ScreenSize");
-	material->projectionScaleParamIndex = Material_GetParameterIndex(material, "ProjectionScale");
-
+	MaterialResource_AddInstance(resource, material);
+	Material_CheckCreated(material);
 	return material;
 }
 
@@ -574,23 +1794,21 @@ void Material_ReleaseTextures(MaterialBase* material)
 void Material_Destroy(MaterialObj* material)
 {
 	Material_ReleaseTextures(material);
+	Material_ReleasePendingParameters(material);
+	MaterialResource_RemoveInstance(material->resource, material);
 	if (!Resource_DecRefCount(material->resource))
 	{
-		if (material->resource->state == ResourceState_Creating)
-		{
-			Log::Warn(string_format("Attempted to destroy the material %s that is still being loaded - waiting for all asynchronous jobs to complete", material->resource->name.c_str()));
-			Jobs::WaitForAllJobs();
-		}
+		if (material->resource->jobID)
+			Jobs::CancelJob(material->resource->jobID);
 
 		Material_ReleaseTextures(material->resource);
-		for (std::vector<MaterialTechnique>::iterator it = material->resource->techniques.begin(); it != material->resource->techniques.end(); ++it)
-			ShaderProgram_Destroy(it->shaderProgram);
+		MaterialResource_DestroyShaderPrograms(material->resource);
 		delete material->resource;
 	}
 	delete material;
 }
 
-MaterialParameter* Material_GetParameter(MaterialBase* material, const std::string& name)
+MaterialParameter* Material_GetParameter(MaterialBase* material, StringId name)
 {
 	for (std::vector<MaterialParameter>::iterator it = material->parameters.begin(); it != material->parameters.end(); ++it)
 		if (it->shaderParameterDescription->name == name)
@@ -598,18 +1816,26 @@ MaterialParameter* Material_GetParameter(MaterialBase* material, const std::stri
 	return NULL;
 }
 
-int Material_GetParameterIndex(MaterialObj* material, const std::string& name)
+void Material_CopyResourceParameters(MaterialObj* material)
 {
-	if (material->parameters.size() == 0)
+	// Copies resource parameters not yet present in the instance (new ones may be added to the resource when shader program variants get compiled)
+
+	for (unsigned int i = material->parameters.size(); i < material->resource->parameters.size(); i++)
 	{
-		material->parameters = material->resource->parameters;
-		for (unsigned int i = 0; i < material->parameters.size(); i++)
-			if (material->parameters[i].shaderParameterDescription->type == ShaderParameterDescription::Type_Texture &&
-				material->parameters[i].textureValue)
-			{
-				Resource_IncRefCount(material->parameters[i].textureValue);
-			}
+		const MaterialParameter& parameter = material->resource->parameters[i];
+		material->parameters.push_back(parameter);
+		if (parameter.shaderParameterDescription->type == ShaderParameterDescription::Type_Texture && parameter.textureValue)
+			Resource_IncRefCount(parameter.textureValue);
 	}
+}
+
+int Material_GetParameterIndex(MaterialObj* material, StringId name)
+{
+	if (!Material_CheckCreated(material))
+		return -1;
+
+	if (material->parameters.size() < material->resource->parameters.size())
+		Material_CopyResourceParameters(material);
 
 	for (unsigned int i = 0; i < material->parameters.size(); i++)
 		if (material->parameters[i].shaderParameterDescription->name == name)
@@ -618,8 +1844,15 @@ int Material_GetParameterIndex(MaterialObj* material, const std::string& name)
 	return -1;
 }
 
-void Material_SetIntParameter(MaterialObj* material, const std::string& name, const int* value, int count)
+void Material_SetIntParameter(MaterialObj* material, StringId name, const int* value, int count)
 {
+	if (!Material_CheckCreated(material))
+	{
+		MaterialPendingParameter& pending = Material_AddPendingParameter(material, name, ShaderParameterDescription::Type_Int, count);
+		memcpy(pending.value.intValue, value, sizeof(int) * min(count, 4));
+		return;
+	}
+
 	const int index = Material_GetParameterIndex(material, name);
 	if (index != -1)
 		Material_SetIntParameter(material, index, value, count);
@@ -648,8 +1881,15 @@ void Material_SetIntParameter(MaterialObj* material, int index, const int* value
 	memcpy(parameter.intValue, value, sizeof(int) * count);
 }
 
-void Material_SetFloatParameter(MaterialObj* material, const std::string& name, const float* value, int count)
+void Material_SetFloatParameter(MaterialObj* material, StringId name, const float* value, int count)
 {
+	if (!Material_CheckCreated(material))
+	{
+		MaterialPendingParameter& pending = Material_AddPendingParameter(material, name, ShaderParameterDescription::Type_Float, count);
+		memcpy(pending.value.floatValue, value, sizeof(float) * min(count, 4));
+		return;
+	}
+
 	const int index = Material_GetParameterIndex(material, name);
 	if (index != -1)
 		Material_SetFloatParameter(material, index, value, count);
@@ -674,12 +1914,79 @@ void Material_SetFloatParameter(MaterialObj* material, int index, const float* v
 		Log::Warn(string_format("Failed to set float parameter %s for material %s, reason: parameter count mismatch", parameter.shaderParameterDescription->name.c_str(), material->resource->name.c_str()));
 		return;
 	}
+	if (parameter.shaderParameterDescription->arraySize != 1)
+	{
+		Log::Warn(string_format("Failed to set float parameter %s for material %s, reason: parameter is an array", parameter.shaderParameterDescription->name.c_str(), material->resource->name.c_str()));
+		return;
+	}
 
 	memcpy(parameter.floatValue, value, sizeof(float) * count);
 }
 
-void Material_SetTextureParameter(MaterialObj* material, const std::string& name, TextureObj* value, const Sampler& sampler)
+void Material_SetFloatArrayParameter(MaterialObj* material, StringId name, const float* value, int count, int numElements)
+{
+	if (!Material_CheckCreated(material))
+	{
+		MaterialPendingParameter& pending = Material_AddPendingParameter(material, name, ShaderParameterDescription::Type_Float, count);
+		pending.value.floatArrayValue.assign(value, value + count * numElements);
+		pending.value.numArrayElements = numElements;
+		return;
+	}
+
+	const int index = Material_GetParameterIndex(material, name);
+	if (index != -1)
+		Material_SetFloatArrayParameter(material, index, value, count, numElements);
+}
+
+void Material_SetFloatArrayParameter(MaterialObj* material, int index, const float* value, int count, int numElements)
+{
+	if (index >= (int) material->parameters.size())
+	{
+		Log::Warn(string_format("Failed to set float array parameter for material %s, reason: invalid parameter index", material->resource->name.c_str()));
+		return;
+	}
+
+	MaterialParameter& parameter = material->parameters[index];
+	if (parameter.shaderParameterDescription->type != ShaderParameter::Type_Float)
+	{
+		Log::Warn(string_format("Failed to set float array parameter %s for material %s, reason: parameter type mismatch", parameter.shaderParameterDescription->name.c_str(), material->resource->name.c_str()));
+		return;
+	}
+	if (parameter.shaderParameterDescription->count != count)
+	{
+		Log::Warn(string_format("Failed to set float array parameter %s for material %s, reason: parameter count mismatch", parameter.shaderParameterDescription->name.c_str(), material->resource->name.c_str()));
+		return;
+	}
+	if (parameter.shaderParameterDescription->arraySize < numElements)
+	{
+		Log::Warn(string_format("Failed to set float array parameter %s for material %s, reason: %d elements exceed array size %d", parameter.shaderParameterDescription->name.c_str(), material->resource->name.c_str(), numElements, parameter.shaderParameterDescription->arraySize));
+		return;
+	}
+
+	// Non-array parameter may also be set this way (as a single element array)
+
+	if (parameter.shaderParameterDescription->arraySize == 1)
+	{
+		memcpy(parameter.floatValue, value, sizeof(float) * count);
+		return;
+	}
+
+	memcpy(&parameter.floatArrayValue[0], value, sizeof(float) * count * numElements);
+	parameter.numArrayElements = numElements;
+}
+
+void Material_SetTextureParameter(MaterialObj* material, StringId name, TextureObj* value, const Sampler& sampler)
 {
+	if (!Material_CheckCreated(material))
+	{
+		MaterialPendingParameter& pending = Material_AddPendingParameter(material, name, ShaderParameterDescription::Type_Texture, 1);
+		pending.value.textureValue = value;
+		pending.value.sampler = sampler;
+		if (value)
+			Resource_IncRefCount(value);
+		return;
+	}
+
 	const int index = Material_GetParameterIndex(material, name);
 	if (index != -1)
 		Material_SetTextureParameter(material, index, value, sampler);
@@ -726,28 +2033,34 @@ void Material_CommitParameter(MaterialParameter* materialParameter, ShaderParame
 		}
 		break;
 	case ShaderParameter::Type_Float:
+	{
+		// Arrays are uploaded with a single call covering all set elements
+
+		const GLfloat* value = (const GLfloat*) materialParameter->floatValue;
+		GLsizei numElements = 1;
+		if (shaderParameter->arraySize != 1)
+		{
+			numElements = materialParameter->numArrayElements;
+			if (!numElements)
+				break;
+			value = &materialParameter->floatArrayValue[0];
+		}
+
 		switch (shaderParameter->count)
 		{
-			case 1: GL(glUniform1fv(shaderParameter->location, 1, (const GLfloat*) materialParameter->floatValue)); break;
-			case 2: GL(glUniform2fv(shaderParameter->location, 1, (const GLfloat*) materialParameter->floatValue)); break;
-			case 3: GL(glUniform3fv(shaderParameter->location, 1, (const GLfloat*) materialParameter->floatValue)); break;
-			case 4: GL(glUniform4fv(shaderParameter->location, 1, (const GLfloat*) materialParameter->floatValue)); break;
+			case 1: GL(glUniform1fv(shaderParameter->location, numElements, value)); break;
+			case 2: GL(glUniform2fv(shaderParameter->location, numElements, value)); break;
+			case 3: GL(glUniform3fv(shaderParameter->location, numElements, value)); break;
+			case 4: GL(glUniform4fv(shaderParameter->location, numElements, value)); break;
 		}
 		break;
+	}
 	case ShaderParameter::Type_Texture:
 		g_maxTextureUnitSet = max(g_maxTextureUnitSet, shaderParameter->location);
 		GL(glActiveTexture(GL_TEXTURE0 + shaderParameter->location));
 		glEnableTexture2D();
 		GL(glBindTexture(GL_TEXTURE_2D, materialParameter->textureValue ? materialParameter->textureValue->handle : 0));
-
-		GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, Sampler_WrapMode_ToOpenGL(materialParameter->sampler.uWrapMode)));
-		GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, Sampler_WrapMode_ToOpenGL(materialParameter->sampler.vWrapMode)));
-		GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, materialParameter->sampler.minFilterLinear ? GL_NEAREST : GL_NEAREST));
-		GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, materialParameter->sampler.magFilterLinear ? GL_LINEAR : GL_NEAREST));
-#ifndef OPENGL_ES
-		GL(glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, (const float*) &materialParameter->sampler.borderColor));
-#endif
-
+		Sampler_Apply(shaderParameter->location, materialParameter->textureValue, materialParameter->sampler);
 		break;
     default:
         Assert(!"Unsupported shader parameter type");
@@ -755,25 +2068,38 @@ void Material_CommitParameter(MaterialParameter* materialParameter, ShaderParame
 	}
 }
 
+MaterialTechniqueVariant* Material_GetCurrentVariant(MaterialObj* material)
+{
+	MaterialTechnique* technique = material->currentTechnique;
+	if (material->currentVariantIndex == -1)
+		material->currentVariantIndex = MaterialTechnique_GetVariantIndex(material->resource, technique, material->keywordMask & technique->keywordMask);
+
+	// Use base variant until requested variant gets compiled (or if it failed to compile)
+
+	MaterialTechniqueVariant* variant = &technique->variants[material->currentVariantIndex];
+	if (variant->state == ResourceState_Creating && ShaderProgram_IsLinkComplete(variant->shaderProgram))
+		Material_FinalizeVariant(material->resource, *technique, *variant);
+	return variant->state == ResourceState_Created ? variant : &technique->variants[0];
+}
+
 void Material_Draw(MaterialObj* material, const Shape::DrawParams* params)
 {
+	// Skip drawing until (asynchronously loaded) material is ready
+
+	if (!Material_CheckCreated(material))
+		return;
+
 	if (params->geometry.numVerts == 0)
 	{
 		Log::Error(string_format("Failed to draw using material %s, reason: zero number of verts to draw", material->resource->name.c_str()));
 		return;
 	}
 
-	// Set built-in parameters
-
-	if (material->screenSizeParamIndex != -1)
-		Material_SetFloatParameter(material, material->screenSizeParamIndex, App_GetScreenSizeMaterialParam(), 4);
-	if (material->projectionScaleParamIndex != -1)
-		Material_SetFloatParameter(material, material->projectionScaleParamIndex, App_GetProjectionScaleMaterialParam(), 4);
-
-	// Get technique and program
+	// Get technique variant and program
 
 	MaterialTechnique* technique = material->currentTechnique;
-	ShaderProgram* program = technique->shaderProgram;
+	MaterialTechniqueVariant* variant = Material_GetCurrentVariant(material);
+	ShaderProgram* program = variant->shaderProgram;
 
 	// Bind vertex data
 
@@ -832,14 +2158,22 @@ void Material_Draw(MaterialObj* material, const Shape::DrawParams* params)
 
 	GL(glUseProgram(program->handle));
 
+	// Commit frame constants (unless up to date)
+
+	if (program->frameConstantsVersion != g_frameConstantsVersion)
+		ShaderProgram_CommitFrameConstants(program);
+
 	// Commit parameters
 
+	if (material->parameters.size() && material->parameters.size() < material->resource->parameters.size())
+		Material_CopyResourceParameters(material);
+
 	g_maxTextureUnitSet = -1;
-	for (unsigned int i = 0; i < technique->materialParameterIndices.size(); i++)
+	for (unsigned int i = 0; i < variant->materialParameterIndices.size(); i++)
 	{
-		const int index = technique->materialParameterIndices[i];
+		const int index = variant->materialParameterIndices[i];
 		MaterialParameter* parameter = &(material->parameters.size() ? material->parameters[index] : material->resource->parameters[index]);
-		Material_CommitParameter(parameter, &technique->shaderProgram->parameters[i]);
+		Material_CommitParameter(parameter, &program->parameters[i]);
 	}
 
 	// Set blending
@@ -888,7 +2222,7 @@ void Material_Draw(MaterialObj* material, const Shape::DrawParams* params)
 	}
 }
 
-int Material_GetTechniqueIndex(MaterialObj* material, const std::string& name)
+int Material_GetTechniqueIndex(MaterialObj* material, StringId name)
 {
 	for (unsigned int i = 0; i < material->resource->techniques.size(); i++)
 		if (material->resource->techniques[i].name == name)
@@ -896,8 +2230,14 @@ int Material_GetTechniqueIndex(MaterialObj* material, const std::string& name)
 	return -1;
 }
 
-void Material_SetTechnique(MaterialObj* material, const std::string& name)
+void Material_SetTechnique(MaterialObj* material, StringId name)
 {
+	if (!Material_CheckCreated(material))
+	{
+		material->pendingTechniqueName = name;
+		return;
+	}
+
 	const int index = Material_GetTechniqueIndex(material, name);
 	if (index == -1)
 	{
@@ -915,6 +2255,160 @@ void Material_SetTechnique(MaterialObj* material, int index)
 		return;
 	}
 	material->currentTechnique = &material->resource->techniques[index];
+	material->currentVariantIndex = -1;
+}
+
+unsigned int Material_GetKeywordMask(MaterialObj* material, const std::string& keywords)
+{
+	if (!Material_CheckCreated(material))
+		return 0;
+
+	std::vector<std::string> keywordNames;
+	string_split(keywordNames, keywords);
+
+	unsigned int mask = 0;
+	for (std::vector<std::string>::iterator it = keywordNames.begin(); it != keywordNames.end(); ++it)
+	{
+		unsigned int index = 0;
+		while (index < material->resource->keywords.size() && material->resource->keywords[index] != *it)
+			index++;
+		if (index == material->resource->keywords.size())
+			Log::Warn(string_format("Shader keyword %s not declared by any technique of material %s", it->c_str(), material->resource->name.c_str()));
+		else
+			mask |= 1u << index;
+	}
+	return mask;
+}
+
+void Material_SetKeywordMask(MaterialObj* material, unsigned int mask)
+{
+	if (material->keywordMask != mask)
+	{
+		material->keywordMask = mask;
+		material->currentVariantIndex = -1;
+	}
+}
+
+void Material_SetKeywords(MaterialObj* material, const std::string& keywords)
+{
+	if (!Material_CheckCreated(material))
+	{
+		material->pendingKeywords = keywords;
+		return;
+	}
+
+	Material_SetKeywordMask(material, Material_GetKeywordMask(material, keywords));
+}
+
+// Hot reload
+
+void Material_Uninitialize(MaterialObj* material)
+{
+	// Turn instance state into pending state, so that it gets re-applied to the new version of the material
+
+	material->pendingTechniqueName = material->currentTechnique ? material->currentTechnique->name : StringId();
+
+	material->pendingKeywords.clear();
+	for (unsigned int i = 0; i < material->resource->keywords.size(); i++)
+		if (material->keywordMask & (1u << i))
+		{
+			if (!material->pendingKeywords.empty())
+				material->pendingKeywords += " ";
+			material->pendingKeywords += material->resource->keywords[i];
+		}
+
+	for (std::vector<MaterialParameter>::iterator it = material->parameters.begin(); it != material->parameters.end(); ++it)
+	{
+		const ShaderParameterDescription* description = it->shaderParameterDescription;
+		if (description->type == ShaderParameterDescription::Type_Float && description->arraySize != 1 && !it->numArrayElements)
+			continue;
+
+		MaterialPendingParameter& pending = Material_AddPendingParameter(material, description->name, description->type, description->count);
+		if (description->type == ShaderParameterDescription::Type_Texture)
+		{
+			pending.value.textureValue = it->textureValue; // Moves texture reference
+			pending.value.sampler = it->sampler;
+			it->textureValue = NULL;
+		}
+		else
+		{
+			memcpy(pending.value.intValue, it->intValue, sizeof(it->intValue));
+			pending.value.floatArrayValue = it->floatArrayValue;
+			pending.value.numArrayElements = it->numArrayElements;
+		}
+	}
+
+	material->parameters.clear();
+	material->currentTechnique = NULL;
+	material->keywordMask = 0;
+	material->currentVariantIndex = -1;
+	material->isInitialized = false;
+}
+
+void Material_PrepareReload()
+{
+	ShaderSourceCache_Clear();
+}
+
+void* Material_BeginReload(Resource* resource)
+{
+	MaterialResource* material = static_cast<MaterialResource*>(resource);
+
+	// Make sure new version doesn't pick up existing shader programs and shaders
+
+	for (std::vector<MaterialTechnique>::iterator it = material->techniques.begin(); it != material->techniques.end(); ++it)
+		for (std::vector<MaterialTechniqueVariant>::iterator variantIt = it->variants.begin(); variantIt != it->variants.end(); ++variantIt)
+			if (ShaderProgram* program = variantIt->shaderProgram)
+			{
+				Resource_Unregister(program);
+				if (program->vs)
+					Resource_Unregister(program->vs);
+				if (program->fs)
+					Resource_Unregister(program->fs);
+			}
+
+	// Load new version into a separate, unregistered material resource
+
+	MaterialResource* shadow = new MaterialResource();
+	shadow->name = material->name;
+	shadow->state = ResourceState_Creating;
+
+	MaterialJobData* jobData = new MaterialJobData();
+	jobData->resource = shadow;
+	jobData->success = false;
+	shadow->jobID = File_ReadAsync(Material_GetPath(shadow), NULL, 0, 0, Material_ReadFunc, Material_DoneFunc, jobData);
+	return shadow;
+}
+
+bool Material_UpdateReload(void* context, Resource* resource)
+{
+	MaterialResource* shadow = (MaterialResource*) context;
+	if (shadow->jobID || (!MaterialResource_CheckCreated(shadow) && shadow->state == ResourceState_Creating))
+		return false;
+
+	// Swap material data and re-initialize all instances; old data gets destroyed together with the shadow
+
+	MaterialResource* material = static_cast<MaterialResource*>(resource);
+	if (material && shadow->state == ResourceState_Created)
+	{
+		for (MaterialObj* instance = material->firstInstance; instance; instance = instance->nextInstance)
+			if (instance->isInitialized)
+				Material_Uninitialize(instance);
+
+		std::swap(material->techniques, shadow->techniques);
+		std::swap(material->keywords, shadow->keywords);
+		std::swap(material->parameters, shadow->parameters);
+
+		for (MaterialObj* instance = material->firstInstance; instance; instance = instance->nextInstance)
+			Material_CheckCreated(instance);
+	}
+	else if (material)
+		Log::Error(string_format("Failed to reload material %s; keeping previous version", material->name.c_str()));
+
+	Material_ReleaseTextures(shadow);
+	MaterialResource_DestroyShaderPrograms(shadow);
+	delete shadow;
+	return true;
 }
 
 };
@@ -33,4 +33,22 @@ GL_PROC(PFNGLCHECKFRAMEBUFFERSTATUSEXTPROC, glCheckFramebufferStatusEXT)
 GL_PROC(PFNGLFRAMEBUFFERTEXTURE2DEXTPROC, glFramebufferTexture2DEXT)
 GL_PROC(PFNGLDRAWBUFFERSPROC, glDrawBuffers)
 GL_PROC(PFNGLENABLEVERTEXATTRIBARRAYARBPROC, glEnableVertexAttribArrayARB)
-GL_PROC(PFNGLVERTEXATTRIBPOINTERARBPROC, glVertexAttribPointerARB)
\ No newline at end of file
+GL_PROC(PFNGLVERTEXATTRIBPOINTERARBPROC, glVertexAttribPointerARB)
+GL_PROC(PFNGLGETPROGRAMBINARYPROC, glGetProgramBinary)
+GL_PROC(PFNGLPROGRAMBINARYPROC, glProgramBinary)
+GL_PROC(PFNGLPROGRAMPARAMETERIPROC, glProgramParameteri)
+GL_PROC(PFNGLGENBUFFERSPROC, glGenBuffers)
+GL_PROC(PFNGLDELETEBUFFERSPROC, glDeleteBuffers)
+GL_PROC(PFNGLBINDBUFFERPROC, glBindBuffer)
+GL_PROC(PFNGLBUFFERDATAPROC, glBufferData)
+GL_PROC(PFNGLBUFFERSUBDATAPROC, glBufferSubData)
+GL_PROC(PFNGLBINDBUFFERBASEPROC, glBindBufferBase)
+GL_PROC(PFNGLGETUNIFORMBLOCKINDEXPROC, glGetUniformBlockIndex)
+GL_PROC(PFNGLUNIFORMBLOCKBINDINGPROC, glUniformBlockBinding)
+GL_PROC(PFNGLGENERATEMIPMAPEXTPROC, glGenerateMipmapEXT)
+GL_PROC(PFNGLGENSAMPLERSPROC, glGenSamplers)
+GL_PROC(PFNGLDELETESAMPLERSPROC, glDeleteSamplers)
+GL_PROC(PFNGLBINDSAMPLERPROC, glBindSampler)
+GL_PROC(PFNGLSAMPLERPARAMETERIPROC, glSamplerParameteri)
+GL_PROC(PFNGLSAMPLERPARAMETERFPROC, glSamplerParameterf)
+GL_PROC(PFNGLSAMPLERPARAMETERFVPROC, glSamplerParameterfv)
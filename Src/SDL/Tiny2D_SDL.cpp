@@ -13,7 +13,11 @@
 	#define GL_PROC(type, func) type func = NULL;
 	#include "../OpenGL/Tiny2D_OpenGLProcedures.h"
 	#undef GL_PROC
+#else
+	PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOESProc = NULL;
+	PFNGLPROGRAMBINARYOESPROC glProgramBinaryOESProc = NULL;
 #endif
+PFNTINY2DMAXSHADERCOMPILERTHREADSPROC glMaxShaderCompilerThreadsProc = NULL;
 
 void App_InitGLProcedures()
 {
@@ -21,7 +25,13 @@ void App_InitGLProcedures()
 	#define GL_PROC(type, func) func = (type) SDL_GL_GetProcAddress(#func);
 	#include "../OpenGL/Tiny2D_OpenGLProcedures.h"
 	#undef GL_PROC
+#else
+	glGetProgramBinaryOESProc = (PFNGLGETPROGRAMBINARYOESPROC) SDL_GL_GetProcAddress("glGetProgramBinaryOES");
+	glProgramBinaryOESProc = (PFNGLPROGRAMBINARYOESPROC) SDL_GL_GetProcAddress("glProgramBinaryOES");
 #endif
+	glMaxShaderCompilerThreadsProc = (PFNTINY2DMAXSHADERCOMPILERTHREADSPROC) SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsKHR");
+	if (!glMaxShaderCompilerThreadsProc)
+		glMaxShaderCompilerThreadsProc = (PFNTINY2DMAXSHADERCOMPILERTHREADSPROC) SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsARB");
 }
 namespace Tiny2D
 {
@@ -50,6 +60,11 @@ void Sound_OnMusicFinished();
 
 void Jobs_Init();
 void Jobs_Deinit();
+void AsyncReads_Init();
+void AsyncReads_Deinit();
+int SDLCALL RW_CloseOwnedMemory(SDL_RWops* rw);
+
+extern SDL_mutex* g_ttfMutex;
 
 bool operator == (const App::DisplayMode& a, const App::DisplayMode& b)
 {
@@ -187,9 +202,164 @@ bool App::ModifyDisplaySettings(const App::DisplaySettings& settings)
 	return true;
 }
 
+// Startup tasks (initialization that doesn't require OpenGL context; runs on job threads while window and OpenGL context are being created)
+
+struct StartupTasks
+{
+	Jobs::JobID audioJobID;
+	std::string audioError;
+
+	Jobs::JobID fontsJobID;
+	bool fontsInitialized;
+	std::string fontsError;
+
+	Jobs::JobID localizationJobID;
+	std::vector<std::string> localizationSetNames;
+	std::vector<LocalizationSet> localizationSets;
+
+	int defaultResourcesPhase;
+};
+
+StartupTasks g_startupTasks;
+
+void StartupTasks_OpenAudio(void*)
+{
+	const int phase = StartupProfiler_BeginPhase("Open audio device");
+	for (g_numAudioChannels = MAX_AUDIO_CHANNELS; g_numAudioChannels >= 1; g_numAudioChannels--)
+		if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, g_numAudioChannels, 4096) >= 0)
+			break;
+	if (g_numAudioChannels == 0)
+		g_startupTasks.audioError = SDL_GetError();
+	StartupProfiler_EndPhase(phase);
+}
+
+void StartupTasks_OpenAudioDone(bool, void*)
+{
+	if (g_numAudioChannels == 0)
+		return;
+	Mix_ChannelFinished(Sound_OnChannelFinished);
+	Mix_HookMusicFinished(Sound_OnMusicFinished);
+}
+
+void StartupTasks_InitFonts(void*)
+{
+	const int phase = StartupProfiler_BeginPhase("Initialize TTF");
+	g_startupTasks.fontsInitialized = TTF_Init() >= 0;
+	if (!g_startupTasks.fontsInitialized)
+		g_startupTasks.fontsError = SDL_GetError();
+	StartupProfiler_EndPhase(phase);
+}
+
+void StartupTasks_InitFontsDone(bool, void*)
+{
+}
+
+void StartupTasks_LoadLocalizationSets(void*)
+{
+	const int phase = StartupProfiler_BeginPhase("Load localization sets");
+	for (std::vector<std::string>::iterator it = g_startupTasks.localizationSetNames.begin(); it != g_startupTasks.localizationSetNames.end(); ++it)
+	{
+		LocalizationSet set;
+		set.name = *it;
+		if (Localization_LoadSet(set))
+		{
+			g_startupTasks.localizationSets.push_back(LocalizationSet());
+			std::swap(g_startupTasks.localizationSets.back(), set);
+		}
+	}
+	StartupProfiler_EndPhase(phase);
+}
+
+void StartupTasks_LoadLocalizationSetsDone(bool, void*)
+{
+	for (std::vector<LocalizationSet>::iterator it = g_startupTasks.localizationSets.begin(); it != g_startupTasks.localizationSets.end(); ++it)
+		Localization_AddSet(*it);
+	g_startupTasks.localizationSets.clear();
+}
+
+void StartupTasks_Start(App::StartupParams* params)
+{
+	Log::Info("Starting initialization tasks");
+
+	g_startupTasks.audioJobID = Jobs::RunJob(StartupTasks_OpenAudio, StartupTasks_OpenAudioDone, NULL);
+	g_startupTasks.fontsInitialized = false;
+	g_startupTasks.fontsJobID = Jobs::RunJob(StartupTasks_InitFonts, StartupTasks_InitFontsDone, NULL);
+	g_startupTasks.localizationSetNames = params->localizationSets;
+	g_startupTasks.localizationJobID = Jobs::RunJob(StartupTasks_LoadLocalizationSets, StartupTasks_LoadLocalizationSetsDone, NULL);
+
+	// Default material (parsing and shader source preload) and cursor sprite go through asynchronous resource loading; OpenGL side is finished on main thread once context exists
+
+	g_startupTasks.defaultResourcesPhase = -1;
+	if (g_supportAsynchronousResourceLoading)
+	{
+		g_startupTasks.defaultResourcesPhase = StartupProfiler_BeginPhase("Load default material and cursor");
+		g_defaultMaterial.Create(params->defaultMaterialName, false);
+		if (g_emulateTouchpadWithMouse)
+			g_cursorSprite.Create(params->defaultCursorName, false);
+	}
+}
+
+bool StartupTasks_Finish(App::StartupParams* params)
+{
+	const int phase = StartupProfiler_BeginPhase("Wait for startup tasks");
+
+	// Wait for audio, fonts and localization
+
+	Jobs::WaitForJob(g_startupTasks.audioJobID);
+	if (g_numAudioChannels == 0)
+	{
+		Log::Error("Mix_OpenAudio failed, reason: " + g_startupTasks.audioError);
+		return false;
+	}
+
+	Jobs::WaitForJob(g_startupTasks.fontsJobID);
+	if (!g_startupTasks.fontsInitialized)
+	{
+		Log::Error("TTF_Init failed, reason: " + g_startupTasks.fontsError);
+		return false;
+	}
+
+	Jobs::WaitForJob(g_startupTasks.localizationJobID);
+
+	// Wait for default material and cursor
+
+	if (g_startupTasks.defaultResourcesPhase != -1)
+	{
+		while (g_defaultMaterial.GetState() == ResourceState_Creating || g_cursorSprite.GetState() == ResourceState_Creating)
+		{
+			Jobs::UpdateDoneJobs();
+			App::Sleep(0.001f);
+		}
+		StartupProfiler_EndPhase(g_startupTasks.defaultResourcesPhase);
+	}
+	else
+	{
+		g_defaultMaterial.Create(params->defaultMaterialName);
+		if (g_emulateTouchpadWithMouse)
+			g_cursorSprite.Create(params->defaultCursorName);
+	}
+
+	if (g_defaultMaterial.GetState() != ResourceState_Created)
+	{
+		Log::Error(string_format("Failed to initialize app, reason: failed to load default material %s", params->defaultMaterialName.c_str()));
+		return false;
+	}
+
+	if (g_emulateTouchpadWithMouse && g_cursorSprite.GetState() != ResourceState_Created)
+	{
+		Log::Error(string_format("Failed to initialize app, reason: failed to load cursor %s", params->defaultCursorName.c_str()));
+		return false;
+	}
+
+	StartupProfiler_EndPhase(phase);
+	return true;
+}
+
 bool App_Startup(App::StartupParams* params)
 {
 	g_rootDataDirs = params->rootDataDirs;
+	g_looseFilesOverridePacks = params->looseFilesOverridePacks;
+	g_fileBufferSize = params->fileBufferSize;
 	g_languageSymbol = params->languageSymbol;
 
 	g_showMessageBoxOnError = params->showMessageBoxOnError;
@@ -198,6 +368,12 @@ bool App_Startup(App::StartupParams* params)
 
 	g_emulateTouchpadWithMouse = params->emulateTouchpadWithMouse;
 	g_supportAsynchronousResourceLoading = params->supportAsynchronousResourceLoading;
+#ifdef DESKTOP
+	g_enableHotReload = params->enableHotReload;
+#endif
+	g_glyphCachePageSize = params->glyphCachePageSize;
+	g_glyphCacheMaxMemory = params->glyphCacheMaxMemory;
+	g_glyphCacheMinUnusedFrames = params->glyphCacheMinUnusedFrames;
 
 	g_textureVersion = params->textureVersion;
 	g_textureVersionSizeMultiplier = params->textureVersionSizeMultiplier;
@@ -209,6 +385,34 @@ bool App_Startup(App::StartupParams* params)
 	g_logMutex = SDL_CreateMutex();
 	Assert(g_logMutex);
 
+	// Initialize timer
+
+	Log::Info("Initializing timer");
+
+	g_timer = SDL_GetPerformanceCounter();
+	g_timerFrequency = SDL_GetPerformanceFrequency();
+
+	// Mount pack files
+
+	const int mountPacksPhase = StartupProfiler_BeginPhase("Mount pack files");
+	if (!Pack_MountAll(params->packFiles))
+		return false;
+	StartupProfiler_EndPhase(mountPacksPhase);
+
+	// Initialize job system
+
+	Log::Info("Initializing job system");
+
+	Jobs_Init();
+	AsyncReads_Init();
+	ShaderSourceCache_Init();
+	HotReload_Init();
+	g_ttfMutex = SDL_CreateMutex();
+
+	// Kick off initialization tasks that don't require OpenGL context
+
+	StartupTasks_Start(params);
+
 	// Determine width and height of the window to create
 
 	int left = 50;
@@ -257,6 +461,7 @@ bool App_Startup(App::StartupParams* params)
 
 	// Create window
 
+	const int createWindowPhase = StartupProfiler_BeginPhase("Create window");
 	Log::Info(string_format("Creating window (size %dx%d viewport %dx%d)", g_width, g_height, g_viewportWidth, g_viewportHeight));
 
 	g_windowHasFocus = false;
@@ -265,9 +470,12 @@ bool App_Startup(App::StartupParams* params)
 		Log::Error(std::string("SDL_CreateWindow failed, reason: ") + SDL_GetError());
 		return false;
 	}
+	StartupProfiler_EndPhase(createWindowPhase);
 
 	// Create OpenGL context
 
+	const int createContextPhase = StartupProfiler_BeginPhase("Create OpenGL context");
+
 	SDL_GL_SetAttribute(SDL_GL_RED_SIZE,        8);
     SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE,      8);
     SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE,       8);
@@ -293,6 +501,9 @@ bool App_Startup(App::StartupParams* params)
 		Log::Error(std::string("Failed to create OpenGL context, reason: ") + SDL_GetError());
 		return false;
 	}
+	StartupProfiler_EndPhase(createContextPhase);
+
+	const int initGLPhase = StartupProfiler_BeginPhase("Initialize OpenGL");
 
 	Log::Info(string_format("OpenGL Version: %s", glGetString(GL_VERSION)));
 	Log::Info(string_format("OpenGL Vendor: %s", glGetString(GL_VENDOR)));
@@ -304,6 +515,33 @@ bool App_Startup(App::StartupParams* params)
 
 	App_InitGLProcedures();
 
+	// Initialize shader program binary cache
+
+	if (params->enableShaderCache)
+	{
+		g_shaderCacheDir = params->shaderCacheDir;
+		if (g_shaderCacheDir.empty())
+		{
+#if defined(__ANDROID__)
+			if (const char* internalStoragePath = SDL_AndroidGetInternalStoragePath())
+				g_shaderCacheDir = std::string(internalStoragePath) + "/";
+#elif SDL_VERSION_ATLEAST(2, 0, 1)
+			// Per-user writable directory; root data directories may be read-only or shared between users
+			if (char* prefPath = SDL_GetPrefPath("Tiny2D", params->name.empty() ? "Tiny2D" : params->name.c_str()))
+			{
+				g_shaderCacheDir = prefPath;
+				SDL_free(prefPath);
+			}
+#endif
+			if (g_shaderCacheDir.empty())
+				Log::Warn("Shader program binary cache disabled, reason: failed to get writable user directory");
+		}
+	}
+	ShaderProgramCache_Init();
+	ShaderCompiler_Init();
+	FrameConstants_Init();
+	Samplers_Init();
+
 #ifndef OPENGL_ES
 	GL(glDisable(GL_LIGHTING));
 	GL(glShadeModel(GL_SMOOTH));
@@ -325,7 +563,7 @@ bool App_Startup(App::StartupParams* params)
 	mainRenderTarget->handle = 0;
 	mainRenderTarget->width = g_width;
 	mainRenderTarget->height = g_height;
-	mainRenderTarget->refCount = 1;
+	SDL_AtomicSet(&mainRenderTarget->refCount, 1);
 	mainRenderTarget->isRenderTarget = true;
 
 	Texture_SetHandle(mainRenderTarget, g_mainRenderTarget);
@@ -335,15 +573,11 @@ bool App_Startup(App::StartupParams* params)
 	Sampler::DefaultPostprocess.minFilterLinear = false;
 	Sampler::DefaultPostprocess.magFilterLinear = false;
 
-	// Initialize timer
-
-	Log::Info("Initializing timer");
-
-	g_timer = SDL_GetPerformanceCounter();
-	g_timerFrequency = SDL_GetPerformanceFrequency();
+	StartupProfiler_EndPhase(initGLPhase);
 
 	// Map keys to SDL keys
 
+	const int initInputPhase = StartupProfiler_BeginPhase("Initialize input");
 	Log::Info("Initializing keys");
 
 	App_MapKey(Key_Left, SDLK_LEFT);
@@ -439,49 +673,16 @@ bool App_Startup(App::StartupParams* params)
 	g_mouse.position = Vec2((float) g_width / 2.0f, g_height / 2.0f);
 	g_mouse.movement = Vec2(0.0f, 0.0f);
 
-	// Initialize audio
-
-	Log::Info("Initializing audio");
-
-	for (g_numAudioChannels = MAX_AUDIO_CHANNELS; g_numAudioChannels >= 1; g_numAudioChannels--)
-		if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, g_numAudioChannels, 4096) >= 0)
-			break;
-
-	if (g_numAudioChannels == 0)
-	{
-		Log::Error(std::string("Mix_OpenAudio failed, reason: ") + SDL_GetError());
-		return false;
-	}
-	Mix_ChannelFinished(Sound_OnChannelFinished);
-	Mix_HookMusicFinished(Sound_OnMusicFinished);
-
-	// Initialize fonts
+	StartupProfiler_EndPhase(initInputPhase);
 
-	Log::Info("Initializing fonts");
+	// Finish initialization tasks
 
-	if (TTF_Init() < 0)
-	{
-		Log::Error(std::string("TTF_Init failed, reason: ") + SDL_GetError());
+	if (!StartupTasks_Finish(params))
 		return false;
-	}
-
-	// Initialize job system
-
-	Log::Info("Initializing job system");
-
-	Jobs_Init();
-
-	// Load default resources
-
-	Log::Info("Loading default resources");
 
-	g_defaultMaterial.Create(params->defaultMaterialName);
-	if (g_defaultMaterial.GetState() != ResourceState_Created)
-	{
-		Log::Error(string_format("Failed to initialize app, reason: failed to load default material %s", params->defaultMaterialName.c_str()));
-		return false;
-	}
+	// Load default font
 
+	const int loadFontPhase = StartupProfiler_BeginPhase("Load default font");
 	g_defaultFont.Create(params->defaultFontName, params->defaultFontSize);
 	if (g_defaultFont.GetState() != ResourceState_Created)
 	{
@@ -489,16 +690,9 @@ bool App_Startup(App::StartupParams* params)
 		return false;
 	}
 	//Font_CacheGlyphsFromFile(g_defaultFont, "common/common_characters.txt");
+	StartupProfiler_EndPhase(loadFontPhase);
 
-	if (g_emulateTouchpadWithMouse)
-	{
-		g_cursorSprite.Create(params->defaultCursorName);
-		if (g_cursorSprite.GetState() != ResourceState_Created)
-		{
-			Log::Error(string_format("Failed to initialize app, reason: failed to load cursor %s", params->defaultCursorName.c_str()));
-			return false;
-		}
-	}
+	ShaderProgramCache_LogStats();
 
 	Log::Info("Initialization completed successfully");
 
@@ -509,16 +703,28 @@ void App_Shutdown()
 {
 	Log::Info("Shutting down subsystems");
 
+	HotReload_Deinit();
 	Localization::UnloadAllSets();
+	Localization_UnregisterAllFonts();
 	RenderTexturePool::DestroyAll();
 	g_cursorSprite.Destroy();
 	g_defaultFont.Destroy();
 	g_defaultMaterial.Destroy();
 	g_mainRenderTarget.Destroy();
 	GL(glDeleteFramebuffersEXT(1, &g_fbo));
+	GlyphCache_Deinit();
+	Samplers_Deinit();
+	FrameConstants_Deinit();
+	ShaderSourceCache_Deinit();
+	ShaderProgramCache_LogStats();
 	Resource_ListUnfreed();
+	AsyncReads_Deinit();
+	Jobs::WaitForAllJobs(); // Run jobs and done functions of reads failed above, so that their data gets freed
 	Jobs_Deinit();
+	Pack_UnmountAll();
 	TTF_Quit();
+	SDL_DestroyMutex(g_ttfMutex);
+	g_ttfMutex = NULL;
 	Log::Info("Closing audio");
 	Mix_CloseAudio();
 	Log::Info("Closing window");
@@ -762,6 +968,8 @@ void App_UpdateTimer()
 
 void App_EndDrawFrame()
 {
+	GlyphCache_Update();
+
 #ifdef CUSTOM_OPENGL_ES
 	OpenGLES_SwapWindow();
 #else
@@ -963,6 +1171,8 @@ TextureObj* Texture_CreateFromSurface(TextureObj* resource, SDL_Surface* surface
 	if (!resource)
 		resource = new TextureObj();
 	resource->handle = handle;
+	resource->hasMipmaps = false;
+	resource->isSamplerStateValid = false;
 	resource->format = format;
 	resource->internalFormat = internalFormat;
 	resource->width = surface->w;
@@ -989,28 +1199,42 @@ std::string Texture_TranslateName(const std::string& name)
 	return translatedName;
 }
 
-void Texture_JobFunc(void* userData)
+SDL_Surface* Image_LoadFromMemory(const void* data, size_t size)
+{
+	SDL_RWops* rw = SDL_RWFromConstMem(data, (int) size);
+	return rw ? IMG_Load_RW(rw, 1) : NULL;
+}
+
+SDL_Surface* Image_LoadFromView(FileViewObj* view)
+{
+	// Decode straight from the view and release it
+
+	SDL_Surface* surface = Image_LoadFromMemory(view->data, view->size);
+	File_Unmap(view);
+	return surface;
+}
+
+void Texture_ReadFunc(void*& data, size_t size, void* userData)
 {
 	TextureJobData* jobData = (TextureJobData*) userData;
 
 	std::string path = Texture_TranslateName(jobData->resource->name);
-	SDL_RWops* rw = File_OpenSDLFileRW(path, File::OpenMode_Read);
-	if (rw)
+	if (data)
 	{
-		jobData->surface = IMG_Load_RW(rw, 1);
+		jobData->surface = Image_LoadFromMemory(data, size);
 		if (jobData->surface)
 			jobData->resource->sizeScale = g_textureVersionSizeMultiplier;
 	}
 	else if (g_textureVersion.length())
 	{
 		path = jobData->resource->name;
-		rw = File_OpenSDLFileRW(path, File::OpenMode_Read);
-		if (!rw)
+		FileViewObj* view = File_Map(path);
+		if (!view)
 		{
 			Log::Error(string_format("Failed to load texture from %s, reason: failed to open file", path.c_str(), SDL_GetError()));
 			return;
 		}
-		jobData->surface = IMG_Load_RW(rw, 1);
+		jobData->surface = Image_LoadFromView(view);
 	}
 
 	if (!jobData->surface)
@@ -1041,13 +1265,11 @@ void Texture_DoneFunc(bool canceled, void* userData)
 TextureObj* Texture_Create(const std::string& name, bool immediate)
 {
 	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	LoadGroup_OnResourceRequested(LoadGroupItemType_Texture, name);
 
-	TextureObj* resource = static_cast<TextureObj*>(Resource_Find("texture", name));
+	TextureObj* resource = static_cast<TextureObj*>(Resource_FindAndIncRefCount("texture", name));
 	if (resource)
-	{
-		Resource_IncRefCount(resource);
 		return resource;
-	}
 
 	if (immediate)
 	{
@@ -1056,10 +1278,10 @@ TextureObj* Texture_Create(const std::string& name, bool immediate)
 		SDL_Surface* surface = NULL;
 
 		std::string path = Texture_TranslateName(name);
-		SDL_RWops* rw = File_OpenSDLFileRW(path, File::OpenMode_Read);
-		if (rw)
+		FileViewObj* view = File_Map(path);
+		if (view)
 		{
-			surface = IMG_Load_RW(rw, 1);
+			surface = Image_LoadFromView(view);
 			if (!surface)
 			{
 				Log::Error(string_format("IMG_Load_RW failed for %s, reason: %s", path.c_str(), SDL_GetError()));
@@ -1072,9 +1294,9 @@ TextureObj* Texture_Create(const std::string& name, bool immediate)
 			if (g_textureVersion.length())
 			{
 				path = name;
-				rw = File_OpenSDLFileRW(path, File::OpenMode_Read);
-				if (rw)
-					surface = IMG_Load_RW(rw, 1);
+				view = File_Map(path);
+				if (view)
+					surface = Image_LoadFromView(view);
 			}
 			if (!surface)
 			{
@@ -1091,7 +1313,13 @@ TextureObj* Texture_Create(const std::string& name, bool immediate)
 		resource->isLoaded = true;
 		resource->name = name;
 		resource->state = ResourceState_Created;
-		Resource_IncRefCount(resource);
+
+		TextureObj* registered = static_cast<TextureObj*>(Resource_FindOrRegister(resource));
+		if (registered != resource)
+		{
+			Texture_Destroy(resource);
+			return registered;
+		}
 	}
 	else
 	{
@@ -1099,16 +1327,71 @@ TextureObj* Texture_Create(const std::string& name, bool immediate)
 		resource->isLoaded = true;
 		resource->name = name;
 		resource->state = ResourceState_Creating;
-		Resource_IncRefCount(resource);
+
+		// Register before kicking off the load, so that concurrent requests share it
+
+		TextureObj* registered = static_cast<TextureObj*>(Resource_FindOrRegister(resource));
+		if (registered != resource)
+		{
+			delete resource;
+			return registered;
+		}
 
 		TextureJobData* jobData = new TextureJobData();
 		jobData->resource = resource;
-		resource->jobID = Jobs::RunJob(Texture_JobFunc, Texture_DoneFunc, jobData);
+		resource->jobID = File_ReadAsync(Texture_TranslateName(name), NULL, 0, 0, Texture_ReadFunc, Texture_DoneFunc, jobData);
 	}
 
+	HotReload_AddFile("texture", name, name);
+	if (g_textureVersion.length())
+		HotReload_AddFile("texture", name, Texture_TranslateName(name));
+
 	return resource;
 }
 
+void* Texture_BeginReload(Resource* resource)
+{
+	// Load new version into a separate, unregistered texture
+
+	TextureObj* shadow = new TextureObj();
+	shadow->isLoaded = true;
+	shadow->name = resource->name;
+	shadow->state = ResourceState_Creating;
+
+	TextureJobData* jobData = new TextureJobData();
+	jobData->resource = shadow;
+	shadow->jobID = File_ReadAsync(Texture_TranslateName(shadow->name), NULL, 0, 0, Texture_ReadFunc, Texture_DoneFunc, jobData);
+	return shadow;
+}
+
+bool Texture_UpdateReload(void* context, Resource* resource)
+{
+	TextureObj* shadow = (TextureObj*) context;
+	if (shadow->state == ResourceState_Creating)
+		return false;
+
+	// Move new texture data into existing texture, so that all handles get to use it
+
+	TextureObj* texture = static_cast<TextureObj*>(resource);
+	if (texture && shadow->state == ResourceState_Created)
+	{
+		std::swap(texture->handle, shadow->handle);
+		texture->format = shadow->format;
+		texture->internalFormat = shadow->internalFormat;
+		texture->hasAlpha = shadow->hasAlpha;
+		texture->width = shadow->width;
+		texture->height = shadow->height;
+		texture->sizeScale = shadow->sizeScale;
+		texture->hasMipmaps = false;
+		texture->isSamplerStateValid = false;
+	}
+
+	if (shadow->handle)
+		GL(glDeleteTextures(1, &shadow->handle));
+	delete shadow;
+	return true;
+}
+
 #if 0
 
 TextureObj* Texture_CreateCameraCapture(Camera camera = Camera_Back, CameraCaptureSize size = CameraCaptureSize_Medium, bool captureSingleFrame = true);
@@ -1173,26 +1456,15 @@ struct SoundObj
 	{}
 };
 
-Mix_Chunk* Sound_LoadOGG(const std::string& path)
+Mix_Chunk* Sound_DecodeOGG(const std::string& path, const void* data, size_t size)
 {
-	// Load OGG file
-
-	int size = 0;
-	void* data = NULL;
-	if (!File_Load(path, data, size))
-	{
-		Log::Error(string_format("Failed to load OGG file %s", path.c_str()));
-		return NULL;
-	}
-
-	// Decode OGG file
+	// Decode OGG file (stb_vorbis doesn't modify the data despite non-const signature)
 
 	int oggChannels = 0;
 	short* oggData = NULL;
-	const int result = stb_vorbis_decode_memory((unsigned char*) data, size, &oggChannels, (short**) &oggData);
+	const int result = stb_vorbis_decode_memory((unsigned char*) data, (int) size, &oggChannels, (short**) &oggData);
 	if (result <= 0)
 	{
-		free(data);
 		Log::Error(string_format("Failed to decode OGG file %s", path.c_str()));
 		return NULL;
 	}
@@ -1204,15 +1476,26 @@ Mix_Chunk* Sound_LoadOGG(const std::string& path)
 	if (!chunk)
 	{
 		stb_vorbis_free(oggData);
-		free(data);
 		Log::Error(std::string("Mix_QuickLoad_RAW failed for ") + path + ", reason: " + Mix_GetError());
 		return NULL;
 	}
 
-	// Clean up
+	return chunk;
+}
+
+Mix_Chunk* Sound_LoadOGG(const std::string& path)
+{
+	// Map OGG file
 
-	free(data);
+	FileViewObj* view = File_Map(path);
+	if (!view)
+	{
+		Log::Error(string_format("Failed to load OGG file %s", path.c_str()));
+		return NULL;
+	}
 
+	Mix_Chunk* chunk = Sound_DecodeOGG(path, view->data, view->size);
+	File_Unmap(view);
 	return chunk;
 }
 
@@ -1259,11 +1542,43 @@ struct SoundResourceJobData
 	bool isMusic;
 };
 
-void SoundResource_JobFunc(void* userData)
+void SoundResource_ReadFunc(void*& data, size_t size, void* userData)
 {
 	SoundResourceJobData* jobData = (SoundResourceJobData*) userData;
-	if (!SoundResource_LoadData(jobData->resource->name, jobData->isMusic, jobData->resource->chunk, jobData->resource->music))
-		Log::Error(string_format("Sound %s async loading failed", jobData->resource->name.c_str()));
+	SoundResource* resource = jobData->resource;
+	if (!data)
+	{
+		Log::Error(string_format("Failed to load create sound from %s, reason: failed to read file", resource->name.c_str()));
+		return;
+	}
+
+	if (jobData->isMusic)
+	{
+		// Music gets streamed from memory, so hand over the data to SDL_RWops that frees it on close
+
+		SDL_RWops* rw = SDL_RWFromConstMem(data, (int) size);
+		if (!rw)
+			return;
+		rw->close = RW_CloseOwnedMemory;
+		data = NULL;
+
+		resource->music = Mix_LoadMUS_RW(rw, 1);
+		if (!resource->music)
+			Log::Error(string_format("Failed to load music from %s via Mix_LoadMUS", resource->name.c_str()));
+	}
+	else
+	{
+		if (strstr(resource->name.c_str(), ".ogg"))
+			resource->chunk = Sound_DecodeOGG(resource->name, data, size);
+		else
+		{
+			SDL_RWops* rw = SDL_RWFromConstMem(data, (int) size);
+			resource->chunk = rw ? Mix_LoadWAV_RW(rw, 1) : NULL;
+		}
+
+		if (!resource->chunk)
+			Log::Error(string_format("Failed to load WAV/OGG sample from %s", resource->name.c_str()));
+	}
 }
 
 void SoundResource_DoneFunc(bool canceled, void* userData)
@@ -1282,6 +1597,22 @@ void SoundResource_DoneFunc(bool canceled, void* userData)
 	delete jobData;
 }
 
+void SoundResource_FreeData(SoundResource* resource)
+{
+	if (resource->chunk)
+	{
+		if (strstr(resource->name.c_str(), ".ogg"))
+			stb_vorbis_free(resource->chunk->abuf);
+		Mix_FreeChunk(resource->chunk);
+		resource->chunk = NULL;
+	}
+	else if (resource->music)
+	{
+		Mix_FreeMusic(resource->music);
+		resource->music = NULL;
+	}
+}
+
 SoundObj* Sound_Clone(SoundObj* other)
 {
 	SoundObj* sound = new SoundObj();
@@ -1293,8 +1624,9 @@ SoundObj* Sound_Clone(SoundObj* other)
 SoundObj* Sound_Create(const std::string& name, bool isMusic, bool immediate)
 {
 	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	LoadGroup_OnResourceRequested(isMusic ? LoadGroupItemType_Music : LoadGroupItemType_Sound, name);
 
-	SoundResource* resource = static_cast<SoundResource*>(Resource_Find("sound", name));
+	SoundResource* resource = static_cast<SoundResource*>(Resource_FindAndIncRefCount("sound", name));
 	if (!resource)
 	{
 		Mix_Chunk* chunk = NULL;
@@ -1308,19 +1640,30 @@ SoundObj* Sound_Create(const std::string& name, bool isMusic, bool immediate)
 		resource->chunk = chunk;
 		resource->music = music;
 
-		if (!immediate)
+		SoundResource* registered = static_cast<SoundResource*>(Resource_FindOrRegister(resource));
+		if (registered != resource)
+		{
+			SoundResource_FreeData(resource);
+			delete resource;
+			resource = registered;
+		}
+		else
 		{
-			SoundResourceJobData* jobData = new SoundResourceJobData();
-			jobData->resource = resource;
-			jobData->isMusic = isMusic;
+			if (!immediate)
+			{
+				SoundResourceJobData* jobData = new SoundResourceJobData();
+				jobData->resource = resource;
+				jobData->isMusic = isMusic;
+
+				resource->jobID = File_ReadAsync(name, NULL, 0, 0, SoundResource_ReadFunc, SoundResource_DoneFunc, jobData);
+			}
 
-			resource->jobID = Jobs::RunJob(SoundResource_JobFunc, SoundResource_DoneFunc, jobData);
+			HotReload_AddFile("sound", name, name);
 		}
 	}
 
 	SoundObj* sound = new SoundObj();
 	sound->resource = resource;
-	Resource_IncRefCount(resource);
 	return sound;
 }
 
@@ -1347,18 +1690,46 @@ void Sound_Destroy(SoundObj* sound, float fadeOutTime)
 		if (sound->resource->state == ResourceState_Creating)
 			Jobs::CancelJob(sound->resource->jobID);
 
-		if (sound->resource->chunk)
-		{
-			if (strstr(sound->resource->name.c_str(), ".ogg"))
-				stb_vorbis_free(sound->resource->chunk->abuf);
-			Mix_FreeChunk(sound->resource->chunk);
-		}
-		else if (sound->resource->music)
-			Mix_FreeMusic(sound->resource->music);
+		SoundResource_FreeData(sound->resource);
 	}
 	delete sound;
 }
 
+void* Sound_BeginReload(Resource* resource)
+{
+	// Load new version into a separate, unregistered sound resource
+
+	SoundResource* shadow = new SoundResource();
+	shadow->name = resource->name;
+	shadow->state = ResourceState_Creating;
+
+	SoundResourceJobData* jobData = new SoundResourceJobData();
+	jobData->resource = shadow;
+	jobData->isMusic = static_cast<SoundResource*>(resource)->music != NULL;
+	shadow->jobID = File_ReadAsync(shadow->name, NULL, 0, 0, SoundResource_ReadFunc, SoundResource_DoneFunc, jobData);
+	return shadow;
+}
+
+bool Sound_UpdateReload(void* context, Resource* resource)
+{
+	SoundResource* shadow = (SoundResource*) context;
+	if (shadow->state == ResourceState_Creating)
+		return false;
+
+	// Swap sound data; freeing old data stops channels still playing it
+
+	SoundResource* sound = static_cast<SoundResource*>(resource);
+	if (sound && shadow->state == ResourceState_Created)
+	{
+		std::swap(sound->chunk, shadow->chunk);
+		std::swap(sound->music, shadow->music);
+	}
+
+	SoundResource_FreeData(shadow);
+	delete shadow;
+	return true;
+}
+
 inline int Sound_ToSDLVolume(float volume)
 {
 	return clamp((int) (volume * 128.0f), 0, 128);
@@ -1476,126 +1847,313 @@ void Sound_OnMusicFinished()
 	}
 }
 
-// FontObj
+// Glyph cache shared by all TTF fonts
+//
+// Atlas pages are fixed size textures split into square cells; each page holds cells of single power-of-two size.
+// Glyphs not used for a number of frames get evicted when there's no free cell and the memory budget is exhausted.
+// Missing glyphs are rasterized in jobs and uploaded at the start of the next frame; large batches are split across
+// job threads, each rendering with its own TTF_Font opened from font file kept in memory.
 
-FontObj* Font_Create(const std::string& faceName, int size, unsigned int flags, bool immediate)
+#define GLYPH_CACHE_MIN_CELL_SIZE 16
+#define GLYPH_CACHE_MIN_GLYPHS_PER_JOB 32
+
+typedef std::pair<FontObj*, unsigned int> GlyphCacheKey;
+
+struct GlyphCacheEntry
 {
-	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	Glyph glyph;
+	bool isValid;		// Does font have this glyph?
+	bool isPending;		// Queued for or undergoing rasterization
+	int pageIndex;		// -1 if not in cache
+	int cellIndex;
+	int lastUsedFrame;
+	int failedFrame;	// Last frame the glyph failed to find cache space
+
+	GlyphCacheEntry() :
+		isValid(false),
+		isPending(false),
+		pageIndex(-1),
+		cellIndex(-1),
+		lastUsedFrame(0),
+		failedFrame(INT_MIN)
+	{}
+};
 
-	const std::string name = string_format("%s:%d:%u", faceName.c_str(), size, flags);
+struct GlyphCachePage
+{
+	TextureObj* texture;
+	int cellSize;
+	std::vector<int> freeCells;
+	std::vector<GlyphCacheKey> cellOwners;
+
+	GlyphCachePage() :
+		texture(NULL),
+		cellSize(0)
+	{}
+};
 
-	FontObj* resource = static_cast<FontObj*>(Resource_Find("font", name));
-	if (!resource)
-	{
-		SDL_RWops* rw = File_OpenSDLFileRW(faceName, File::OpenMode_Read);
-		if (!rw)
-		{
-			Log::Error(string_format("Failed to create font from %s, reason: failed to open file for reading", faceName.c_str()));
-			return NULL;
-		}
+struct GlyphRasterizationRequest
+{
+	unsigned int code;
+	SDL_Surface* surface;	// Cropped glyph image with 1 pixel transparent border
+	int left;				// Offset of the cropped glyph image within rendered glyph
+	int top;
+
+	GlyphRasterizationRequest() :
+		code(0),
+		surface(NULL),
+		left(0),
+		top(0)
+	{}
+};
 
-		TTF_Font* font = TTF_OpenFontRW(rw, 1, size);
-		if (!font)
-		{
-			Log::Error(string_format("Failed to load font from %s, reason: %s", faceName.c_str(), SDL_GetError()));
-			return NULL;
-		}
+struct GlyphCacheJobData
+{
+	Jobs::JobID jobID;
+	FontObj* font;
+	bool usePrivateFace;	// Open own TTF_Font instead of locking the shared one, so the job can run in parallel with other jobs
+	bool isFontCreation;	// Is it one of the jobs rasterizing initial glyph set of asynchronously created font?
+	std::vector<GlyphRasterizationRequest> requests;
+};
 
-		TTF_SetFontStyle(font,
-			((flags & Font::Flags_Bold) ? TTF_STYLE_BOLD : 0) |
-			((flags & Font::Flags_Italic) ? TTF_STYLE_ITALIC : 0) |
-			((flags & Font::Flags_StrikeThrough) ? TTF_STYLE_STRIKETHROUGH : 0) |
-			((flags & Font::Flags_Underlined) ? TTF_STYLE_UNDERLINE : 0));
-		TTF_SetFontKerning(font, 1);
+SDL_mutex* g_ttfMutex = NULL; // SDL_ttf isn't thread safe; guards opening / closing of all fonts and use of FontObj::font
+std::map<GlyphCacheKey, GlyphCacheEntry> g_glyphCacheEntries;
+std::vector<GlyphCachePage> g_glyphCachePages;
+std::vector<GlyphCacheKey> g_glyphCachePending;
+std::vector<Jobs::JobID> g_glyphCacheJobIDs;
 
-		resource = new FontObj();
-		resource->state = ResourceState_Created;
-		resource->font = font;
-		resource->name = name;
-		resource->size = size;
+TTF_Font* Font_OpenFace(FontObj* font)
+{
+	SDL_RWops* rw = SDL_RWFromConstMem(font->fileView->data, (int) font->fileView->size);
+	if (!rw)
+		return NULL;
+
+	SDL_LockMutex(g_ttfMutex);
+	TTF_Font* face = TTF_OpenFontRW(rw, 1, font->size);
+	if (face)
+	{
+		TTF_SetFontStyle(face,
+			((font->flags & Font::Flags_Bold) ? TTF_STYLE_BOLD : 0) |
+			((font->flags & Font::Flags_Italic) ? TTF_STYLE_ITALIC : 0) |
+			((font->flags & Font::Flags_StrikeThrough) ? TTF_STYLE_STRIKETHROUGH : 0) |
+			((font->flags & Font::Flags_Underlined) ? TTF_STYLE_UNDERLINE : 0));
+		TTF_SetFontKerning(face, 1);
 	}
+	SDL_UnlockMutex(g_ttfMutex);
+	return face;
+}
 
-	Resource_IncRefCount(resource);
+void Font_CloseFace(TTF_Font* face)
+{
+	SDL_LockMutex(g_ttfMutex);
+	TTF_CloseFont(face);
+	SDL_UnlockMutex(g_ttfMutex);
+}
 
-	return resource;
+int GlyphCache_GetCellSize(int width, int height)
+{
+	const int size = max(width, height) + 2; // 1 pixel border around each glyph to avoid bleeding with bilinear filtering
+	int cellSize = GLYPH_CACHE_MIN_CELL_SIZE;
+	while (cellSize < size)
+		cellSize <<= 1;
+	return cellSize;
 }
 
-void Font_Destroy(FontObj* font)
+void GlyphCache_InitPageCells(GlyphCachePage& page, int cellSize)
 {
-	if (!Resource_DecRefCount(font))
+	const int numCells = (g_glyphCachePageSize / cellSize) * (g_glyphCachePageSize / cellSize);
+
+	page.cellSize = cellSize;
+	page.freeCells.resize(numCells);
+	for (int i = 0; i < numCells; i++)
+		page.freeCells[i] = numCells - 1 - i;
+	page.cellOwners.clear();
+	page.cellOwners.resize(numCells, GlyphCacheKey((FontObj*) NULL, 0));
+}
+
+void GlyphCache_EvictCell(int pageIndex, int cellIndex)
+{
+	GlyphCachePage& page = g_glyphCachePages[pageIndex];
+	GlyphCacheKey& owner = page.cellOwners[cellIndex];
+	if (!owner.first)
+		return;
+
+	if (GlyphCacheEntry* entry = map_find(g_glyphCacheEntries, owner))
 	{
-		if (font->texture)
-			Texture_Destroy(font->texture);
-		TTF_CloseFont(font->font);
-		delete font;
+		entry->pageIndex = -1;
+		entry->cellIndex = -1;
 	}
+	owner = GlyphCacheKey((FontObj*) NULL, 0);
+	page.freeCells.push_back(cellIndex);
 }
 
-void Font_CacheGlyphs(FontObj* font, unsigned int* buffer, int bufferSize)
+bool GlyphCache_AllocateCell(int cellSize, int& pageIndex, int& cellIndex)
 {
-	// Check what's missing
-
-	std::map<unsigned int, Glyph> glyphsToBuild;
+	// Free cell in existing page
 
-	for (int i = 0; i < bufferSize; i++)
-		if (!map_find(font->glyphs, buffer[i]) && !map_find(glyphsToBuild, buffer[i]))
+	for (pageIndex = 0; pageIndex < (int) g_glyphCachePages.size(); pageIndex++)
+	{
+		GlyphCachePage& page = g_glyphCachePages[pageIndex];
+		if (page.cellSize == cellSize && page.freeCells.size())
 		{
-			int minx, maxx, miny, maxy, advance;
-			if (TTF_GlyphMetrics(font->font, buffer[i], &minx, &maxx, &miny, &maxy, &advance))
-				continue;
+			cellIndex = page.freeCells.back();
+			page.freeCells.pop_back();
+			return true;
+		}
+	}
 
-			Glyph& glyph = map_add(glyphsToBuild, buffer[i]);
-			glyph.code = buffer[i];
-			glyph.pos.left = (float) minx;
-			glyph.pos.top = (float) maxx;
-			glyph.pos.width = (float) (maxx - minx);
-			glyph.pos.height = (float) (maxy - miny);
-			glyph.advancePos = (float) advance;
+	// New page if within memory budget
+
+	const int pageMemory = g_glyphCachePageSize * g_glyphCachePageSize * 4;
+	if (g_glyphCachePages.empty() || (int) (g_glyphCachePages.size() + 1) * pageMemory <= g_glyphCacheMaxMemory)
+	{
+		SDL_Surface* surface = SDL_CreateRGBSurface(0, g_glyphCachePageSize, g_glyphCachePageSize, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+		if (!surface)
+		{
+			Log::Error(string_format("SDL_CreateRGBSurface failed while creating glyph cache page, reason: %s", SDL_GetError()));
+			return false;
 		}
 
-	// Anything to add to cache?
+		TextureObj* texture = Texture_CreateFromSurface(NULL, surface);
+		if (!texture)
+			return false;
+		SDL_AtomicSet(&texture->refCount, 1); // Increase refcount manually to prevent texture from being added to managed resources
 
-	if (!glyphsToBuild.size())
-		return;
+		GlyphCachePage& page = vector_add(g_glyphCachePages);
+		page.texture = texture;
+		GlyphCache_InitPageCells(page, cellSize);
+
+		pageIndex = (int) g_glyphCachePages.size() - 1;
+		cellIndex = page.freeCells.back();
+		page.freeCells.pop_back();
+		return true;
+	}
+
+	// Evict least recently used glyph of the same cell size
 
-	// Add all existing glyphs too
+	const int maxLastUsedFrame = g_frameIndex - g_glyphCacheMinUnusedFrames;
 
-	if (font->texture)
+	int lruFrame = INT_MAX;
+	int lruPageIndex = -1;
+	int lruCellIndex = -1;
+	for (int i = 0; i < (int) g_glyphCachePages.size(); i++)
 	{
-		for (std::map<unsigned int, Glyph>::iterator it = font->glyphs.begin(); it != font->glyphs.end(); ++it)
-			glyphsToBuild[it->first] = it->second;
-		font->glyphs.clear();
+		GlyphCachePage& page = g_glyphCachePages[i];
+		if (page.cellSize != cellSize)
+			continue;
+
+		for (int j = 0; j < (int) page.cellOwners.size(); j++)
+		{
+			GlyphCacheEntry* entry = map_find(g_glyphCacheEntries, page.cellOwners[j]);
+			if (entry && entry->lastUsedFrame < maxLastUsedFrame && entry->lastUsedFrame < lruFrame)
+			{
+				lruFrame = entry->lastUsedFrame;
+				lruPageIndex = i;
+				lruCellIndex = j;
+			}
+		}
+	}
 
-		Texture_Destroy(font->texture);
-		font->texture = NULL;
+	if (lruPageIndex != -1)
+	{
+		GlyphCache_EvictCell(lruPageIndex, lruCellIndex);
+		g_glyphCachePages[lruPageIndex].freeCells.pop_back();
+		pageIndex = lruPageIndex;
+		cellIndex = lruCellIndex;
+		return true;
 	}
 
-	// Determine optimal layout
+	// Repurpose page of different cell size whose glyphs are all unused
 
-	std::vector<RectPacker::Rect> packerRects;
-	for (std::map<unsigned int, Glyph>::iterator it = glyphsToBuild.begin(); it != glyphsToBuild.end(); ++it)
+	for (pageIndex = 0; pageIndex < (int) g_glyphCachePages.size(); pageIndex++)
 	{
-		Glyph& glyph = it->second;
+		GlyphCachePage& page = g_glyphCachePages[pageIndex];
+
+		bool allUnused = true;
+		for (std::vector<GlyphCacheKey>::iterator it = page.cellOwners.begin(); it != page.cellOwners.end() && allUnused; ++it)
+		{
+			GlyphCacheEntry* entry = map_find(g_glyphCacheEntries, *it);
+			allUnused = !entry || entry->lastUsedFrame < maxLastUsedFrame;
+		}
+		if (!allUnused)
+			continue;
+
+		for (int i = 0; i < (int) page.cellOwners.size(); i++)
+			GlyphCache_EvictCell(pageIndex, i);
+		GlyphCache_InitPageCells(page, cellSize);
 
-		RectPacker::Rect& packerRect = vector_add(packerRects);
-		packerRect.w = (int) glyph.pos.width;
-		packerRect.h = (int) glyph.pos.height;
-		packerRect.userData = &glyph;
+		cellIndex = page.freeCells.back();
+		page.freeCells.pop_back();
+		return true;
 	}
 
-	unsigned int textureWidth, textureHeight;
-	RectPacker::Solve(2, 1, true, packerRects, textureWidth, textureHeight);
+	return false;
+}
 
-	// Create surface to copy all glyphs into
+GlyphCacheEntry* GlyphCache_FindOrAddEntry(FontObj* font, unsigned int code)
+{
+	const GlyphCacheKey key(font, code);
 
-	SDL_Surface* surface = SDL_CreateRGBSurface(0, textureWidth, textureHeight, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
-	if (!surface)
+	GlyphCacheEntry* entry = map_find(g_glyphCacheEntries, key);
+	if (!entry)
 	{
-		Log::Error(string_format("SDL_CreateRGBSurface failed while generating font, reason: %s", SDL_GetError()));
-		return;
+		entry = &map_add(g_glyphCacheEntries, key);
+
+		int minx, maxx, miny, maxy, advance;
+		SDL_LockMutex(g_ttfMutex);
+		entry->isValid = code <= 0xFFFF && !TTF_GlyphMetrics(font->font, (Uint16) code, &minx, &maxx, &miny, &maxy, &advance);
+		SDL_UnlockMutex(g_ttfMutex);
+
+		if (entry->isValid)
+		{
+			entry->glyph.code = code;
+			entry->glyph.pos.left = (float) minx;
+			entry->glyph.pos.top = 0.0f;
+			entry->glyph.pos.width = (float) (maxx - minx);
+			entry->glyph.pos.height = (float) (maxy - miny);
+			entry->glyph.advancePos = (float) advance;
+		}
+	}
+	return entry;
+}
+
+inline bool GlyphCache_NeedsRasterization(GlyphCacheEntry* entry)
+{
+	// Not cached, not pending, not empty (e.g. space) and didn't recently fail to find cache space
+
+	return entry->isValid && entry->pageIndex == -1 && !entry->isPending &&
+		entry->glyph.pos.width > 0.0f && entry->glyph.pos.height > 0.0f &&
+		g_frameIndex - entry->failedFrame > g_glyphCacheMinUnusedFrames;
+}
+
+bool GlyphCache_GetGlyph(FontObj* font, unsigned int code, Glyph*& glyph, TextureObj*& texture)
+{
+	GlyphCacheEntry* entry = GlyphCache_FindOrAddEntry(font, code);
+	if (!entry->isValid)
+		return false;
+
+	entry->lastUsedFrame = g_frameIndex;
+	glyph = &entry->glyph;
+	texture = entry->pageIndex != -1 ? g_glyphCachePages[entry->pageIndex].texture : NULL;
+
+	// Queue for rasterization if missing
+
+	if (GlyphCache_NeedsRasterization(entry))
+	{
+		entry->isPending = true;
+		g_glyphCachePending.push_back(GlyphCacheKey(font, code));
 	}
 
-	// Construct font texture
+	return true;
+}
+
+void GlyphCache_JobFunc(void* userData)
+{
+	GlyphCacheJobData* jobData = (GlyphCacheJobData*) userData;
+
+	TTF_Font* face = jobData->usePrivateFace ? Font_OpenFace(jobData->font) : jobData->font->font;
+	if (!face)
+		return;
 
 	SDL_Color white;
 	white.r = 255;
@@ -1603,38 +2161,33 @@ void Font_CacheGlyphs(FontObj* font, unsigned int* buffer, int bufferSize)
 	white.b = 255;
 	white.a = 255;
 
-	for (std::vector<RectPacker::Rect>::iterator it = packerRects.begin(); it != packerRects.end(); ++it)
+	for (std::vector<GlyphRasterizationRequest>::iterator it = jobData->requests.begin(); it != jobData->requests.end(); ++it)
 	{
-		Glyph* glyph = (Glyph*) it->userData;
-
-		glyph->uv.left = (float) it->x / (float) textureWidth;
-		glyph->uv.top = (float) it->y / (float) textureHeight;
-		glyph->uv.width = (float) it->w / (float) textureWidth;
-		glyph->uv.height = (float) it->h / (float) textureHeight;
-
-		const unsigned short codes[2] = {(unsigned short) glyph->code, (unsigned short) '\0' };
-		SDL_Surface* glyphSurface = TTF_RenderUNICODE_Blended(font->font, codes, white);
+		// Render the glyph
+
+		const unsigned short codes[2] = {(unsigned short) it->code, (unsigned short) '\0' };
+		if (!jobData->usePrivateFace)
+			SDL_LockMutex(g_ttfMutex);
+		SDL_Surface* glyphSurface = TTF_RenderUNICODE_Blended(face, codes, white);
+		if (!jobData->usePrivateFace)
+			SDL_UnlockMutex(g_ttfMutex);
 		if (!glyphSurface)
 			continue;
 
+		// Crop to non-transparent pixels
+
 		int minX = INT_MAX, maxX = INT_MIN, minY = INT_MAX, maxY = INT_MIN;
 		for (int y = 0; y < glyphSurface->h; y++)
-		{
 			for (int x = 0; x < glyphSurface->w; x++)
-			{
-				const unsigned char alpha = ((unsigned char*) glyphSurface->pixels)[(x + y * glyphSurface->w) * 4 + 3];
-
-				if (alpha)
+				if (((unsigned char*) glyphSurface->pixels)[x * 4 + y * glyphSurface->pitch + 3])
 				{
 					minX = min(minX, x);
 					maxX = max(maxX, x);
 					minY = min(minY, y);
 					maxY = max(maxY, y);
 				}
-			}
-		}
 
-		if (it->w && it->h)
+		if (minX <= maxX)
 		{
 			SDL_Rect glyphSrcRect;
 			glyphSrcRect.x = minX;
@@ -1642,288 +2195,2051 @@ void Font_CacheGlyphs(FontObj* font, unsigned int* buffer, int bufferSize)
 			glyphSrcRect.w = maxX - minX + 1;
 			glyphSrcRect.h = maxY - minY + 1;
 
-			glyph->pos.left = (float) minX;
-			glyph->pos.top = (float) minY;
-
 			SDL_Rect glyphDstRect;
-			glyphDstRect.x = it->x;
-			glyphDstRect.y = it->y;
-			glyphDstRect.w = it->w;
-			glyphDstRect.h = it->h;
+			glyphDstRect.x = 1;
+			glyphDstRect.y = 1;
+			glyphDstRect.w = glyphSrcRect.w;
+			glyphDstRect.h = glyphSrcRect.h;
 
-			SDL_BlitSurface(glyphSurface, &glyphSrcRect, surface, &glyphDstRect);
+			it->surface = SDL_CreateRGBSurface(0, glyphSrcRect.w + 2, glyphSrcRect.h + 2, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+			if (it->surface)
+			{
+				SDL_SetSurfaceBlendMode(glyphSurface, SDL_BLENDMODE_NONE);
+				SDL_BlitSurface(glyphSurface, &glyphSrcRect, it->surface, &glyphDstRect);
+				it->left = minX;
+				it->top = minY;
+			}
 		}
 
 		SDL_FreeSurface(glyphSurface);
-
-		font->glyphs[glyph->code] = *glyph;
 	}
 
-	// Create texture from surface
-
-	font->texture = Texture_CreateFromSurface(NULL, surface);
-	if (!font->texture)
-	{
-		Log::Error(string_format("Failed to create texture from surface while (re)generating font %s", font->name.c_str()));
-		return;
-	}
-	font->texture->refCount = 1; // Increase refcount manually to prevent texture from being added to managed resources
+	if (jobData->usePrivateFace)
+		Font_CloseFace(face);
 }
 
-void Font_CalculateSize(FontObj* font, const Text::DrawParams* params, float& width, float& height)
+void GlyphCache_DoneFunc(bool canceled, void* userData)
 {
-	int widthInt, heightInt;
-	const int result = TTF_SizeUTF8(font->font, params->text.c_str(), &widthInt, &heightInt);
-	(void) result;
-	width = (float) widthInt;
-	height = (float) heightInt;
-}
+	GlyphCacheJobData* jobData = (GlyphCacheJobData*) userData;
 
-// Asynchronous stuff
+	static int lastCacheFullWarningFrame = INT_MIN;
 
-struct Job
-{
-	Jobs::JobID id;
-	Jobs::JobFunc jobFunc;
-	Jobs::DoneFunc doneFunc;
-	void* userData;
-};
+	for (std::vector<GlyphRasterizationRequest>::iterator it = jobData->requests.begin(); it != jobData->requests.end(); ++it)
+	{
+		const GlyphCacheKey key(jobData->font, it->code);
+		GlyphCacheEntry* entry = map_find(g_glyphCacheEntries, key);
+		if (!entry || canceled || !it->surface)
+		{
+			if (entry)
+			{
+				entry->isPending = false;
+				entry->failedFrame = g_frameIndex;
+			}
+			if (it->surface)
+				SDL_FreeSurface(it->surface);
+			continue;
+		}
+		entry->isPending = false;
 
-volatile bool quitJobSystem = false;
-SDL_mutex* jobMutex = NULL;
-SDL_Thread* thread = NULL;
-std::list<Job> jobs;
-std::list<Job> doneJobs;
-volatile int numJobs = 0;
-volatile Jobs::JobID currentJobID = 0;
+		// Find space for the glyph
 
-int Jobs_MainFunc(void*)
-{
-	while (!quitJobSystem)
-	{
-		// Get next job off the queue
+		const int width = it->surface->w - 2;
+		const int height = it->surface->h - 2;
+		const int cellSize = GlyphCache_GetCellSize(width, height);
 
-		SDL_LockMutex(jobMutex);
-		if (jobs.empty())
+		int pageIndex, cellIndex;
+		if (cellSize > g_glyphCachePageSize || !GlyphCache_AllocateCell(cellSize, pageIndex, cellIndex))
 		{
-			SDL_UnlockMutex(jobMutex);
-			SDL_Delay(10);
+			entry->failedFrame = g_frameIndex;
+			if (lastCacheFullWarningFrame != g_frameIndex)
+			{
+				lastCacheFullWarningFrame = g_frameIndex;
+				Log::Warn(string_format("Glyph cache full (%d pages of %dx%d), consider increasing App::StartupParams::glyphCacheMaxMemory", (int) g_glyphCachePages.size(), g_glyphCachePageSize, g_glyphCachePageSize));
+			}
+			SDL_FreeSurface(it->surface);
 			continue;
 		}
-		Job job = jobs.front();
-		jobs.pop_front();
-		currentJobID = job.id;
-		SDL_UnlockMutex(jobMutex);
 
-		// Do the job
+		// Upload to atlas page
+
+		GlyphCachePage& page = g_glyphCachePages[pageIndex];
+		const int numCellsPerRow = g_glyphCachePageSize / page.cellSize;
+		const int cellX = (cellIndex % numCellsPerRow) * page.cellSize;
+		const int cellY = (cellIndex / numCellsPerRow) * page.cellSize;
+
+		GL(glBindTexture(GL_TEXTURE_2D, page.texture->handle));
+		GL(glTexSubImage2D(GL_TEXTURE_2D, 0, cellX, cellY, it->surface->w, it->surface->h, GL_RGBA, GL_UNSIGNED_BYTE, it->surface->pixels));
+		SDL_FreeSurface(it->surface);
+
+		page.cellOwners[cellIndex] = key;
+		entry->pageIndex = pageIndex;
+		entry->cellIndex = cellIndex;
+
+		Glyph& glyph = entry->glyph;
+		glyph.pos.left = (float) it->left;
+		glyph.pos.top = (float) it->top;
+		glyph.pos.width = (float) width;
+		glyph.pos.height = (float) height;
+		glyph.uv.left = (float) (cellX + 1) / (float) g_glyphCachePageSize;
+		glyph.uv.top = (float) (cellY + 1) / (float) g_glyphCachePageSize;
+		glyph.uv.width = (float) width / (float) g_glyphCachePageSize;
+		glyph.uv.height = (float) height / (float) g_glyphCachePageSize;
+	}
 
-		job.jobFunc(job.userData);
+	vector_remove(g_glyphCacheJobIDs, jobData->jobID);
 
-		// Finalize the job
+	// Finalize asynchronous font creation once all initial glyphs are done
 
-		SDL_LockMutex(jobMutex);
-		currentJobID = 0;
-		if (job.doneFunc)
-			doneJobs.push_back(job); // Transfer to done jobs queue for main thread processing
-		else
-			--numJobs;
-		SDL_UnlockMutex(jobMutex);
+	FontObj* font = jobData->font;
+	if (jobData->isFontCreation && --font->numCreationJobs == 0)
+	{
+		font->state = ResourceState_Created;
+		Log::Info(string_format("Font %s finished async loading", font->name.c_str()));
 	}
-	return 0;
-}
 
-void Jobs_Init()
-{
-	quitJobSystem = false;
-	jobMutex = SDL_CreateMutex();
-	SDL_CreateThread(Jobs_MainFunc, "jobsys", NULL);
+	delete jobData;
 }
 
-void Jobs_Deinit()
+int GlyphCache_RunJobs(FontObj* font, const std::vector<unsigned int>& codes, bool isFontCreation)
 {
-	quitJobSystem = true;
-	int status;
-	SDL_WaitThread(thread, &status);
-	SDL_DestroyMutex(jobMutex);
-	jobMutex = NULL;
-}
+	if (codes.empty())
+		return 0;
 
-void Jobs::UpdateDoneJobs(float maxTime)
-{
-	const Time::Ticks maxTicks = Time::SecondsToTicks(maxTime);
-	const Time::Ticks startTicks = Time::GetTicks();
+	// Split large batches across job threads
 
-	while (1)
+	const int numJobs = g_supportAsynchronousResourceLoading ?
+		clamp((int) codes.size() / GLYPH_CACHE_MIN_GLYPHS_PER_JOB, 1, Jobs::GetNumWorkerThreads()) :
+		1;
+	const int numCodesPerJob = ((int) codes.size() + numJobs - 1) / numJobs;
+
+	for (int i = 0; i < numJobs; i++)
 	{
-		SDL_LockMutex(jobMutex);
-		if (doneJobs.empty())
+		GlyphCacheJobData* jobData = new GlyphCacheJobData();
+		jobData->jobID = 0;
+		jobData->font = font;
+		jobData->usePrivateFace = numJobs > 1;
+		jobData->isFontCreation = isFontCreation;
+
+		const int firstCode = i * numCodesPerJob;
+		const int lastCode = min((int) codes.size(), firstCode + numCodesPerJob);
+		for (int j = firstCode; j < lastCode; j++)
 		{
-			SDL_UnlockMutex(jobMutex);
-			break;
+			GlyphRasterizationRequest& request = vector_add(jobData->requests);
+			request.code = codes[j];
+			request.surface = NULL;
+			request.left = 0;
+			request.top = 0;
 		}
-		Job doneJob = doneJobs.front();
-		doneJobs.pop_front();
-		SDL_UnlockMutex(jobMutex);
-
-		doneJob.doneFunc(false, doneJob.userData);
-		--numJobs;
 
-		const Time::Ticks currentTicks = Time::GetTicks();
-		if (currentTicks - startTicks >= maxTicks)
-			break;
+		if (g_supportAsynchronousResourceLoading)
+		{
+			jobData->jobID = Jobs::RunJob(GlyphCache_JobFunc, GlyphCache_DoneFunc, jobData);
+			g_glyphCacheJobIDs.push_back(jobData->jobID);
+		}
+		else
+		{
+			GlyphCache_JobFunc(jobData);
+			GlyphCache_DoneFunc(false, jobData);
+		}
 	}
+
+	return numJobs;
 }
 
-bool Jobs_IsJobWaiting(Jobs::JobID id)
+void GlyphCache_Update()
 {
-	SDL_LockMutex(jobMutex);
-	if (currentJobID == id)
+	if (g_glyphCachePending.empty())
+		return;
+
+	// Group pending glyphs by font
+
+	std::map<FontObj*, std::vector<unsigned int> > codesPerFont;
+	for (std::vector<GlyphCacheKey>::iterator it = g_glyphCachePending.begin(); it != g_glyphCachePending.end(); ++it)
+		codesPerFont[it->first].push_back(it->second);
+	g_glyphCachePending.clear();
+
+	for (std::map<FontObj*, std::vector<unsigned int> >::iterator it = codesPerFont.begin(); it != codesPerFont.end(); ++it)
+		GlyphCache_RunJobs(it->first, it->second, false);
+}
+
+void GlyphCache_WaitForAllJobs()
+{
+	while (g_glyphCacheJobIDs.size())
+		Jobs::WaitForJob(g_glyphCacheJobIDs.back());
+}
+
+void GlyphCache_RemoveFont(FontObj* font)
+{
+	// Make sure the font isn't used by rasterization jobs
+
+	GlyphCache_WaitForAllJobs();
+
+	// Remove all font's glyphs
+
+	std::map<GlyphCacheKey, GlyphCacheEntry>::iterator it = g_glyphCacheEntries.lower_bound(GlyphCacheKey(font, 0));
+	while (it != g_glyphCacheEntries.end() && it->first.first == font)
 	{
-		SDL_UnlockMutex(jobMutex);
-		return true;
+		if (it->second.pageIndex != -1)
+			GlyphCache_EvictCell(it->second.pageIndex, it->second.cellIndex);
+		g_glyphCacheEntries.erase(it++);
 	}
-	for (std::list<Job>::iterator it = jobs.begin(); it != jobs.end(); ++it)
-		if (it->id == id)
-		{
-			SDL_UnlockMutex(jobMutex);
-			return true;
-		}
-	SDL_UnlockMutex(jobMutex);
-	return false;
+
+	for (int i = (int) g_glyphCachePending.size() - 1; i >= 0; i--)
+		if (g_glyphCachePending[i].first == font)
+			vector_remove_at(g_glyphCachePending, i);
 }
 
-void Jobs::WaitForJob(JobID id)
+void GlyphCache_Deinit()
 {
-	while (Jobs_IsJobWaiting(id))
-		App::Sleep(0.1f);
+	GlyphCache_WaitForAllJobs();
 
-	SDL_LockMutex(jobMutex);
-	for (std::list<Job>::iterator it = doneJobs.begin(); it != doneJobs.end(); ++it)
-		if (it->id == id)
-		{
-			Job job = *it;
-			doneJobs.erase(it);
-			SDL_UnlockMutex(jobMutex);
-			job.doneFunc(false, job.userData);
-			--numJobs;
-			return;
-		}
-	SDL_UnlockMutex(jobMutex);
+	for (std::vector<GlyphCachePage>::iterator it = g_glyphCachePages.begin(); it != g_glyphCachePages.end(); ++it)
+		Texture_Destroy(it->texture);
+	g_glyphCachePages.clear();
+	g_glyphCacheEntries.clear();
+	g_glyphCachePending.clear();
 }
 
-void Jobs::CancelJob(JobID id)
+// FontObj
+
+bool Font_LoadBaked(FontObj* font, const std::string& faceName, int size, unsigned int flags)
 {
-	SDL_LockMutex(jobMutex);
-	if (currentJobID == id)
-	{
-		SDL_UnlockMutex(jobMutex);
+	const std::string basePath = Font_GetBakedBasePath(faceName, size, flags);
+
+	// Load glyph metrics
+
+	FileViewObj* view = File_Map(basePath + ".font");
+	if (!view)
+		return false;
+
+	const BakedFontHeader* header = (const BakedFontHeader*) view->data;
+	if (view->size < sizeof(BakedFontHeader) ||
+		header->magic != BAKED_FONT_MAGIC ||
+		header->version != BAKED_FONT_VERSION ||
+		header->size != size ||
+		header->flags != flags)
+	{
+		Log::Warn(string_format("Ignoring prebaked font %s.font, reason: invalid header or version mismatch", basePath.c_str()));
+		File_Unmap(view);
+		return false;
+	}
+
+	if (view->size < sizeof(BakedFontHeader) + sizeof(Glyph) * header->numGlyphs)
+	{
+		Log::Warn(string_format("Ignoring prebaked font %s.font, reason: truncated glyph table", basePath.c_str()));
+		File_Unmap(view);
+		return false;
+	}
+
+	// Load atlas
+
+	FileViewObj* atlasView = File_Map(basePath + ".png");
+	SDL_Surface* surface = atlasView ? Image_LoadFromView(atlasView) : NULL;
+	if (!surface)
+	{
+		Log::Warn(string_format("Ignoring prebaked font %s.font, reason: failed to load atlas %s.png", basePath.c_str(), basePath.c_str()));
+		File_Unmap(view);
+		return false;
+	}
+
+	font->texture = Texture_CreateFromSurface(NULL, surface);
+	if (!font->texture)
+	{
+		File_Unmap(view);
+		return false;
+	}
+	SDL_AtomicSet(&font->texture->refCount, 1); // Increase refcount manually to prevent texture from being added to managed resources
+
+	const Glyph* glyphs = (const Glyph*) (header + 1);
+	for (unsigned int i = 0; i < header->numGlyphs; i++)
+		font->glyphs[glyphs[i].code] = glyphs[i];
+	font->lineHeight = header->lineHeight;
+
+	Log::Info(string_format("Loaded prebaked font %s (%u glyphs)", basePath.c_str(), header->numGlyphs));
+	File_Unmap(view);
+	return true;
+}
+
+struct FontJobData
+{
+	FontObj* resource;
+	std::string faceName;
+	TTF_Font* face;
+};
+
+void Font_ReadFunc(void*& data, size_t size, void* userData)
+{
+	FontJobData* jobData = (FontJobData*) userData;
+	FontObj* resource = jobData->resource;
+
+	if (!data)
+	{
+		Log::Error(string_format("Failed to create font from %s, reason: failed to load file", jobData->faceName.c_str()));
+		return;
+	}
+
+	// Font keeps the data for glyph rasterization
+
+	resource->fileView = File_CreateView(data, size);
+	data = NULL;
+
+	jobData->face = Font_OpenFace(resource);
+	if (!jobData->face)
+		Log::Error(string_format("Failed to load font from %s, reason: %s", jobData->faceName.c_str(), SDL_GetError()));
+}
+
+void Font_DoneFunc(bool canceled, void* userData)
+{
+	FontJobData* jobData = (FontJobData*) userData;
+	FontObj* resource = jobData->resource;
+
+	if (!jobData->face)
+	{
+		resource->state = ResourceState_AsyncError;
+		if (canceled)
+			Log::Info(string_format("Font %s async loading was canceled", resource->name.c_str()));
+		else
+			Log::Error(string_format("Font %s async loading failed", resource->name.c_str()));
+		delete jobData;
+		return;
+	}
+
+	resource->font = jobData->face;
+	resource->lineHeight = TTF_FontHeight(jobData->face);
+	delete jobData;
+
+	// Rasterize initial glyph set (printable ASCII and glyphs requested meanwhile) in parallel; the font becomes created when all of these are done
+
+	for (unsigned int code = 0x20; code < 0x7F; code++)
+		resource->precacheCodes.push_back(code);
+
+	std::vector<unsigned int> codes;
+	for (std::vector<unsigned int>::iterator it = resource->precacheCodes.begin(); it != resource->precacheCodes.end(); ++it)
+	{
+		GlyphCacheEntry* entry = GlyphCache_FindOrAddEntry(resource, *it);
+		if (GlyphCache_NeedsRasterization(entry))
+		{
+			entry->isPending = true;
+			codes.push_back(*it);
+		}
+	}
+	std::vector<unsigned int>().swap(resource->precacheCodes);
+
+	resource->numCreationJobs = GlyphCache_RunJobs(resource, codes, true);
+	if (!resource->numCreationJobs)
+	{
+		resource->state = ResourceState_Created;
+		Log::Info(string_format("Font %s finished async loading", resource->name.c_str()));
+	}
+}
+
+// Registers created font unless the same font got registered concurrently
+FontObj* Font_Register(FontObj* resource)
+{
+	FontObj* registered = static_cast<FontObj*>(Resource_FindOrRegister(resource));
+	if (registered != resource)
+		Font_Destroy(resource);
+	return registered;
+}
+
+FontObj* Font_Create(const std::string& faceName, int size, unsigned int flags, bool immediate)
+{
+	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	LoadGroup_OnResourceRequested(LoadGroupItemType_Font, faceName, size, flags);
+
+	const std::string name = string_format("%s:%d:%u", faceName.c_str(), size, flags);
+
+	FontObj* resource = static_cast<FontObj*>(Resource_FindAndIncRefCount("font", name));
+	if (resource)
+		return resource;
+
+	resource = new FontObj();
+	resource->name = name;
+	resource->size = size;
+	resource->flags = flags;
+
+	// Prefer prebaked font if available
+
+	if (Font_LoadBaked(resource, faceName, size, flags))
+	{
+		resource->state = ResourceState_Created;
+		return Font_Register(resource);
+	}
+
+	// Fall back to TTF rasterization at runtime
+
+	if (immediate)
+	{
+		if (!(resource->fileView = File_Map(faceName)))
+		{
+			Log::Error(string_format("Failed to create font from %s, reason: failed to load file", faceName.c_str()));
+			delete resource;
+			return NULL;
+		}
+
+		resource->font = Font_OpenFace(resource);
+		if (!resource->font)
+		{
+			Log::Error(string_format("Failed to load font from %s, reason: %s", faceName.c_str(), SDL_GetError()));
+			File_Unmap(resource->fileView);
+			delete resource;
+			return NULL;
+		}
+
+		resource->state = ResourceState_Created;
+		resource->lineHeight = TTF_FontHeight(resource->font);
+		return Font_Register(resource);
+	}
+	else
+	{
+		resource->state = ResourceState_Creating;
+
+		FontObj* registered = static_cast<FontObj*>(Resource_FindOrRegister(resource));
+		if (registered != resource)
+		{
+			delete resource;
+			return registered;
+		}
+
+		FontJobData* jobData = new FontJobData();
+		jobData->resource = resource;
+		jobData->faceName = faceName;
+		jobData->face = NULL;
+		resource->jobID = File_ReadAsync(faceName, NULL, 0, 0, Font_ReadFunc, Font_DoneFunc, jobData);
+	}
+
+	return resource;
+}
+
+void Font_Destroy(FontObj* font)
+{
+	if (!Resource_DecRefCount(font))
+	{
+		if (font->state == ResourceState_Creating)
+			Jobs::CancelJob(font->jobID);
+
+		if (font->texture)
+			Texture_Destroy(font->texture);
+		if (font->fileView)
+			GlyphCache_RemoveFont(font);
+		if (font->font)
+			Font_CloseFace(font->font);
+		if (font->fileView)
+			File_Unmap(font->fileView);
+		delete font;
+	}
+}
+
+void Font_CacheGlyphs(FontObj* font, unsigned int* buffer, int bufferSize)
+{
+	// Rasterize along with initial glyph set if still being created
+
+	if (font->state == ResourceState_Creating)
+	{
+		font->precacheCodes.insert(font->precacheCodes.end(), buffer, buffer + bufferSize);
+		return;
+	}
+
+	// Prebaked fonts can't rasterize new glyphs
+
+	if (!font->font)
+		return;
+
+	// Request all glyphs from the glyph cache; missing ones get rasterized in the background
+
+	Glyph* glyph;
+	TextureObj* texture;
+	for (int i = 0; i < bufferSize; i++)
+		Font_GetGlyph(font, buffer[i], glyph, texture);
+}
+
+bool Font_GetGlyph(FontObj* font, unsigned int code, Glyph*& glyph, TextureObj*& texture)
+{
+	if (font->state != ResourceState_Created)
+		return false;
+
+	if (!font->font)
+	{
+		glyph = map_find(font->glyphs, code);
+		texture = font->texture;
+		return glyph != NULL;
+	}
+	return GlyphCache_GetGlyph(font, code, glyph, texture);
+}
+
+void Font_CalculateSize(FontObj* font, const Text::DrawParams* params, float& width, float& height)
+{
+	if (font->state != ResourceState_Created)
+	{
+		width = height = 0.0f;
+		return;
+	}
+
+	// Prebaked font: sum up glyph advances
+
+	if (!font->font)
+	{
+		std::vector<unsigned int> buffer(params->text.length() + 1); // UTF-32 never has more code points than UTF-8 has bytes
+		unsigned int bufferSize = (unsigned int) buffer.size();
+		width = height = 0.0f;
+		if (!UTF8ToUTF32((const unsigned char*) params->text.c_str(), params->text.length(), &buffer[0], bufferSize))
+			return;
+
+		float lineWidth = 0.0f;
+		for (unsigned int i = 0; i < bufferSize; i++)
+		{
+			if (buffer[i] == '\n')
+			{
+				lineWidth = 0.0f;
+				continue;
+			}
+			if (Glyph* glyph = map_find(font->glyphs, buffer[i]))
+				lineWidth += glyph->advancePos;
+			width = max(width, lineWidth);
+		}
+		height = (float) font->lineHeight;
+		return;
+	}
+
+	int widthInt, heightInt;
+	SDL_LockMutex(g_ttfMutex);
+	const int result = TTF_SizeUTF8(font->font, params->text.c_str(), &widthInt, &heightInt);
+	SDL_UnlockMutex(g_ttfMutex);
+	(void) result;
+	width = (float) widthInt;
+	height = (float) heightInt;
+}
+
+// Asynchronous stuff
+
+struct Job
+{
+	Jobs::JobID id;
+	Jobs::JobFunc jobFunc;
+	Jobs::DoneFunc doneFunc;
+	void* userData;
+	bool isReady;	// Jobs that aren't ready (e.g. waiting for asynchronous file read) stay queued until Jobs_SetJobReady()
+};
+
+#define MAX_JOB_THREADS 8
+
+volatile bool quitJobSystem = false;
+SDL_mutex* jobMutex = NULL;
+SDL_Thread* threads[MAX_JOB_THREADS];
+int numThreads = 0;
+std::list<Job> jobs;
+std::list<Job> doneJobs;
+volatile int numJobs = 0;
+volatile Jobs::JobID currentJobIDs[MAX_JOB_THREADS]; // Id of the job being done by each thread or 0
+
+int Jobs_MainFunc(void* data)
+{
+	const int threadIndex = (int) (size_t) data;
+
+	while (!quitJobSystem)
+	{
+		// Get next job off the queue
+
+		SDL_LockMutex(jobMutex);
+		std::list<Job>::iterator it = jobs.begin();
+		while (it != jobs.end() && !it->isReady)
+			++it;
+		if (it == jobs.end())
+		{
+			SDL_UnlockMutex(jobMutex);
+			SDL_Delay(10);
+			continue;
+		}
+		Job job = *it;
+		jobs.erase(it);
+		currentJobIDs[threadIndex] = job.id;
+		SDL_UnlockMutex(jobMutex);
+
+		// Do the job
+
+		job.jobFunc(job.userData);
+
+		// Finalize the job
+
+		SDL_LockMutex(jobMutex);
+		currentJobIDs[threadIndex] = 0;
+		if (job.doneFunc)
+			doneJobs.push_back(job); // Transfer to done jobs queue for main thread processing
+		else
+			--numJobs;
+		SDL_UnlockMutex(jobMutex);
+	}
+	return 0;
+}
+
+void Jobs_Init()
+{
+	quitJobSystem = false;
+	jobMutex = SDL_CreateMutex();
+
+	// One thread per core except for the main one
+
+	numThreads = clamp(SDL_GetCPUCount() - 1, 1, MAX_JOB_THREADS);
+	for (int i = 0; i < numThreads; i++)
+	{
+		currentJobIDs[i] = 0;
+		threads[i] = SDL_CreateThread(Jobs_MainFunc, "jobsys", (void*) (size_t) i);
+	}
+	Log::Info(string_format("Started %d job threads", numThreads));
+}
+
+void Jobs_Deinit()
+{
+	quitJobSystem = true;
+	for (int i = 0; i < numThreads; i++)
+	{
+		int status;
+		SDL_WaitThread(threads[i], &status);
+		threads[i] = NULL;
+	}
+	numThreads = 0;
+	SDL_DestroyMutex(jobMutex);
+	jobMutex = NULL;
+}
+
+int Jobs::GetNumWorkerThreads()
+{
+	return numThreads;
+}
+
+void Jobs::UpdateDoneJobs(float maxTime)
+{
+	const Time::Ticks maxTicks = Time::SecondsToTicks(maxTime);
+	const Time::Ticks startTicks = Time::GetTicks();
+
+	while (1)
+	{
+		SDL_LockMutex(jobMutex);
+		if (doneJobs.empty())
+		{
+			SDL_UnlockMutex(jobMutex);
+			break;
+		}
+		Job doneJob = doneJobs.front();
+		doneJobs.pop_front();
+		SDL_UnlockMutex(jobMutex);
+
+		doneJob.doneFunc(false, doneJob.userData);
+		SDL_LockMutex(jobMutex);
+		--numJobs;
+		SDL_UnlockMutex(jobMutex);
+
+		const Time::Ticks currentTicks = Time::GetTicks();
+		if (currentTicks - startTicks >= maxTicks)
+			break;
+	}
+}
+
+bool Jobs_IsJobWaiting(Jobs::JobID id)
+{
+	SDL_LockMutex(jobMutex);
+	for (int i = 0; i < numThreads; i++)
+		if (currentJobIDs[i] == id)
+		{
+			SDL_UnlockMutex(jobMutex);
+			return true;
+		}
+	for (std::list<Job>::iterator it = jobs.begin(); it != jobs.end(); ++it)
+		if (it->id == id)
+		{
+			SDL_UnlockMutex(jobMutex);
+			return true;
+		}
+	SDL_UnlockMutex(jobMutex);
+	return false;
+}
+
+bool Jobs_IsJobRunning(Jobs::JobID id)
+{
+	for (int i = 0; i < numThreads; i++)
+		if (currentJobIDs[i] == id)
+			return true;
+	return false;
+}
+
+void Jobs::WaitForJob(JobID id)
+{
+	while (Jobs_IsJobWaiting(id))
+		App::Sleep(0.001f);
+
+	SDL_LockMutex(jobMutex);
+	for (std::list<Job>::iterator it = doneJobs.begin(); it != doneJobs.end(); ++it)
+		if (it->id == id)
+		{
+			Job job = *it;
+			doneJobs.erase(it);
+			SDL_UnlockMutex(jobMutex);
+			job.doneFunc(false, job.userData);
+			SDL_LockMutex(jobMutex);
+			--numJobs;
+			SDL_UnlockMutex(jobMutex);
+			return;
+		}
+	SDL_UnlockMutex(jobMutex);
+}
+
+void Jobs::CancelJob(JobID id)
+{
+	SDL_LockMutex(jobMutex);
+	if (Jobs_IsJobRunning(id))
+	{
+		SDL_UnlockMutex(jobMutex);
 		Jobs::WaitForJob(id);
 		return;
 	}
-	for (std::list<Job>::iterator it = jobs.begin(); it != jobs.end(); ++it)
-		if (it->id == id)
+	for (std::list<Job>::iterator it = jobs.begin(); it != jobs.end(); ++it)
+		if (it->id == id)
+		{
+			Job job = *it;
+			jobs.erase(it);
+			SDL_UnlockMutex(jobMutex);
+			if (job.doneFunc)
+				job.doneFunc(true, job.userData);
+			SDL_LockMutex(jobMutex);
+			--numJobs;
+			SDL_UnlockMutex(jobMutex);
+			return;
+		}
+	for (std::list<Job>::iterator it = doneJobs.begin(); it != doneJobs.end(); ++it)
+		if (it->id == id)
+		{
+			Job job = *it;
+			doneJobs.erase(it);
+			SDL_UnlockMutex(jobMutex);
+			job.doneFunc(false, job.userData);
+			SDL_LockMutex(jobMutex);
+			--numJobs;
+			SDL_UnlockMutex(jobMutex);
+			return;
+		}
+	SDL_UnlockMutex(jobMutex);
+}
+
+int Jobs::GetNumJobsInProgress()
+{
+	return numJobs;
+}
+
+Jobs::JobID Jobs_GenerateNewJobID()
+{
+	static Jobs::JobID id = 1;
+	return ++id;
+}
+
+Jobs::JobID Jobs_RunJob(Jobs::JobFunc jobFunc, Jobs::DoneFunc doneFunc, void* userData, bool isReady)
+{
+	Job job;
+	job.jobFunc = jobFunc;
+	job.doneFunc = doneFunc;
+	job.userData = userData;
+	job.isReady = isReady;
+
+	SDL_LockMutex(jobMutex);
+	job.id = Jobs_GenerateNewJobID();
+	jobs.push_back(job);
+	++numJobs;
+	SDL_UnlockMutex(jobMutex);
+
+	return job.id;
+}
+
+Jobs::JobID Jobs::RunJob(Jobs::JobFunc jobFunc, Jobs::DoneFunc doneFunc, void* userData)
+{
+	return Jobs_RunJob(jobFunc, doneFunc, userData, true);
+}
+
+bool Jobs_SetJobReady(Jobs::JobID id)
+{
+	SDL_LockMutex(jobMutex);
+	for (std::list<Job>::iterator it = jobs.begin(); it != jobs.end(); ++it)
+		if (it->id == id)
+		{
+			it->isReady = true;
+			SDL_UnlockMutex(jobMutex);
+			return true;
+		}
+	SDL_UnlockMutex(jobMutex);
+	return false; // Job got canceled
+}
+
+// Memory mapped file
+
+#if defined(__WIN32__) || defined(__WIN64__)
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+struct MappedFile
+{
+	const unsigned char* data;
+	size_t size;
+#if defined(__WIN32__) || defined(__WIN64__)
+	HANDLE fileHandle;
+	HANDLE mappingHandle;
+#endif
+
+	MappedFile() :
+		data(NULL),
+		size(0)
+#if defined(__WIN32__) || defined(__WIN64__)
+		, fileHandle(INVALID_HANDLE_VALUE),
+		mappingHandle(NULL)
+#endif
+	{}
+};
+
+bool MappedFile_Open(MappedFile& file, const std::string& fullPath)
+{
+#if defined(__WIN32__) || defined(__WIN64__)
+	file.fileHandle = CreateFileA(fullPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (file.fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file.fileHandle, &fileSize) || fileSize.QuadPart == 0 || !(file.mappingHandle = CreateFileMappingA(file.fileHandle, NULL, PAGE_READONLY, 0, 0, NULL)))
+	{
+		CloseHandle(file.fileHandle);
+		file.fileHandle = INVALID_HANDLE_VALUE;
+		return false;
+	}
+	file.data = (const unsigned char*) MapViewOfFile(file.mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (!file.data)
+	{
+		CloseHandle(file.mappingHandle);
+		CloseHandle(file.fileHandle);
+		file.mappingHandle = NULL;
+		file.fileHandle = INVALID_HANDLE_VALUE;
+		return false;
+	}
+	file.size = (size_t) fileSize.QuadPart;
+#else
+	const int fd = open(fullPath.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) || fileStat.st_size == 0) // Empty files can't be mapped
+	{
+		close(fd);
+		return false;
+	}
+	void* data = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // Mapping stays valid after closing the descriptor
+	if (data == MAP_FAILED)
+		return false;
+	file.data = (const unsigned char*) data;
+	file.size = (size_t) fileStat.st_size;
+#endif
+	return true;
+}
+
+void MappedFile_Close(MappedFile& file)
+{
+	if (!file.data)
+		return;
+#if defined(__WIN32__) || defined(__WIN64__)
+	UnmapViewOfFile(file.data);
+	CloseHandle(file.mappingHandle);
+	CloseHandle(file.fileHandle);
+	file.fileHandle = INVALID_HANDLE_VALUE;
+	file.mappingHandle = NULL;
+#else
+	munmap((void*) file.data, file.size);
+#endif
+	file.data = NULL;
+	file.size = 0;
+}
+
+// Pack file
+
+struct PackFile
+{
+	std::string path;
+
+	const unsigned char* data;	// Pack file contents; points to either mapping or buffer
+	size_t size;
+	MappedFile mapping;
+	void* buffer;				// Pack file contents loaded into memory when memory mapping isn't possible
+
+	const PackHeader* header;
+	const PackEntry* entries;
+	const char* names;
+
+	PackFile() :
+		data(NULL),
+		size(0),
+		buffer(NULL),
+		header(NULL),
+		entries(NULL),
+		names(NULL)
+	{}
+};
+
+std::vector<PackFile*> g_packFiles; // Ordered from the highest to lowest priority; only modified at startup and shutdown
+
+void PackFile_Unmap(PackFile* pack)
+{
+	MappedFile_Close(pack->mapping);
+	free(pack->buffer);
+	pack->buffer = NULL;
+	pack->data = NULL;
+}
+
+bool PackFile_Load(PackFile* pack)
+{
+	// Memory map the pack from one of the root data directories; fall back to loading it into memory (e.g. for packs stored within Android APK)
+
+	for (std::vector<std::string>::const_iterator it = g_rootDataDirs.begin(); it != g_rootDataDirs.end() && !pack->mapping.data; ++it)
+		MappedFile_Open(pack->mapping, *it + pack->path);
+
+	if (pack->mapping.data)
+	{
+		pack->data = pack->mapping.data;
+		pack->size = pack->mapping.size;
+	}
+	else
+	{
+		int size = 0;
+		if (!File_Load(pack->path, pack->buffer, size))
+			return false;
+		pack->data = (const unsigned char*) pack->buffer;
+		pack->size = (size_t) size;
+		Log::Warn(string_format("Pack %s couldn't be memory mapped and got loaded into memory instead", pack->path.c_str()));
+	}
+
+	// Validate table of contents
+
+	pack->header = (const PackHeader*) pack->data;
+	if (pack->size < sizeof(PackHeader) || pack->header->magic != PACK_MAGIC || pack->header->version != PACK_VERSION)
+	{
+		Log::Error(string_format("Failed to mount pack %s, reason: invalid header or version mismatch", pack->path.c_str()));
+		return false;
+	}
+
+	const size_t tocSize = sizeof(PackHeader) + (size_t) pack->header->numEntries * sizeof(PackEntry) + pack->header->namesSize;
+	if (pack->size < tocSize)
+	{
+		Log::Error(string_format("Failed to mount pack %s, reason: truncated table of contents", pack->path.c_str()));
+		return false;
+	}
+	pack->entries = (const PackEntry*) (pack->header + 1);
+	pack->names = (const char*) (pack->entries + pack->header->numEntries);
+
+	// Entry names are read as C strings, so the names block must be terminated
+
+	if (!pack->header->namesSize || pack->names[pack->header->namesSize - 1] != '\0')
+	{
+		Log::Error(string_format("Failed to mount pack %s, reason: invalid names block", pack->path.c_str()));
+		return false;
+	}
+
+	for (unsigned int i = 0; i < pack->header->numEntries; i++)
+	{
+		const PackEntry& entry = pack->entries[i];
+		if (entry.nameOffset >= pack->header->namesSize || entry.offset > pack->size || entry.packedSize > pack->size - entry.offset ||
+			entry.compression >= PackCompression_COUNT || (entry.compression == PackCompression_None && entry.packedSize != entry.size))
+		{
+			Log::Error(string_format("Failed to mount pack %s, reason: entry %u out of bounds", pack->path.c_str(), i));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Pack_MountAll(const std::vector<std::string>& packFiles)
+{
+	for (std::vector<std::string>::const_iterator it = packFiles.begin(); it != packFiles.end(); ++it)
+	{
+		PackFile* pack = new PackFile();
+		pack->path = *it;
+		if (!PackFile_Load(pack))
+		{
+			Log::Error(string_format("Failed to mount pack %s", it->c_str()));
+			PackFile_Unmap(pack);
+			delete pack;
+			return false;
+		}
+		g_packFiles.push_back(pack);
+		Log::Info(string_format("Mounted pack %s (%u files, %s)", it->c_str(), pack->header->numEntries, pack->mapping.data ? "memory mapped" : "loaded"));
+	}
+	return true;
+}
+
+void Pack_UnmountAll()
+{
+	for (std::vector<PackFile*>::iterator it = g_packFiles.begin(); it != g_packFiles.end(); ++it)
+	{
+		PackFile_Unmap(*it);
+		delete *it;
+	}
+	g_packFiles.clear();
+}
+
+const PackEntry* PackFile_FindEntry(PackFile* pack, const char* name, unsigned int nameHash)
+{
+	// Binary search for the first entry with matching hash, then compare names of all entries with that hash
+
+	const PackEntry* entries = pack->entries;
+	unsigned int first = 0;
+	unsigned int count = pack->header->numEntries;
+	while (count > 0)
+	{
+		const unsigned int step = count / 2;
+		if (entries[first + step].nameHash < nameHash)
+		{
+			first += step + 1;
+			count -= step + 1;
+		}
+		else
+			count = step;
+	}
+
+	for (unsigned int i = first; i < pack->header->numEntries && entries[i].nameHash == nameHash; i++)
+		if (!strcmp(pack->names + entries[i].nameOffset, name))
+			return &entries[i];
+	return NULL;
+}
+
+const PackEntry* Pack_FindEntry(const std::string& name, const void*& packedData)
+{
+	if (g_packFiles.empty())
+		return NULL;
+
+	std::string normalizedName = name;
+	for (size_t i = 0; i < normalizedName.length(); i++)
+		if (normalizedName[i] == '\\')
+			normalizedName[i] = '/';
+	const unsigned int nameHash = string_hash(normalizedName.c_str(), normalizedName.length());
+
+	for (std::vector<PackFile*>::iterator it = g_packFiles.begin(); it != g_packFiles.end(); ++it)
+		if (const PackEntry* entry = PackFile_FindEntry(*it, normalizedName.c_str(), nameHash))
+		{
+			packedData = (*it)->data + entry->offset;
+			return entry;
+		}
+	return NULL;
+}
+
+int SDLCALL RW_CloseOwnedMemory(SDL_RWops* rw)
+{
+	free(rw->hidden.mem.base);
+	SDL_FreeRW(rw);
+	return 0;
+}
+
+void* Pack_DecompressEntry(const std::string& name, const PackEntry* entry, const void* packedData)
+{
+	const size_t size = (size_t) entry->size;
+	void* data = malloc(size + 1);
+	if (!data)
+	{
+		Log::Error(string_format("Failed to allocate %u bytes while decompressing packed file %s", (unsigned int) size, name.c_str()));
+		return NULL;
+	}
+
+	if (!LZ4_Decompress(packedData, (size_t) entry->packedSize, data, size))
+	{
+		free(data);
+		Log::Error(string_format("Failed to decompress packed file %s, reason: corrupted data", name.c_str()));
+		return NULL;
+	}
+
+	((char*) data)[size] = '\0';
+	return data;
+}
+
+SDL_RWops* Pack_OpenEntry(const std::string& name, const PackEntry* entry, const void* packedData)
+{
+	if (entry->compression == PackCompression_None)
+		return SDL_RWFromConstMem(packedData, (int) entry->size);
+
+	// Decompress into memory owned by returned SDL_RWops
+
+	void* data = Pack_DecompressEntry(name, entry, packedData);
+	if (!data)
+		return NULL;
+
+	SDL_RWops* rw = SDL_RWFromConstMem(data, (int) entry->size);
+	if (!rw)
+	{
+		free(data);
+		return NULL;
+	}
+	rw->close = RW_CloseOwnedMemory;
+	return rw;
+}
+
+// File
+
+#include "SDL_rwops.h"
+
+#if !defined(__WIN32__) && !defined(__WIN64__)
+	#include <errno.h>
+	#include <sys/uio.h>
+#endif
+
+struct FileObj
+{
+	File::OpenMode openMode;
+	long long size;				// Read mode only
+	long long offset;			// Current (logical) file offset
+
+	// Underlying file storage; exactly one is used
+
+#if !defined(__WIN32__) && !defined(__WIN64__)
+	int fd;						// Loose file opened for reading; read via pread() which doesn't need locking
+#endif
+	const unsigned char* memory;// Packed file contents; points into pack file mapping or to ownedMemory
+	void* ownedMemory;			// Decompressed packed file contents
+	const PackEntry* packEntry;	// Compressed pack entry opened without decompression (see File_OpenEx); memory is NULL in this case
+	const void* packedData;
+	SDL_RWops* rw;				// Any other file (opened for writing, file within Android APK etc.)
+	SDL_mutex* rwMutex;			// Guards positioning of rw so that ReadAt() can be used from multiple threads
+	long long rwOffset;			// Current offset of rw
+
+	// Read / write buffer
+
+	std::vector<unsigned char> buffer; // Allocated on first use
+	size_t bufferCapacity;
+	long long bufferOffset;		// Read mode: file offset of the first buffered byte
+	size_t bufferSize;			// Read mode: number of buffered bytes; write mode: number of pending bytes
+
+	FileObj() :
+		openMode(File::OpenMode_Read),
+		size(0),
+		offset(0),
+#if !defined(__WIN32__) && !defined(__WIN64__)
+		fd(-1),
+#endif
+		memory(NULL),
+		ownedMemory(NULL),
+		packEntry(NULL),
+		packedData(NULL),
+		rw(NULL),
+		rwMutex(NULL),
+		rwOffset(0),
+		bufferCapacity(g_fileBufferSize > 0 ? (size_t) g_fileBufferSize : 0),
+		bufferOffset(0),
+		bufferSize(0)
+	{}
+};
+
+#if !defined(__WIN32__) && !defined(__WIN64__)
+
+bool File_OpenDescriptor(FileObj* file, const std::string& fullPath)
+{
+	const int fd = open(fullPath.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+	{
+		close(fd);
+		return false;
+	}
+
+#if defined(__LINUX__) || defined(__ANDROID__)
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL); // Most files are read front to back; let the kernel read ahead more aggressively
+#endif
+
+	file->fd = fd;
+	file->size = (long long) fileStat.st_size;
+	return true;
+}
+
+#endif
+
+bool File_OpenLooseFile(FileObj* file, const std::string& name)
+{
+	const std::vector<std::string>& rootDirs = App::GetRootDataDirs();
+	for (std::vector<std::string>::const_iterator it = rootDirs.begin(); it != rootDirs.end(); ++it)
+	{
+		const std::string fullPath = *it + name;
+
+#if !defined(__WIN32__) && !defined(__WIN64__)
+		if (file->openMode == File::OpenMode_Read)
+		{
+			if (File_OpenDescriptor(file, fullPath))
+				return true;
+	#if !defined(__ANDROID__) && !defined(__IPHONEOS__) // SDL can additionally open files from APK / app bundle
+			continue;
+	#endif
+		}
+#endif
+
+		file->rw = SDL_RWFromFile(fullPath.c_str(), file->openMode == File::OpenMode_Read ? "rb" : "wb");
+		if (file->rw)
+		{
+			file->rwMutex = SDL_CreateMutex();
+			if (file->openMode == File::OpenMode_Read)
+				file->size = (long long) SDL_RWsize(file->rw);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool File_OpenPackedFile(FileObj* file, const std::string& name, bool decompress)
+{
+	const void* packedData;
+	const PackEntry* entry = Pack_FindEntry(name, packedData);
+	if (!entry)
+		return false;
+
+	file->size = (long long) entry->size;
+	if (entry->compression == PackCompression_None)
+		file->memory = (const unsigned char*) packedData;
+	else if (!decompress)
+	{
+		file->packEntry = entry;
+		file->packedData = packedData;
+	}
+	else if ((file->ownedMemory = Pack_DecompressEntry(name, entry, packedData)) != NULL)
+		file->memory = (const unsigned char*) file->ownedMemory;
+	else
+		return false;
+	return true;
+}
+
+FileObj* File_OpenEx(const std::string& name, File::OpenMode openMode, bool decompress)
+{
+	FileObj* file = new FileObj();
+	file->openMode = openMode;
+
+	const bool looseFilesFirst = openMode != File::OpenMode_Read || g_looseFilesOverridePacks || g_packFiles.empty();
+	if ((looseFilesFirst && File_OpenLooseFile(file, name)) ||
+		(openMode == File::OpenMode_Read && File_OpenPackedFile(file, name, decompress)) ||
+		(!looseFilesFirst && File_OpenLooseFile(file, name)))
+		return file;
+
+	delete file;
+	return NULL;
+}
+
+FileObj* File_Open(const std::string& name, File::OpenMode openMode)
+{
+	return File_OpenEx(name, openMode, true);
+}
+
+// Reads at given offset bypassing the buffer; thread safe
+
+size_t File_ReadRaw(FileObj* file, long long offset, void* dst, size_t size)
+{
+	if (offset < 0 || offset >= file->size)
+		return 0;
+	if ((unsigned long long) size > (unsigned long long) (file->size - offset))
+		size = (size_t) (file->size - offset);
+
+	if (file->memory)
+	{
+		memcpy(dst, file->memory + offset, size);
+		return size;
+	}
+
+#if !defined(__WIN32__) && !defined(__WIN64__)
+	if (file->fd != -1)
+	{
+		size_t numRead = 0;
+		while (numRead < size)
+		{
+			const ssize_t result = pread(file->fd, (unsigned char*) dst + numRead, size - numRead, (off_t) (offset + numRead));
+			if (result > 0)
+				numRead += (size_t) result;
+			else if (result == 0 || errno != EINTR)
+				break;
+		}
+		return numRead;
+	}
+#endif
+
+	SDL_LockMutex(file->rwMutex);
+	if (file->rwOffset != offset)
+		file->rwOffset = (long long) SDL_RWseek(file->rw, offset, RW_SEEK_SET);
+	const size_t numRead = file->rwOffset == offset ? SDL_RWread(file->rw, dst, 1, size) : 0;
+	file->rwOffset += numRead;
+	SDL_UnlockMutex(file->rwMutex);
+	return numRead;
+}
+
+bool File_Flush(FileObj* file)
+{
+	if (file->openMode != File::OpenMode_Write || !file->bufferSize)
+		return true;
+
+	const bool success = SDL_RWwrite(file->rw, &file->buffer[0], file->bufferSize, 1) == 1;
+	file->bufferSize = 0;
+	return success;
+}
+
+void File_Close(FileObj* file)
+{
+	if (!File_Flush(file))
+		Log::Error("Failed to flush buffered file writes on close");
+
+#if !defined(__WIN32__) && !defined(__WIN64__)
+	if (file->fd != -1)
+		close(file->fd);
+#endif
+	if (file->rw)
+		SDL_RWclose(file->rw);
+	if (file->rwMutex)
+		SDL_DestroyMutex(file->rwMutex);
+	free(file->ownedMemory);
+	delete file;
+}
+
+long long File_GetSize(FileObj* file)
+{
+	if (file->openMode == File::OpenMode_Read)
+		return file->size;
+	File_Flush(file);
+	return (long long) SDL_RWsize(file->rw);
+}
+
+void File_Seek(FileObj* file, long long offset)
+{
+	if (file->openMode == File::OpenMode_Write)
+	{
+		File_Flush(file);
+		SDL_RWseek(file->rw, offset, RW_SEEK_SET);
+	}
+	file->offset = offset;
+}
+
+long long File_GetOffset(FileObj* file)
+{
+	return file->offset;
+}
+
+void File_SetBufferSize(FileObj* file, size_t size)
+{
+	File_Flush(file);
+	file->buffer.clear();
+	file->bufferCapacity = size;
+	file->bufferSize = 0;
+}
+
+size_t File_Read(FileObj* file, void* dst, size_t size)
+{
+	if (file->openMode != File::OpenMode_Read)
+		return 0;
+
+	unsigned char* out = (unsigned char*) dst;
+	size_t numRead = 0;
+	while (numRead < size)
+	{
+		// Copy buffered data
+
+		if (file->offset >= file->bufferOffset && file->offset < file->bufferOffset + (long long) file->bufferSize)
+		{
+			const size_t bufferIndex = (size_t) (file->offset - file->bufferOffset);
+			const size_t count = min(size - numRead, file->bufferSize - bufferIndex);
+			memcpy(out + numRead, &file->buffer[bufferIndex], count);
+			numRead += count;
+			file->offset += count;
+			continue;
+		}
+
+		// Read directly when the remainder doesn't fit the buffer (or the file is in memory anyway)
+
+		const size_t remaining = size - numRead;
+		if (file->memory || remaining >= file->bufferCapacity)
+		{
+			const size_t count = File_ReadRaw(file, file->offset, out + numRead, remaining);
+			numRead += count;
+			file->offset += count;
+			break;
+		}
+
+		// Refill the buffer
+
+		file->buffer.resize(file->bufferCapacity);
+		file->bufferOffset = file->offset;
+		file->bufferSize = File_ReadRaw(file, file->offset, &file->buffer[0], file->bufferCapacity);
+		if (!file->bufferSize)
+			break;
+	}
+	return numRead;
+}
+
+size_t File_ReadAt(FileObj* file, long long offset, const File::Buffer* buffers, int numBuffers)
+{
+	if (file->openMode != File::OpenMode_Read)
+		return 0;
+
+	size_t numRead = 0;
+	int bufferIndex = 0;
+	size_t bufferNumRead = 0; // Number of bytes already read into buffers[bufferIndex]
+
+#if defined(__LINUX__)
+	// Scatter read with a single system call
+
+	if (file->fd != -1 && numBuffers > 1)
+	{
+		std::vector<struct iovec> iovecs(numBuffers);
+		for (int i = 0; i < numBuffers; i++)
 		{
-			Job job = *it;
-			jobs.erase(it);
-			SDL_UnlockMutex(jobMutex);
-			if (job.doneFunc)
-				job.doneFunc(true, job.userData);
-			--numJobs;
-			return;
+			iovecs[i].iov_base = buffers[i].dst;
+			iovecs[i].iov_len = buffers[i].size;
 		}
-	for (std::list<Job>::iterator it = doneJobs.begin(); it != doneJobs.end(); ++it)
-		if (it->id == id)
+		const ssize_t result = preadv(file->fd, &iovecs[0], numBuffers, (off_t) offset);
+		if (result > 0)
 		{
-			Job job = *it;
-			doneJobs.erase(it);
-			SDL_UnlockMutex(jobMutex);
-			job.doneFunc(false, job.userData);
-			--numJobs;
-			return;
+			numRead = (size_t) result;
+			for (bufferNumRead = numRead; bufferIndex < numBuffers && bufferNumRead >= buffers[bufferIndex].size; bufferIndex++)
+				bufferNumRead -= buffers[bufferIndex].size;
 		}
-	SDL_UnlockMutex(jobMutex);
+	}
+#endif
+
+	// Read remaining buffers (all of them when scatter read isn't available, otherwise only after short read)
+
+	for (; bufferIndex < numBuffers; bufferIndex++, bufferNumRead = 0)
+	{
+		const File::Buffer& buffer = buffers[bufferIndex];
+		const size_t remaining = buffer.size - bufferNumRead;
+		const size_t count = File_ReadRaw(file, offset + numRead, (unsigned char*) buffer.dst + bufferNumRead, remaining);
+		numRead += count;
+		if (count < remaining)
+			break;
+	}
+	return numRead;
 }
 
-int Jobs::GetNumJobsInProgress()
+bool File_Write(FileObj* file, const void* src, size_t size)
 {
-	return numJobs;
+	if (file->openMode != File::OpenMode_Write)
+		return false;
+	if (!size)
+		return true; // Nothing to write; also avoids indexing an empty buffer when buffering is disabled
+
+	file->offset += size;
+
+	// Buffer small writes
+
+	if (file->bufferSize + size <= file->bufferCapacity)
+	{
+		file->buffer.resize(file->bufferCapacity);
+		memcpy(&file->buffer[file->bufferSize], src, size);
+		file->bufferSize += size;
+		return true;
+	}
+
+	// Flush and write directly
+
+	return File_Flush(file) && SDL_RWwrite(file->rw, src, size, 1) == 1;
 }
 
-Jobs::JobID Jobs_GenerateNewJobID()
+// Asynchronous file reads
+
+#if defined(__LINUX__) && defined(__has_include)
+	#if __has_include(<linux/io_uring.h>)
+		#include <linux/io_uring.h>
+		#include <sys/syscall.h>
+		#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+			#define SUPPORT_IO_URING
+		#endif
+	#endif
+#endif
+
+#define ASYNC_READ_MAX_THREADS		4	// Number of blocking reader threads when io_uring isn't available
+#define ASYNC_READ_URING_ENTRIES	64	// Max. number of reads in flight with io_uring
+
+struct AsyncRead
 {
-	static Jobs::JobID id = 1;
-	return ++id;
+	SDL_atomic_t refCount;		// One reference held by the reader, one by the job
+	Jobs::JobID jobID;			// Job that gets ready when the data has been read
+
+	std::string path;			// Empty when reading from file opened by the user
+	FileObj* file;
+	long long offset;
+	size_t size;				// Number of bytes to read; 0 indicates reading until the end of the file
+
+	unsigned char* data;		// Null terminated data (size + 1 bytes)
+	size_t numRead;
+	bool success;
+#ifdef SUPPORT_IO_URING
+	struct iovec iov;
+#endif
+
+	File::ReadFunc readFunc;
+	File::ReadDoneFunc doneFunc;
+	void* userData;
+
+	LoadGroupObj* loadGroup;	// Load group to account read bytes to
+};
+
+volatile bool g_quitAsyncReads = false;
+SDL_mutex* g_asyncReadMutex = NULL;
+SDL_sem* g_asyncReadSem = NULL;	// Signaled for each queued read
+std::list<AsyncRead*> g_asyncReadQueue;
+SDL_Thread* g_asyncReadThreads[ASYNC_READ_MAX_THREADS];
+int g_numAsyncReadThreads = 0;
+
+void AsyncRead_Release(AsyncRead* read)
+{
+	if (!SDL_AtomicDecRef(&read->refCount))
+		return;
+	if (read->file && !read->path.empty())
+		File_Close(read->file);
+	if (read->loadGroup)
+		LoadGroup_Release(read->loadGroup);
+	free(read->data);
+	delete read;
 }
 
-Jobs::JobID Jobs::RunJob(Jobs::JobFunc jobFunc, Jobs::DoneFunc doneFunc, void* userData)
+void AsyncRead_Complete(AsyncRead* read, bool success)
 {
-	Job job;
-	job.jobFunc = jobFunc;
-	job.doneFunc = doneFunc;
-	job.userData = userData;
-	job.id = Jobs_GenerateNewJobID();
+	read->success = success;
+	if (read->loadGroup && read->file)
+		LoadGroup_AddBytes(read->loadGroup, 0, (long long) read->size);
+	if (read->data)
+		read->data[read->numRead] = 0;
+	Jobs_SetJobReady(read->jobID); // Fails harmlessly if the job got canceled meanwhile
+	AsyncRead_Release(read);
+}
 
-	SDL_LockMutex(jobMutex);
-	jobs.push_back(job);
-	++numJobs;
-	SDL_UnlockMutex(jobMutex);
+// Opens the file and allocates the destination; returns true if the read is to be done via file descriptor, otherwise completes the read synchronously
 
-	return job.id;
+bool AsyncRead_Prepare(AsyncRead* read, bool canReadViaDescriptor)
+{
+	if (!read->path.empty() && !(read->file = File_OpenEx(read->path, File::OpenMode_Read, false)))
+	{
+		AsyncRead_Complete(read, false); // Reported by read function (e.g. texture might get loaded from fallback path)
+		return false;
+	}
+
+	const long long available = max(read->file->size - read->offset, 0LL);
+	if (!read->size || (unsigned long long) read->size > (unsigned long long) available)
+		read->size = (size_t) available;
+	if (read->loadGroup)
+		LoadGroup_AddBytes(read->loadGroup, (long long) read->size, 0);
+
+	// Compressed packed files get decompressed by the job
+
+	if (read->file->packEntry)
+	{
+		AsyncRead_Complete(read, true);
+		return false;
+	}
+
+	read->data = (unsigned char*) malloc(read->size + 1);
+	if (!read->data)
+	{
+		Log::Error(string_format("Failed to allocate %u bytes for asynchronous read", (unsigned int) read->size));
+		AsyncRead_Complete(read, false);
+		return false;
+	}
+
+#if !defined(__WIN32__) && !defined(__WIN64__)
+	if (canReadViaDescriptor && read->file->fd != -1 && read->size)
+		return true;
+#endif
+
+	read->numRead = File_ReadRaw(read->file, read->offset, read->data, read->size);
+	AsyncRead_Complete(read, read->numRead == read->size);
+	return false;
 }
 
-// File
+void AsyncRead_JobFunc(void* userData)
+{
+	AsyncRead* read = (AsyncRead*) userData;
 
-#include "SDL_rwops.h"
+	// Decompress packed data
 
-FileObj* File_Open(const std::string& name, File::OpenMode openMode)
+	FileObj* file = read->file;
+	if (read->success && file && file->packEntry)
+	{
+		unsigned char* data = (unsigned char*) Pack_DecompressEntry(read->path, file->packEntry, file->packedData);
+		if (data && read->offset > 0)
+			memmove(data, data + read->offset, read->size);
+		read->data = data;
+		read->numRead = data ? read->size : 0;
+		read->success = data != NULL;
+		if (data)
+			data[read->numRead] = 0;
+	}
+
+	void* data = read->success ? read->data : NULL;
+	read->readFunc(data, read->numRead, read->userData);
+	if (read->success && !data) // Ownership taken over by read function
+		read->data = NULL;
+}
+
+void AsyncRead_DoneFunc(bool canceled, void* userData)
 {
-	return (FileObj*) File_OpenSDLFileRW(name, openMode);
+	AsyncRead* read = (AsyncRead*) userData;
+	if (read->doneFunc)
+		read->doneFunc(canceled, read->userData);
+	AsyncRead_Release(read);
 }
 
-void File_Close(FileObj* file)
+int AsyncRead_BlockingThreadFunc(void*)
+{
+	while (1)
+	{
+		SDL_SemWait(g_asyncReadSem);
+
+		SDL_LockMutex(g_asyncReadMutex);
+		if (g_asyncReadQueue.empty())
+		{
+			SDL_UnlockMutex(g_asyncReadMutex);
+			if (g_quitAsyncReads)
+				break;
+			continue;
+		}
+		AsyncRead* read = g_asyncReadQueue.front();
+		g_asyncReadQueue.pop_front();
+		SDL_UnlockMutex(g_asyncReadMutex);
+
+		AsyncRead_Prepare(read, false);
+	}
+	return 0;
+}
+
+#ifdef SUPPORT_IO_URING
+
+struct IOUring
+{
+	int fd;
+	unsigned int numEntries;
+
+	unsigned int* sqHead;
+	unsigned int* sqTail;
+	unsigned int* sqMask;
+	unsigned int* sqArray;
+	struct io_uring_sqe* sqes;
+
+	unsigned int* cqHead;
+	unsigned int* cqTail;
+	unsigned int* cqMask;
+	struct io_uring_cqe* cqes;
+
+	void* sqRing;
+	size_t sqRingSize;
+	void* cqRing;
+	size_t cqRingSize;
+	size_t sqesSize;
+};
+
+IOUring g_ioUring;
+
+bool IOUring_Init(IOUring& ring, unsigned int numEntries)
+{
+	memset(&ring, 0, sizeof(ring));
+
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	ring.fd = (int) syscall(__NR_io_uring_setup, numEntries, &params);
+	if (ring.fd < 0)
+		return false;
+
+	// Map submission and completion rings (single mapping on kernels supporting it) and submission queue entries
+
+	ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	bool singleMapping = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+	singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMapping)
+		ring.sqRingSize = ring.cqRingSize = max(ring.sqRingSize, ring.cqRingSize);
+#endif
+	ring.sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	ring.sqRing = mmap(NULL, ring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+	ring.cqRing = singleMapping ? ring.sqRing : mmap(NULL, ring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+	void* sqes = mmap(NULL, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+	if (ring.sqRing == MAP_FAILED || ring.cqRing == MAP_FAILED || sqes == MAP_FAILED)
+	{
+		if (ring.sqRing != MAP_FAILED)
+			munmap(ring.sqRing, ring.sqRingSize);
+		if (!singleMapping && ring.cqRing != MAP_FAILED)
+			munmap(ring.cqRing, ring.cqRingSize);
+		if (sqes != MAP_FAILED)
+			munmap(sqes, ring.sqesSize);
+		close(ring.fd);
+		return false;
+	}
+
+	unsigned char* sq = (unsigned char*) ring.sqRing;
+	ring.sqHead = (unsigned int*) (sq + params.sq_off.head);
+	ring.sqTail = (unsigned int*) (sq + params.sq_off.tail);
+	ring.sqMask = (unsigned int*) (sq + params.sq_off.ring_mask);
+	ring.sqArray = (unsigned int*) (sq + params.sq_off.array);
+	ring.sqes = (struct io_uring_sqe*) sqes;
+
+	unsigned char* cq = (unsigned char*) ring.cqRing;
+	ring.cqHead = (unsigned int*) (cq + params.cq_off.head);
+	ring.cqTail = (unsigned int*) (cq + params.cq_off.tail);
+	ring.cqMask = (unsigned int*) (cq + params.cq_off.ring_mask);
+	ring.cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
+
+	ring.numEntries = params.sq_entries;
+	return true;
+}
+
+void IOUring_Deinit(IOUring& ring)
+{
+	munmap(ring.sqes, ring.sqesSize);
+	if (ring.cqRing != ring.sqRing)
+		munmap(ring.cqRing, ring.cqRingSize);
+	munmap(ring.sqRing, ring.sqRingSize);
+	close(ring.fd);
+}
+
+void IOUring_QueueRead(IOUring& ring, AsyncRead* read)
 {
-	SDL_RWclose((SDL_RWops*) file);
+	const unsigned int tail = *ring.sqTail;
+	const unsigned int index = tail & *ring.sqMask;
+
+	read->iov.iov_base = read->data + read->numRead;
+	read->iov.iov_len = read->size - read->numRead;
+
+	struct io_uring_sqe* sqe = &ring.sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = read->file->fd;
+	sqe->addr = (unsigned long long) (size_t) &read->iov;
+	sqe->len = 1;
+	sqe->off = (unsigned long long) (read->offset + read->numRead);
+	sqe->user_data = (unsigned long long) (size_t) read;
+
+	ring.sqArray[index] = index;
+	__atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+int AsyncRead_IOUringThreadFunc(void*)
+{
+	IOUring& ring = g_ioUring;
+	unsigned int numInFlight = 0;	// Submitted to the kernel
+	unsigned int numQueued = 0;		// Queued in submission ring but not yet submitted
+
+	while (!g_quitAsyncReads || numInFlight || numQueued)
+	{
+		// Take as many new reads as there is room for in the ring
+
+		std::vector<AsyncRead*> newReads;
+		SDL_LockMutex(g_asyncReadMutex);
+		while (!g_asyncReadQueue.empty() && numInFlight + numQueued + newReads.size() < ring.numEntries)
+		{
+			newReads.push_back(g_asyncReadQueue.front());
+			g_asyncReadQueue.pop_front();
+		}
+		const bool moreReadsWaiting = !g_asyncReadQueue.empty();
+		SDL_UnlockMutex(g_asyncReadMutex);
+
+		for (std::vector<AsyncRead*>::iterator it = newReads.begin(); it != newReads.end(); ++it)
+			if (AsyncRead_Prepare(*it, true))
+			{
+				IOUring_QueueRead(ring, *it);
+				numQueued++;
+			}
+
+		if (!numInFlight && !numQueued)
+		{
+			if (!moreReadsWaiting && !g_quitAsyncReads)
+				SDL_SemWaitTimeout(g_asyncReadSem, 100);
+			continue;
+		}
+
+		// Submit queued reads and wait for at least one completion unless there are new reads to pick up
+
+		const unsigned int minComplete = newReads.empty() || moreReadsWaiting ? 1 : 0;
+		const int numSubmitted = (int) syscall(__NR_io_uring_enter, ring.fd, numQueued, minComplete, IORING_ENTER_GETEVENTS, NULL, 0);
+		if (numSubmitted < 0)
+		{
+			if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			{
+				Log::Error(string_format("io_uring_enter failed, reason: %s", strerror(errno)));
+				SDL_Delay(1);
+			}
+		}
+		else
+		{
+			numQueued -= (unsigned int) numSubmitted;
+			numInFlight += (unsigned int) numSubmitted;
+		}
+
+		// Process completions; resubmit interrupted and short reads
+
+		unsigned int head = *ring.cqHead;
+		const unsigned int tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+		for (; head != tail; head++)
+		{
+			const struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cqMask];
+			AsyncRead* read = (AsyncRead*) (size_t) cqe->user_data;
+			const int result = cqe->res;
+			numInFlight--;
+
+			if (result == -EINTR || result == -EAGAIN || (result > 0 && read->numRead + result < read->size))
+			{
+				if (result > 0)
+					read->numRead += result;
+				IOUring_QueueRead(ring, read);
+				numQueued++;
+			}
+			else if (result < 0)
+			{
+				Log::Error(string_format("Asynchronous read failed, reason: %s", strerror(-result)));
+				AsyncRead_Complete(read, false);
+			}
+			else
+			{
+				read->numRead += result;
+				AsyncRead_Complete(read, read->numRead == read->size);
+			}
+		}
+		__atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+	}
+	return 0;
 }
 
-int File_GetSize(FileObj* file)
+#endif // SUPPORT_IO_URING
+
+void AsyncReads_Init()
 {
-	return (int) SDL_RWsize((SDL_RWops*) file);
+	g_quitAsyncReads = false;
+	g_asyncReadMutex = SDL_CreateMutex();
+	g_asyncReadSem = SDL_CreateSemaphore(0);
+
+#ifdef SUPPORT_IO_URING
+	if (IOUring_Init(g_ioUring, ASYNC_READ_URING_ENTRIES))
+	{
+		g_asyncReadThreads[g_numAsyncReadThreads++] = SDL_CreateThread(AsyncRead_IOUringThreadFunc, "asyncread", NULL);
+		Log::Info(string_format("Started asynchronous file reads via io_uring (%u entries)", g_ioUring.numEntries));
+		return;
+	}
+	Log::Info("io_uring not available; falling back to blocking reads on reader threads");
+#endif
+
+	for (; g_numAsyncReadThreads < ASYNC_READ_MAX_THREADS; g_numAsyncReadThreads++)
+		g_asyncReadThreads[g_numAsyncReadThreads] = SDL_CreateThread(AsyncRead_BlockingThreadFunc, "asyncread", NULL);
+	Log::Info(string_format("Started %d asynchronous file reader threads", g_numAsyncReadThreads));
 }
 
-void File_Seek(FileObj* file, int offset)
+void AsyncReads_Deinit()
 {
-	SDL_RWseek((SDL_RWops*) file, offset, RW_SEEK_SET);
+	// Let reader threads finish reads in progress
+
+	g_quitAsyncReads = true;
+	for (int i = 0; i < g_numAsyncReadThreads; i++)
+		SDL_SemPost(g_asyncReadSem);
+	for (int i = 0; i < g_numAsyncReadThreads; i++)
+	{
+		int status;
+		SDL_WaitThread(g_asyncReadThreads[i], &status);
+		g_asyncReadThreads[i] = NULL;
+	}
+	g_numAsyncReadThreads = 0;
+
+#ifdef SUPPORT_IO_URING
+	if (g_ioUring.sqRing)
+		IOUring_Deinit(g_ioUring);
+	memset(&g_ioUring, 0, sizeof(g_ioUring));
+#endif
+
+	// Fail reads that never started
+
+	for (std::list<AsyncRead*>::iterator it = g_asyncReadQueue.begin(); it != g_asyncReadQueue.end(); ++it)
+		AsyncRead_Complete(*it, false);
+	g_asyncReadQueue.clear();
+
+	SDL_DestroySemaphore(g_asyncReadSem);
+	g_asyncReadSem = NULL;
+	SDL_DestroyMutex(g_asyncReadMutex);
+	g_asyncReadMutex = NULL;
 }
 
-int File_GetOffset(FileObj* file)
+Jobs::JobID File_ReadAsync(const std::string& path, FileObj* file, long long offset, size_t size, File::ReadFunc readFunc, File::ReadDoneFunc doneFunc, void* userData)
 {
-	return (int) SDL_RWtell((SDL_RWops*) file);
+	if (file && file->openMode != File::OpenMode_Read)
+	{
+		Log::Error("Failed to read file asynchronously, reason: file not opened for reading");
+		return 0;
+	}
+
+	AsyncRead* read = new AsyncRead();
+	SDL_AtomicSet(&read->refCount, 2);
+	read->path = path;
+	read->file = file;
+	read->offset = offset;
+	read->size = size;
+	read->data = NULL;
+	read->numRead = 0;
+	read->success = false;
+	read->readFunc = readFunc;
+	read->doneFunc = doneFunc;
+	read->userData = userData;
+	if ((read->loadGroup = g_currentLoadGroup) != NULL)
+		LoadGroup_AddRef(read->loadGroup);
+	read->jobID = Jobs_RunJob(AsyncRead_JobFunc, AsyncRead_DoneFunc, read, false);
+
+	SDL_LockMutex(g_asyncReadMutex);
+	g_asyncReadQueue.push_back(read);
+	SDL_UnlockMutex(g_asyncReadMutex);
+	SDL_SemPost(g_asyncReadSem);
+
+	return read->jobID;
 }
 
-bool File_Read(FileObj* file, void* dst, int size)
+bool ShaderProgramCache_LoadFile(const std::string& fileName, std::vector<unsigned char>& data)
 {
-	return (int) SDL_RWread((SDL_RWops*) file, dst, size, 1) == 1;
+	const std::string path = g_shaderCacheDir + fileName;
+	SDL_RWops* rw = SDL_RWFromFile(path.c_str(), "rb");
+	if (!rw)
+		return false;
+
+	const Sint64 size = SDL_RWsize(rw);
+	data.resize(size > 0 ? (size_t) size : 0);
+	const bool success = size > 0 && SDL_RWread(rw, &data[0], data.size(), 1) == 1;
+	SDL_RWclose(rw);
+	return success;
 }
 
-bool File_Write(FileObj* file, const void* src, int size)
+bool ShaderProgramCache_SaveFile(const std::string& fileName, const std::vector<unsigned char>& data)
 {
-	return (int) SDL_RWwrite((SDL_RWops*) file, src, size, 1) == 1;
+	const std::string path = g_shaderCacheDir + fileName;
+	SDL_RWops* rw = SDL_RWFromFile(path.c_str(), "wb");
+	if (!rw)
+	{
+		Log::Warn(string_format("Failed to save shader program binary to %s", path.c_str()));
+		return false;
+	}
+
+	const bool success = SDL_RWwrite(rw, &data[0], data.size(), 1) == 1;
+	SDL_RWclose(rw);
+	return success;
 }
 
 SDL_RWops* File_OpenSDLFileRW(const std::string& name, File::OpenMode openMode)
 {
 	const std::vector<std::string>& rootDirs = App::GetRootDataDirs();
 
-	for (std::vector<std::string>::const_iterator it = rootDirs.begin(); it != rootDirs.end(); ++it)
+	// Loose files
+
+	if (openMode != File::OpenMode_Read || g_looseFilesOverridePacks || g_packFiles.empty())
+		for (std::vector<std::string>::const_iterator it = rootDirs.begin(); it != rootDirs.end(); ++it)
+		{
+			const std::string fullPath = *it + name;
+			SDL_RWops* f = SDL_RWFromFile(fullPath.c_str(), openMode == File::OpenMode_Read ? "rb" : "wb");
+			if (f)
+				return f;
+		}
+
+	// Packed files; read straight from pack file mapping (or decompressed on calling thread)
+
+	if (openMode == File::OpenMode_Read)
 	{
-		const std::string fullPath = *it + name;
-		SDL_RWops* f = SDL_RWFromFile(fullPath.c_str(), openMode == File::OpenMode_Read ? "rb" : "wb");
-		if (f)
-			return f;
+		const void* packedData;
+		if (const PackEntry* entry = Pack_FindEntry(name, packedData))
+			return Pack_OpenEntry(name, entry, packedData);
 	}
+
 	return NULL;
 }
 
+// File view
+
+struct FileViewSDL : FileViewObj
+{
+	MappedFile mapping;
+	void* buffer;	// Owned copy of file contents (decompressed pack entry or file loaded into memory); NULL if contents are memory mapped or point into pack file
+
+	FileViewSDL() : buffer(NULL) {}
+};
+
+bool File_MapLooseFile(FileViewSDL* view, const std::string& name)
+{
+	const std::vector<std::string>& rootDirs = App::GetRootDataDirs();
+	for (std::vector<std::string>::const_iterator it = rootDirs.begin(); it != rootDirs.end(); ++it)
+		if (MappedFile_Open(view->mapping, *it + name))
+		{
+			view->data = view->mapping.data;
+			view->size = view->mapping.size;
+			return true;
+		}
+	return false;
+}
+
+FileViewObj* File_Map(const std::string& name)
+{
+	FileViewSDL* view = new FileViewSDL();
+
+	// Memory mapped loose files
+
+	const bool looseFilesFirst = g_looseFilesOverridePacks || g_packFiles.empty();
+	if (looseFilesFirst && File_MapLooseFile(view, name))
+		return view;
+
+	// Packed files; point straight into pack file mapping or decompress
+
+	const void* packedData;
+	if (const PackEntry* entry = Pack_FindEntry(name, packedData))
+	{
+		if (entry->compression != PackCompression_None && !(view->buffer = Pack_DecompressEntry(name, entry, packedData)))
+		{
+			delete view;
+			return NULL;
+		}
+		view->data = view->buffer ? view->buffer : packedData;
+		view->size = (size_t) entry->size;
+		return view;
+	}
+
+	if (!looseFilesFirst && File_MapLooseFile(view, name))
+		return view;
+
+	// Fall back to loading whole file into memory (e.g. empty files or files within Android APK)
+
+	SDL_RWops* rw = File_OpenSDLFileRW(name, File::OpenMode_Read);
+	if (!rw)
+	{
+		delete view;
+		return NULL;
+	}
+
+	const Sint64 size = SDL_RWsize(rw);
+	view->buffer = size >= 0 ? malloc((size_t) size + 1) : NULL;
+	if (!view->buffer || (size > 0 && SDL_RWread(rw, view->buffer, (size_t) size, 1) != 1))
+	{
+		SDL_RWclose(rw);
+		free(view->buffer);
+		delete view;
+		return NULL;
+	}
+	SDL_RWclose(rw);
+	((char*) view->buffer)[size] = '\0';
+	view->data = view->buffer;
+	view->size = (size_t) size;
+	return view;
+}
+
+FileViewObj* File_CreateView(void* buffer, size_t size)
+{
+	FileViewSDL* view = new FileViewSDL();
+	view->buffer = buffer;
+	view->data = buffer;
+	view->size = size;
+	return view;
+}
+
+void File_Unmap(FileViewObj* _view)
+{
+	FileViewSDL* view = (FileViewSDL*) _view;
+	MappedFile_Close(view->mapping);
+	free(view->buffer);
+	delete view;
+}
+
 };
 
 // Main
@@ -24,6 +24,7 @@ bool Texture::Save(const std::string& path, bool saveAlpha) { return obj && Text
 ResourceState Texture::GetState() const { return obj ? Texture_GetState(obj) : ResourceState_Uninitialized; }
 void Texture::Draw(const Shape::DrawParams* params, const Sampler& sampler) { if (obj) Texture_Draw(obj, params, sampler); }
 void Texture::Draw(const Vec2& position, float rotation, float scale, const Color& color) { if (obj) Texture_Draw(obj, position, rotation, scale, color); }
+void Texture::DrawBatch(const BatchInstance* instances, int numInstances) { if (obj) Texture_DrawBatch(obj, instances, numInstances); }
 int Texture::GetWidth() { return obj ? Texture_GetWidth(obj) : 0; }
 int	Texture::GetHeight() { return obj ? Texture_GetHeight(obj) : 0; }
 int Texture::GetRealWidth() { return obj ? Texture_GetRealWidth(obj) : 0; }
@@ -40,15 +41,30 @@ void Material::operator = (const Material& other) { Destroy(); obj = other.obj ?
 bool Material::Create(const std::string& name, bool immediate) { if (obj) Material_Destroy(obj); obj = Material_Create(name, immediate); return obj != NULL; }
 void Material::Destroy() { if (obj) { Material_Destroy(obj); obj = NULL; } }
 ResourceState Material::GetState() const { return obj ? Material_GetState(obj) : ResourceState_Uninitialized; }
-void Material::SetTechnique(const std::string& name) { if (obj) Material_SetTechnique(obj, name); }
-int Material::GetParameterIndex(const std::string& name) { return obj ? Material_GetParameterIndex(obj, name) : -1; }
+int Material::GetTechniqueIndex(const std::string& name) { return obj ? Material_GetTechniqueIndex(obj, StringId::Find(name)) : -1; }
+int Material::GetTechniqueIndex(StringId name) { return obj ? Material_GetTechniqueIndex(obj, name) : -1; }
+void Material::SetTechnique(int index) { if (obj) Material_SetTechnique(obj, index); }
+void Material::SetTechnique(const std::string& name) { if (obj) Material_SetTechnique(obj, StringId(name)); }
+void Material::SetTechnique(StringId name) { if (obj) Material_SetTechnique(obj, name); }
+unsigned int Material::GetKeywordMask(const std::string& keywords) { return obj ? Material_GetKeywordMask(obj, keywords) : 0; }
+void Material::SetKeywordMask(unsigned int mask) { if (obj) Material_SetKeywordMask(obj, mask); }
+void Material::SetKeywords(const std::string& keywords) { if (obj) Material_SetKeywords(obj, keywords); }
+int Material::GetParameterIndex(const std::string& name) { return obj ? Material_GetParameterIndex(obj, StringId::Find(name)) : -1; }
+int Material::GetParameterIndex(StringId name) { return obj ? Material_GetParameterIndex(obj, name) : -1; }
 void Material::SetIntParameter(int index, const int* value, int count) { if (obj) Material_SetIntParameter(obj, index, value, count); }
-void Material::SetIntParameter(const std::string& name, const int* value, int count) { if (obj) Material_SetIntParameter(obj, name, value, count); }
+void Material::SetIntParameter(const std::string& name, const int* value, int count) { if (obj) Material_SetIntParameter(obj, StringId(name), value, count); }
+void Material::SetIntParameter(StringId name, const int* value, int count) { if (obj) Material_SetIntParameter(obj, name, value, count); }
 void Material::SetFloatParameter(int index, const float* value, int count) { if (obj) Material_SetFloatParameter(obj, index, value, count); }
-void Material::SetFloatParameter(const std::string& name, const float* value, int count) { if (obj) Material_SetFloatParameter(obj, name, value, count); }
-void Material::SetFloatParameter(const std::string& name, const float value) { if (obj) Material_SetFloatParameter(obj, name, &value, 1); }
+void Material::SetFloatParameter(const std::string& name, const float* value, int count) { if (obj) Material_SetFloatParameter(obj, StringId(name), value, count); }
+void Material::SetFloatParameter(StringId name, const float* value, int count) { if (obj) Material_SetFloatParameter(obj, name, value, count); }
+void Material::SetFloatParameter(const std::string& name, const float value) { if (obj) Material_SetFloatParameter(obj, StringId(name), &value, 1); }
+void Material::SetFloatParameter(StringId name, const float value) { if (obj) Material_SetFloatParameter(obj, name, &value, 1); }
+void Material::SetFloatArrayParameter(int index, const float* value, int count, int numElements) { if (obj) Material_SetFloatArrayParameter(obj, index, value, count, numElements); }
+void Material::SetFloatArrayParameter(const std::string& name, const float* value, int count, int numElements) { if (obj) Material_SetFloatArrayParameter(obj, StringId(name), value, count, numElements); }
+void Material::SetFloatArrayParameter(StringId name, const float* value, int count, int numElements) { if (obj) Material_SetFloatArrayParameter(obj, name, value, count, numElements); }
 void Material::SetTextureParameter(int index, Texture& value, const Sampler& sampler) { if (obj) Material_SetTextureParameter(obj, index, Texture_Get(value), sampler); }
-void Material::SetTextureParameter(const std::string& name, Texture& value, const Sampler& sampler) { if (obj) Material_SetTextureParameter(obj, name, Texture_Get(value), sampler); }
+void Material::SetTextureParameter(const std::string& name, Texture& value, const Sampler& sampler) { if (obj) Material_SetTextureParameter(obj, StringId(name), Texture_Get(value), sampler); }
+void Material::SetTextureParameter(StringId name, Texture& value, const Sampler& sampler) { if (obj) Material_SetTextureParameter(obj, name, Texture_Get(value), sampler); }
 void Material::Draw(const Shape::DrawParams* params) { if (obj) Material_Draw(obj, params); }
 void Material::DrawFullscreenQuad() { if (obj) Material_DrawFullscreenQuad(obj); }
 
@@ -69,6 +85,7 @@ void Font::Destroy() { if (obj) { Font_Destroy(obj); obj = NULL; } }
 ResourceState Font::GetState() const { return obj ? obj->state : ResourceState_Uninitialized; }
 void Font::CacheGlyphs(const std::string& text) { if (obj) Font_CacheGlyphs(obj, text); }
 void Font::CacheGlyphsFromFile(const std::string& path) { if (obj) Font_CacheGlyphsFromFile(obj, path); }
+void Font::CacheGlyphs(const std::vector<unsigned int>& codePoints) { if (obj && codePoints.size()) Font_CacheGlyphs(obj, const_cast<unsigned int*>(&codePoints[0]), (int) codePoints.size()); }
 void Font::Draw(const Text::DrawParams* params) { if (obj) Font_Draw(obj, params); }
 void Font::Draw(const char* text, const Vec2& position, const Color& color) { if (obj) Font_Draw(obj, text, position, color); }
 void Font::CalculateSize(const Text::DrawParams* params, float& width, float& height) { if (obj) Font_CalculateSize(obj, params, width, height); else width = height = 0.0f; }
@@ -79,10 +96,11 @@ Sprite::~Sprite() { Destroy(); }
 void Sprite::operator = (const Sprite& other) { Destroy(); obj = other.obj ? Sprite_Clone(const_cast<SpriteObj*>(other.obj)) : NULL; }
 bool Sprite::Create(const std::string& name, bool immediate) { if (obj) Sprite_Destroy(obj); obj = Sprite_Create(name, immediate); return obj != NULL; }
 void Sprite::Destroy() { if (obj) { Sprite_Destroy(obj); obj = NULL; } }
-ResourceState Sprite::GetState() const { return obj ? obj->resource->state : ResourceState_Uninitialized; }
+ResourceState Sprite::GetState() const { return obj ? Sprite_GetState(obj) : ResourceState_Uninitialized; }
 void Sprite::SetEventCallback(Sprite::EventCallback callback, void* userData) { if (obj) Sprite_SetEventCallback(obj, callback, userData); }
 void Sprite::Update(float deltaTime) { if (obj) Sprite_Update(obj, deltaTime); }
-void Sprite::PlayAnimation(const std::string& name, AnimationMode mode, float transitionTime) { if (obj) Sprite_PlayAnimation(obj, name, mode, transitionTime); }
+void Sprite::PlayAnimation(const std::string& name, AnimationMode mode, float transitionTime) { if (obj) Sprite_PlayAnimation(obj, StringId(name), mode, transitionTime); }
+void Sprite::PlayAnimation(StringId name, AnimationMode mode, float transitionTime) { if (obj) Sprite_PlayAnimation(obj, name, mode, transitionTime); }
 void Sprite::Draw(const Sprite::DrawParams* params) { if (obj) Sprite_Draw(obj, params); }
 void Sprite::Draw(const Vec2& position, float rotation) { if (obj) Sprite_Draw(obj, position, rotation); }
 void Sprite::DrawCentered(const Vec2& center, float rotation) { Draw(Vec2(center.x - (float) GetWidth() * 0.5f, center.y - (float) GetHeight() * 0.5f), rotation); }
@@ -93,14 +111,30 @@ File::File() : file(NULL) {}
 File::~File() { Close(); }
 bool File::Open(const std::string& path, File::OpenMode openMode) { if (file) File_Close(file); file = File_Open(path, openMode); return file != NULL; }
 void File::Close() { if (file) { File_Close(file); file = NULL; } }
-int File::GetSize() { return file ? File_GetSize(file) : 0; }
-void File::Seek(int offset) { if (file) File_Seek(file, offset); }
-int File::GetOffset() { return file ? File_GetOffset(file) : 0; }
-bool File::Read(void* dst, int size) { return file ? File_Read(file, dst, size) : false; }
-bool File::Write(const void* src, int size) { return file ? File_Write(file, src, size) : false; }
+long long File::GetSize() { return file ? File_GetSize(file) : 0; }
+void File::Seek(long long offset) { if (file) File_Seek(file, offset); }
+long long File::GetOffset() { return file ? File_GetOffset(file) : 0; }
+void File::SetBufferSize(size_t size) { if (file) File_SetBufferSize(file, size); }
+size_t File::Read(void* dst, size_t size) { return file ? File_Read(file, dst, size) : 0; }
+size_t File::ReadAt(long long offset, void* dst, size_t size) { Buffer buffer = {dst, size}; return ReadAt(offset, &buffer, 1); }
+size_t File::ReadAt(long long offset, const Buffer* buffers, int numBuffers) { return file ? File_ReadAt(file, offset, buffers, numBuffers) : 0; }
+bool File::Write(const void* src, size_t size) { return file ? File_Write(file, src, size) : false; }
+bool File::Flush() { return file ? File_Flush(file) : false; }
+int File::ReadAsync(long long offset, size_t size, ReadFunc readFunc, ReadDoneFunc doneFunc, void* userData) { return file ? File_ReadAsync(std::string(), file, offset, size, readFunc, doneFunc, userData) : 0; }
+bool File::Map(const std::string& path, FileView& view) { view.Unmap(); view.view = File_Map(path); return view.view != NULL; }
+int File::ReadAsync(const std::string& path, long long offset, size_t size, ReadFunc readFunc, ReadDoneFunc doneFunc, void* userData) { return File_ReadAsync(path, NULL, offset, size, readFunc, doneFunc, userData); }
 File::File(const File&) {}
 void File::operator = (const File&) {}
 
+FileView::FileView() : view(NULL) {}
+FileView::~FileView() { Unmap(); }
+void FileView::Unmap() { if (view) { File_Unmap(view); view = NULL; } }
+bool FileView::IsValid() const { return view != NULL; }
+const void* FileView::GetData() const { return view ? view->data : NULL; }
+size_t FileView::GetSize() const { return view ? view->size : 0; }
+FileView::FileView(const FileView&) {}
+void FileView::operator = (const FileView&) {}
+
 XMLDoc::XMLDoc() : doc(NULL) {}
 XMLDoc::~XMLDoc() { Destroy(); }
 bool XMLDoc::Load(const std::string& path) { if (doc) XMLDoc_Destroy(doc); doc = XMLDoc_Load(path); return doc != NULL; }
@@ -158,7 +192,7 @@ Effect::Effect() : obj(NULL) {}
 Effect::Effect(const Effect& other) : obj(NULL) { *this = other; }
 Effect::~Effect() { Destroy(); }
 void Effect::operator = (const Effect& other) { Destroy(); obj = other.obj ? Effect_Clone(const_cast<EffectObj*>(other.obj)) : NULL; }
-bool Effect::Create(const std::string& path, const Vec2& pos, float rotation, bool immediate) { if (obj) Effect_Destroy(obj); obj = Effect_Create(path, pos, rotation, immediate); return obj != NULL; }
+bool Effect::Create(const std::string& path, const Vec2& pos, float rotation, bool immediate) { if (obj) Effect_Destroy(obj); obj = Effect_Create(path, pos, rotation, 1.0f, immediate); return obj != NULL; }
 void Effect::Destroy() { if (obj) { Effect_Destroy(obj); obj = NULL; } }
 ResourceState Effect::GetState() const { return obj ? Effect_GetState(obj) : ResourceState_Uninitialized; }
 void Effect::Update(float deltaTime) { if (obj && !Effect_Update(obj, deltaTime)) obj = NULL; }
@@ -167,3 +201,23 @@ void Effect::SetPosition(const Vec2& pos) { if (obj) Effect_SetPosition(obj, pos
 void Effect::SetRotation(float rotation) { if (obj) Effect_SetRotation(obj, rotation); }
 void Effect::SetScale(float scale) { if (obj) Effect_SetScale(obj, scale); }
 void Effect::SetSpawnCountMultiplier(float multiplier) { if (obj) Effect_SetSpawnCountMultiplier(obj, multiplier); }
+
+LoadGroup::LoadGroup() : obj(NULL) {}
+LoadGroup::~LoadGroup() { Clear(); }
+void LoadGroup::AddTexture(const std::string& name) { if (!obj) obj = LoadGroup_Create(this); LoadGroup_Add(obj, LoadGroupItemType_Texture, name); }
+void LoadGroup::AddMaterial(const std::string& name) { if (!obj) obj = LoadGroup_Create(this); LoadGroup_Add(obj, LoadGroupItemType_Material, name); }
+void LoadGroup::AddSprite(const std::string& name) { if (!obj) obj = LoadGroup_Create(this); LoadGroup_Add(obj, LoadGroupItemType_Sprite, name); }
+void LoadGroup::AddSound(const std::string& path, bool isMusic) { if (!obj) obj = LoadGroup_Create(this); LoadGroup_Add(obj, isMusic ? LoadGroupItemType_Music : LoadGroupItemType_Sound, path); }
+void LoadGroup::AddFont(const std::string& path, int size, unsigned int flags) { if (!obj) obj = LoadGroup_Create(this); LoadGroup_Add(obj, LoadGroupItemType_Font, path, size, flags); }
+void LoadGroup::AddEffect(const std::string& path) { if (!obj) obj = LoadGroup_Create(this); LoadGroup_Add(obj, LoadGroupItemType_Effect, path); }
+void LoadGroup::SetDoneCallback(DoneCallback callback, void* userData) { if (!obj) obj = LoadGroup_Create(this); LoadGroup_SetDoneCallback(obj, callback, userData); }
+bool LoadGroup::IsReady() { return obj ? LoadGroup_IsReady(obj) : true; }
+bool LoadGroup::HasFailed() { Progress progress; GetProgress(progress); return progress.numItemsFailed > 0; }
+void LoadGroup::GetProgress(Progress& progress) { LoadGroup_GetProgress(obj, progress); }
+void LoadGroup::Clear() { if (obj) { LoadGroup_Destroy(obj); obj = NULL; } }
+bool LoadGroup::AddManifest(const std::string& path) { if (!obj) obj = LoadGroup_Create(this); return LoadGroup_AddManifest(obj, path); }
+void LoadGroup::GetMissingResources(std::vector<std::string>& resources) { if (obj) LoadGroup_GetMissingResources(obj, resources); else resources.clear(); }
+void LoadGroup::StartRecordingManifest() { LoadGroup_StartRecordingManifest(); }
+bool LoadGroup::StopRecordingManifest(const std::string& path) { return LoadGroup_StopRecordingManifest(path); }
+LoadGroup::LoadGroup(const LoadGroup&) {}
+void LoadGroup::operator = (const LoadGroup&) {}
@@ -1,5 +1,7 @@
 #include "Tiny2D.h"
 #include "Tiny2D_Common.h"
+#include "SDL_atomic.h"
+#include "SDL_thread.h"
 
 FILE _iob[] = {*stdin, *stdout, *stderr};
 
@@ -22,6 +24,8 @@ App::Callbacks* g_app = NULL;
 App::SystemInfo g_systemInfo;
 
 std::vector<std::string> g_rootDataDirs;
+bool g_looseFilesOverridePacks = true;
+int g_fileBufferSize = 64 << 10;
 std::string g_languageSymbol;
 bool g_quit = false;
 bool g_restartApp = false;
@@ -73,6 +77,10 @@ float g_textureVersionSizeMultiplier;
 
 bool g_supportAsynchronousResourceLoading;
 
+int g_glyphCachePageSize = 512;
+int g_glyphCacheMaxMemory = 16 << 20;
+int g_glyphCacheMinUnusedFrames = 60;
+
 // STL
 
 std::string string_format(const char* format, ...)
@@ -184,12 +192,22 @@ App::StartupParams::StartupParams() :
 	showMessageBoxOnError(false),
 	exitOnError(false),
 	emulateTouchpadWithMouse(false),
-	supportAsynchronousResourceLoading(true)
+	supportAsynchronousResourceLoading(true),
+	looseFilesOverridePacks(true),
+	fileBufferSize(64 << 10),
+	glyphCachePageSize(512),
+	glyphCacheMaxMemory(16 << 20),
+	glyphCacheMinUnusedFrames(60),
+	enableShaderCache(true),
+	enableHotReload(false)
 {
 #ifdef DESKTOP
 	emulateTouchpadWithMouse = true;
 	rootDataDirs.push_back("../../Data/");		// App data
 	rootDataDirs.push_back("../../../Data/");	// Common data
+#ifdef DEBUG
+	enableHotReload = true;
+#endif
 #else
 	rootDataDirs.push_back("");		// All data
 #endif
@@ -218,6 +236,8 @@ void App_Update()
 {
 	const float jobUpdateTime = min(1.0f / 120.0f, 1.0f / 60.0f - g_deltaTime);
 	Jobs::UpdateDoneJobs(jobUpdateTime);
+	HotReload_Update();
+	LoadGroups_Update();
 
 	g_app->OnUpdate(g_deltaTime);
 
@@ -393,16 +413,24 @@ int App_MainRun(int argc, char** argv)
 
 	// Startup system
 
+	StartupProfiler_Start();
+
 	App::StartupParams params;
+	const int onStartupPhase = StartupProfiler_BeginPhase("App OnStartup");
 	if (!g_app->OnStartup(argc - 1, (const char**) (argv + 1), g_systemInfo, params))
 		return 2;
+	StartupProfiler_EndPhase(onStartupPhase);
 	if (!App_Startup(&params))
 		return 3;
 
 	// Init app
 
+	const int onInitPhase = StartupProfiler_BeginPhase("App OnInit");
 	if (!g_app->OnInit())
 		return 4;
+	StartupProfiler_EndPhase(onInitPhase);
+
+	StartupProfiler_LogTimeline();
 
 	// Run app
 
@@ -645,60 +673,448 @@ float Time::SecondsSince(Time::Ticks ticks)
 	return Time::TicksToSeconds(Time::GetTicks() - ticks);
 }
 
+// Startup profiler
+
+#define STARTUP_TIMELINE_WIDTH 40 // Number of characters used to draw the whole startup timeline
+
+struct StartupPhase
+{
+	const char* name;
+	Time::Ticks startTicks;
+	Time::Ticks endTicks;
+	bool isMainThread;
+};
+
+SDL_SpinLock g_startupPhasesLock = 0;
+std::vector<StartupPhase> g_startupPhases;
+Time::Ticks g_startupTicks = 0;
+SDL_threadID g_startupThreadID = 0;
+
+void StartupProfiler_Start()
+{
+	g_startupPhases.clear();
+	g_startupTicks = Time::GetTicks();
+	g_startupThreadID = SDL_ThreadID();
+}
+
+int StartupProfiler_BeginPhase(const char* name)
+{
+	StartupPhase phase;
+	phase.name = name;
+	phase.startTicks = Time::GetTicks();
+	phase.endTicks = 0;
+	phase.isMainThread = SDL_ThreadID() == g_startupThreadID;
+
+	SDL_AtomicLock(&g_startupPhasesLock);
+	g_startupPhases.push_back(phase);
+	const int index = (int) g_startupPhases.size() - 1;
+	SDL_AtomicUnlock(&g_startupPhasesLock);
+	return index;
+}
+
+void StartupProfiler_EndPhase(int phase)
+{
+	const Time::Ticks endTicks = Time::GetTicks();
+
+	SDL_AtomicLock(&g_startupPhasesLock);
+	g_startupPhases[phase].endTicks = endTicks;
+	SDL_AtomicUnlock(&g_startupPhasesLock);
+}
+
+void StartupProfiler_LogTimeline()
+{
+	SDL_AtomicLock(&g_startupPhasesLock);
+	std::vector<StartupPhase> phases = g_startupPhases;
+	SDL_AtomicUnlock(&g_startupPhasesLock);
+
+	Time::Ticks totalTicks = 1;
+	for (std::vector<StartupPhase>::iterator it = phases.begin(); it != phases.end(); ++it)
+		totalTicks = max(totalTicks, (it->endTicks ? it->endTicks : it->startTicks) - g_startupTicks);
+
+	// One line per phase: start and end times, thread and a bar showing when the phase was running
+
+	std::string timeline = string_format("Startup timeline (total %.1f ms):", Time::TicksToSeconds(totalTicks) * 1000.0f);
+	for (std::vector<StartupPhase>::iterator it = phases.begin(); it != phases.end(); ++it)
+	{
+		const Time::Ticks startTicks = it->startTicks - g_startupTicks;
+		const Time::Ticks endTicks = it->endTicks ? it->endTicks - g_startupTicks : startTicks;
+
+		const int barStart = (int) (startTicks * STARTUP_TIMELINE_WIDTH / totalTicks);
+		const int barEnd = max(barStart + 1, (int) ((endTicks * STARTUP_TIMELINE_WIDTH + totalTicks - 1) / totalTicks));
+		std::string bar(STARTUP_TIMELINE_WIDTH, ' ');
+		for (int i = barStart; i < min(barEnd, STARTUP_TIMELINE_WIDTH); i++)
+			bar[i] = '#';
+
+		timeline += string_format("\n  %8.1f - %8.1f ms  %-6s [%s] %s%s",
+			Time::TicksToSeconds(startTicks) * 1000.0f,
+			Time::TicksToSeconds(endTicks) * 1000.0f,
+			it->isMainThread ? "main" : "job",
+			bar.c_str(),
+			it->name,
+			it->endTicks ? "" : " (unfinished)");
+	}
+	Log::Info(timeline);
+}
+
+// String id
+
+#define STRING_ID_PAGE_SIZE 1024
+#define STRING_ID_MAX_PAGES 4096
+
+struct StringIdEntry
+{
+	std::string str;
+	unsigned int hash;
+};
+
+// All globals below are zero initialized before any static constructors run, so string ids can be created during static initialization
+SDL_SpinLock g_stringIdLock = 0;						// Guards interning; reads of interned strings are lock free
+StringIdEntry* g_stringIdPages[STRING_ID_MAX_PAGES];	// Interned strings; entries never move or get freed, so they can be read without locking
+unsigned int g_numStringIds = 0;						// Number of used ids including reserved id 0 (empty string)
+unsigned int* g_stringIdTable = NULL;					// Open addressing hash table of ids; 0 marks empty slot
+unsigned int g_stringIdTableSize = 0;					// Power of 2
+
+inline StringIdEntry& StringId_GetEntry(unsigned int id)
+{
+	return g_stringIdPages[id / STRING_ID_PAGE_SIZE][id % STRING_ID_PAGE_SIZE];
+}
+
+void StringId_InsertIntoTable(unsigned int* table, unsigned int tableSize, unsigned int id)
+{
+	unsigned int slot = StringId_GetEntry(id).hash & (tableSize - 1);
+	while (table[slot])
+		slot = (slot + 1) & (tableSize - 1);
+	table[slot] = id;
+}
+
+// Expects g_stringIdLock to be locked; returns 0 if not found
+unsigned int StringId_FindLocked(const char* str, size_t length, unsigned int hash)
+{
+	if (!g_stringIdTableSize)
+		return 0;
+
+	for (unsigned int slot = hash & (g_stringIdTableSize - 1); g_stringIdTable[slot]; slot = (slot + 1) & (g_stringIdTableSize - 1))
+	{
+		const unsigned int id = g_stringIdTable[slot];
+		const StringIdEntry& entry = StringId_GetEntry(id);
+		if (entry.hash == hash && entry.str.length() == length && !memcmp(entry.str.c_str(), str, length))
+			return id;
+	}
+	return 0;
+}
+
+unsigned int StringId_Find(const char* str, size_t length)
+{
+	if (!length)
+		return 0;
+
+	const unsigned int hash = string_hash(str, length);
+
+	SDL_AtomicLock(&g_stringIdLock); // Table might get reallocated by concurrent interning
+	const unsigned int id = StringId_FindLocked(str, length, hash);
+	SDL_AtomicUnlock(&g_stringIdLock);
+	return id;
+}
+
+unsigned int StringId_Intern(const char* str, size_t length)
+{
+	if (!length)
+		return 0;
+
+	const unsigned int hash = string_hash(str, length);
+
+	SDL_AtomicLock(&g_stringIdLock);
+
+	if (!g_numStringIds)
+		g_numStringIds = 1;
+
+	// Look up existing id
+
+	if (const unsigned int existingId = StringId_FindLocked(str, length, hash))
+	{
+		SDL_AtomicUnlock(&g_stringIdLock);
+		return existingId;
+	}
+
+	// Grow hash table (keeping it at most half full)
+
+	if ((g_numStringIds + 1) * 2 > g_stringIdTableSize)
+	{
+		const unsigned int newTableSize = g_stringIdTableSize ? g_stringIdTableSize * 2 : 1024;
+		unsigned int* newTable = new unsigned int[newTableSize];
+		memset(newTable, 0, newTableSize * sizeof(unsigned int));
+		for (unsigned int i = 0; i < g_stringIdTableSize; i++)
+			if (g_stringIdTable[i])
+				StringId_InsertIntoTable(newTable, newTableSize, g_stringIdTable[i]);
+		delete[] g_stringIdTable;
+		g_stringIdTable = newTable;
+		g_stringIdTableSize = newTableSize;
+	}
+
+	// Add new entry
+
+	const unsigned int id = g_numStringIds;
+	const unsigned int pageIndex = id / STRING_ID_PAGE_SIZE;
+	if (pageIndex == STRING_ID_MAX_PAGES)
+	{
+		SDL_AtomicUnlock(&g_stringIdLock);
+		Assert(!"Too many interned strings");
+		return 0;
+	}
+	if (!g_stringIdPages[pageIndex])
+		g_stringIdPages[pageIndex] = new StringIdEntry[STRING_ID_PAGE_SIZE];
+
+	StringIdEntry& entry = StringId_GetEntry(id);
+	entry.str.assign(str, length);
+	entry.hash = hash;
+	g_numStringIds++;
+
+	StringId_InsertIntoTable(g_stringIdTable, g_stringIdTableSize, id);
+
+	SDL_AtomicUnlock(&g_stringIdLock);
+	return id;
+}
+
+StringId::StringId(const char* str) :
+	id(StringId_Intern(str, strlen(str)))
+{}
+
+StringId::StringId(const std::string& str) :
+	id(StringId_Intern(str.c_str(), str.length()))
+{}
+
+StringId StringId::Find(const char* str)
+{
+	StringId result;
+	result.id = StringId_Find(str, strlen(str));
+	return result;
+}
+
+StringId StringId::Find(const std::string& str)
+{
+	StringId result;
+	result.id = StringId_Find(str.c_str(), str.length());
+	return result;
+}
+
+unsigned int StringId::GetHash() const
+{
+	return id ? StringId_GetEntry(id).hash : string_hash("", 0);
+}
+
+const std::string& StringId::GetString() const
+{
+	static const std::string empty;
+	return id ? StringId_GetEntry(id).str : empty;
+}
+
 // Resource
 
-typedef std::map<std::string, Resource*> ResourceMap;
-typedef std::map<std::string, ResourceMap*> ResourceTypeMap;
-ResourceTypeMap g_resources;
+#define RESOURCE_REGISTRY_NUM_SHARDS 16 // Power of 2
+#define RESOURCE_REGISTRY_MIN_BUCKETS 64
 
-void Resource_ListUnfreed()
+struct ResourceRegistryShard
 {
-	for (ResourceTypeMap::iterator it = g_resources.begin(); it != g_resources.end(); ++it)
-		for (ResourceMap::iterator it2 = it->second->begin(); it2 != it->second->end(); ++it2)
-			Log::Warn(string_format("Unfreed %s resource %s on exit", it2->second->type, it2->second->name.c_str()));
+	SDL_SpinLock lock;
+	std::vector<Resource*> buckets;	// Size is power of 2; resources within bucket are linked via Resource::nextInBucket
+	unsigned int numResources;
+};
+
+ResourceRegistryShard g_resourceRegistry[RESOURCE_REGISTRY_NUM_SHARDS];
+
+inline unsigned int Resource_GetHash(const char* type, const std::string& name)
+{
+	return string_hash(name.c_str(), name.length(), string_hash(type, strlen(type)));
 }
 
-ResourceMap& Resource_GetTypeMap(const char* type)
+inline ResourceRegistryShard& ResourceRegistry_GetShard(unsigned int hash)
 {
-	ResourceMap*& resourceMap = g_resources[type];
-	if (!resourceMap)
-		resourceMap = new ResourceMap();
-	return *resourceMap;
+	return g_resourceRegistry[(hash >> 24) & (RESOURCE_REGISTRY_NUM_SHARDS - 1)];
+}
+
+// Expects shard to be locked
+Resource* ResourceRegistry_Find(ResourceRegistryShard& shard, unsigned int hash, const char* type, const std::string& name)
+{
+	if (!shard.numResources)
+		return NULL;
+
+	// Full type and name comparison protects against hash collisions
+
+	for (Resource* resource = shard.buckets[hash & (shard.buckets.size() - 1)]; resource; resource = resource->nextInBucket)
+		if (resource->registryHash == hash && !strcmp(resource->type, type) && resource->name == name)
+			return resource;
+	return NULL;
+}
+
+// Expects shard to be locked
+void ResourceRegistry_Add(ResourceRegistryShard& shard, Resource* resource)
+{
+	// Grow (keep average bucket length at most 1)
+
+	if (shard.numResources + 1 > shard.buckets.size())
+	{
+		std::vector<Resource*> buckets(max((unsigned int) shard.buckets.size() * 2, (unsigned int) RESOURCE_REGISTRY_MIN_BUCKETS), (Resource*) NULL);
+		for (std::vector<Resource*>::iterator it = shard.buckets.begin(); it != shard.buckets.end(); ++it)
+			while (Resource* other = *it)
+			{
+				*it = other->nextInBucket;
+				Resource*& bucket = buckets[other->registryHash & (buckets.size() - 1)];
+				other->nextInBucket = bucket;
+				bucket = other;
+			}
+		shard.buckets.swap(buckets);
+	}
+
+	Resource*& bucket = shard.buckets[resource->registryHash & (shard.buckets.size() - 1)];
+	resource->nextInBucket = bucket;
+	bucket = resource;
+	shard.numResources++;
+}
+
+// Expects shard to be locked
+void ResourceRegistry_Remove(ResourceRegistryShard& shard, Resource* resource)
+{
+	if (!shard.numResources)
+		return;
+
+	for (Resource** link = &shard.buckets[resource->registryHash & (shard.buckets.size() - 1)]; *link; link = &(*link)->nextInBucket)
+		if (*link == resource)
+		{
+			*link = resource->nextInBucket;
+			resource->nextInBucket = NULL;
+			shard.numResources--;
+			return;
+		}
+}
+
+void Resource_ListUnfreed()
+{
+	for (int i = 0; i < RESOURCE_REGISTRY_NUM_SHARDS; i++)
+	{
+		ResourceRegistryShard& shard = g_resourceRegistry[i];
+		SDL_AtomicLock(&shard.lock);
+		for (std::vector<Resource*>::iterator it = shard.buckets.begin(); it != shard.buckets.end(); ++it)
+			for (Resource* resource = *it; resource; resource = resource->nextInBucket)
+				Log::Warn(string_format("Unfreed %s resource %s on exit", resource->type, resource->name.c_str()));
+		SDL_AtomicUnlock(&shard.lock);
+	}
 }
 
 Resource* Resource_Find(const char* type, const std::string& name)
 {
-	return map_find(Resource_GetTypeMap(type), name);
+	const unsigned int hash = Resource_GetHash(type, name);
+	ResourceRegistryShard& shard = ResourceRegistry_GetShard(hash);
+
+	SDL_AtomicLock(&shard.lock);
+	Resource* resource = ResourceRegistry_Find(shard, hash, type, name);
+	SDL_AtomicUnlock(&shard.lock);
+	return resource;
+}
+
+Resource* Resource_FindAndIncRefCount(const char* type, const std::string& name)
+{
+	const unsigned int hash = Resource_GetHash(type, name);
+	ResourceRegistryShard& shard = ResourceRegistry_GetShard(hash);
+
+	// Reference count of registered resource can only drop to 0 under the shard lock, so it's safe to increment it here
+
+	SDL_AtomicLock(&shard.lock);
+	Resource* resource = ResourceRegistry_Find(shard, hash, type, name);
+	if (resource)
+		SDL_AtomicIncRef(&resource->refCount);
+	SDL_AtomicUnlock(&shard.lock);
+	return resource;
+}
+
+Resource* Resource_FindOrRegister(Resource* resource)
+{
+	Assert(resource->name.length() > 0);
+	Assert(SDL_AtomicGet(&resource->refCount) == 0);
+
+	// Passed resource gets its single reference either way; if it loses, it's never registered and can be released via its regular destroy function
+
+	SDL_AtomicSet(&resource->refCount, 1);
+	resource->registryHash = Resource_GetHash(resource->type, resource->name);
+	ResourceRegistryShard& shard = ResourceRegistry_GetShard(resource->registryHash);
+
+	// Lookup and insertion under the same lock, so that concurrent loaders of the same resource end up sharing single registered instance
+
+	SDL_AtomicLock(&shard.lock);
+	Resource* existing = ResourceRegistry_Find(shard, resource->registryHash, resource->type, resource->name);
+	if (existing)
+		SDL_AtomicIncRef(&existing->refCount);
+	else
+		ResourceRegistry_Add(shard, resource);
+	SDL_AtomicUnlock(&shard.lock);
+
+	if (existing)
+		return existing;
+
+	Log::Info(string_format("Created %s resource '%s'", resource->type, resource->name.c_str()));
+	return resource;
 }
 
 void Resource_IncRefCount(Resource* resource)
 {
-	if (++resource->refCount == 1)
+	// Only for resources already holding a reference; new resources get registered via Resource_FindOrRegister()
+
+	const int oldRefCount = SDL_AtomicIncRef(&resource->refCount);
+	Assert(oldRefCount > 0);
+	(void) oldRefCount;
+}
+
+int Resource_DecRefCount(Resource* resource)
+{
+	// Not the last reference - no need to lock
+
+	for (;;)
 	{
-		Assert(resource->name.length() > 0);
-		ResourceMap& resourceMap = Resource_GetTypeMap(resource->type);
-		Assert(resourceMap.find(resource->name) == resourceMap.end());
-		resourceMap[resource->name] = resource;
-		Log::Info(string_format("Created %s resource '%s'", resource->type, resource->name.c_str()));
+		const int refCount = SDL_AtomicGet(&resource->refCount);
+		Assert(refCount >= 1);
+		if (refCount <= 1)
+			break;
+		if (SDL_AtomicCAS(&resource->refCount, refCount, refCount - 1))
+			return refCount - 1;
 	}
+
+	// Last reference - unregister under the lock so that Resource_FindAndIncRefCount() can't grab it in the meantime
+
+	ResourceRegistryShard& shard = ResourceRegistry_GetShard(resource->registryHash);
+	SDL_AtomicLock(&shard.lock);
+	const int refCount = SDL_AtomicAdd(&resource->refCount, -1) - 1;
+	if (refCount == 0)
+		ResourceRegistry_Remove(shard, resource);
+	SDL_AtomicUnlock(&shard.lock);
+	return refCount;
 }
 
-int Resource_DecRefCount(Resource* resource)
+void Resource_Unregister(Resource* resource)
 {
-	Assert(resource->refCount >= 1);
-	if (--resource->refCount == 0)
-		Resource_GetTypeMap(resource->type).erase(resource->name);
-	return resource->refCount;
+	// Removing already unregistered resource (also when its last reference gets released later) is a no-op
+
+	ResourceRegistryShard& shard = ResourceRegistry_GetShard(resource->registryHash);
+	SDL_AtomicLock(&shard.lock);
+	ResourceRegistry_Remove(shard, resource);
+	SDL_AtomicUnlock(&shard.lock);
 }
 
 Sampler::Sampler() :
 	minFilterLinear(true),
 	magFilterLinear(true),
+	mipFilter(Sampler::MipFilter_None),
+	maxAnisotropy(1.0f),
 	uWrapMode(Sampler::WrapMode_Clamp),
 	vWrapMode(Sampler::WrapMode_Clamp),
 	borderColor(Color::White)
 {}
 
+Texture::BatchInstance::BatchInstance() :
+	position(0, 0),
+	rotation(0),
+	scale(1),
+	color(Color::White)
+{}
+
 
 // Texture pool
 
@@ -736,25 +1152,24 @@ void RenderTexturePool::DestroyAll()
 
 bool File_Load(const std::string& path, void*& data, int& size)
 {
-	File file;
-	if (!file.Open(path, File::OpenMode_Read))
+	// Copy out of the view; only needed by callers that modify or keep the data (e.g. in-place XML parsing)
+
+	FileViewObj* view = File_Map(path);
+	if (!view)
 	{
 		Log::Error(string_format("Failed to open file %s", path.c_str()));
 		return false;
 	}
-	size = file.GetSize();
+	size = (int) view->size;
 	data = malloc(size + 1);
 	if (!data)
 	{
+		File_Unmap(view);
 		Log::Error(string_format("Failed to allocate %d bytes while loading file %s", size, path.c_str()));
 		return false;
 	}
-	if (!file.Read(data, size))
-	{
-		free(data);
-		Log::Error(string_format("Failed to load %d bytes from file %s", size, path.c_str()));
-		return false;
-	}
+	memcpy(data, view->data, size);
+	File_Unmap(view);
 	((char*) data)[size] = '\0';
 
 	return true;
@@ -800,6 +1215,56 @@ void Font_CacheGlyphs(FontObj* font, const std::string& text)
 	Font_CacheGlyphs(font, buffer, bufferSize);
 }
 
+void Font_DrawGlyphs(const std::vector<float>& xy, const std::vector<float>& uv, const std::vector<TextureObj*>& glyphTextures, const Color& color)
+{
+	Shape::DrawParams texParams;
+	texParams.SetGeometryType(Shape::Geometry::Type_Triangles);
+	texParams.color = color;
+
+	// Draw all glyphs at once if they all come from single texture (always the case for prebaked fonts)
+
+	TextureObj* firstTexture = glyphTextures[0];
+	unsigned int numFromFirstTexture = 0;
+	while (numFromFirstTexture < glyphTextures.size() && glyphTextures[numFromFirstTexture] == firstTexture)
+		numFromFirstTexture++;
+
+	if (numFromFirstTexture == glyphTextures.size())
+	{
+		texParams.SetNumVerts(xy.size() / 2);
+		texParams.SetPosition(&xy[0]);
+		texParams.SetTexCoord(&uv[0]);
+		Texture_Draw(firstTexture, &texParams);
+		return;
+	}
+
+	// Otherwise draw glyphs grouped by glyph cache page
+
+	std::vector<bool> isDrawn(glyphTextures.size(), false);
+	std::vector<float> pageXY;
+	std::vector<float> pageUV;
+	for (unsigned int i = 0; i < glyphTextures.size(); i++)
+	{
+		if (isDrawn[i])
+			continue;
+
+		TextureObj* texture = glyphTextures[i];
+		pageXY.clear();
+		pageUV.clear();
+		for (unsigned int j = i; j < glyphTextures.size(); j++)
+			if (glyphTextures[j] == texture)
+			{
+				pageXY.insert(pageXY.end(), xy.begin() + j * 12, xy.begin() + (j + 1) * 12);
+				pageUV.insert(pageUV.end(), uv.begin() + j * 12, uv.begin() + (j + 1) * 12);
+				isDrawn[j] = true;
+			}
+
+		texParams.SetNumVerts(pageXY.size() / 2);
+		texParams.SetPosition(&pageXY[0]);
+		texParams.SetTexCoord(&pageUV[0]);
+		Texture_Draw(texture, &texParams);
+	}
+}
+
 void Font_Draw(FontObj* font, const Text::DrawParams* params)
 {
 	// Convert to UTF32
@@ -809,19 +1274,13 @@ void Font_Draw(FontObj* font, const Text::DrawParams* params)
 	if (!UTF8ToUTF32((const unsigned char*) params->text.c_str(), params->text.length(), buffer, bufferSize))
 		return;
 
-	// Make sure all glyphs are present
-
-	Font_CacheGlyphs(font, buffer, bufferSize);
-
-	// Generate positions and uvs for the text
-
-	if (!font->texture)
-		return;
+	// Generate positions and uvs for the text; glyphs that aren't cached yet are skipped (they'll be available in one of the next frames)
 
 	const float scale = params->scale;
 
 	std::vector<float> xy;
 	std::vector<float> uv;
+	std::vector<TextureObj*> glyphTextures;
 
 	float x = params->position.x;
 	float y = params->position.y;
@@ -836,9 +1295,16 @@ void Font_Draw(FontObj* font, const Text::DrawParams* params)
 			continue;
 		}
 
-		Glyph* glyph = map_find(font->glyphs, buffer[i]);
-		if (!glyph)
+		Glyph* glyph;
+		TextureObj* texture;
+		if (!Font_GetGlyph(font, buffer[i], glyph, texture))
+			continue;
+		if (!texture)
+		{
+			x += glyph->advancePos * scale;
 			continue;
+		}
+		glyphTextures.push_back(texture);
 
 		uv.push_back(glyph->uv.left); uv.push_back(glyph->uv.top);
 		uv.push_back(glyph->uv.left + glyph->uv.width); uv.push_back(glyph->uv.top);
@@ -857,6 +1323,9 @@ void Font_Draw(FontObj* font, const Text::DrawParams* params)
 		x += glyph->advancePos * scale;
 	}
 
+	if (glyphTextures.empty())
+		return;
+
 	// Determine mins and maxes of the text
 
 	float minX = (float) INT_MAX, maxX = (float) INT_MIN, minY = (float) INT_MAX, maxY = (float) INT_MIN;
@@ -926,13 +1395,6 @@ void Font_Draw(FontObj* font, const Text::DrawParams* params)
             break;
 	}
 
-	// Set up draw params
-
-	Shape::DrawParams texParams;
-	texParams.SetGeometryType(Shape::Geometry::Type_Triangles);
-	texParams.SetNumVerts(xy.size() / 2);
-	texParams.SetTexCoord(&uv[0]);
-
 	// Draw shadow
 
 	if (params->drawShadow)
@@ -960,10 +1422,7 @@ void Font_Draw(FontObj* font, const Text::DrawParams* params)
 
 		// Draw the shadow
 
-		texParams.color = params->shadowColor;
-		texParams.SetPosition(&xyShadow[0]);
-
-		Texture_Draw(font->texture, &texParams);
+		Font_DrawGlyphs(xyShadow, uv, glyphTextures, params->shadowColor);
 	}
 
 	// Rotate the text
@@ -979,10 +1438,7 @@ void Font_Draw(FontObj* font, const Text::DrawParams* params)
 
 	// Draw
 
-	texParams.color = params->color;
-	texParams.SetPosition(&xy[0]);
-
-	Texture_Draw(font->texture, &texParams);
+	Font_DrawGlyphs(xy, uv, glyphTextures, params->color);
 }
 
 void Material_DrawFullscreenQuad(MaterialObj* material)
@@ -1060,6 +1516,11 @@ MaterialObj* Material_Get(Material& handle)
 	return *(MaterialObj**) (void**) &handle;
 }
 
+FontObj* Font_Get(Font& handle)
+{
+	return *(FontObj**) (void**) &handle;
+}
+
 void HandleAssertion(const char* what, const char* fileName, int fileLine)
 {
 	Log::Error(string_format("Condition %s failed in %s:%d", what, fileName, fileLine));
@@ -4,6 +4,7 @@
 #include <vector>
 #include <map>
 #include <math.h>
+#include "SDL_atomic.h"
 #if defined(WIN32)
 	#include <shlwapi.h>
 #endif
@@ -127,6 +128,17 @@ namespace Tiny2D
 		}
 	}
 
+	// FNV-1a hash; 'hash' can be set to hash of preceding data to hash multiple strings together
+	inline unsigned int string_hash(const char* str, size_t length, unsigned int hash = 2166136261u)
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= (unsigned char) str[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
 	template <class REPLACEMENT_PRED>
 	inline int string_replace_all_pred(std::string& s, const std::string& src, REPLACEMENT_PRED& repl)
 	{
@@ -143,6 +155,19 @@ namespace Tiny2D
 		return numReplacements;
 	}
 
+	inline unsigned long long hash_fnv1a64(const void* data, size_t size, unsigned long long hash = 14695981039346656037ULL)
+	{
+		const unsigned char* bytes = (const unsigned char*) data;
+		for (size_t i = 0; i < size; i++)
+			hash = (hash ^ bytes[i]) * 1099511628211ULL;
+		return hash;
+	}
+
+	inline unsigned long long hash_fnv1a64(const std::string& s, unsigned long long hash = 14695981039346656037ULL)
+	{
+		return hash_fnv1a64(s.c_str(), s.length(), hash);
+	}
+
 	template <typename TYPE>
 	inline TYPE& vector_add(std::vector<TYPE>& container)
 	{
@@ -167,6 +192,18 @@ namespace Tiny2D
 		container.pop_back();
 	}
 
+	template <typename TYPE>
+	inline bool vector_remove(std::vector<TYPE>& container, const TYPE& value)
+	{
+		for (unsigned int i = 0; i < container.size(); i++)
+			if (container[i] == value)
+			{
+				vector_remove_at(container, i);
+				return true;
+			}
+		return false;
+	}
+
 	template <typename KEY_TYPE, typename VALUE_TYPE>
 	inline VALUE_TYPE& map_add(std::map<KEY_TYPE, VALUE_TYPE>& container, const KEY_TYPE& key)
 	{
@@ -214,6 +251,12 @@ namespace Tiny2D
 
 	bool UTF8ToUTF32(const unsigned char* src, unsigned int srcSize, unsigned int* dst, unsigned int& dstSize);
 
+	// LZ4 (block format; see Tiny2D_LZ4.cpp)
+
+	size_t LZ4_CompressBound(size_t srcSize);
+	size_t LZ4_Compress(const void* src, size_t srcSize, void* dst);
+	bool LZ4_Decompress(const void* src, size_t srcSize, void* dst, size_t dstSize);
+
 	// Rect
 
 	struct RectI
@@ -258,6 +301,8 @@ namespace Tiny2D
 	extern App::Callbacks* g_app;
 
 	extern std::vector<std::string> g_rootDataDirs;
+	extern bool g_looseFilesOverridePacks;
+	extern int g_fileBufferSize;
 	extern std::string g_languageSymbol;
 	extern bool g_quit;
 	extern bool g_restartApp;
@@ -313,6 +358,10 @@ namespace Tiny2D
 
 	extern bool g_supportAsynchronousResourceLoading;
 
+	extern int g_glyphCachePageSize;
+	extern int g_glyphCacheMaxMemory;
+	extern int g_glyphCacheMinUnusedFrames;
+
 	int App_Main(int argc, char** argv);
 	bool App_Startup(App::StartupParams* params);
 	void App_Shutdown();
@@ -328,6 +377,13 @@ namespace Tiny2D
 	const float* App_GetProjectionScaleMaterialParam();
 	Texture& App_GetSceneRenderTarget();
 
+	// Startup profiler; records engine and app initialization phases (also those performed on job threads) and logs them as a timeline
+
+	void StartupProfiler_Start();
+	int StartupProfiler_BeginPhase(const char* name); // Thread safe; returns phase index
+	void StartupProfiler_EndPhase(int phase); // Thread safe
+	void StartupProfiler_LogTimeline();
+
 	// Texture
 
 	bool			operator == (Texture& texture, const TextureObj* obj);
@@ -342,6 +398,7 @@ namespace Tiny2D
 	int				Texture_GetBytesPerPixel(TextureObj* texture);
 	void			Texture_Draw(TextureObj* texture, const Shape::DrawParams* params, const Sampler& sampler = Sampler::Default);
 	void			Texture_Draw(TextureObj* texture, const Vec2& position, float rotation = 0.0f, float scale = 1.0f, const Color& color = Color::White);
+	void			Texture_DrawBatch(TextureObj* texture, const Texture::BatchInstance* instances, int numInstances);
 	int				Texture_GetWidth(TextureObj* texture);
 	int				Texture_GetHeight(TextureObj* texture);
 	int				Texture_GetRealWidth(TextureObj* texture);
@@ -359,16 +416,21 @@ namespace Tiny2D
 	MaterialObj*	Material_Create(const std::string& name, bool immediate = true);
 	MaterialObj*	Material_Clone(MaterialObj* material);
 	void			Material_Destroy(MaterialObj* material);
-	int				Material_GetTechniqueIndex(MaterialObj* material, const std::string& name);
+	int				Material_GetTechniqueIndex(MaterialObj* material, StringId name);
 	void			Material_SetTechnique(MaterialObj* material, int index);
-	void			Material_SetTechnique(MaterialObj* material, const std::string& name);
-	int				Material_GetParameterIndex(MaterialObj* material, const std::string& name);
+	void			Material_SetTechnique(MaterialObj* material, StringId name);
+	unsigned int	Material_GetKeywordMask(MaterialObj* material, const std::string& keywords);
+	void			Material_SetKeywordMask(MaterialObj* material, unsigned int mask);
+	void			Material_SetKeywords(MaterialObj* material, const std::string& keywords);
+	int				Material_GetParameterIndex(MaterialObj* material, StringId name);
 	void			Material_SetIntParameter(MaterialObj* material, int index, const int* value, int count = 1);
-	void			Material_SetIntParameter(MaterialObj* material, const std::string& name, const int* value, int count = 1);
+	void			Material_SetIntParameter(MaterialObj* material, StringId name, const int* value, int count = 1);
 	void			Material_SetFloatParameter(MaterialObj* material, int index, const float* value, int count = 1);
-	void			Material_SetFloatParameter(MaterialObj* material, const std::string& name, const float* value, int count = 1);
+	void			Material_SetFloatParameter(MaterialObj* material, StringId name, const float* value, int count = 1);
+	void			Material_SetFloatArrayParameter(MaterialObj* material, int index, const float* value, int count, int numElements);
+	void			Material_SetFloatArrayParameter(MaterialObj* material, StringId name, const float* value, int count, int numElements);
 	void			Material_SetTextureParameter(MaterialObj* material, int index, TextureObj* value, const Sampler& sampler = Sampler::Default);
-	void			Material_SetTextureParameter(MaterialObj* material, const std::string& name, TextureObj* value, const Sampler& sampler = Sampler::Default);
+	void			Material_SetTextureParameter(MaterialObj* material, StringId name, TextureObj* value, const Sampler& sampler = Sampler::Default);
 	void			Material_Draw(MaterialObj* material, const Shape::DrawParams* params);
 	void			Material_DrawFullscreenQuad(MaterialObj* material);
 
@@ -379,13 +441,32 @@ namespace Tiny2D
 	void			Font_Draw(FontObj* font, const Text::DrawParams* params);
 	inline void		Font_Draw(FontObj* font, const char* text, const Vec2& position, const Color& color = Color::White) { Text::DrawParams params; params.text = text; params.position = position; params.color = color; Font_Draw(font, &params); }
 	void			Font_CalculateSize(FontObj* font, const Text::DrawParams* params, float& width, float& height);
+	FontObj*		Font_Get(Font& handle);
+
+	// Localization
+
+	struct LocalizationSet
+	{
+		std::string name;
+		std::vector<std::pair<std::string, std::string> > strings;	// Full string name and its translation
+		std::vector<unsigned int> codePoints;						// Sorted distinct characters used by the set
+	};
+
+	bool			Localization_LoadSet(LocalizationSet& set); // Thread safe; only parses the file
+	void			Localization_AddSet(LocalizationSet& set); // Makes parsed set available and precaches its glyphs for registered fonts
+	void			Localization_UnregisterAllFonts();
+
+	typedef std::map<std::string, Rect> SpriteAtlasInfo;
 
 	SpriteObj*		Sprite_Create(const std::string& name, bool immediate = true);
+	SpriteObj*		Sprite_CreateFromDoc(const std::string& name, XMLDocObj* doc, const SpriteAtlasInfo* atlasInfo /* loaded if NULL */, bool immediate = true);
+	bool			Sprite_LoadAtlasInfo(const std::string& atlasName, SpriteAtlasInfo& atlasInfo);
 	SpriteObj*		Sprite_Clone(SpriteObj* sprite);
+	ResourceState	Sprite_GetState(SpriteObj* sprite);
 	void			Sprite_Destroy(SpriteObj* sprite);
 	void			Sprite_SetEventCallback(SpriteObj* sprite, Sprite::EventCallback callback, void* userData);
 	void			Sprite_Update(SpriteObj* sprite, float deltaTime);
-	void			Sprite_PlayAnimation(SpriteObj* sprite, const std::string& name = std::string() /* default animation */, Sprite::AnimationMode mode = Sprite::AnimationMode_Loop, float transitionTime = 0);
+	void			Sprite_PlayAnimation(SpriteObj* sprite, StringId name = StringId() /* default animation */, Sprite::AnimationMode mode = Sprite::AnimationMode_Loop, float transitionTime = 0);
 	void			Sprite_Draw(SpriteObj* sprite, const Sprite::DrawParams* params);
 	inline void		Sprite_Draw(SpriteObj* sprite, const Vec2& position, float rotation = 0) { Sprite::DrawParams params; params.position = position; params.rotation = rotation; Sprite_Draw(sprite, &params); }
 	int				Sprite_GetWidth(SpriteObj* sprite);
@@ -393,15 +474,134 @@ namespace Tiny2D
 
 	FileObj*		File_Open(const std::string& path, File::OpenMode openMode);
 	void			File_Close(FileObj* file);
-	int				File_GetSize(FileObj* file);
-	void			File_Seek(FileObj* file, int offset);
-	int				File_GetOffset(FileObj* file);
-	bool			File_Read(FileObj* file, void* dst, int size);
-	bool			File_Write(FileObj* file, const void* src, int size);
+	long long		File_GetSize(FileObj* file);
+	void			File_Seek(FileObj* file, long long offset);
+	long long		File_GetOffset(FileObj* file);
+	void			File_SetBufferSize(FileObj* file, size_t size);
+	size_t			File_Read(FileObj* file, void* dst, size_t size);
+	size_t			File_ReadAt(FileObj* file, long long offset, const File::Buffer* buffers, int numBuffers);
+	bool			File_Write(FileObj* file, const void* src, size_t size);
+	bool			File_Flush(FileObj* file);
+	int				File_ReadAsync(const std::string& path, FileObj* file, long long offset, size_t size, File::ReadFunc readFunc, File::ReadDoneFunc doneFunc, void* userData);
 	bool			File_Load(const std::string& path, void*& dst, int& size);
 	SDL_RWops*		File_OpenSDLFileRW(const std::string& path, File::OpenMode openMode);
 
-	XMLDocObj*		XMLDoc_Load(const std::string& path);
+	// File view
+
+	struct FileViewObj
+	{
+		const void* data;	// Read-only file contents; memory mapped, pointing into pack file mapping or owned copy (always null terminated when owned)
+		size_t size;
+
+		FileViewObj() :
+			data(NULL),
+			size(0)
+		{}
+	};
+
+	FileViewObj*	File_Map(const std::string& path);
+	FileViewObj*	File_CreateView(void* buffer, size_t size); // Takes ownership of malloc'ed buffer
+	void			File_Unmap(FileViewObj* view);
+
+	// Pack file (generated offline by Tools/PackBuilder)
+	//
+	// Layout (little endian):
+	//   PackHeader
+	//   PackEntry[numEntries] - sorted by (nameHash, name) for binary search
+	//   char[namesSize] - null terminated entry names; relative to root data directory with '/' separators, e.g. "common/default.material.xml"
+	//   entry data; each entry starts at offset aligned to PACK_ENTRY_ALIGNMENT; stored either raw or compressed (see PackCompression)
+	//
+	// Packs are mounted at startup (see App::StartupParams::packFiles) and memory mapped; uncompressed files read from packs are served directly from the mapping,
+	// compressed ones are decompressed by whoever opens them (i.e. by the loading job for asynchronously loaded resources)
+
+	#define PACK_MAGIC				0x4B503254 // "T2PK"
+	#define PACK_VERSION			2
+	#define PACK_ENTRY_ALIGNMENT	16
+
+	enum PackCompression
+	{
+		PackCompression_None = 0,
+		PackCompression_LZ4,		// LZ4 block format (see LZ4_Decompress)
+
+		PackCompression_COUNT
+	};
+
+	struct PackHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int numEntries;
+		unsigned int namesSize;
+	};
+
+	struct PackEntry
+	{
+		unsigned int nameHash;		// string_hash() of the name
+		unsigned int nameOffset;	// Offset within names
+		unsigned long long offset;	// Offset of the data from the beginning of the pack file
+		unsigned long long size;	// Uncompressed size
+		unsigned long long packedSize; // Size of the data stored in pack file; same as size for uncompressed entries
+		unsigned int compression;	// See PackCompression
+		unsigned int reserved;
+	};
+
+	bool			Pack_MountAll(const std::vector<std::string>& packFiles);
+	void			Pack_UnmountAll();
+	const PackEntry* Pack_FindEntry(const std::string& name, const void*& packedData);
+	void*			Pack_DecompressEntry(const std::string& name, const PackEntry* entry, const void* packedData);
+	SDL_RWops*		Pack_OpenEntry(const std::string& name, const PackEntry* entry, const void* packedData);
+
+	// Cooked XML document (generated offline by Tools/XMLCooker)
+	//
+	// Layout (little endian):
+	//   XMLCookedHeader
+	//   XMLCookedNode[numNodes] - document node followed by all of its descendants in depth first order
+	//   XMLCookedAttribute[numAttributes] - attributes of all nodes in node order
+	//   char[stringsSize] - null terminated node and attribute names and values (deduplicated)
+	//
+	// Cooked file is stored next to its source as <source path>XML_COOKED_SUFFIX, e.g. "common/default.material.xml.cooked", and is preferred by XMLDoc_Load()
+	// whenever source hash and size match (or the source is missing); it's memory mapped and names and values of the resulting document point straight into it
+
+	#define XML_COOKED_MAGIC		0x58433254 // "T2CX"
+	#define XML_COOKED_VERSION		1
+	#define XML_COOKED_SUFFIX		".cooked"
+
+	struct XMLCookedHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned long long sourceHash;	// hash_fnv1a64() of the source file
+		unsigned long long sourceSize;
+		unsigned int numNodes;
+		unsigned int numAttributes;
+		unsigned int stringsSize;
+		unsigned int reserved;
+	};
+
+	struct XMLCookedNode
+	{
+		unsigned int type;			// rapidxml::node_type
+		unsigned int nameOffset;	// Offset within strings
+		unsigned int nameSize;		// Excluding null terminator
+		unsigned int valueOffset;
+		unsigned int valueSize;
+		unsigned int numAttributes;
+		unsigned int numChildren;
+	};
+
+	struct XMLCookedAttribute
+	{
+		unsigned int nameOffset;
+		unsigned int nameSize;
+		unsigned int valueOffset;
+		unsigned int valueSize;
+	};
+
+	XMLDocObj*		XMLDoc_Load(const std::string& path); // Prefers up to date cooked document
+	XMLDocObj*		XMLDoc_LoadFromString(char* text); // Takes ownership of malloc'ed text (also on failure)
+	XMLDocObj*		XMLDoc_LoadFromFileData(const std::string& path, char* text, size_t size); // Prefers up to date cooked document; takes ownership of malloc'ed file contents (NULL if file couldn't be read)
+	XMLDocObj*		XMLDoc_LoadCooked(const std::string& path, const void* source /* skips up to date check if NULL */, size_t sourceSize); // Returns NULL if there's no valid cooked document
+	void			XMLDoc_Cook(XMLDocObj* doc, const void* source, size_t sourceSize, std::vector<unsigned char>& cooked);
 	XMLDocObj*		XMLDoc_Create(const std::string& version = "1.0", const std::string& encoding = "utf-8");
 	bool			XMLDoc_Save(XMLDocObj* doc, const std::string& path);
 	void			XMLDoc_Destroy(XMLDocObj* doc);
@@ -441,6 +641,7 @@ namespace Tiny2D
 	bool			Sound_IsPlaying(SoundObj* sound);
 
 	EffectObj*		Effect_Create(const std::string& path, const Vec2& pos, float rotation = 0.0f, float scale = 1.0f, bool immediate = true);
+	EffectObj*		Effect_CreateFromDoc(const std::string& path, XMLDocObj* doc, bool immediate = true);
 	EffectObj*		Effect_Clone(EffectObj* effect);
 	ResourceState	Effect_GetState(EffectObj* effect);
 	void			Effect_Destroy(EffectObj* effect);
@@ -451,6 +652,50 @@ namespace Tiny2D
 	bool			Effect_Update(EffectObj* effect, float deltaTime); // Returns false if destroyed
 	void			Effect_Draw(EffectObj* effect);
 
+	// Load group
+
+	enum LoadGroupItemType
+	{
+		LoadGroupItemType_Texture = 0,
+		LoadGroupItemType_Material,
+		LoadGroupItemType_Sprite,
+		LoadGroupItemType_Sound,
+		LoadGroupItemType_Music,
+		LoadGroupItemType_Font,
+		LoadGroupItemType_Effect,
+
+		LoadGroupItemType_COUNT
+	};
+
+	struct LoadGroupDependency
+	{
+		LoadGroupItemType type;
+		std::string name;
+	};
+
+	extern LoadGroupObj* g_currentLoadGroup; // Group to account asynchronous reads to; only set on main thread while group issues resource loads
+
+	LoadGroupObj*	LoadGroup_Create(LoadGroup* handle);
+	void			LoadGroup_Destroy(LoadGroupObj* group);
+	void			LoadGroup_Add(LoadGroupObj* group, LoadGroupItemType type, const std::string& name, int fontSize = 0, unsigned int fontFlags = 0);
+	void			LoadGroup_SetDoneCallback(LoadGroupObj* group, LoadGroup::DoneCallback callback, void* userData);
+	bool			LoadGroup_IsReady(LoadGroupObj* group);
+	void			LoadGroup_GetProgress(LoadGroupObj* group /* may be NULL */, LoadGroup::Progress& progress);
+	bool			LoadGroup_AddManifest(LoadGroupObj* group, const std::string& path);
+	void			LoadGroup_GetMissingResources(LoadGroupObj* group, std::vector<std::string>& resources);
+	void			LoadGroup_StartRecordingManifest();
+	bool			LoadGroup_StopRecordingManifest(const std::string& path);
+	void			LoadGroup_OnResourceRequested(LoadGroupItemType type, const std::string& name, int fontSize = 0, unsigned int fontFlags = 0); // Invoked by all Create() functions; main thread only
+	void			LoadGroup_AddRef(LoadGroupObj* group);
+	void			LoadGroup_Release(LoadGroupObj* group);
+	void			LoadGroup_AddBytes(LoadGroupObj* group, long long numBytes, long long numBytesDone); // Thread safe
+	void			LoadGroups_Update();
+
+	// Gets dependencies listed in resource files; called from job threads
+
+	void			Sprite_GetDependencies(XMLDocObj* doc, std::vector<LoadGroupDependency>& dependencies);
+	void			Effect_GetDependencies(XMLDocObj* doc, std::vector<LoadGroupDependency>& dependencies);
+
 	// Input
 
 	void Input_AddTouch(float x, float y, long long int id);
@@ -472,22 +717,68 @@ namespace Tiny2D
 	{
 		const char* type;
 		std::string name;
-		int refCount;
+		SDL_atomic_t refCount;
 		ResourceState state;
 		Jobs::JobID jobID;
 
+		unsigned int registryHash;	// Hash of type and name; set when resource gets registered
+		Resource* nextInBucket;		// Next resource in the same registry bucket
+
 		Resource(const char* _type) :
 			type(_type),
-			refCount(0),
 			state(ResourceState_Uninitialized),
-			jobID(0)
-		{}
+			jobID(0),
+			registryHash(0),
+			nextInBucket(NULL)
+		{
+			SDL_AtomicSet(&refCount, 0);
+		}
 	};
 
+	// Resource registry; hashed by (type, name) and split into independently locked shards, so resources can be looked up and created from job threads
+	// Resource gets registered when its reference count goes from 0 to 1 and unregistered when it drops back to 0
+
 	void Resource_ListUnfreed();
 	Resource* Resource_Find(const char* type, const std::string& name);
+	Resource* Resource_FindAndIncRefCount(const char* type, const std::string& name); // Thread safe way of getting a reference to existing resource
+	Resource* Resource_FindOrRegister(Resource* resource); // Thread safe; registers new resource (with reference count of 1) or returns referenced already registered one of the same type and name, in which case the caller must destroy the passed resource
 	void Resource_IncRefCount(Resource* resource);
 	int Resource_DecRefCount(Resource* resource);
+	void Resource_Unregister(Resource* resource); // Removes resource from the registry without destroying it, so that subsequent lookups create a new one
+	inline int Resource_GetRefCount(Resource* resource) { return SDL_AtomicGet(&resource->refCount); }
+
+	// Hot reload; watches root data directories for modified files and reloads resources loaded from them in place, so that existing handles stay valid
+	// New version of each resource is loaded asynchronously (just like regular resource) and then moved into the existing resource object
+	// Resources are reloaded in stages, so that dependents get rebuilt only after their dependencies (e.g. sprites after their textures)
+
+	struct HotReloadHandler
+	{
+		const char* type;	// Resource type
+		int stage;			// Resources of lower stages get reloaded first
+		void (*prepareFunc)();									// Optional; invoked once per stage before reloading any resources of this type
+		void* (*beginFunc)(Resource* resource);					// Starts loading new version of the resource; returns reload context or NULL on failure
+		bool (*updateFunc)(void* context, Resource* resource);	// Invoked each frame until it returns true; resource is NULL if it got destroyed in the meantime; frees the context once done
+	};
+
+	extern bool g_enableHotReload;
+
+	void			HotReload_Init();
+	void			HotReload_Deinit();
+	void			HotReload_Update();
+	void			HotReload_AddFile(const char* type, const std::string& name, const std::string& path); // Thread safe; registers file whose modification triggers reload of given resource
+	void			HotReload_AddInclude(const std::string& path, const std::string& includingPath); // Thread safe; modification of the file counts as modification of the file including it
+
+	void*			Texture_BeginReload(Resource* resource);
+	bool			Texture_UpdateReload(void* context, Resource* resource);
+	void*			Sound_BeginReload(Resource* resource);
+	bool			Sound_UpdateReload(void* context, Resource* resource);
+	void			Material_PrepareReload();
+	void*			Material_BeginReload(Resource* resource);
+	bool			Material_UpdateReload(void* context, Resource* resource);
+	void*			Sprite_BeginReload(Resource* resource);
+	bool			Sprite_UpdateReload(void* context, Resource* resource);
+	void*			Effect_BeginReload(Resource* resource);
+	bool			Effect_UpdateReload(void* context, Resource* resource);
 
 	// Font
 
@@ -501,19 +792,66 @@ namespace Tiny2D
 
 	struct FontObj : Resource
 	{
-		TTF_Font* font;
+		TTF_Font* font;			// NULL for prebaked fonts
+		FileViewObj* fileView;	// TTF file contents; kept mapped so that job threads can open their own TTF_Font
 		int size;
-		TextureObj* texture;
-		std::map<unsigned int, Glyph> glyphs;
+		unsigned int flags;
+		int lineHeight;
+		int numCreationJobs;	// Number of jobs rasterizing initial glyph set during asynchronous creation
+		std::vector<unsigned int> precacheCodes; // Glyphs requested while the font was still being created
+		TextureObj* texture;	// Prebaked fonts only; TTF fonts use shared glyph cache
+		std::map<unsigned int, Glyph> glyphs; // Prebaked fonts only
 
 		FontObj() :
 			Resource("font"),
 			font(NULL),
+			fileView(NULL),
+			size(0),
+			flags(0),
+			lineHeight(0),
+			numCreationJobs(0),
 			texture(NULL)
 		{}
 	};
 
 	void Font_CacheGlyphs(FontObj* font, unsigned int* buffer, int bufferSize);
+	//! Gets glyph for given character code; returns false if font doesn't have such glyph; returned texture is NULL if the glyph is empty or isn't cached yet
+	bool Font_GetGlyph(FontObj* font, unsigned int code, Glyph*& glyph, TextureObj*& texture);
+
+	// Glyph cache
+
+	bool GlyphCache_GetGlyph(FontObj* font, unsigned int code, Glyph*& glyph, TextureObj*& texture);
+	void GlyphCache_RemoveFont(FontObj* font);
+	void GlyphCache_Update();
+	void GlyphCache_Deinit();
+
+	// Prebaked font (generated offline by Tools/FontBaker)
+	//
+	// <base>.font file layout (little endian):
+	//   BakedFontHeader
+	//   Glyph[numGlyphs]
+	// <base>.png holds the glyph atlas
+
+	#define BAKED_FONT_MAGIC	0x46443254 // "T2DF"
+	#define BAKED_FONT_VERSION	1
+
+	struct BakedFontHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		int size;
+		unsigned int flags;
+		int lineHeight;
+		unsigned int numGlyphs;
+	};
+
+	//! Gets base path (without extension) of the prebaked font files, e.g. "common/courbd_16_0" for "common/courbd.ttf", size 16 and no flags
+	inline std::string Font_GetBakedBasePath(const std::string& faceName, int size, unsigned int flags)
+	{
+		const size_t dotIndex = faceName.find_last_of('.');
+		const std::string baseName = dotIndex == std::string::npos ? faceName : faceName.substr(0, dotIndex);
+		return baseName + "_" + string_from_int(size) + "_" + string_from_int((int) flags);
+	}
 
 	// Sprite
 
@@ -540,7 +878,7 @@ namespace Tiny2D
 		};
 		bool hasAtlas;
 		Texture atlas;
-		std::map<std::string, Animation> animations;
+		std::map<StringId, Animation> animations;
 		Animation* defaultAnimation;
 		int width;
 		int height;
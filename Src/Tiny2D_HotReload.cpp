@@ -0,0 +1,456 @@
+#include "Tiny2D.h"
+#include "Tiny2D_Common.h"
+
+#include <set>
+#include <sys/stat.h>
+
+#if defined(__LINUX__)
+	#include <sys/inotify.h>
+	#include <dirent.h>
+	#include <errno.h>
+	#include <unistd.h>
+	#define SUPPORT_INOTIFY
+#endif
+
+#define HOT_RELOAD_SETTLE_TIME		0.25f	// Seconds to wait after the last file modification before reloading; editors often save files in multiple steps
+#define HOT_RELOAD_POLL_INTERVAL	1.0f	// Seconds between file modification time checks when inotify isn't available
+
+namespace Tiny2D
+{
+
+bool g_enableHotReload = false;
+
+// Reload handlers
+
+const HotReloadHandler g_hotReloadHandlers[] =
+{
+	{ "texture", 0, NULL, Texture_BeginReload, Texture_UpdateReload },
+	{ "sound", 0, NULL, Sound_BeginReload, Sound_UpdateReload },
+	{ "material", 1, Material_PrepareReload, Material_BeginReload, Material_UpdateReload },
+	{ "sprite", 2, NULL, Sprite_BeginReload, Sprite_UpdateReload },
+	{ "effect", 2, NULL, Effect_BeginReload, Effect_UpdateReload }
+};
+
+const HotReloadHandler* HotReload_GetHandler(const char* type)
+{
+	for (int i = 0; i < (int) ARRAYSIZE(g_hotReloadHandlers); i++)
+		if (!strcmp(g_hotReloadHandlers[i].type, type))
+			return &g_hotReloadHandlers[i];
+	return NULL;
+}
+
+// Watched files
+
+struct HotReloadTarget
+{
+	const HotReloadHandler* handler;
+	std::string name;
+
+	inline bool operator < (const HotReloadTarget& other) const
+	{
+		return handler->stage != other.handler->stage ? handler->stage < other.handler->stage : (handler != other.handler ? handler < other.handler : name < other.name);
+	}
+};
+
+SDL_SpinLock g_hotReloadFilesLock = 0; // Guards g_hotReloadFiles and g_hotReloadIncludes; files get registered from job threads too
+std::map<std::string, std::set<HotReloadTarget> > g_hotReloadFiles;	// Resources to reload by file path
+std::map<std::string, std::set<std::string> > g_hotReloadIncludes;	// Files including given file
+
+std::set<std::string> g_hotReloadChangedFiles;	// Modified files not yet processed
+Time::Ticks g_hotReloadLastChangeTicks = 0;
+
+void HotReload_AddFile(const char* type, const std::string& name, const std::string& path)
+{
+	if (!g_enableHotReload)
+		return;
+
+	HotReloadTarget target;
+	target.handler = HotReload_GetHandler(type);
+	target.name = name;
+	if (!target.handler)
+		return;
+
+	SDL_AtomicLock(&g_hotReloadFilesLock);
+	g_hotReloadFiles[path].insert(target);
+	SDL_AtomicUnlock(&g_hotReloadFilesLock);
+}
+
+void HotReload_AddInclude(const std::string& path, const std::string& includingPath)
+{
+	if (!g_enableHotReload)
+		return;
+
+	SDL_AtomicLock(&g_hotReloadFilesLock);
+	g_hotReloadIncludes[path].insert(includingPath);
+	SDL_AtomicUnlock(&g_hotReloadFilesLock);
+}
+
+void HotReload_OnFileChanged(const std::string& path)
+{
+	g_hotReloadChangedFiles.insert(path);
+	g_hotReloadLastChangeTicks = Time::GetTicks();
+}
+
+// File watcher based on inotify; directories get watched recursively, each with its own watch
+
+#ifdef SUPPORT_INOTIFY
+
+struct InotifyWatch
+{
+	std::string rootDir;
+	std::string dir;	// Relative to root data directory; either empty or ends with slash
+};
+
+int g_inotifyFd = -1;
+std::map<int, InotifyWatch> g_inotifyWatches;
+
+bool Inotify_IsDirectory(const std::string& path, const struct dirent* entry)
+{
+	if (entry->d_type != DT_UNKNOWN)
+		return entry->d_type == DT_DIR;
+
+	struct stat fileStat;
+	return stat(path.c_str(), &fileStat) == 0 && S_ISDIR(fileStat.st_mode);
+}
+
+bool Inotify_AddWatches(const std::string& rootDir, const std::string& dir)
+{
+	std::string fullPath = rootDir + dir;
+	if (fullPath.empty())
+		fullPath = ".";
+
+	const int wd = inotify_add_watch(g_inotifyFd, fullPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+	if (wd == -1)
+		return errno == ENOENT || errno == ENOTDIR; // Not all root data directories have to exist
+
+	InotifyWatch& watch = g_inotifyWatches[wd];
+	watch.rootDir = rootDir;
+	watch.dir = dir;
+
+	// Watch subdirectories (skipping hidden ones)
+
+	DIR* dirHandle = opendir(fullPath.c_str());
+	if (!dirHandle)
+		return true;
+
+	bool success = true;
+	while (struct dirent* entry = readdir(dirHandle))
+		if (entry->d_name[0] != '.' && Inotify_IsDirectory(fullPath + "/" + entry->d_name, entry) && !Inotify_AddWatches(rootDir, dir + entry->d_name + "/"))
+		{
+			success = false;
+			break;
+		}
+	closedir(dirHandle);
+	return success;
+}
+
+void Inotify_Deinit()
+{
+	if (g_inotifyFd != -1)
+	{
+		close(g_inotifyFd);
+		g_inotifyFd = -1;
+	}
+	g_inotifyWatches.clear();
+}
+
+bool Inotify_Init()
+{
+	g_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (g_inotifyFd == -1)
+	{
+		Log::Warn(string_format("Failed to initialize inotify, reason: %s", strerror(errno)));
+		return false;
+	}
+
+	for (std::vector<std::string>::const_iterator it = g_rootDataDirs.begin(); it != g_rootDataDirs.end(); ++it)
+		if (!Inotify_AddWatches(*it, std::string()))
+		{
+			Log::Warn(string_format("Failed to watch root data directory '%s' via inotify, reason: %s", it->c_str(), strerror(errno)));
+			Inotify_Deinit();
+			return false;
+		}
+	return true;
+}
+
+void Inotify_ProcessEvents()
+{
+	long long buffer[4096 / sizeof(long long)]; // Suitably aligned for inotify_event
+	for (;;)
+	{
+		const ssize_t length = read(g_inotifyFd, buffer, sizeof(buffer));
+		if (length <= 0)
+			break; // EAGAIN when there are no more events
+
+		for (const char* ptr = (const char*) buffer; ptr < (const char*) buffer + length; )
+		{
+			const struct inotify_event* event = (const struct inotify_event*) ptr;
+			ptr += sizeof(struct inotify_event) + event->len;
+
+			std::map<int, InotifyWatch>::iterator watchIt = g_inotifyWatches.find(event->wd);
+			if (watchIt == g_inotifyWatches.end())
+				continue;
+			if (event->mask & IN_IGNORED)
+			{
+				g_inotifyWatches.erase(watchIt);
+				continue;
+			}
+			if (!event->len)
+				continue;
+
+			const InotifyWatch watch = watchIt->second;
+			const std::string path = watch.dir + event->name;
+			if (event->mask & IN_ISDIR)
+			{
+				if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && event->name[0] != '.')
+					Inotify_AddWatches(watch.rootDir, path + "/");
+			}
+			else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+				HotReload_OnFileChanged(path);
+		}
+	}
+}
+
+#endif // SUPPORT_INOTIFY
+
+// Fallback file watcher; periodically checks modification times of all watched files on job thread
+
+struct FileTime
+{
+	long long modificationTime;
+	long long size;
+};
+
+struct PollJobData
+{
+	std::vector<std::string> paths;			// Files to check
+	std::vector<std::string> changedPaths;	// Files modified since last check
+};
+
+std::map<std::string, FileTime> g_hotReloadFileTimes; // Only accessed by the poll job
+bool g_isPollJobRunning = false;
+Time::Ticks g_lastPollTicks = 0;
+
+void PollJob_JobFunc(void* userData)
+{
+	PollJobData* jobData = (PollJobData*) userData;
+	for (std::vector<std::string>::iterator it = jobData->paths.begin(); it != jobData->paths.end(); ++it)
+	{
+		// Files are looked up in root data directories in priority order (just like when opening them)
+
+		struct stat fileStat;
+		bool found = false;
+		for (std::vector<std::string>::const_iterator rootIt = g_rootDataDirs.begin(); rootIt != g_rootDataDirs.end() && !found; ++rootIt)
+			found = stat((*rootIt + *it).c_str(), &fileStat) == 0;
+		if (!found)
+			continue;
+
+		FileTime fileTime;
+		fileTime.modificationTime = (long long) fileStat.st_mtime;
+		fileTime.size = (long long) fileStat.st_size;
+
+		std::map<std::string, FileTime>::iterator timeIt = g_hotReloadFileTimes.find(*it);
+		if (timeIt == g_hotReloadFileTimes.end())
+			g_hotReloadFileTimes[*it] = fileTime;
+		else if (timeIt->second.modificationTime != fileTime.modificationTime || timeIt->second.size != fileTime.size)
+		{
+			timeIt->second = fileTime;
+			jobData->changedPaths.push_back(*it);
+		}
+	}
+}
+
+void PollJob_DoneFunc(bool, void* userData)
+{
+	PollJobData* jobData = (PollJobData*) userData;
+	for (std::vector<std::string>::iterator it = jobData->changedPaths.begin(); it != jobData->changedPaths.end(); ++it)
+		HotReload_OnFileChanged(*it);
+	delete jobData;
+
+	g_isPollJobRunning = false;
+	g_lastPollTicks = Time::GetTicks();
+}
+
+void HotReload_StartPollJob()
+{
+	PollJobData* jobData = new PollJobData();
+	SDL_AtomicLock(&g_hotReloadFilesLock);
+	for (std::map<std::string, std::set<HotReloadTarget> >::iterator it = g_hotReloadFiles.begin(); it != g_hotReloadFiles.end(); ++it)
+		jobData->paths.push_back(it->first);
+	for (std::map<std::string, std::set<std::string> >::iterator it = g_hotReloadIncludes.begin(); it != g_hotReloadIncludes.end(); ++it)
+		if (g_hotReloadFiles.find(it->first) == g_hotReloadFiles.end())
+			jobData->paths.push_back(it->first);
+	SDL_AtomicUnlock(&g_hotReloadFilesLock);
+
+	g_isPollJobRunning = true;
+	Jobs::RunJob(PollJob_JobFunc, PollJob_DoneFunc, jobData);
+}
+
+// Reloading
+
+struct HotReload
+{
+	HotReloadTarget target;
+	void* context;
+};
+
+std::vector<HotReloadTarget> g_hotReloadQueue;	// Resources waiting to be reloaded; sorted by stage
+std::vector<HotReload> g_hotReloads;			// Reloads in progress; all belong to the same stage
+
+void HotReload_StartBatch()
+{
+	// Files included by modified files count as modified too
+
+	std::set<std::string> changedFiles;
+	changedFiles.swap(g_hotReloadChangedFiles);
+
+	std::set<HotReloadTarget> targets;
+	std::vector<std::string> filesToVisit(changedFiles.begin(), changedFiles.end());
+
+	SDL_AtomicLock(&g_hotReloadFilesLock);
+	while (!filesToVisit.empty())
+	{
+		const std::string path = filesToVisit.back();
+		filesToVisit.pop_back();
+
+		std::map<std::string, std::set<HotReloadTarget> >::iterator filesIt = g_hotReloadFiles.find(path);
+		if (filesIt != g_hotReloadFiles.end())
+			targets.insert(filesIt->second.begin(), filesIt->second.end());
+
+		std::map<std::string, std::set<std::string> >::iterator includesIt = g_hotReloadIncludes.find(path);
+		if (includesIt != g_hotReloadIncludes.end())
+			for (std::set<std::string>::iterator it = includesIt->second.begin(); it != includesIt->second.end(); ++it)
+				if (changedFiles.insert(*it).second)
+					filesToVisit.push_back(*it);
+	}
+	SDL_AtomicUnlock(&g_hotReloadFilesLock);
+
+	// Only reload resources that are still alive; targets are already ordered by stage
+
+	for (std::set<HotReloadTarget>::iterator it = targets.begin(); it != targets.end(); ++it)
+		if (Resource_Find(it->handler->type, it->name))
+			g_hotReloadQueue.push_back(*it);
+
+	if (!g_hotReloadQueue.empty())
+		Log::Info(string_format("Hot reloading %d resources affected by %d modified files", (int) g_hotReloadQueue.size(), (int) changedFiles.size()));
+}
+
+void HotReload_StartNextStage()
+{
+	// Queue is sorted by stage
+
+	const int stage = g_hotReloadQueue.front().handler->stage;
+	std::vector<HotReloadTarget>::iterator end = g_hotReloadQueue.begin();
+	while (end != g_hotReloadQueue.end() && end->handler->stage == stage)
+		++end;
+
+	std::set<const HotReloadHandler*> preparedHandlers;
+	for (std::vector<HotReloadTarget>::iterator it = g_hotReloadQueue.begin(); it != end; ++it)
+	{
+		// Skip resources destroyed in the meantime or still being loaded (they'll pick up new version anyway)
+
+		Resource* resource = Resource_Find(it->handler->type, it->name);
+		if (!resource || resource->state != ResourceState_Created)
+			continue;
+
+		if (it->handler->prepareFunc && preparedHandlers.insert(it->handler).second)
+			it->handler->prepareFunc();
+
+		Log::Info(string_format("Reloading %s %s", it->handler->type, it->name.c_str()));
+		HotReload reload;
+		reload.target = *it;
+		reload.context = it->handler->beginFunc(resource);
+		if (reload.context)
+			g_hotReloads.push_back(reload);
+	}
+
+	g_hotReloadQueue.erase(g_hotReloadQueue.begin(), end);
+}
+
+void HotReload_UpdateReloads(bool discard)
+{
+	for (unsigned int i = 0; i < g_hotReloads.size(); )
+	{
+		HotReload& reload = g_hotReloads[i];
+		Resource* resource = discard ? NULL : Resource_Find(reload.target.handler->type, reload.target.name);
+		if (reload.target.handler->updateFunc(reload.context, resource))
+		{
+			g_hotReloads[i] = g_hotReloads.back();
+			g_hotReloads.pop_back();
+		}
+		else
+			i++;
+	}
+}
+
+void HotReload_Init()
+{
+	if (!g_enableHotReload)
+		return;
+
+#ifdef SUPPORT_INOTIFY
+	if (Inotify_Init())
+	{
+		Log::Info("Hot reload enabled; watching root data directories via inotify");
+		return;
+	}
+#endif
+
+	Log::Info(string_format("Hot reload enabled; checking watched files for modifications every %.1f seconds", HOT_RELOAD_POLL_INTERVAL));
+}
+
+void HotReload_Deinit()
+{
+	if (!g_enableHotReload)
+		return;
+
+	// Finish reloads in progress, discarding their results
+
+	g_hotReloadQueue.clear();
+	while (!g_hotReloads.empty() || g_isPollJobRunning)
+	{
+		Jobs::WaitForAllJobs();
+		HotReload_UpdateReloads(true);
+		if (!g_hotReloads.empty())
+			App::Sleep(0.001f);
+	}
+
+#ifdef SUPPORT_INOTIFY
+	Inotify_Deinit();
+#endif
+
+	g_hotReloadFiles.clear();
+	g_hotReloadIncludes.clear();
+	g_hotReloadChangedFiles.clear();
+	g_hotReloadFileTimes.clear();
+}
+
+void HotReload_Update()
+{
+	if (!g_enableHotReload)
+		return;
+
+	// Collect modified files
+
+#ifdef SUPPORT_INOTIFY
+	if (g_inotifyFd != -1)
+		Inotify_ProcessEvents();
+	else
+#endif
+	if (!g_isPollJobRunning && Time::SecondsSince(g_lastPollTicks) >= HOT_RELOAD_POLL_INTERVAL)
+		HotReload_StartPollJob();
+
+	// Finish current stage before starting the next one, so that dependents get rebuilt using reloaded dependencies
+
+	HotReload_UpdateReloads(false);
+	if (!g_hotReloads.empty())
+		return;
+
+	if (g_hotReloadQueue.empty() && !g_hotReloadChangedFiles.empty() && Time::SecondsSince(g_hotReloadLastChangeTicks) >= HOT_RELOAD_SETTLE_TIME)
+		HotReload_StartBatch();
+
+	if (!g_hotReloadQueue.empty())
+		HotReload_StartNextStage();
+}
+
+};
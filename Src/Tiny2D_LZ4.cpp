@@ -0,0 +1,209 @@
+#include "Tiny2D.h"
+#include "Tiny2D_Common.h"
+
+// LZ4 block format codec (compatible with reference LZ4 block format; no frame headers or checksums)
+//
+// Each sequence is:
+//   token - high 4 bits: literal length, low 4 bits: match length - 4 (value of 15 means more length bytes follow)
+//   [literal length bytes] - each adds 0-255; byte of 255 means another one follows
+//   literals
+//   match offset - 2 bytes, little endian
+//   [match length bytes] - same encoding as literal length bytes
+//
+// Last sequence consists of literals only; last 5 bytes are always literals and last match starts at least 12 bytes before the end.
+
+namespace Tiny2D
+{
+
+#define LZ4_MIN_MATCH			4
+#define LZ4_LAST_LITERALS		5
+#define LZ4_MATCH_SAFE_DISTANCE	12
+#define LZ4_MAX_OFFSET			65535
+#define LZ4_HASH_BITS			16
+
+inline unsigned int LZ4_Read32(const unsigned char* p)
+{
+	return (unsigned int) p[0] | ((unsigned int) p[1] << 8) | ((unsigned int) p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+inline unsigned int LZ4_Hash(unsigned int sequence)
+{
+	return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+inline unsigned char* LZ4_WriteLength(unsigned char* dst, size_t length)
+{
+	for (; length >= 255; length -= 255)
+		*dst++ = 255;
+	*dst++ = (unsigned char) length;
+	return dst;
+}
+
+size_t LZ4_CompressBound(size_t srcSize)
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+size_t LZ4_Compress(const void* src, size_t srcSize, void* dst)
+{
+	const unsigned char* const srcStart = (const unsigned char*) src;
+	const unsigned char* const srcEnd = srcStart + srcSize;
+	const unsigned char* const matchLimit = srcEnd - LZ4_LAST_LITERALS;
+	unsigned char* out = (unsigned char*) dst;
+
+	const unsigned char* literals = srcStart;
+
+	if (srcSize > LZ4_MATCH_SAFE_DISTANCE)
+	{
+		const unsigned char* const searchEnd = srcEnd - LZ4_MATCH_SAFE_DISTANCE;
+		std::vector<unsigned int> hashTable(1 << LZ4_HASH_BITS, 0);
+
+		const unsigned char* p = srcStart + 1;
+		hashTable[LZ4_Hash(LZ4_Read32(srcStart))] = 0;
+
+		while (p < searchEnd)
+		{
+			// Find match candidate via hash of next 4 bytes
+
+			const unsigned int sequence = LZ4_Read32(p);
+			unsigned int& slot = hashTable[LZ4_Hash(sequence)];
+			const unsigned char* match = srcStart + slot;
+			slot = (unsigned int) (p - srcStart);
+
+			if (match >= p || p - match > LZ4_MAX_OFFSET || LZ4_Read32(match) != sequence)
+			{
+				p++;
+				continue;
+			}
+
+			// Extend match backwards and forwards
+
+			while (p > literals && match > srcStart && p[-1] == match[-1])
+			{
+				p--;
+				match--;
+			}
+
+			const unsigned char* matchEnd = p + LZ4_MIN_MATCH;
+			const unsigned char* matchRef = match + LZ4_MIN_MATCH;
+			while (matchEnd < matchLimit && *matchEnd == *matchRef)
+			{
+				matchEnd++;
+				matchRef++;
+			}
+
+			// Emit sequence
+
+			const size_t literalLength = p - literals;
+			const size_t matchLength = matchEnd - p - LZ4_MIN_MATCH;
+			unsigned char* token = out++;
+			*token = (unsigned char) ((literalLength >= 15 ? 15 : literalLength) << 4);
+			if (literalLength >= 15)
+				out = LZ4_WriteLength(out, literalLength - 15);
+			memcpy(out, literals, literalLength);
+			out += literalLength;
+
+			const unsigned int offset = (unsigned int) (p - match);
+			*out++ = (unsigned char) offset;
+			*out++ = (unsigned char) (offset >> 8);
+
+			*token |= (unsigned char) (matchLength >= 15 ? 15 : matchLength);
+			if (matchLength >= 15)
+				out = LZ4_WriteLength(out, matchLength - 15);
+
+			// Insert skipped position to improve subsequent matches
+
+			if (matchEnd - 2 > srcStart && matchEnd - 2 < searchEnd)
+				hashTable[LZ4_Hash(LZ4_Read32(matchEnd - 2))] = (unsigned int) (matchEnd - 2 - srcStart);
+
+			p = literals = matchEnd;
+		}
+	}
+
+	// Emit last literals
+
+	const size_t literalLength = srcEnd - literals;
+	*out++ = (unsigned char) ((literalLength >= 15 ? 15 : literalLength) << 4);
+	if (literalLength >= 15)
+		out = LZ4_WriteLength(out, literalLength - 15);
+	memcpy(out, literals, literalLength);
+	out += literalLength;
+
+	return out - (unsigned char*) dst;
+}
+
+bool LZ4_Decompress(const void* src, size_t srcSize, void* dst, size_t dstSize)
+{
+	const unsigned char* in = (const unsigned char*) src;
+	const unsigned char* const inEnd = in + srcSize;
+	unsigned char* const dstStart = (unsigned char*) dst;
+	unsigned char* out = dstStart;
+	unsigned char* const outEnd = out + dstSize;
+
+	while (in < inEnd)
+	{
+		const unsigned int token = *in++;
+
+		// Copy literals
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15)
+		{
+			unsigned int b;
+			do
+			{
+				if (in == inEnd)
+					return false;
+				b = *in++;
+				literalLength += b;
+			} while (b == 255);
+		}
+		if ((size_t) (inEnd - in) < literalLength || (size_t) (outEnd - out) < literalLength)
+			return false;
+		memcpy(out, in, literalLength);
+		in += literalLength;
+		out += literalLength;
+
+		if (in == inEnd)
+			break; // Last sequence has no match
+
+		// Copy match
+
+		if (inEnd - in < 2)
+			return false;
+		const size_t offset = (size_t) in[0] | ((size_t) in[1] << 8);
+		in += 2;
+		if (offset == 0 || offset > (size_t) (out - dstStart))
+			return false;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15)
+		{
+			unsigned int b;
+			do
+			{
+				if (in == inEnd)
+					return false;
+				b = *in++;
+				matchLength += b;
+			} while (b == 255);
+		}
+		matchLength += LZ4_MIN_MATCH;
+		if ((size_t) (outEnd - out) < matchLength)
+			return false;
+
+		const unsigned char* match = out - offset;
+		if (offset >= matchLength)
+		{
+			memcpy(out, match, matchLength);
+			out += matchLength;
+		}
+		else
+			while (matchLength--) // Overlapping copy
+				*out++ = *match++;
+	}
+
+	return out == outEnd;
+}
+
+};
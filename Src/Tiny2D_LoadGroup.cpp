@@ -0,0 +1,504 @@
+#include "Tiny2D.h"
+#include "Tiny2D_Common.h"
+
+#include <algorithm>
+#include <set>
+
+namespace Tiny2D
+{
+
+LoadGroupObj* g_currentLoadGroup = NULL;
+
+const char* g_loadGroupItemTypeNames[LoadGroupItemType_COUNT] =
+{
+	"texture",
+	"material",
+	"sprite",
+	"sound",
+	"music",
+	"font",
+	"effect"
+};
+
+struct LoadGroupItem
+{
+	LoadGroupObj* group;
+	LoadGroupItemType type;
+	std::string name;
+	int fontSize;
+	unsigned int fontFlags;
+	void* obj;				// TextureObj*, MaterialObj*, SpriteObj*, SoundObj*, FontObj* or EffectObj*; NULL if failed or still being parsed
+	Jobs::JobID parseJobID;	// Job reading and parsing sprite or effect file
+
+	// Filled in by parse job
+
+	XMLDocObj* doc;
+	std::vector<LoadGroupDependency> dependencies;
+	SpriteAtlasInfo atlasInfo;
+	bool hasAtlasInfo;
+
+	LoadGroupItem() :
+		group(NULL),
+		fontSize(0),
+		fontFlags(0),
+		obj(NULL),
+		parseJobID(0),
+		doc(NULL),
+		hasAtlasInfo(false)
+	{}
+};
+
+struct LoadGroupObj
+{
+	SDL_atomic_t refCount;	// One reference held by the handle and one by each asynchronous read accounted to the group
+	LoadGroup* handle;
+	std::vector<LoadGroupItem*> items;
+	std::map<std::string, LoadGroupItem*> itemsByKey;
+	std::set<std::string> manifestKeys;			// Resources listed in manifests added to the group
+	std::vector<std::string> missingResources;	// Resources requested elsewhere but not listed in manifests
+	LoadGroup::DoneCallback doneCallback;
+	void* doneCallbackUserData;
+	bool isDone;			// Set when done callback has been invoked; reset when new items get added
+	bool isBeingDestroyed;
+
+	SDL_SpinLock bytesLock;
+	long long numBytes;
+	long long numBytesDone;
+
+	LoadGroupObj() :
+		handle(NULL),
+		doneCallback(NULL),
+		doneCallbackUserData(NULL),
+		isDone(false),
+		isBeingDestroyed(false),
+		bytesLock(0),
+		numBytes(0),
+		numBytesDone(0)
+	{
+		SDL_AtomicSet(&refCount, 1);
+	}
+};
+
+std::vector<LoadGroupObj*> g_loadGroups;
+
+std::string LoadGroup_MakeKey(LoadGroupItemType type, const std::string& name, int fontSize, unsigned int fontFlags)
+{
+	return type == LoadGroupItemType_Font ?
+		string_format("%s:%s:%d:%u", g_loadGroupItemTypeNames[type], name.c_str(), fontSize, fontFlags) :
+		string_format("%s:%s", g_loadGroupItemTypeNames[type], name.c_str());
+}
+
+LoadGroupObj* LoadGroup_Create(LoadGroup* handle)
+{
+	LoadGroupObj* group = new LoadGroupObj();
+	group->handle = handle;
+	g_loadGroups.push_back(group);
+	return group;
+}
+
+void LoadGroup_AddRef(LoadGroupObj* group)
+{
+	SDL_AtomicIncRef(&group->refCount);
+}
+
+void LoadGroup_Release(LoadGroupObj* group)
+{
+	if (SDL_AtomicDecRef(&group->refCount))
+		delete group;
+}
+
+void LoadGroup_AddBytes(LoadGroupObj* group, long long numBytes, long long numBytesDone)
+{
+	SDL_AtomicLock(&group->bytesLock);
+	group->numBytes += numBytes;
+	group->numBytesDone += numBytesDone;
+	SDL_AtomicUnlock(&group->bytesLock);
+}
+
+// Sprites and effects: resource file is read and parsed and its dependencies are gathered on job thread
+
+std::string LoadGroupItem_GetPath(LoadGroupItem* item)
+{
+	return item->name + (item->type == LoadGroupItemType_Sprite ? ".sprite.xml" : ".effect.xml");
+}
+
+void LoadGroupItem_ReadFunc(void*& data, size_t size, void* userData)
+{
+	LoadGroupItem* item = (LoadGroupItem*) userData;
+
+	item->doc = XMLDoc_LoadFromFileData(LoadGroupItem_GetPath(item), (char*) data, size);
+	data = NULL;
+	if (!item->doc)
+	{
+		Log::Error(string_format("Failed to load %s", LoadGroupItem_GetPath(item).c_str()));
+		return;
+	}
+
+	if (item->type == LoadGroupItemType_Sprite)
+	{
+		Sprite_GetDependencies(item->doc, item->dependencies);
+		XMLNode* spriteNode = XMLNode_GetFirstNode(XMLDoc_AsNode(item->doc), "sprite");
+		if (const char* atlasName = spriteNode ? XMLNode_GetAttributeValue(spriteNode, "atlas") : NULL)
+			item->hasAtlasInfo = Sprite_LoadAtlasInfo(atlasName, item->atlasInfo);
+	}
+	else
+		Effect_GetDependencies(item->doc, item->dependencies);
+}
+
+void LoadGroupItem_DoneFunc(bool canceled, void* userData)
+{
+	LoadGroupItem* item = (LoadGroupItem*) userData;
+	LoadGroupObj* group = item->group;
+	item->parseJobID = 0;
+
+	if (!canceled && !group->isBeingDestroyed && item->doc)
+	{
+		// Start loading all dependencies first, so they load in parallel; resource creation below finds them in the registry
+
+		for (std::vector<LoadGroupDependency>::iterator it = item->dependencies.begin(); it != item->dependencies.end(); ++it)
+			LoadGroup_Add(group, it->type, it->name);
+
+		LoadGroupObj* prevGroup = g_currentLoadGroup;
+		g_currentLoadGroup = group;
+		if (item->type == LoadGroupItemType_Sprite)
+			item->obj = Sprite_CreateFromDoc(item->name, item->doc, item->hasAtlasInfo ? &item->atlasInfo : NULL, false);
+		else
+			item->obj = Effect_CreateFromDoc(item->name, item->doc, false);
+		g_currentLoadGroup = prevGroup;
+	}
+
+	if (item->doc)
+	{
+		XMLDoc_Destroy(item->doc);
+		item->doc = NULL;
+	}
+	std::vector<LoadGroupDependency>().swap(item->dependencies);
+	item->atlasInfo.clear();
+}
+
+ResourceState LoadGroupItem_GetState(LoadGroupItem* item)
+{
+	if (item->parseJobID)
+		return ResourceState_Creating;
+	if (!item->obj)
+		return ResourceState_AsyncError;
+
+	switch (item->type)
+	{
+		case LoadGroupItemType_Texture: return Texture_GetState((TextureObj*) item->obj);
+		case LoadGroupItemType_Material: return Material_GetState((MaterialObj*) item->obj);
+		case LoadGroupItemType_Sprite: return Sprite_GetState((SpriteObj*) item->obj);
+		case LoadGroupItemType_Sound:
+		case LoadGroupItemType_Music: return Sound_GetState((SoundObj*) item->obj);
+		case LoadGroupItemType_Font: return ((FontObj*) item->obj)->state;
+		case LoadGroupItemType_Effect: return Effect_GetState((EffectObj*) item->obj);
+		default:
+			Assert(0);
+			return ResourceState_AsyncError;
+	}
+}
+
+void LoadGroup_Add(LoadGroupObj* group, LoadGroupItemType type, const std::string& name, int fontSize, unsigned int fontFlags)
+{
+	// Each resource is loaded only once per group
+
+	const std::string key = LoadGroup_MakeKey(type, name, fontSize, fontFlags);
+	if (group->itemsByKey.find(key) != group->itemsByKey.end())
+		return;
+
+	LoadGroupItem* item = new LoadGroupItem();
+	item->group = group;
+	item->type = type;
+	item->name = name;
+	item->fontSize = fontSize;
+	item->fontFlags = fontFlags;
+	group->items.push_back(item);
+	group->itemsByKey[key] = item;
+	group->isDone = false;
+
+	// Start asynchronous loading; reads issued meanwhile are accounted to this group
+
+	LoadGroupObj* prevGroup = g_currentLoadGroup;
+	g_currentLoadGroup = group;
+	switch (type)
+	{
+		case LoadGroupItemType_Texture: item->obj = Texture_Create(name, false); break;
+		case LoadGroupItemType_Material: item->obj = Material_Create(name, false); break;
+		case LoadGroupItemType_Sound: item->obj = Sound_Create(name, false, false); break;
+		case LoadGroupItemType_Music: item->obj = Sound_Create(name, true, false); break;
+		case LoadGroupItemType_Font: item->obj = Font_Create(name, fontSize, fontFlags, false); break;
+		case LoadGroupItemType_Sprite:
+			if (strchr(name.c_str(), '.') || Resource_Find("sprite", name))
+			{
+				item->obj = Sprite_Create(name, false);
+				break;
+			}
+			item->parseJobID = File_ReadAsync(LoadGroupItem_GetPath(item), NULL, 0, 0, LoadGroupItem_ReadFunc, LoadGroupItem_DoneFunc, item);
+			break;
+		case LoadGroupItemType_Effect:
+			if (Resource_Find("effect", name))
+			{
+				item->obj = Effect_Create(name, Vec2(0.0f, 0.0f), 0.0f, 1.0f, false);
+				break;
+			}
+			item->parseJobID = File_ReadAsync(LoadGroupItem_GetPath(item), NULL, 0, 0, LoadGroupItem_ReadFunc, LoadGroupItem_DoneFunc, item);
+			break;
+		default:
+			Assert(0);
+			break;
+	}
+	g_currentLoadGroup = prevGroup;
+}
+
+// Manifests
+
+struct ManifestEntry
+{
+	LoadGroupItemType type;
+	std::string name;
+	int fontSize;
+	unsigned int fontFlags;
+};
+
+bool g_isRecordingManifest = false;
+std::vector<ManifestEntry> g_recordedManifest;
+std::set<std::string> g_recordedManifestKeys;
+
+void LoadGroup_StartRecordingManifest()
+{
+	g_isRecordingManifest = true;
+	g_recordedManifest.clear();
+	g_recordedManifestKeys.clear();
+}
+
+bool LoadGroup_StopRecordingManifest(const std::string& path)
+{
+	if (!g_isRecordingManifest)
+	{
+		Log::Error(string_format("Failed to save manifest to %s, reason: manifest recording wasn't started", path.c_str()));
+		return false;
+	}
+	g_isRecordingManifest = false;
+
+	XMLDoc doc;
+	doc.Create();
+	XMLNode* manifestNode = doc.AsNode()->AddNode("manifest");
+	for (std::vector<ManifestEntry>::iterator it = g_recordedManifest.begin(); it != g_recordedManifest.end(); ++it)
+	{
+		XMLNode* resourceNode = manifestNode->AddNode("resource");
+		resourceNode->AddAttribute("type", g_loadGroupItemTypeNames[it->type]);
+		resourceNode->AddAttribute("name", it->name.c_str());
+		if (it->type == LoadGroupItemType_Font)
+		{
+			resourceNode->AddAttributeInt("size", it->fontSize);
+			resourceNode->AddAttributeInt("flags", (int) it->fontFlags);
+		}
+	}
+
+	std::vector<ManifestEntry>().swap(g_recordedManifest);
+	g_recordedManifestKeys.clear();
+
+	if (!doc.Save(path))
+	{
+		Log::Error(string_format("Failed to save manifest to %s", path.c_str()));
+		return false;
+	}
+	return true;
+}
+
+void LoadGroup_OnResourceRequested(LoadGroupItemType type, const std::string& name, int fontSize, unsigned int fontFlags)
+{
+	const std::string key = LoadGroup_MakeKey(type, name, fontSize, fontFlags);
+
+	if (g_isRecordingManifest && g_recordedManifestKeys.insert(key).second)
+	{
+		ManifestEntry& entry = vector_add(g_recordedManifest);
+		entry.type = type;
+		entry.name = name;
+		entry.fontSize = fontSize;
+		entry.fontFlags = fontFlags;
+	}
+
+	// Report resources requested outside of load groups that weren't prefetched by any of manifests
+
+	if (g_currentLoadGroup)
+		return;
+	bool hasManifests = false;
+	for (std::vector<LoadGroupObj*>::iterator it = g_loadGroups.begin(); it != g_loadGroups.end(); ++it)
+		if (!(*it)->manifestKeys.empty())
+		{
+			if ((*it)->manifestKeys.find(key) != (*it)->manifestKeys.end())
+				return;
+			hasManifests = true;
+		}
+	if (!hasManifests)
+		return;
+
+	bool isNew = false;
+	for (std::vector<LoadGroupObj*>::iterator it = g_loadGroups.begin(); it != g_loadGroups.end(); ++it)
+		if (!(*it)->manifestKeys.empty() && std::find((*it)->missingResources.begin(), (*it)->missingResources.end(), key) == (*it)->missingResources.end())
+		{
+			(*it)->missingResources.push_back(key);
+			isNew = true;
+		}
+	if (isNew)
+		Log::Warn(string_format("Resource %s requested but not listed in any of the manifests being loaded", key.c_str()));
+}
+
+bool LoadGroup_AddManifest(LoadGroupObj* group, const std::string& path)
+{
+	XMLDoc doc;
+	if (!doc.Load(path))
+	{
+		Log::Error(string_format("Failed to load manifest from %s", path.c_str()));
+		return false;
+	}
+
+	XMLNode* manifestNode = doc.AsNode()->GetFirstNode("manifest");
+	if (!manifestNode)
+	{
+		Log::Error(string_format("Failed to load manifest from %s, reason: root 'manifest' node not found", path.c_str()));
+		return false;
+	}
+
+	// Start loading resources in recorded order
+
+	for (XMLNode* resourceNode = manifestNode->GetFirstNode("resource"); resourceNode; resourceNode = resourceNode->GetNext("resource"))
+	{
+		const char* typeName = resourceNode->GetAttributeValue("type");
+		const char* name = resourceNode->GetAttributeValue("name");
+		int type = 0;
+		while (type < LoadGroupItemType_COUNT && (!typeName || strcmp(typeName, g_loadGroupItemTypeNames[type])))
+			type++;
+		if (type == LoadGroupItemType_COUNT || !name)
+		{
+			Log::Error(string_format("Invalid resource entry in manifest %s", path.c_str()));
+			continue;
+		}
+
+		int fontSize = 0, fontFlags = 0;
+		if (type == LoadGroupItemType_Font)
+		{
+			resourceNode->GetAttributeValueInt("size", fontSize, 0);
+			resourceNode->GetAttributeValueInt("flags", fontFlags, 0);
+		}
+
+		group->manifestKeys.insert(LoadGroup_MakeKey((LoadGroupItemType) type, name, fontSize, (unsigned int) fontFlags));
+		LoadGroup_Add(group, (LoadGroupItemType) type, name, fontSize, (unsigned int) fontFlags);
+	}
+	return true;
+}
+
+void LoadGroup_GetMissingResources(LoadGroupObj* group, std::vector<std::string>& resources)
+{
+	resources = group->missingResources;
+}
+
+void LoadGroup_SetDoneCallback(LoadGroupObj* group, LoadGroup::DoneCallback callback, void* userData)
+{
+	group->doneCallback = callback;
+	group->doneCallbackUserData = userData;
+	group->isDone = false;
+}
+
+bool LoadGroup_IsReady(LoadGroupObj* group)
+{
+	for (std::vector<LoadGroupItem*>::iterator it = group->items.begin(); it != group->items.end(); ++it)
+		if (LoadGroupItem_GetState(*it) == ResourceState_Creating)
+			return false;
+	return true;
+}
+
+void LoadGroup_GetProgress(LoadGroupObj* group, LoadGroup::Progress& progress)
+{
+	memset(&progress, 0, sizeof(progress));
+	if (!group)
+		return;
+
+	progress.numItems = (int) group->items.size();
+	for (std::vector<LoadGroupItem*>::iterator it = group->items.begin(); it != group->items.end(); ++it)
+		switch (LoadGroupItem_GetState(*it))
+		{
+			case ResourceState_AsyncError:
+				progress.numItemsFailed++;
+				// Fall through
+			case ResourceState_Created:
+				progress.numItemsDone++;
+				break;
+			default:
+				break;
+		}
+
+	SDL_AtomicLock(&group->bytesLock);
+	progress.numBytes = group->numBytes;
+	progress.numBytesDone = group->numBytesDone;
+	SDL_AtomicUnlock(&group->bytesLock);
+}
+
+void LoadGroup_Destroy(LoadGroupObj* group)
+{
+	group->isBeingDestroyed = true;
+
+	// Stop parsing resource files; done function gets called from within CancelJob
+
+	for (std::vector<LoadGroupItem*>::iterator it = group->items.begin(); it != group->items.end(); ++it)
+		if ((*it)->parseJobID)
+			Jobs::CancelJob((*it)->parseJobID);
+
+	// Release resources
+
+	for (std::vector<LoadGroupItem*>::iterator it = group->items.begin(); it != group->items.end(); ++it)
+	{
+		LoadGroupItem* item = *it;
+		if (item->obj)
+			switch (item->type)
+			{
+				case LoadGroupItemType_Texture: Texture_Destroy((TextureObj*) item->obj); break;
+				case LoadGroupItemType_Material: Material_Destroy((MaterialObj*) item->obj); break;
+				case LoadGroupItemType_Sprite: Sprite_Destroy((SpriteObj*) item->obj); break;
+				case LoadGroupItemType_Sound:
+				case LoadGroupItemType_Music: Sound_Destroy((SoundObj*) item->obj); break;
+				case LoadGroupItemType_Font: Font_Destroy((FontObj*) item->obj); break;
+				case LoadGroupItemType_Effect: Effect_Destroy((EffectObj*) item->obj); break;
+				default: Assert(0); break;
+			}
+		delete item;
+	}
+	group->items.clear();
+	group->itemsByKey.clear();
+
+	vector_remove(g_loadGroups, group);
+	group->handle = NULL;
+	LoadGroup_Release(group);
+}
+
+void LoadGroups_Update()
+{
+	// Collect ready groups first; callbacks might create or destroy groups (including other ready ones)
+
+	std::vector<LoadGroupObj*> readyGroups;
+	for (std::vector<LoadGroupObj*>::iterator it = g_loadGroups.begin(); it != g_loadGroups.end(); ++it)
+	{
+		LoadGroupObj* group = *it;
+		if (group->isDone || !group->doneCallback || !LoadGroup_IsReady(group))
+			continue;
+
+		group->isDone = true;
+		LoadGroup_AddRef(group);
+		readyGroups.push_back(group);
+	}
+
+	for (std::vector<LoadGroupObj*>::iterator it = readyGroups.begin(); it != readyGroups.end(); ++it)
+	{
+		LoadGroupObj* group = *it;
+		if (group->handle) // Not destroyed by preceding callback
+		{
+			LoadGroup::Progress progress;
+			LoadGroup_GetProgress(group, progress);
+			group->doneCallback(group->handle, progress.numItemsFailed == 0, group->doneCallbackUserData);
+		}
+		LoadGroup_Release(group);
+	}
+}
+
+};
@@ -3,7 +3,11 @@
 
 using namespace Tiny2D;
 
-std::map<std::string, std::string> g_strings;
+#include <set>
+
+std::map<StringId, std::string> g_strings;
+std::map<std::string, std::vector<unsigned int> > g_setCodePoints;
+std::vector<Font> g_registeredFonts;
 
 Localization::Param::Param() :
 	type(Type_Uninitialized)
@@ -28,9 +32,9 @@ Localization::Param::Param(const std::string& _name, const std::string& value) :
 {}
 
 
-bool Localization::LoadSet(const std::string& name)
+bool Tiny2D::Localization_LoadSet(LocalizationSet& set)
 {
-	const std::string path = name + "_" + App::GetLanguageSymbol() + ".translations.xml";
+	const std::string path = set.name + "_" + App::GetLanguageSymbol() + ".translations.xml";
 
 	XMLDoc doc;
 	if (!doc.Load(path))
@@ -48,6 +52,9 @@ bool Localization::LoadSet(const std::string& name)
 
 	// Load groups
 
+	std::set<unsigned int> codePoints;
+	std::vector<unsigned int> buffer;
+
 	for (XMLNode* groupNode = XMLNode_GetFirstNode(translationsNode, "group"); groupNode; groupNode = XMLNode_GetNext(groupNode, "group"))
 	{
 		const std::string groupName = XMLNode_GetAttributeValue(groupNode, "name");
@@ -59,12 +66,43 @@ bool Localization::LoadSet(const std::string& name)
 			const std::string translationName = XMLNode_GetAttributeValue(translationNode, "name");
 			const char* value = XMLNode_GetAttributeValue(translationNode, "value");
 
-			const std::string fullName = name + "." + groupName + "." + translationName;
+			set.strings.push_back(std::make_pair(set.name + "." + groupName + "." + translationName, std::string(value)));
 
-			g_strings[fullName] = value;
+			// Gather used characters
+
+			const unsigned int valueLength = (unsigned int) strlen(value);
+			buffer.resize(valueLength + 1);
+			unsigned int bufferSize = (unsigned int) buffer.size();
+			if (UTF8ToUTF32((const unsigned char*) value, valueLength, &buffer[0], bufferSize))
+				codePoints.insert(buffer.begin(), buffer.begin() + bufferSize);
 		}
 	}
 
+	set.codePoints.assign(codePoints.begin(), codePoints.end());
+	return true;
+}
+
+void Tiny2D::Localization_AddSet(LocalizationSet& set)
+{
+	for (std::vector<std::pair<std::string, std::string> >::iterator it = set.strings.begin(); it != set.strings.end(); ++it)
+		g_strings[StringId(it->first)].swap(it->second);
+
+	std::vector<unsigned int>& setCodePoints = g_setCodePoints[set.name];
+	setCodePoints.swap(set.codePoints);
+
+	// Precache glyphs for registered fonts
+
+	for (std::vector<Font>::iterator it = g_registeredFonts.begin(); it != g_registeredFonts.end(); ++it)
+		it->CacheGlyphs(setCodePoints);
+}
+
+bool Localization::LoadSet(const std::string& name)
+{
+	LocalizationSet set;
+	set.name = name;
+	if (!Localization_LoadSet(set))
+		return false;
+	Localization_AddSet(set);
 	return true;
 }
 
@@ -72,19 +110,65 @@ void Localization::UnloadSet(const std::string& name)
 {
 	const std::string setPrefix = name + ".";
 
-	for (std::map<std::string, std::string>::iterator it = g_strings.begin(); it != g_strings.end(); ++it)
+	std::map<StringId, std::string>::iterator it = g_strings.begin();
+	while (it != g_strings.end())
 		if (!strncmp(it->first.c_str(), setPrefix.c_str(), setPrefix.length()))
-			g_strings.erase(it);
+			g_strings.erase(it++);
+		else
+			++it;
+
+	g_setCodePoints.erase(name);
 }
 
 void Localization::UnloadAllSets()
 {
 	g_strings.clear();
+	g_setCodePoints.clear();
+}
+
+const std::vector<unsigned int>& Localization::GetSetCodePoints(const std::string& name)
+{
+	static const std::vector<unsigned int> empty;
+	const std::vector<unsigned int>* codePoints = map_find(g_setCodePoints, name);
+	return codePoints ? *codePoints : empty;
+}
+
+void Localization::RegisterFont(Font& font)
+{
+	for (std::vector<Font>::iterator it = g_registeredFonts.begin(); it != g_registeredFonts.end(); ++it)
+		if (Font_Get(*it) == Font_Get(font))
+			return;
+	g_registeredFonts.push_back(font);
+
+	// Precache glyphs of already loaded sets
+
+	for (std::map<std::string, std::vector<unsigned int> >::iterator it = g_setCodePoints.begin(); it != g_setCodePoints.end(); ++it)
+		font.CacheGlyphs(it->second);
+}
+
+void Localization::UnregisterFont(Font& font)
+{
+	for (std::vector<Font>::iterator it = g_registeredFonts.begin(); it != g_registeredFonts.end(); ++it)
+		if (Font_Get(*it) == Font_Get(font))
+		{
+			g_registeredFonts.erase(it);
+			return;
+		}
+}
+
+void Tiny2D::Localization_UnregisterAllFonts()
+{
+	g_registeredFonts.clear();
 }
 
 const std::string Localization::Get(const char* stringName, const Localization::Param* params, int numParams)
 {
-	std::string* localizedPtr = map_find<std::string, std::string>(g_strings, stringName);
+	return Get(StringId::Find(stringName), params, numParams); // Doesn't intern; strings not interned yet can't be localized anyway
+}
+
+const std::string Localization::Get(StringId stringName, const Localization::Param* params, int numParams)
+{
+	std::string* localizedPtr = map_find<StringId, std::string>(g_strings, stringName);
 	if (!localizedPtr)
 		return "<STRING>";
 	if (numParams == 0)
@@ -411,8 +411,12 @@ struct EmitterResource
 struct EffectResource : Resource
 {
 	std::vector<EmitterResource> emitters;
+	unsigned int version; // Incremented on every hot reload
 
-	EffectResource() : Resource("effect") {}
+	EffectResource() :
+		Resource("effect"),
+		version(0)
+	{}
 };
 
 struct Particle
@@ -470,11 +474,13 @@ struct EffectObj
 	EffectResource* resource;
 	std::vector<Emitter> emitters;
 	float spawnMultiplier;
+	unsigned int resourceVersion; // Version of the resource emitters were set up for
 
 	EffectObj() :
 		toDelete(false),
 		resource(NULL),
-		spawnMultiplier(1.0f)
+		spawnMultiplier(1.0f),
+		resourceVersion(0)
 	{}
 };
 
@@ -686,8 +692,63 @@ void Emitter_Update(EffectObj* effect, Emitter* emitter, EmitterResource* resour
 	Emitter_SpawnParticles(effect, emitter, resource, deltaTime);
 }
 
+void Emitter_Init(EffectObj* effect, Emitter* emitter, EmitterResource* resource)
+{
+	emitter->seed = Random::GetFloat(0.0f, 1.0f);
+	emitter->cyclesTotal = resource->emitter.cyclesTotal.Generate();
+	emitter->lifeTotal = resource->emitter.lifeTotal.Generate();
+	emitter->spawnAccumulator = resource->initial.spawnCount.Generate();
+
+	Emitter_SpawnParticles(effect, emitter, resource, 0.0f);
+}
+
+void Effect_SyncWithResource(EffectObj* effect)
+{
+	if (effect->resourceVersion == effect->resource->version)
+		return;
+	effect->resourceVersion = effect->resource->version;
+
+	// Resource got hot reloaded; keep existing particles but match new emitter setup
+
+	const unsigned int oldNumEmitters = effect->emitters.size();
+	effect->emitters.resize(effect->resource->emitters.size());
+	for (unsigned int i = 0; i < effect->emitters.size(); i++)
+	{
+		Emitter& emitter = effect->emitters[i];
+		EmitterResource& emitterResource = effect->resource->emitters[i];
+		if (i >= oldNumEmitters)
+			Emitter_Init(effect, &emitter, &emitterResource);
+		else if ((int) emitter.particles.size() > emitterResource.maxParticles)
+			emitter.particles.resize(emitterResource.maxParticles);
+	}
+}
+
+bool EffectResource_CheckCreated(EffectResource* resource)
+{
+	if (resource->state != ResourceState_Creating)
+		return resource->state == ResourceState_Created;
+
+	// Wait for color maps and materials; emitters fall back to default material if theirs fails to load
+
+	for (std::vector<EmitterResource>::iterator it = resource->emitters.begin(); it != resource->emitters.end(); ++it)
+	{
+		if (it->colorMap.GetState() == ResourceState_Creating || it->material.GetState() == ResourceState_Creating)
+			return false;
+		if (it->colorMap.GetState() == ResourceState_AsyncError)
+		{
+			resource->state = ResourceState_AsyncError;
+			Log::Error(string_format("Particle effect %s color map failed to load (asynchronously)", resource->name.c_str()));
+			return false;
+		}
+	}
+
+	resource->state = ResourceState_Created;
+	return true;
+}
+
 ResourceState Effect_GetState(EffectObj* effect)
 {
+	EffectResource_CheckCreated(effect->resource);
 	return effect->resource->state;
 }
 
@@ -698,6 +759,8 @@ bool Effect_Update(EffectObj* effect, float deltaTime)
 	effect->previousTransform = effect->transform;
 	effect->transform = effect->newTransform;
 
+	Effect_SyncWithResource(effect);
+
 	// Update emitters
 
 	int numParticles = 0;
@@ -787,22 +850,16 @@ void Emitter_Draw(EffectObj* effect, Emitter* emitter, EmitterResource* resource
 
 void Effect_Draw(EffectObj* effect)
 {
+	Effect_SyncWithResource(effect);
 	for (unsigned int i = 0; i < effect->emitters.size(); i++)
 		Emitter_Draw(effect, &effect->emitters[i], &effect->resource->emitters[i]);
 }
 
-EffectResource* EffectResource_Load(const std::string& name, bool immediate)
+EffectResource* EffectResource_LoadFromDoc(const std::string& name, XMLDocObj* doc, bool immediate)
 {
 	const std::string path = name + ".effect.xml";
 
-	XMLDoc doc;
-	if (!doc.Load(path))
-	{
-		Log::Error(string_format("Failed to load particle effect XML from %s", path.c_str()));
-		return NULL;
-	}
-
-	XMLNode* effectNode = doc.AsNode()->GetFirstNode("effect");
+	XMLNode* effectNode = XMLDoc_AsNode(doc)->GetFirstNode("effect");
 	if (!effectNode)
 	{
 		Log::Error(string_format("Invalid particle effect XML file %s, reason: root 'effect' element not found", path.c_str()));
@@ -820,6 +877,8 @@ EffectResource* EffectResource_Load(const std::string& name, bool immediate)
 	resource->name = name;
 	resource->state = ResourceState_Creating;
 
+	HotReload_AddFile("effect", name, path);
+
 	for (XMLNode* emitterNode = emittersNode->GetFirstNode("emitter"); emitterNode; emitterNode = emitterNode->GetNext("emitter"))
 	{
 		EmitterResource& emitter = vector_add(resource->emitters);
@@ -879,40 +938,105 @@ EffectResource* EffectResource_Load(const std::string& name, bool immediate)
 		emitter.emitter.lifeTotal.Load( emitterNode->GetFirstNode("emitterLifeTotal") );
 	}
 
+	EffectResource_CheckCreated(resource);
 	return resource;
 }
 
-EffectObj* Effect_Create(const std::string& name, const Vec2& pos, float rotation, float scale, bool immediate)
+EffectResource* EffectResource_Load(const std::string& name, bool immediate)
 {
-	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	const std::string path = name + ".effect.xml";
 
-	EffectResource* resource = static_cast<EffectResource*>(Resource_Find("effect", name));
-	if (!resource && !(resource = EffectResource_Load(name, immediate)))
+	XMLDocObj* doc = XMLDoc_Load(path);
+	if (!doc)
+	{
+		Log::Error(string_format("Failed to load particle effect XML from %s", path.c_str()));
 		return NULL;
+	}
+
+	EffectResource* resource = EffectResource_LoadFromDoc(name, doc, immediate);
+	XMLDoc_Destroy(doc);
+	return resource;
+}
+
+void Effect_GetDependencies(XMLDocObj* doc, std::vector<LoadGroupDependency>& dependencies)
+{
+	XMLNode* effectNode = XMLDoc_AsNode(doc)->GetFirstNode("effect");
+	XMLNode* emittersNode = effectNode ? effectNode->GetFirstNode("emitters") : NULL;
+	if (!emittersNode)
+		return;
+
+	for (XMLNode* emitterNode = emittersNode->GetFirstNode("emitter"); emitterNode; emitterNode = emitterNode->GetNext("emitter"))
+	{
+		if (const char* colorMapName = emitterNode->GetAttributeValue("colorMap"))
+		{
+			LoadGroupDependency& dependency = vector_add(dependencies);
+			dependency.type = LoadGroupItemType_Texture;
+			dependency.name = colorMapName;
+		}
+		if (const char* materialName = emitterNode->GetAttributeValue("material"))
+		{
+			LoadGroupDependency& dependency = vector_add(dependencies);
+			dependency.type = LoadGroupItemType_Material;
+			dependency.name = materialName;
+		}
+	}
+}
 
+EffectObj* Effect_CreateFromResource(EffectResource* resource, const Vec2& pos, float rotation, float scale)
+{
 	EffectObj* effect = new EffectObj();
 	effect->transform.pos = pos;
 	effect->transform.rotation = rotation;
 	effect->transform.scale = scale;
 	effect->newTransform = effect->previousTransform = effect->transform;
 	effect->resource = resource;
+	effect->resourceVersion = resource->version;
 	effect->emitters.resize( resource->emitters.size() );
 	for (unsigned int i = 0; i < effect->emitters.size(); i++)
-	{
-		Emitter& emitter = effect->emitters[i];
-		EmitterResource& emitterResource = resource->emitters[i];
+		Emitter_Init(effect, &effect->emitters[i], &resource->emitters[i]);
 
-		emitter.seed = Random::GetFloat(0.0f, 1.0f);
-		emitter.cyclesTotal = emitterResource.emitter.cyclesTotal.Generate();
-		emitter.lifeTotal = emitterResource.emitter.lifeTotal.Generate();
-		emitter.spawnAccumulator = emitterResource.initial.spawnCount.Generate();
+	return effect;
+}
 
-		Emitter_SpawnParticles(effect, &emitter, &emitterResource, 0.0f);
+// Registers loaded effect resource unless the same effect got registered concurrently
+EffectResource* EffectResource_Register(EffectResource* resource)
+{
+	EffectResource* registered = static_cast<EffectResource*>(Resource_FindOrRegister(resource));
+	if (registered != resource)
+		delete resource;
+	return registered;
+}
+
+EffectObj* Effect_Create(const std::string& name, const Vec2& pos, float rotation, float scale, bool immediate)
+{
+	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	LoadGroup_OnResourceRequested(LoadGroupItemType_Effect, name);
+
+	EffectResource* resource = static_cast<EffectResource*>(Resource_FindAndIncRefCount("effect", name));
+	if (!resource)
+	{
+		if (!(resource = EffectResource_Load(name, immediate)))
+			return NULL;
+		resource = EffectResource_Register(resource);
 	}
 
-	Resource_IncRefCount(effect->resource);
+	return Effect_CreateFromResource(resource, pos, rotation, scale);
+}
 
-	return effect;
+EffectObj* Effect_CreateFromDoc(const std::string& name, XMLDocObj* doc, bool immediate)
+{
+	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	LoadGroup_OnResourceRequested(LoadGroupItemType_Effect, name);
+
+	EffectResource* resource = static_cast<EffectResource*>(Resource_FindAndIncRefCount("effect", name));
+	if (!resource)
+	{
+		if (!(resource = EffectResource_LoadFromDoc(name, doc, immediate)))
+			return NULL;
+		resource = EffectResource_Register(resource);
+	}
+
+	return Effect_CreateFromResource(resource, Vec2(0.0f, 0.0f), 0.0f, 1.0f);
 }
 
 void Effect_Destroy(EffectObj* effect)
@@ -946,25 +1070,91 @@ EffectObj* Effect_Clone(EffectObj* other)
 {
 	EffectObj* effect = new EffectObj();
 	effect->resource = other->resource;
+	effect->resourceVersion = effect->resource->version;
 	Resource_IncRefCount(effect->resource);
 
 	effect->transform = other->transform;
 	effect->newTransform = effect->previousTransform = effect->transform;
 	effect->emitters.resize( effect->resource->emitters.size() );
 	for (unsigned int i = 0; i < effect->emitters.size(); i++)
-	{
-		Emitter& emitter = effect->emitters[i];
-		EmitterResource& emitterResource = effect->resource->emitters[i];
+		Emitter_Init(effect, &effect->emitters[i], &effect->resource->emitters[i]);
 
-		emitter.seed = Random::GetFloat(0.0f, 1.0f);
-		emitter.cyclesTotal = emitterResource.emitter.cyclesTotal.Generate();
-		emitter.lifeTotal = emitterResource.emitter.lifeTotal.Generate();
-		emitter.spawnAccumulator = emitterResource.initial.spawnCount.Generate();
+	return effect;
+}
+
+// Hot reload
+
+struct EffectReload
+{
+	std::string name;
+	XMLDocObj* doc;
+	Jobs::JobID jobID;
+	EffectResource* shadow; // New version of the effect resource; not registered
+
+	EffectReload() :
+		doc(NULL),
+		jobID(0),
+		shadow(NULL)
+	{}
+};
 
-		Emitter_SpawnParticles(effect, &emitter, &emitterResource, 0.0f);
+void EffectReload_ReadFunc(void*& data, size_t, void* userData)
+{
+	EffectReload* reload = (EffectReload*) userData;
+	if (!data)
+		return;
+
+	// Parse on job thread; document takes ownership of the data
+
+	reload->doc = XMLDoc_LoadFromString((char*) data);
+	data = NULL;
+}
+
+void EffectReload_DoneFunc(bool canceled, void* userData)
+{
+	EffectReload* reload = (EffectReload*) userData;
+	reload->jobID = 0;
+
+	if (!reload->doc)
+		return;
+	if (!canceled)
+		reload->shadow = EffectResource_LoadFromDoc(reload->name, reload->doc, false);
+	XMLDoc_Destroy(reload->doc);
+	reload->doc = NULL;
+}
+
+void* Effect_BeginReload(Resource* resource)
+{
+	EffectReload* reload = new EffectReload();
+	reload->name = resource->name;
+	reload->jobID = File_ReadAsync(reload->name + ".effect.xml", NULL, 0, 0, EffectReload_ReadFunc, EffectReload_DoneFunc, reload);
+	return reload;
+}
+
+bool Effect_UpdateReload(void* context, Resource* resource)
+{
+	EffectReload* reload = (EffectReload*) context;
+	if (reload->jobID)
+		return false;
+
+	EffectResource* shadow = reload->shadow;
+	if (shadow && !EffectResource_CheckCreated(shadow) && shadow->state == ResourceState_Creating)
+		return false;
+
+	// Swap emitters; existing effects pick up the change on their next update
+
+	EffectResource* effect = static_cast<EffectResource*>(resource);
+	if (effect && shadow && shadow->state == ResourceState_Created)
+	{
+		std::swap(effect->emitters, shadow->emitters);
+		effect->version++;
 	}
+	else if (effect)
+		Log::Error(string_format("Failed to reload particle effect %s; keeping previous version", effect->name.c_str()));
 
-	return effect;
+	delete shadow;
+	delete reload;
+	return true;
 }
 
 };
@@ -4,6 +4,42 @@
 namespace Tiny2D
 {
 
+// Names of material techniques and parameters used by postprocessing effects
+
+const StringId g_downsample2x2TechniqueName("downsample2x2");
+const StringId g_verticalBlurTechniqueName("vertical_blur");
+const StringId g_horizontalBlurTechniqueName("horizontal_blur");
+const StringId g_blendTechniqueName("blend");
+const StringId g_oldtvTechniqueName("oldtv");
+const StringId g_quakeTechniqueName("quake");
+const StringId g_rainEvaporationTechniqueName("rain_evaporation");
+const StringId g_copyTextureTechniqueName("copy_texture");
+const StringId g_texColTechniqueName("tex_col");
+const StringId g_rainDistortionTechniqueName("rain_distortion");
+const StringId g_colorMapParameterName("ColorMap");
+const StringId g_blurKernelParameterName("BlurKernel");
+const StringId g_colorMap0ParameterName("ColorMap0");
+const StringId g_colorMap1ParameterName("ColorMap1");
+const StringId g_blendFactorParameterName("BlendFactor");
+const StringId g_timeParameterName("Time");
+const StringId g_overExposureAmountParameterName("OverExposureAmount");
+const StringId g_dustAmountParameterName("DustAmount");
+const StringId g_frameJitterFrequencyParameterName("FrameJitterFrequency");
+const StringId g_maxFrameJitterParameterName("MaxFrameJitter");
+const StringId g_filmColorParameterName("FilmColor");
+const StringId g_grainThicknesParameterName("GrainThicknes");
+const StringId g_grainAmountParameterName("GrainAmount");
+const StringId g_scratchesAmountParameterName("ScratchesAmount");
+const StringId g_scratchesLevelParameterName("ScratchesLevel");
+const StringId g_dustMapParameterName("DustMap");
+const StringId g_lineMapParameterName("LineMap");
+const StringId g_tvMapParameterName("TvMap");
+const StringId g_noiseMapParameterName("NoiseMap");
+const StringId g_offsetParameterName("Offset");
+const StringId g_colorParameterName("Color");
+const StringId g_dropletColorParameterName("DropletColor");
+const StringId g_normalMapParameterName("NormalMap");
+
 // Bloom
 
 struct Bloom
@@ -51,8 +87,8 @@ void Postprocessing_DrawBloom(Texture& output, Texture& scene)
 
 	Texture halfSizeRenderTexture = RenderTexturePool::Get(width / 2, height / 2);
 	halfSizeRenderTexture.BeginDrawing();
-	bloom->material.SetTechnique("downsample2x2");
-	bloom->material.SetTextureParameter("ColorMap", scene);
+	bloom->material.SetTechnique(g_downsample2x2TechniqueName);
+	bloom->material.SetTextureParameter(g_colorMapParameterName, scene);
 	bloom->material.DrawFullscreenQuad();
 	halfSizeRenderTexture.EndDrawing();
 
@@ -62,7 +98,7 @@ void Postprocessing_DrawBloom(Texture& output, Texture& scene)
 
 	quarterSizeRenderTextures[0] = RenderTexturePool::Get(width / 4, height / 4);
 	quarterSizeRenderTextures[0].BeginDrawing();
-	bloom->material.SetTextureParameter("ColorMap", halfSizeRenderTexture);
+	bloom->material.SetTextureParameter(g_colorMapParameterName, halfSizeRenderTexture);
 	bloom->material.DrawFullscreenQuad();
 	quarterSizeRenderTextures[0].EndDrawing();
 	RenderTexturePool::Release(halfSizeRenderTexture);
@@ -71,21 +107,21 @@ void Postprocessing_DrawBloom(Texture& output, Texture& scene)
 
 	if (bloom->numBlurSteps)
 	{
-		bloom->material.SetFloatParameter("BlurKernel", &bloom->blurKernel);
+		bloom->material.SetFloatParameter(g_blurKernelParameterName, &bloom->blurKernel);
 		quarterSizeRenderTextures[1] = RenderTexturePool::Get(width / 4, height / 4);
 	}
 
 	for (int i = 0; i < bloom->numBlurSteps; i++)
 	{
 		quarterSizeRenderTextures[1].BeginDrawing();
-		bloom->material.SetTechnique("vertical_blur");
-		bloom->material.SetTextureParameter("ColorMap", quarterSizeRenderTextures[0], Sampler::DefaultPostprocess);
+		bloom->material.SetTechnique(g_verticalBlurTechniqueName);
+		bloom->material.SetTextureParameter(g_colorMapParameterName, quarterSizeRenderTextures[0], Sampler::DefaultPostprocess);
 		bloom->material.DrawFullscreenQuad();
 		quarterSizeRenderTextures[1].EndDrawing();
 
 		quarterSizeRenderTextures[0].BeginDrawing();
-		bloom->material.SetTechnique("horizontal_blur");
-		bloom->material.SetTextureParameter("ColorMap", quarterSizeRenderTextures[1], Sampler::DefaultPostprocess);
+		bloom->material.SetTechnique(g_horizontalBlurTechniqueName);
+		bloom->material.SetTextureParameter(g_colorMapParameterName, quarterSizeRenderTextures[1], Sampler::DefaultPostprocess);
 		bloom->material.DrawFullscreenQuad();
 		quarterSizeRenderTextures[0].EndDrawing();
 	}
@@ -96,10 +132,10 @@ void Postprocessing_DrawBloom(Texture& output, Texture& scene)
 	// Blend result with the scene
 
 	output.BeginDrawing();
-	bloom->material.SetTechnique("blend");
-	bloom->material.SetTextureParameter("ColorMap0", quarterSizeRenderTextures[0]);
-	bloom->material.SetTextureParameter("ColorMap1", scene, Sampler::DefaultPostprocess);
-	bloom->material.SetFloatParameter("BlendFactor", &bloom->blendFactor);
+	bloom->material.SetTechnique(g_blendTechniqueName);
+	bloom->material.SetTextureParameter(g_colorMap0ParameterName, quarterSizeRenderTextures[0]);
+	bloom->material.SetTextureParameter(g_colorMap1ParameterName, scene, Sampler::DefaultPostprocess);
+	bloom->material.SetFloatParameter(g_blendFactorParameterName, &bloom->blendFactor);
 	bloom->material.DrawFullscreenQuad();
 	output.EndDrawing();
 
@@ -146,41 +182,41 @@ void Postprocessing_DrawOldTV(Texture& renderTarget, Texture& scene)
 {
 	renderTarget.BeginDrawing();
 
-	oldtv->material.SetTechnique("oldtv");
+	oldtv->material.SetTechnique(g_oldtvTechniqueName);
 
-	oldtv->material.SetTextureParameter("ColorMap", scene, Sampler::DefaultPostprocess);
-	oldtv->material.SetFloatParameter("Time", oldtv->time);
+	oldtv->material.SetTextureParameter(g_colorMapParameterName, scene, Sampler::DefaultPostprocess);
+	oldtv->material.SetFloatParameter(g_timeParameterName, oldtv->time);
 
-	oldtv->material.SetFloatParameter("OverExposureAmount", 0.1f);
-	oldtv->material.SetFloatParameter("DustAmount", 4.0f);
-	oldtv->material.SetFloatParameter("FrameJitterFrequency", 3.0f);
-	oldtv->material.SetFloatParameter("MaxFrameJitter", 1.4f);
+	oldtv->material.SetFloatParameter(g_overExposureAmountParameterName, 0.1f);
+	oldtv->material.SetFloatParameter(g_dustAmountParameterName, 4.0f);
+	oldtv->material.SetFloatParameter(g_frameJitterFrequencyParameterName, 3.0f);
+	oldtv->material.SetFloatParameter(g_maxFrameJitterParameterName, 1.4f);
 	const Color filmColor(1.0f, 0.7559052f, 0.58474624f, 1.0f);
-	oldtv->material.SetFloatParameter("FilmColor", (const float*) &filmColor, 4);
-	oldtv->material.SetFloatParameter("GrainThicknes", 1.0f);
-	oldtv->material.SetFloatParameter("GrainAmount", 0.8f);
-	oldtv->material.SetFloatParameter("ScratchesAmount", 3.0f);
-	oldtv->material.SetFloatParameter("ScratchesLevel", 0.7f);
+	oldtv->material.SetFloatParameter(g_filmColorParameterName, (const float*) &filmColor, 4);
+	oldtv->material.SetFloatParameter(g_grainThicknesParameterName, 1.0f);
+	oldtv->material.SetFloatParameter(g_grainAmountParameterName, 0.8f);
+	oldtv->material.SetFloatParameter(g_scratchesAmountParameterName, 3.0f);
+	oldtv->material.SetFloatParameter(g_scratchesLevelParameterName, 0.7f);
 
 	Sampler dustSampler;
 	dustSampler.SetFiltering(true, true);
 	dustSampler.SetWrapMode(Sampler::WrapMode_ClampToBorder, Sampler::WrapMode_ClampToBorder, Color::White);
-	oldtv->material.SetTextureParameter("DustMap", oldtv->dustMap, dustSampler);
+	oldtv->material.SetTextureParameter(g_dustMapParameterName, oldtv->dustMap, dustSampler);
 
 	Sampler lineSampler;
 	lineSampler.SetFiltering(false, false);
 	lineSampler.SetWrapMode(Sampler::WrapMode_ClampToBorder, Sampler::WrapMode_Clamp, Color::White);
-	oldtv->material.SetTextureParameter("LineMap", oldtv->lineMap, lineSampler);
+	oldtv->material.SetTextureParameter(g_lineMapParameterName, oldtv->lineMap, lineSampler);
 
 	Sampler tvSampler;
 	tvSampler.SetFiltering(true, true);
 	tvSampler.SetWrapMode(Sampler::WrapMode_Clamp, Sampler::WrapMode_Clamp);
-	oldtv->material.SetTextureParameter("TvMap", oldtv->tvAndNoiseMap, tvSampler);
+	oldtv->material.SetTextureParameter(g_tvMapParameterName, oldtv->tvAndNoiseMap, tvSampler);
 
 	Sampler noiseSampler;
 	noiseSampler.SetFiltering(true, true);
 	noiseSampler.SetWrapMode(Sampler::WrapMode_Repeat, Sampler::WrapMode_Repeat);
-	oldtv->material.SetTextureParameter("NoiseMap", oldtv->tvAndNoiseMap, noiseSampler);
+	oldtv->material.SetTextureParameter(g_noiseMapParameterName, oldtv->tvAndNoiseMap, noiseSampler);
 
 	oldtv->material.DrawFullscreenQuad();
 
@@ -305,9 +341,9 @@ void Postprocessing_UpdateQuake(float deltaTime)
 void Postprocessing_DrawQuake(Texture& output, Texture& scene)
 {
 	output.BeginDrawing(&Color::Black);
-	quake->material.SetTechnique("quake");
-	quake->material.SetTextureParameter("ColorMap", scene);
-	quake->material.SetFloatParameter("Offset", (const float*) &quake->targetOffset, 2);
+	quake->material.SetTechnique(g_quakeTechniqueName);
+	quake->material.SetTextureParameter(g_colorMapParameterName, scene);
+	quake->material.SetFloatParameter(g_offsetParameterName, (const float*) &quake->targetOffset, 2);
 	quake->material.DrawFullscreenQuad();
 	output.EndDrawing();
 }
@@ -464,15 +500,15 @@ void Postprocessing_DrawRainyGlass(Texture& renderTarget, Texture& scene)
 	{
 		if (rain->rainEvaporation > 0.02f) // Apply rain evaporation
 		{
-			rain->material.SetTechnique("rain_evaporation");
+			rain->material.SetTechnique(g_rainEvaporationTechniqueName);
 			rain->rainEvaporation = 0;
 		}
 		else // Just copy previous buffer (skip evaporation step this time)
 		{
-			rain->material.SetTechnique("copy_texture");
+			rain->material.SetTechnique(g_copyTextureTechniqueName);
 		}
 
-		rain->material.SetTextureParameter("ColorMap", rain->dropletBuffer, Sampler::DefaultPostprocess);
+		rain->material.SetTextureParameter(g_colorMapParameterName, rain->dropletBuffer, Sampler::DefaultPostprocess);
 		rain->material.DrawFullscreenQuad();
 	}
 
@@ -537,9 +573,9 @@ void Postprocessing_DrawRainyGlass(Texture& renderTarget, Texture& scene)
 
 		Material& defaultMaterial = App::GetDefaultMaterial();
 
-		defaultMaterial.SetTechnique("tex_col");
-		defaultMaterial.SetFloatParameter("Color", (const float*) &Color::White, 4);
-		defaultMaterial.SetTextureParameter("ColorMap", rain->dropletTexture);
+		defaultMaterial.SetTechnique(g_texColTechniqueName);
+		defaultMaterial.SetFloatParameter(g_colorParameterName, (const float*) &Color::White, 4);
+		defaultMaterial.SetTextureParameter(g_colorMapParameterName, rain->dropletTexture);
 		defaultMaterial.Draw(&drawParams);
 	}
 
@@ -559,10 +595,10 @@ void Postprocessing_DrawRainyGlass(Texture& renderTarget, Texture& scene)
 	colorSampler.minFilterLinear = true;
 	colorSampler.magFilterLinear = true;
 
-	rain->material.SetTechnique("rain_distortion");
-	rain->material.SetFloatParameter("DropletColor", (const float*) &rain->dropletColor, 4);
-	rain->material.SetTextureParameter("ColorMap", scene, colorSampler);
-	rain->material.SetTextureParameter("NormalMap", rain->dropletBuffer);
+	rain->material.SetTechnique(g_rainDistortionTechniqueName);
+	rain->material.SetFloatParameter(g_dropletColorParameterName, (const float*) &rain->dropletColor, 4);
+	rain->material.SetTextureParameter(g_colorMapParameterName, scene, colorSampler);
+	rain->material.SetTextureParameter(g_normalMapParameterName, rain->dropletBuffer);
 	rain->material.DrawFullscreenQuad();
 
 	renderTarget.EndDrawing();
@@ -1324,14 +1324,18 @@ namespace rapidxml
         //! Constructs empty XMLDocObj document
         xml_document()
             : xml_node<Ch>(node_document),
-			m_user_data(NULL)
+			m_user_data(NULL),
+			m_file_view(NULL)
         {
         }
 
 		void set_user_data(void* data) { m_user_data = data; }
 		void* get_user_data() { return m_user_data; }
+		void set_file_view(void* view) { m_file_view = view; }
+		void* get_file_view() { return m_file_view; }
 	private:
 		void* m_user_data;
+		void* m_file_view;
 	public:
 
         //! Parses zero-terminated XMLDocObj string according to given flags.
@@ -2583,6 +2587,8 @@ void XMLDoc_Destroy(XMLDocObj* _doc)
 {
 	xml_document<>* doc = (xml_document<>*) _doc;
 	free(doc->get_user_data());
+	if (FileViewObj* view = (FileViewObj*) doc->get_file_view())
+		File_Unmap(view);
 	delete doc;
 }
 
@@ -2680,7 +2686,7 @@ bool XMLDoc_Save(XMLDocObj* _doc, const std::string& path)
 	xml_document<>* doc = (xml_document<>*) _doc;
 	std::string output;
 	XMLNode_ToString(doc->first_node(), output, 0);
-	return file.Write(output.c_str(), output.length() + 1) == 1;
+	return file.Write(output.c_str(), output.length() + 1) && file.Flush();
 }
 
 XMLDocObj* XMLDoc_LoadFromString(char* text)
@@ -2703,15 +2709,45 @@ XMLDocObj* XMLDoc_LoadFromString(char* text)
 
 XMLDocObj* XMLDoc_Load(const std::string& path)
 {
-	int size = 0;
-	void* data = NULL;
-	if (!File_Load(path, data, size))
+	// Source is only mapped to verify cooked document is up to date; copied for in place parsing otherwise
+
+	FileViewObj* view = File_Map(path);
+	if (XMLDocObj* doc = XMLDoc_LoadCooked(path, view ? view->data : NULL, view ? view->size : 0))
+	{
+		if (view)
+			File_Unmap(view);
+		return doc;
+	}
+
+	if (!view)
+	{
+		Log::Error(string_format("Failed to load XML file %s", path.c_str()));
+		return NULL;
+	}
+
+	char* text = (char*) malloc(view->size + 1);
+	memcpy(text, view->data, view->size);
+	text[view->size] = '\0';
+	File_Unmap(view);
+
+	return XMLDoc_LoadFromString(text);
+}
+
+XMLDocObj* XMLDoc_LoadFromFileData(const std::string& path, char* text, size_t size)
+{
+	if (XMLDocObj* doc = XMLDoc_LoadCooked(path, text, size))
+	{
+		free(text);
+		return doc;
+	}
+
+	if (!text)
 	{
 		Log::Error(string_format("Failed to load XML file %s", path.c_str()));
 		return NULL;
 	}
 
-	return XMLDoc_LoadFromString((char*) data);
+	return XMLDoc_LoadFromString(text);
 }
 
 XMLNode* XMLDoc_AsNode(XMLDocObj* doc)
@@ -2843,6 +2879,198 @@ XMLAttribute* XMLNode_AddAttributeFloat(XMLNode* node, const char* name, float v
 	return XMLNode_AddAttribute(node, name, string_from_float(value).c_str());
 }
 
+// Cooked XML
+
+struct XMLCookedReader
+{
+	xml_document<>* doc;
+	const XMLCookedHeader* header;
+	const XMLCookedNode* nodes;
+	const XMLCookedAttribute* attributes;
+	const char* strings;
+	unsigned int nodeIndex;
+	unsigned int attributeIndex;
+};
+
+bool XMLCookedReader_IsValidString(XMLCookedReader* reader, unsigned int offset, unsigned int size)
+{
+	return offset < reader->header->stringsSize && size < reader->header->stringsSize - offset && reader->strings[offset + size] == '\0';
+}
+
+bool XMLCookedReader_ReadChildren(XMLCookedReader* reader, xml_node<>* parent, unsigned int numChildren)
+{
+	for (unsigned int i = 0; i < numChildren; i++)
+	{
+		if (reader->nodeIndex >= reader->header->numNodes)
+			return false;
+		const XMLCookedNode& cookedNode = reader->nodes[reader->nodeIndex++];
+		if (cookedNode.type == node_document || cookedNode.type > node_pi ||
+			!XMLCookedReader_IsValidString(reader, cookedNode.nameOffset, cookedNode.nameSize) ||
+			!XMLCookedReader_IsValidString(reader, cookedNode.valueOffset, cookedNode.valueSize) ||
+			cookedNode.numAttributes > reader->header->numAttributes - reader->attributeIndex)
+			return false;
+
+		// Names and values point straight into cooked data
+
+		xml_node<>* node = reader->doc->allocate_node((node_type) cookedNode.type,
+			reader->strings + cookedNode.nameOffset, reader->strings + cookedNode.valueOffset,
+			(int) cookedNode.nameSize, (int) cookedNode.valueSize);
+		parent->append_node(node);
+
+		for (unsigned int j = 0; j < cookedNode.numAttributes; j++)
+		{
+			const XMLCookedAttribute& cookedAttr = reader->attributes[reader->attributeIndex++];
+			if (!XMLCookedReader_IsValidString(reader, cookedAttr.nameOffset, cookedAttr.nameSize) ||
+				!XMLCookedReader_IsValidString(reader, cookedAttr.valueOffset, cookedAttr.valueSize))
+				return false;
+			node->append_attribute(reader->doc->allocate_attribute(
+				reader->strings + cookedAttr.nameOffset, reader->strings + cookedAttr.valueOffset,
+				(int) cookedAttr.nameSize, (int) cookedAttr.valueSize));
+		}
+
+		if (!XMLCookedReader_ReadChildren(reader, node, cookedNode.numChildren))
+			return false;
+	}
+	return true;
+}
+
+XMLDocObj* XMLDoc_LoadCooked(const std::string& path, const void* source, size_t sourceSize)
+{
+	const std::string cookedPath = path + XML_COOKED_SUFFIX;
+	FileViewObj* view = File_Map(cookedPath);
+	if (!view)
+		return NULL;
+
+	// Validate header
+
+	const XMLCookedHeader* header = (const XMLCookedHeader*) view->data;
+	if (view->size < sizeof(XMLCookedHeader) || header->magic != XML_COOKED_MAGIC || header->version != XML_COOKED_VERSION)
+	{
+		Log::Warn(string_format("Ignoring cooked XML file %s, reason: unsupported format or version (expected %d)", cookedPath.c_str(), XML_COOKED_VERSION));
+		File_Unmap(view);
+		return NULL;
+	}
+
+	if (source && (header->sourceSize != sourceSize || header->sourceHash != hash_fnv1a64(source, sourceSize)))
+	{
+		Log::Info(string_format("Ignoring cooked XML file %s, reason: out of date with its source", cookedPath.c_str()));
+		File_Unmap(view);
+		return NULL;
+	}
+
+	const unsigned long long expectedSize = sizeof(XMLCookedHeader) +
+		(unsigned long long) header->numNodes * sizeof(XMLCookedNode) +
+		(unsigned long long) header->numAttributes * sizeof(XMLCookedAttribute) +
+		header->stringsSize;
+	if (view->size < expectedSize || !header->numNodes || !header->stringsSize)
+	{
+		Log::Error(string_format("Failed to load cooked XML file %s, reason: file is truncated", cookedPath.c_str()));
+		File_Unmap(view);
+		return NULL;
+	}
+
+	// Build document; the view is kept mapped for the lifetime of the document
+
+	xml_document<>* doc = new xml_document<>();
+	doc->set_file_view(view);
+
+	XMLCookedReader reader;
+	reader.doc = doc;
+	reader.header = header;
+	reader.nodes = (const XMLCookedNode*) (header + 1);
+	reader.attributes = (const XMLCookedAttribute*) (reader.nodes + header->numNodes);
+	reader.strings = (const char*) (reader.attributes + header->numAttributes);
+	reader.nodeIndex = 1; // Skip document node
+	reader.attributeIndex = 0;
+
+	if (reader.nodes[0].type != node_document ||
+		!XMLCookedReader_ReadChildren(&reader, doc, reader.nodes[0].numChildren) ||
+		reader.nodeIndex != header->numNodes ||
+		reader.attributeIndex != header->numAttributes)
+	{
+		Log::Error(string_format("Failed to load cooked XML file %s, reason: file is corrupted", cookedPath.c_str()));
+		XMLDoc_Destroy((XMLDocObj*) doc);
+		return NULL;
+	}
+
+	return (XMLDocObj*) doc;
+}
+
+unsigned int XMLCookedWriter_AddString(std::string& strings, std::map<std::string, unsigned int>& offsets, const char* s, size_t size)
+{
+	const std::string value(s, size);
+	std::map<std::string, unsigned int>::iterator it = offsets.find(value);
+	if (it != offsets.end())
+		return it->second;
+
+	const unsigned int offset = (unsigned int) strings.length();
+	strings.append(value.c_str(), value.length() + 1);
+	offsets[value] = offset;
+	return offset;
+}
+
+void XMLCookedWriter_AddNode(xml_node<>* node, std::vector<XMLCookedNode>& nodes, std::vector<XMLCookedAttribute>& attributes, std::string& strings, std::map<std::string, unsigned int>& offsets)
+{
+	XMLCookedNode cookedNode;
+	cookedNode.type = (unsigned int) node->type();
+	cookedNode.nameSize = (unsigned int) node->name_size();
+	cookedNode.nameOffset = XMLCookedWriter_AddString(strings, offsets, node->name(), node->name_size());
+	cookedNode.valueSize = (unsigned int) node->value_size();
+	cookedNode.valueOffset = XMLCookedWriter_AddString(strings, offsets, node->value(), node->value_size());
+	cookedNode.numAttributes = 0;
+	cookedNode.numChildren = 0;
+
+	for (xml_attribute<>* attr = node->first_attribute(); attr; attr = attr->next_attribute())
+	{
+		XMLCookedAttribute cookedAttr;
+		cookedAttr.nameSize = (unsigned int) attr->name_size();
+		cookedAttr.nameOffset = XMLCookedWriter_AddString(strings, offsets, attr->name(), attr->name_size());
+		cookedAttr.valueSize = (unsigned int) attr->value_size();
+		cookedAttr.valueOffset = XMLCookedWriter_AddString(strings, offsets, attr->value(), attr->value_size());
+		attributes.push_back(cookedAttr);
+		cookedNode.numAttributes++;
+	}
+
+	const size_t nodeIndex = nodes.size();
+	nodes.push_back(cookedNode);
+
+	for (xml_node<>* child = node->first_node(); child; child = child->next_sibling())
+	{
+		XMLCookedWriter_AddNode(child, nodes, attributes, strings, offsets);
+		nodes[nodeIndex].numChildren++;
+	}
+}
+
+void XMLDoc_Cook(XMLDocObj* doc, const void* source, size_t sourceSize, std::vector<unsigned char>& cooked)
+{
+	std::vector<XMLCookedNode> nodes;
+	std::vector<XMLCookedAttribute> attributes;
+	std::string strings;
+	std::map<std::string, unsigned int> offsets;
+	XMLCookedWriter_AddNode((xml_document<>*) doc, nodes, attributes, strings, offsets);
+
+	XMLCookedHeader header;
+	header.magic = XML_COOKED_MAGIC;
+	header.version = XML_COOKED_VERSION;
+	header.sourceHash = hash_fnv1a64(source, sourceSize);
+	header.sourceSize = sourceSize;
+	header.numNodes = (unsigned int) nodes.size();
+	header.numAttributes = (unsigned int) attributes.size();
+	header.stringsSize = (unsigned int) strings.length();
+	header.reserved = 0;
+
+	cooked.resize(sizeof(header) + nodes.size() * sizeof(XMLCookedNode) + attributes.size() * sizeof(XMLCookedAttribute) + strings.length());
+	unsigned char* dst = &cooked[0];
+	memcpy(dst, &header, sizeof(header));
+	dst += sizeof(header);
+	memcpy(dst, &nodes[0], nodes.size() * sizeof(XMLCookedNode));
+	dst += nodes.size() * sizeof(XMLCookedNode);
+	if (!attributes.empty())
+		memcpy(dst, &attributes[0], attributes.size() * sizeof(XMLCookedAttribute));
+	dst += attributes.size() * sizeof(XMLCookedAttribute);
+	memcpy(dst, strings.c_str(), strings.length());
+}
+
 // Default value readers
 
 const char* XMLNode_GetAttributeValue(XMLNode* node, const char* name, const char* defaultValue)
@@ -32,7 +32,7 @@ bool SpriteResource_CheckCreated(SpriteResource* resource)
 			return false;
 		}
 	}
-	else for (std::map<std::string, SpriteResource::Animation>::iterator it = resource->animations.begin(); it != resource->animations.end(); ++it)
+	else for (std::map<StringId, SpriteResource::Animation>::iterator it = resource->animations.begin(); it != resource->animations.end(); ++it)
 		for (std::vector<SpriteResource::Frame>::iterator it2 = it->second.frames.begin(); it2 != it->second.frames.end(); ++it2)
 		{
 			const Resource* texture = (const Resource*) Texture_Get(it2->texture);
@@ -67,7 +67,7 @@ bool SpriteResource_CheckCreated(SpriteResource* resource)
 		const float atlasWidth = (float) resource->atlas.GetWidth();
 		const float atlasHeight = (float) resource->atlas.GetHeight();
 
-		for (std::map<std::string, SpriteResource::Animation>::iterator it = resource->animations.begin(); it != resource->animations.end(); ++it)
+		for (std::map<StringId, SpriteResource::Animation>::iterator it = resource->animations.begin(); it != resource->animations.end(); ++it)
 			for (std::vector<SpriteResource::Frame>::iterator it2 = it->second.frames.begin(); it2 != it->second.frames.end(); ++it2)
 			{
 				Rect& rect = it2->rectangle;
@@ -90,19 +90,29 @@ SpriteObj* Sprite_Clone(SpriteObj* other)
 	return sprite;
 }
 
-typedef std::map<std::string, Rect> AtlasInfo;
+ResourceState Sprite_GetState(SpriteObj* sprite)
+{
+	SpriteResource_CheckCreated(sprite->resource);
+	return sprite->resource->state;
+}
 
-bool Sprite_LoadAtlasInfo(const std::string& atlasName, AtlasInfo& atlasInfo)
+std::string Sprite_GetAtlasInfoPath(const std::string& atlasName)
 {
 	const size_t dotIndex = atlasName.find_last_of('.');
 	if (dotIndex == std::string::npos)
+		return std::string();
+	return atlasName.substr(0, dotIndex) + ".xml";
+}
+
+bool Sprite_LoadAtlasInfo(const std::string& atlasName, SpriteAtlasInfo& atlasInfo)
+{
+	const std::string path = Sprite_GetAtlasInfoPath(atlasName);
+	if (path.empty())
 	{
 		Log::Error("Sprite atlas " + atlasName + " has invalid extension");
 		return false;
 	}
 
-	const std::string path = atlasName.substr(0, dotIndex) + ".xml";
-
 	XMLDoc doc;
 	if (!doc.Load(path))
 	{
@@ -165,191 +175,274 @@ std::string ExtractFileName(const std::string& path)
 	return path.substr(slashIndex, dotIndex - slashIndex);
 }
 
-SpriteObj* Sprite_Create(const std::string& name, bool immediate)
+SpriteObj* Sprite_CreateFromResource(SpriteResource* resource)
 {
-	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	SpriteObj* sprite = new SpriteObj();
+	sprite->resource = resource;
 
-	SpriteResource* resource = static_cast<SpriteResource*>(Resource_Find("sprite", name));
-	if (resource)
-		Resource_IncRefCount(resource);
+	Sprite_PlayAnimation(sprite);
 
-	// Create sprite from XML
+	return sprite;
+}
 
-	else if (!strstr(name.c_str(), "."))
+SpriteResource* SpriteResource_Load(const std::string& name, XMLDocObj* doc, const SpriteAtlasInfo* preloadedAtlasInfo, bool immediate)
+{
+	const std::string path = name + ".sprite.xml";
+
+	XMLNode* spriteNode = XMLNode_GetFirstNode(XMLDoc_AsNode(doc), "sprite");
+	if (!spriteNode)
 	{
-		const std::string path = name + ".sprite.xml";
+		Log::Error("Failed to load sprite resource from " + path + ", reason: root node 'sprite' not found.");
+		return NULL;
+	}
+
+	MaterialObj* material = NULL;
 
-		XMLDoc doc;
-		if (!doc.Load(path))
+	if (const char* materialName = XMLNode_GetAttributeValue(spriteNode, "material"))
+	{
+		material = Material_Create(materialName, immediate);
+		if (!material)
 		{
-			Log::Error("Failed to load sprite resource from " + path);
+			Log::Error("Failed to load sprite resource from " + path + ", reason: can't load material " + materialName);
 			return NULL;
 		}
+	}
 
-		XMLNode* spriteNode = doc.AsNode()->GetFirstNode("sprite");
-		if (!spriteNode)
+	SpriteResource* resource = new SpriteResource();
+	resource->state = ResourceState_Creating;
+	resource->name = name;
+	Material_SetHandle(material, resource->material);
+
+	HotReload_AddFile("sprite", name, path);
+
+	// Load (optionally) texture atlas
+
+	SpriteAtlasInfo loadedAtlasInfo;
+	const SpriteAtlasInfo& atlasInfo = preloadedAtlasInfo ? *preloadedAtlasInfo : loadedAtlasInfo;
+	const char* atlasName = XMLNode_GetAttributeValue(spriteNode, "atlas");
+	if (atlasName)
+	{
+		resource->atlas.Create(atlasName, immediate);
+		if (!Texture_Get(resource->atlas))
 		{
-			Log::Error("Failed to load sprite resource from " + path + ", reason: root node 'sprite' not found.");
+			delete resource;
+			Log::Error("Failed to load sprite resource from " + path + ", reason: can't load texture atlas " + atlasName);
 			return NULL;
 		}
-
-		MaterialObj* material = NULL;
-
-		if (const char* materialName = XMLNode_GetAttributeValue(spriteNode, "material"))
+		if (!preloadedAtlasInfo && !Sprite_LoadAtlasInfo(atlasName, loadedAtlasInfo))
 		{
-			material = Material_Create(materialName, immediate);
-			if (!material)
-			{
-				Log::Error("Failed to load sprite resource from " + path + ", reason: can't load material " + materialName);
-				return NULL;
-			}
+			delete resource;
+			Log::Error("Failed to load sprite resource from " + path + ", reason: can't load texture atlas info " + atlasName);
+			return NULL;
 		}
+		resource->hasAtlas = true;
+
+		HotReload_AddFile("sprite", name, atlasName);
+		HotReload_AddFile("sprite", name, Sprite_GetAtlasInfoPath(atlasName));
+	}
+
+	// Load animations
+
+	std::string defaultAnimationName;
+
+	for (XMLNode* animNode = XMLNode_GetFirstNode(spriteNode, "animation"); animNode; animNode = XMLNode_GetNext(animNode, "animation"))
+	{
+		const std::string animName = XMLNode_GetAttributeValue(animNode, "name");
+		SpriteResource::Animation& anim = map_add(resource->animations, StringId(animName));
+		anim.name = animName;
+
+		// Get frame time
+
+		XMLNode_GetAttributeValueFloat(animNode, "frameTime", anim.frameTime, 0.1f);
+
+		// Check blend mode
+
+		//XMLNode_GetAttributeValueBool(animNode, "blending", anim->blendFrames);
 
-		resource = new SpriteResource();
-		resource->state = ResourceState_Creating;
-		resource->name = name;
-		Material_SetHandle(material, resource->material);
-		Resource_IncRefCount(resource);
+		// Check if default
 
-		// Load (optionally) texture atlas
+		bool isDefault;
+		if (defaultAnimationName.empty() || (XMLNode_GetAttributeValueBool(animNode, "isDefault", isDefault) && isDefault))
+			defaultAnimationName = anim.name;
 
-		AtlasInfo atlasInfo;
-		const char* atlasName = XMLNode_GetAttributeValue(spriteNode, "atlas");
-		if (atlasName)
+		// Load all frames and events
+
+		float time = 0.0f;
+		for (XMLNode* elemNode = XMLNode_GetFirstNode(animNode); elemNode; elemNode = XMLNode_GetNext(elemNode))
 		{
-			resource->atlas.Create(atlasName, immediate);
-			if (!Texture_Get(resource->atlas))
+			const char* elemName = XMLNode_GetName(elemNode);
+
+			if (!strcmp(elemName, "frame"))
 			{
-				delete resource;
-				Log::Error("Failed to load sprite resource from " + path + ", reason: can't load texture atlas " + atlasName);
-				return NULL;
+				SpriteResource::Frame& frame = vector_add(anim.frames);
+				const char* textureName = XMLNode_GetAttributeValue(elemNode, "texture");
+				if (resource->hasAtlas)
+				{
+					const std::string fileName = ExtractFileName(textureName);
+					SpriteAtlasInfo::const_iterator rect = atlasInfo.find(fileName);
+					if (rect == atlasInfo.end())
+					{
+						Log::Error("Failed to load sprite resource from " + path + ", reason: failed to find texture " + textureName + " in texture atlas " + atlasName);
+						delete resource;
+						return NULL;
+					}
+					frame.rectangle = rect->second;
+				}
+				else
+				{
+					frame.texture.Create(textureName, immediate);
+					if (!Texture_Get(frame.texture))
+					{
+						Log::Error("Failed to load sprite resource from " + path + ", reason: failed to load texture " + textureName);
+						delete resource;
+						return NULL;
+					}
+					HotReload_AddFile("sprite", name, textureName);
+				}
+
+				time += anim.frameTime;
 			}
-			if (!Sprite_LoadAtlasInfo(atlasName, atlasInfo))
+			else if (!strcmp(elemName, "event"))
 			{
-				delete resource;
-				Log::Error("Failed to load sprite resource from " + path + ", reason: can't load texture atlas info " + atlasName);
-				return NULL;
+				SpriteResource::Event& ev = vector_add(anim.events);
+				ev.time = time;
+				ev.name = XMLNode_GetAttributeValue(elemNode, "name");
 			}
-			resource->hasAtlas = true;
 		}
 
-		// Load animations
+		anim.totalTime = (float) anim.frames.size() * anim.frameTime;
+	}
 
-		std::string defaultAnimationName;
+	resource->defaultAnimation = &resource->animations[StringId(defaultAnimationName)];
 
-		for (XMLNode* animNode = XMLNode_GetFirstNode(spriteNode, "animation"); animNode; animNode = XMLNode_GetNext(animNode, "animation"))
-		{
-			const std::string name = XMLNode_GetAttributeValue(animNode, "name");
-			SpriteResource::Animation& anim = map_add(resource->animations, name);
-			anim.name = name;
+	SpriteResource_CheckCreated(resource);
+	return resource;
+}
 
-			// Get frame time
+SpriteResource* SpriteResource_CreateFromTexture(const std::string& name, bool immediate)
+{
+	TextureObj* texture = Texture_Create(name, immediate);
+	if (!texture)
+	{
+		Log::Error("Failed to create sprite resource from texture " + name);
+		return NULL;
+	}
 
-			XMLNode_GetAttributeValueFloat(animNode, "frameTime", anim.frameTime, 0.1f);
+	SpriteResource* resource = new SpriteResource();
+	resource->state = ResourceState_Creating;
+	resource->name = name;
 
-			// Check blend mode
+	// Add simple animation with one animation frame
 
-			//XMLNode_GetAttributeValueBool(animNode, "blending", anim->blendFrames);
+	SpriteResource::Animation& animation = map_add(resource->animations, StringId(resource->name));
+	animation.frameTime = 1.0f;
+	animation.totalTime = 1.0f;
+	SpriteResource::Frame& frame = vector_add(animation.frames);
+	Texture_SetHandle(texture, frame.texture);
 
-			// Check if default
+	resource->defaultAnimation = &animation;
+	SpriteResource_CheckCreated(resource);
 
-			bool isDefault;
-			if (defaultAnimationName.empty() || (XMLNode_GetAttributeValueBool(animNode, "isDefault", isDefault) && isDefault))
-				defaultAnimationName = anim.name;
+	Texture_Destroy(texture);
 
-			// Load all frames and events
+	HotReload_AddFile("sprite", name, name);
+	return resource;
+}
 
-			float time = 0.0f;
-			for (XMLNode* elemNode = XMLNode_GetFirstNode(animNode); elemNode; elemNode = XMLNode_GetNext(elemNode))
-			{
-				const char* elemName = XMLNode_GetName(elemNode);
+void Sprite_GetDependencies(XMLDocObj* doc, std::vector<LoadGroupDependency>& dependencies)
+{
+	XMLNode* spriteNode = XMLNode_GetFirstNode(XMLDoc_AsNode(doc), "sprite");
+	if (!spriteNode)
+		return;
 
-				if (!strcmp(elemName, "frame"))
-				{
-					SpriteResource::Frame& frame = vector_add(anim.frames);
-					const char* textureName = XMLNode_GetAttributeValue(elemNode, "texture");
-					if (resource->hasAtlas)
-					{
-						const std::string fileName = ExtractFileName(textureName);
-						Rect* rect = map_find(atlasInfo, fileName);
-						if (!rect)
-						{
-							Log::Error("Failed to load sprite resource from " + path + ", reason: failed to find texture " + textureName + " in texture atlas " + atlasName);
-							delete resource;
-							return NULL;
-						}
-						frame.rectangle = *rect;
-					}
-					else
-					{
-						frame.texture.Create(textureName, immediate);
-						if (frame.texture.GetState() != ResourceState_Created)
-						{
-							Log::Error("Failed to load sprite resource from " + path + ", reason: failed to load texture " + textureName);
-							delete resource;
-							return NULL;
-						}
-					}
+	if (const char* materialName = XMLNode_GetAttributeValue(spriteNode, "material"))
+	{
+		LoadGroupDependency& dependency = vector_add(dependencies);
+		dependency.type = LoadGroupItemType_Material;
+		dependency.name = materialName;
+	}
 
-					time += anim.frameTime;
-				}
-				else if (!strcmp(elemName, "event"))
-				{
-					SpriteResource::Event& ev = vector_add(anim.events);
-					ev.time = time;
-					ev.name = XMLNode_GetAttributeValue(elemNode, "name");
-				}
+	// Either single texture atlas or one texture per frame
+
+	if (const char* atlasName = XMLNode_GetAttributeValue(spriteNode, "atlas"))
+	{
+		LoadGroupDependency& dependency = vector_add(dependencies);
+		dependency.type = LoadGroupItemType_Texture;
+		dependency.name = atlasName;
+		return;
+	}
+
+	for (XMLNode* animNode = XMLNode_GetFirstNode(spriteNode, "animation"); animNode; animNode = XMLNode_GetNext(animNode, "animation"))
+		for (XMLNode* frameNode = XMLNode_GetFirstNode(animNode, "frame"); frameNode; frameNode = XMLNode_GetNext(frameNode, "frame"))
+			if (const char* textureName = XMLNode_GetAttributeValue(frameNode, "texture"))
+			{
+				LoadGroupDependency& dependency = vector_add(dependencies);
+				dependency.type = LoadGroupItemType_Texture;
+				dependency.name = textureName;
 			}
+}
 
-			anim.totalTime = (float) anim.frames.size() * anim.frameTime;
-		}
+// Registers loaded sprite resource unless the same sprite got registered concurrently (e.g. by another loading job)
+SpriteResource* SpriteResource_Register(SpriteResource* resource)
+{
+	SpriteResource* registered = static_cast<SpriteResource*>(Resource_FindOrRegister(resource));
+	if (registered != resource)
+		delete resource;
+	return registered;
+}
 
-		resource->defaultAnimation = &resource->animations[defaultAnimationName];
+SpriteObj* Sprite_CreateFromDoc(const std::string& name, XMLDocObj* doc, const SpriteAtlasInfo* atlasInfo, bool immediate)
+{
+	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	LoadGroup_OnResourceRequested(LoadGroupItemType_Sprite, name);
 
-		SpriteResource_CheckCreated(resource);
+	SpriteResource* resource = static_cast<SpriteResource*>(Resource_FindAndIncRefCount("sprite", name));
+	if (!resource)
+	{
+		if (!(resource = SpriteResource_Load(name, doc, atlasInfo, immediate)))
+			return NULL;
+		resource = SpriteResource_Register(resource);
 	}
+	return Sprite_CreateFromResource(resource);
+}
 
-	// Create sprite from texture
+SpriteObj* Sprite_Create(const std::string& name, bool immediate)
+{
+	immediate = immediate || !g_supportAsynchronousResourceLoading;
+	LoadGroup_OnResourceRequested(LoadGroupItemType_Sprite, name);
 
-	else
+	SpriteResource* resource = static_cast<SpriteResource*>(Resource_FindAndIncRefCount("sprite", name));
+
+	// Create sprite from XML
+
+	if (!resource && !strstr(name.c_str(), "."))
 	{
-		TextureObj* texture = Texture_Create(name, immediate);
-		if (!texture)
+		const std::string path = name + ".sprite.xml";
+
+		XMLDocObj* doc = XMLDoc_Load(path);
+		if (!doc)
 		{
-			Log::Error("Failed to create sprite resource from texture " + name);
+			Log::Error("Failed to load sprite resource from " + path);
 			return NULL;
 		}
 
-		resource = new SpriteResource();
-		resource->state = ResourceState_Creating;
-		resource->name = name;
-		Resource_IncRefCount(resource);
-
-		// Add simple animation with one animation frame
-
-		SpriteResource::Animation& animation = map_add(resource->animations, resource->name);
-		animation.frameTime = 1.0f;
-		animation.totalTime = 1.0f;
-		SpriteResource::Frame& frame = vector_add(animation.frames);
-		Texture_SetHandle(texture, frame.texture);
+		resource = SpriteResource_Load(name, doc, NULL, immediate);
+		XMLDoc_Destroy(doc);
+		if (resource)
+			resource = SpriteResource_Register(resource);
+	}
 
-		resource->defaultAnimation = &animation;
-		SpriteResource_CheckCreated(resource);
+	// Create sprite from texture
 
-		Texture_Destroy(texture);
-	}
+	else if (!resource && (resource = SpriteResource_CreateFromTexture(name, immediate)))
+		resource = SpriteResource_Register(resource);
 
 	if (!resource)
 		return NULL;
 
 	// Create sprite
 
-	SpriteObj* sprite = new SpriteObj();
-	sprite->resource = resource;
-
-	Sprite_PlayAnimation(sprite);
-
-	return sprite;
+	return Sprite_CreateFromResource(resource);
 }
 
 void Sprite_Destroy(SpriteObj* sprite)
@@ -359,6 +452,109 @@ void Sprite_Destroy(SpriteObj* sprite)
 	delete sprite;
 }
 
+// Hot reload
+
+struct SpriteReload
+{
+	std::string name;
+	XMLDocObj* doc;
+	SpriteAtlasInfo atlasInfo;
+	bool hasAtlasInfo;
+	Jobs::JobID jobID;
+	SpriteResource* shadow; // New version of the sprite resource; not registered
+
+	SpriteReload() :
+		doc(NULL),
+		hasAtlasInfo(false),
+		jobID(0),
+		shadow(NULL)
+	{}
+};
+
+void SpriteReload_ReadFunc(void*& data, size_t, void* userData)
+{
+	SpriteReload* reload = (SpriteReload*) userData;
+	if (!data)
+		return;
+
+	// Parse sprite and its atlas info on job thread; document takes ownership of the data
+
+	reload->doc = XMLDoc_LoadFromString((char*) data);
+	data = NULL;
+	if (!reload->doc)
+		return;
+
+	XMLNode* spriteNode = XMLNode_GetFirstNode(XMLDoc_AsNode(reload->doc), "sprite");
+	if (const char* atlasName = spriteNode ? XMLNode_GetAttributeValue(spriteNode, "atlas") : NULL)
+		reload->hasAtlasInfo = Sprite_LoadAtlasInfo(atlasName, reload->atlasInfo);
+}
+
+void SpriteReload_DoneFunc(bool canceled, void* userData)
+{
+	SpriteReload* reload = (SpriteReload*) userData;
+	reload->jobID = 0;
+
+	if (!reload->doc)
+		return;
+	if (!canceled)
+		reload->shadow = SpriteResource_Load(reload->name, reload->doc, reload->hasAtlasInfo ? &reload->atlasInfo : NULL, false);
+	XMLDoc_Destroy(reload->doc);
+	reload->doc = NULL;
+}
+
+void* Sprite_BeginReload(Resource* resource)
+{
+	SpriteReload* reload = new SpriteReload();
+	reload->name = resource->name;
+
+	// Sprites created from textures only need to refresh their size
+
+	if (strstr(reload->name.c_str(), "."))
+		reload->shadow = SpriteResource_CreateFromTexture(reload->name, false);
+	else
+		reload->jobID = File_ReadAsync(reload->name + ".sprite.xml", NULL, 0, 0, SpriteReload_ReadFunc, SpriteReload_DoneFunc, reload);
+	return reload;
+}
+
+bool Sprite_UpdateReload(void* context, Resource* resource)
+{
+	SpriteReload* reload = (SpriteReload*) context;
+	if (reload->jobID)
+		return false;
+
+	SpriteResource* shadow = reload->shadow;
+	if (shadow && !SpriteResource_CheckCreated(shadow) && shadow->state == ResourceState_Creating)
+		return false;
+
+	// Replace animations in place, so that animation instances of existing sprites stay valid; animations removed from the sprite are kept
+
+	SpriteResource* sprite = static_cast<SpriteResource*>(resource);
+	if (sprite && shadow && shadow->state == ResourceState_Created)
+	{
+		for (std::map<StringId, SpriteResource::Animation>::iterator it = shadow->animations.begin(); it != shadow->animations.end(); ++it)
+		{
+			sprite->animations[it->first] = it->second;
+			if (shadow->defaultAnimation == &it->second)
+				sprite->defaultAnimation = &sprite->animations[it->first];
+		}
+
+		sprite->hasAtlas = shadow->hasAtlas;
+		sprite->atlas = shadow->atlas;
+		sprite->width = shadow->width;
+		sprite->height = shadow->height;
+
+		sprite->material.Destroy();
+		Material_SetHandle(Material_Get(shadow->material), sprite->material);
+		Material_SetHandle(NULL, shadow->material);
+	}
+	else if (sprite)
+		Log::Error(string_format("Failed to reload sprite %s; keeping previous version", sprite->name.c_str()));
+
+	delete shadow;
+	delete reload;
+	return true;
+}
+
 void Sprite_SetEventCallback(SpriteObj* sprite, Sprite::EventCallback callback, void* userData)
 {
 	sprite->callback = callback;
@@ -449,16 +645,16 @@ void Sprite_Update(SpriteObj* sprite, float dt)
 		Sprite_PlayAnimation(sprite);
 }
 
-void Sprite_PlayAnimation(SpriteObj* sprite, const std::string& name, Sprite::AnimationMode mode, float transitionTime)
+void Sprite_PlayAnimation(SpriteObj* sprite, StringId name, Sprite::AnimationMode mode, float transitionTime)
 {
 	// Get animation
 
 	SpriteResource::Animation* animation = NULL;
-	if (name == std::string())
+	if (name.IsEmpty())
 		animation = sprite->resource->defaultAnimation;
 	else
 	{
-		std::map<std::string, SpriteResource::Animation>::iterator it = sprite->resource->animations.find(name);
+		std::map<StringId, SpriteResource::Animation>::iterator it = sprite->resource->animations.find(name);
 		if (it == sprite->resource->animations.end())
 		{
 			Log::Error(string_format("Animation %s not found in sprite %s", name.c_str(), sprite->resource->name.c_str()));
@@ -0,0 +1,128 @@
+// Tiny2D asynchronous read test
+//
+// Headless regression test of File::ReadAsync error paths: reading a missing file, reading past the end of file and a short read of a file
+// truncated after it was opened. Checks that the read function gets NULL data on failure and that every read is completed; built with leak
+// sanitizer, so buffers of failed reads that don't get freed make the test fail too.
+//
+// Usage:
+//   make test
+//
+// Returns non-zero on any failure. Requires the engine library to be built first (make in the root directory).
+
+#include "Tiny2D.h"
+#include "Tiny2D_Common.h"
+
+namespace Tiny2D
+{
+	void Jobs_Init();
+	void Jobs_Deinit();
+	void AsyncReads_Init();
+	void AsyncReads_Deinit();
+};
+
+using namespace Tiny2D;
+
+#define TEST_FILE_NAME "Tiny2D_AsyncReadTest.tmp"
+#define TEST_FILE_SIZE 4096
+
+struct ReadResult
+{
+	bool isRead;
+	bool isDone;
+	bool gotData;
+	size_t size;
+
+	ReadResult() :
+		isRead(false),
+		isDone(false),
+		gotData(false),
+		size(0)
+	{}
+};
+
+void Test_ReadFunc(void*& data, size_t size, void* userData)
+{
+	ReadResult* result = (ReadResult*) userData;
+	result->isRead = true;
+	result->gotData = data != NULL;
+	result->size = size;
+}
+
+void Test_DoneFunc(bool canceled, void* userData)
+{
+	ReadResult* result = (ReadResult*) userData;
+	result->isDone = !canceled;
+}
+
+bool Test_Check(const char* name, const ReadResult& result, bool expectData, size_t expectSize)
+{
+	const bool success = result.isRead && result.isDone && result.gotData == expectData && (!expectData || result.size == expectSize);
+	if (success)
+		printf("%s: ok\n", name);
+	else
+		fprintf(stderr, "Error: %s: read %d, done %d, data %d, size %u\n", name, (int) result.isRead, (int) result.isDone, (int) result.gotData, (unsigned int) result.size);
+	return success;
+}
+
+bool Test_WriteFile(size_t size)
+{
+	File file;
+	if (!file.Open(TEST_FILE_NAME, File::OpenMode_Write))
+		return false;
+	std::vector<unsigned char> contents(size, 'x');
+	return !size || file.Write(&contents[0], size);
+}
+
+int main(int argc, char** argv)
+{
+	g_rootDataDirs.push_back("./");
+	Jobs_Init();
+	AsyncReads_Init();
+
+	if (!Test_WriteFile(TEST_FILE_SIZE))
+	{
+		fprintf(stderr, "Error: failed to write %s\n", TEST_FILE_NAME);
+		return 1;
+	}
+
+	// Missing file
+
+	ReadResult missingResult;
+	File::ReadAsync("Tiny2D_AsyncReadTest.missing", 0, 0, Test_ReadFunc, Test_DoneFunc, &missingResult);
+
+	// Past the end of file (succeeds with no data read)
+
+	ReadResult pastEndResult;
+	File::ReadAsync(TEST_FILE_NAME, TEST_FILE_SIZE * 2, 16, Test_ReadFunc, Test_DoneFunc, &pastEndResult);
+
+	// Short read of a file truncated after it was opened (destination buffer is allocated, but the read fails)
+
+	ReadResult truncatedResult;
+	File truncatedFile;
+	if (!truncatedFile.Open(TEST_FILE_NAME, File::OpenMode_Read) || !Test_WriteFile(0))
+	{
+		fprintf(stderr, "Error: failed to open and truncate %s\n", TEST_FILE_NAME);
+		return 1;
+	}
+	truncatedFile.ReadAsync(0, TEST_FILE_SIZE, Test_ReadFunc, Test_DoneFunc, &truncatedResult);
+
+	Jobs::WaitForAllJobs();
+	truncatedFile.Close();
+
+	AsyncReads_Deinit();
+	Jobs::WaitForAllJobs();
+	Jobs_Deinit();
+	remove(TEST_FILE_NAME);
+
+	int numFailed = 0;
+	numFailed += Test_Check("missing file", missingResult, false, 0) ? 0 : 1;
+	numFailed += Test_Check("past end of file", pastEndResult, true, 0) ? 0 : 1;
+	numFailed += Test_Check("truncated file", truncatedResult, false, 0) ? 0 : 1;
+	if (numFailed)
+	{
+		fprintf(stderr, "%d of 3 tests failed\n", numFailed);
+		return 1;
+	}
+	printf("All tests passed\n");
+	return 0;
+}
@@ -0,0 +1,366 @@
+// Tiny2D font baker
+//
+// Bakes TTF font at given size into glyph atlas image (<base>.png) and binary glyph metrics table (<base>.font)
+// which are then picked up by Font::Create() at runtime instead of rasterizing glyphs via FreeType.
+//
+// Usage:
+//   Tiny2D_FontBaker <font.ttf> <size> [options]
+//
+// Options:
+//   -bold, -italic, -underlined, -strikethrough    font style flags (must match flags passed to Font::Create)
+//   -chars <file>                                  add all characters found in UTF-8 text file
+//   -translations <file>                           add all characters found in translation values of *.translations.xml file
+//   -noascii                                       don't add printable ASCII characters (added by default)
+//   -out <base>                                    output base path; defaults to <font>_<size>_<flags> next to the TTF file
+//
+// Paths are the same as used at runtime relative to one of the root data directories, so the tool is best run from within it, e.g.:
+//   cd Data && Tiny2D_FontBaker common/courbd.ttf 16 -chars common/common_characters.txt -translations texts_EN.translations.xml
+
+#include "Tiny2D.h"
+#include "Tiny2D_Common.h"
+
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "SDL_image.h"
+
+#include <set>
+
+using namespace Tiny2D;
+
+bool LoadFile(const char* path, std::string& contents)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return false;
+
+	char buffer[4096];
+	size_t numRead;
+	while ((numRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.append(buffer, numRead);
+	fclose(file);
+	return true;
+}
+
+void AddCharacters(const std::string& text, std::set<unsigned int>& codes)
+{
+	std::vector<unsigned int> buffer(text.length() + 1);
+	unsigned int bufferSize = (unsigned int) buffer.size();
+	if (!UTF8ToUTF32((const unsigned char*) text.c_str(), (unsigned int) text.length(), &buffer[0], bufferSize))
+		return;
+
+	for (unsigned int i = 0; i < bufferSize; i++)
+		if (buffer[i] != '\r' && buffer[i] != '\n' && buffer[i] != '\t')
+			codes.insert(buffer[i]);
+}
+
+std::string DecodeXMLEntities(const std::string& value)
+{
+	std::string result;
+	for (size_t i = 0; i < value.length(); i++)
+	{
+		if (value[i] != '&')
+		{
+			result += value[i];
+			continue;
+		}
+
+		const size_t end = value.find(';', i);
+		if (end == std::string::npos)
+		{
+			result += value[i];
+			continue;
+		}
+
+		const std::string entity = value.substr(i + 1, end - i - 1);
+		if (entity == "amp") result += '&';
+		else if (entity == "lt") result += '<';
+		else if (entity == "gt") result += '>';
+		else if (entity == "quot") result += '\"';
+		else if (entity == "apos") result += '\'';
+		else if (entity.length() > 1 && entity[0] == '#')
+		{
+			// Numeric entity - encode back as UTF-8
+
+			const unsigned int code = (unsigned int) (entity[1] == 'x' ? strtoul(entity.c_str() + 2, NULL, 16) : strtoul(entity.c_str() + 1, NULL, 10));
+			if (code < 0x80)
+				result += (char) code;
+			else if (code < 0x800)
+			{
+				result += (char) (0xC0 | (code >> 6));
+				result += (char) (0x80 | (code & 0x3F));
+			}
+			else if (code < 0x10000)
+			{
+				result += (char) (0xE0 | (code >> 12));
+				result += (char) (0x80 | ((code >> 6) & 0x3F));
+				result += (char) (0x80 | (code & 0x3F));
+			}
+			else
+			{
+				result += (char) (0xF0 | (code >> 18));
+				result += (char) (0x80 | ((code >> 12) & 0x3F));
+				result += (char) (0x80 | ((code >> 6) & 0x3F));
+				result += (char) (0x80 | (code & 0x3F));
+			}
+		}
+		else
+			result += value.substr(i, end - i + 1);
+		i = end;
+	}
+	return result;
+}
+
+void AddTranslationCharacters(const std::string& xml, std::set<unsigned int>& codes)
+{
+	// Translation values are stored as <translation name="..." value="..."/>
+
+	const std::string valueAttr = "value=\"";
+	size_t start = 0;
+	while ((start = xml.find(valueAttr, start)) != std::string::npos)
+	{
+		start += valueAttr.length();
+		const size_t end = xml.find('\"', start);
+		if (end == std::string::npos)
+			break;
+
+		AddCharacters(DecodeXMLEntities(xml.substr(start, end - start)), codes);
+		start = end + 1;
+	}
+}
+
+// Same glyph layout and rasterization as runtime Font_CacheGlyphs() so that both produce identical metrics
+
+bool BakeFont(TTF_Font* font, int size, unsigned int flags, const std::set<unsigned int>& codes, const std::string& outBasePath)
+{
+	std::map<unsigned int, Glyph> glyphsToBuild;
+	for (std::set<unsigned int>::const_iterator it = codes.begin(); it != codes.end(); ++it)
+	{
+		int minx, maxx, miny, maxy, advance;
+		if (*it > 0xFFFF || TTF_GlyphMetrics(font, (Uint16) *it, &minx, &maxx, &miny, &maxy, &advance))
+		{
+			fprintf(stderr, "Warning: skipping character U+%04X, reason: not supported by font\n", *it);
+			continue;
+		}
+
+		Glyph& glyph = glyphsToBuild[*it];
+		glyph.code = *it;
+		glyph.pos.left = (float) minx;
+		glyph.pos.top = (float) miny;
+		glyph.pos.width = (float) (maxx - minx);
+		glyph.pos.height = (float) (maxy - miny);
+		glyph.advancePos = (float) advance;
+	}
+
+	// Determine optimal layout
+
+	std::vector<RectPacker::Rect> packerRects;
+	for (std::map<unsigned int, Glyph>::iterator it = glyphsToBuild.begin(); it != glyphsToBuild.end(); ++it)
+	{
+		RectPacker::Rect& packerRect = vector_add(packerRects);
+		packerRect.w = (int) it->second.pos.width;
+		packerRect.h = (int) it->second.pos.height;
+		packerRect.userData = &it->second;
+	}
+
+	unsigned int textureWidth, textureHeight;
+	RectPacker::Solve(2, 1, true, packerRects, textureWidth, textureHeight);
+
+	SDL_Surface* surface = SDL_CreateRGBSurface(0, textureWidth, textureHeight, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+	if (!surface)
+	{
+		fprintf(stderr, "Error: SDL_CreateRGBSurface failed, reason: %s\n", SDL_GetError());
+		return false;
+	}
+
+	// Render glyphs
+
+	SDL_Color white;
+	white.r = 255;
+	white.g = 255;
+	white.b = 255;
+	white.a = 255;
+
+	std::vector<Glyph> glyphs;
+	for (std::vector<RectPacker::Rect>::iterator it = packerRects.begin(); it != packerRects.end(); ++it)
+	{
+		Glyph* glyph = (Glyph*) it->userData;
+
+		glyph->uv.left = (float) it->x / (float) textureWidth;
+		glyph->uv.top = (float) it->y / (float) textureHeight;
+		glyph->uv.width = (float) it->w / (float) textureWidth;
+		glyph->uv.height = (float) it->h / (float) textureHeight;
+
+		const unsigned short codes[2] = {(unsigned short) glyph->code, (unsigned short) '\0' };
+		SDL_Surface* glyphSurface = TTF_RenderUNICODE_Blended(font, codes, white);
+		if (!glyphSurface)
+			continue;
+
+		int minX = INT_MAX, maxX = INT_MIN, minY = INT_MAX, maxY = INT_MIN;
+		for (int y = 0; y < glyphSurface->h; y++)
+			for (int x = 0; x < glyphSurface->w; x++)
+				if (((unsigned char*) glyphSurface->pixels)[(x + y * glyphSurface->w) * 4 + 3])
+				{
+					minX = min(minX, x);
+					maxX = max(maxX, x);
+					minY = min(minY, y);
+					maxY = max(maxY, y);
+				}
+
+		if (it->w && it->h)
+		{
+			SDL_Rect glyphSrcRect;
+			glyphSrcRect.x = minX;
+			glyphSrcRect.y = minY;
+			glyphSrcRect.w = maxX - minX + 1;
+			glyphSrcRect.h = maxY - minY + 1;
+
+			glyph->pos.left = (float) minX;
+			glyph->pos.top = (float) minY;
+
+			SDL_Rect glyphDstRect;
+			glyphDstRect.x = it->x;
+			glyphDstRect.y = it->y;
+			glyphDstRect.w = it->w;
+			glyphDstRect.h = it->h;
+
+			SDL_BlitSurface(glyphSurface, &glyphSrcRect, surface, &glyphDstRect);
+		}
+
+		SDL_FreeSurface(glyphSurface);
+
+		glyphs.push_back(*glyph);
+	}
+
+	// Save atlas
+
+	const std::string atlasPath = outBasePath + ".png";
+	if (IMG_SavePNG(surface, atlasPath.c_str()) != 0)
+	{
+		fprintf(stderr, "Error: failed to save atlas to %s, reason: %s\n", atlasPath.c_str(), SDL_GetError());
+		SDL_FreeSurface(surface);
+		return false;
+	}
+	SDL_FreeSurface(surface);
+
+	// Save glyph metrics
+
+	const std::string metricsPath = outBasePath + ".font";
+	FILE* file = fopen(metricsPath.c_str(), "wb");
+	if (!file)
+	{
+		fprintf(stderr, "Error: failed to open %s for writing\n", metricsPath.c_str());
+		return false;
+	}
+
+	BakedFontHeader header;
+	header.magic = BAKED_FONT_MAGIC;
+	header.version = BAKED_FONT_VERSION;
+	header.size = size;
+	header.flags = flags;
+	header.lineHeight = TTF_FontHeight(font);
+	header.numGlyphs = (unsigned int) glyphs.size();
+
+	const bool success =
+		fwrite(&header, sizeof(header), 1, file) == 1 &&
+		(glyphs.empty() || fwrite(&glyphs[0], sizeof(Glyph) * glyphs.size(), 1, file) == 1);
+	fclose(file);
+	if (!success)
+	{
+		fprintf(stderr, "Error: failed to write %s\n", metricsPath.c_str());
+		return false;
+	}
+
+	printf("Baked %u glyphs into %s (%ux%u) and %s\n", header.numGlyphs, atlasPath.c_str(), textureWidth, textureHeight, metricsPath.c_str());
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("Usage: %s <font.ttf> <size> [-bold] [-italic] [-underlined] [-strikethrough] [-chars <file>]* [-translations <file>]* [-noascii] [-out <base>]\n", argv[0]);
+		return 1;
+	}
+
+	const std::string fontPath = argv[1];
+	const int size = atoi(argv[2]);
+	if (size <= 0)
+	{
+		fprintf(stderr, "Error: invalid font size %s\n", argv[2]);
+		return 1;
+	}
+
+	// Parse options
+
+	unsigned int flags = 0;
+	bool addASCII = true;
+	std::string outBasePath;
+	std::set<unsigned int> codes;
+
+	for (int i = 3; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		if (option == "-bold") flags |= Font::Flags_Bold;
+		else if (option == "-italic") flags |= Font::Flags_Italic;
+		else if (option == "-underlined") flags |= Font::Flags_Underlined;
+		else if (option == "-strikethrough") flags |= Font::Flags_StrikeThrough;
+		else if (option == "-noascii") addASCII = false;
+		else if (i + 1 < argc && (option == "-chars" || option == "-translations"))
+		{
+			std::string contents;
+			if (!LoadFile(argv[++i], contents))
+			{
+				fprintf(stderr, "Error: failed to load %s\n", argv[i]);
+				return 1;
+			}
+			if (option == "-chars")
+				AddCharacters(contents, codes);
+			else
+				AddTranslationCharacters(contents, codes);
+		}
+		else if (i + 1 < argc && option == "-out")
+			outBasePath = argv[++i];
+		else
+		{
+			fprintf(stderr, "Error: unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (addASCII)
+		for (unsigned int code = 0x20; code < 0x7F; code++)
+			codes.insert(code);
+
+	if (outBasePath.empty())
+		outBasePath = Font_GetBakedBasePath(fontPath, size, flags);
+
+	// Open font
+
+	if (SDL_Init(0) != 0 || TTF_Init() != 0)
+	{
+		fprintf(stderr, "Error: failed to initialize SDL, reason: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	TTF_Font* font = TTF_OpenFont(fontPath.c_str(), size);
+	if (!font)
+	{
+		fprintf(stderr, "Error: failed to load font from %s, reason: %s\n", fontPath.c_str(), SDL_GetError());
+		return 1;
+	}
+
+	TTF_SetFontStyle(font,
+		((flags & Font::Flags_Bold) ? TTF_STYLE_BOLD : 0) |
+		((flags & Font::Flags_Italic) ? TTF_STYLE_ITALIC : 0) |
+		((flags & Font::Flags_StrikeThrough) ? TTF_STYLE_STRIKETHROUGH : 0) |
+		((flags & Font::Flags_Underlined) ? TTF_STYLE_UNDERLINE : 0));
+	TTF_SetFontKerning(font, 1);
+
+	const bool success = BakeFont(font, size, flags, codes, outBasePath);
+
+	TTF_CloseFont(font);
+	TTF_Quit();
+	SDL_Quit();
+
+	return success ? 0 : 1;
+}
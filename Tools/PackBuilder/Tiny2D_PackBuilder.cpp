@@ -0,0 +1,333 @@
+// Tiny2D pack builder
+//
+// Packs data files into single indexed pack file (<output>.pack) which can be mounted at runtime via App::StartupParams::packFiles.
+// Files read from mounted packs are served directly from memory mapped pack file instead of opening individual loose files.
+//
+// Usage:
+//   Tiny2D_PackBuilder <output.pack> <dir or file>... [options]
+//
+// Options:
+//   -exclude <suffix>    skip files whose names end with given suffix (e.g. ".psd"); may be used multiple times
+//   -store <suffix>      store files whose names end with given suffix uncompressed; may be used multiple times
+//   -nocompress          store all files uncompressed
+//
+// By default files are LZ4 compressed except for already compressed formats (png, jpg, ogg) and files that don't shrink by at least 10%.
+//
+// Entry names are the same as used at runtime relative to one of the root data directories, so the tool is best run from within it, e.g.:
+//   cd Data && Tiny2D_PackBuilder ../common.pack common
+
+#include "Tiny2D.h"
+#include "Tiny2D_Common.h"
+
+#include <algorithm>
+#include <map>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+using namespace Tiny2D;
+
+struct InputFile
+{
+	std::string name;
+	unsigned int nameHash;
+	unsigned int nameOffset;
+	unsigned long long offset;
+	unsigned long long size;
+	unsigned long long packedSize;
+	unsigned int compression;
+};
+
+struct CompressionStats
+{
+	unsigned int numFiles;
+	unsigned long long size;
+	unsigned long long packedSize;
+
+	CompressionStats() : numFiles(0), size(0), packedSize(0) {}
+};
+
+bool InputFile_TocLess(const InputFile* a, const InputFile* b)
+{
+	return a->nameHash != b->nameHash ? a->nameHash < b->nameHash : a->name < b->name;
+}
+
+bool InputFile_NameLess(const InputFile& a, const InputFile& b)
+{
+	return a.name < b.name;
+}
+
+bool HasSuffix(const std::string& name, const std::vector<std::string>& suffixes)
+{
+	for (std::vector<std::string>::const_iterator it = suffixes.begin(); it != suffixes.end(); ++it)
+		if (name.length() >= it->length() && !name.compare(name.length() - it->length(), it->length(), *it))
+			return true;
+	return false;
+}
+
+bool IsDirectory(const std::string& path)
+{
+#if defined(_WIN32)
+	const DWORD attributes = GetFileAttributesA(path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+	struct stat pathStat;
+	return stat(path.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode);
+#endif
+}
+
+void CollectFiles(const std::string& path, const std::vector<std::string>& excludes, std::vector<InputFile>& files)
+{
+	if (!IsDirectory(path))
+	{
+		if (HasSuffix(path, excludes))
+			return;
+		InputFile file;
+		file.name = path;
+		files.push_back(file);
+		return;
+	}
+
+	std::vector<std::string> children;
+#if defined(_WIN32)
+	WIN32_FIND_DATAA findData;
+	HANDLE findHandle = FindFirstFileA((path + "/*").c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE)
+		return;
+	do
+		children.push_back(findData.cFileName);
+	while (FindNextFileA(findHandle, &findData));
+	FindClose(findHandle);
+#else
+	DIR* dir = opendir(path.c_str());
+	if (!dir)
+		return;
+	while (struct dirent* entry = readdir(dir))
+		children.push_back(entry->d_name);
+	closedir(dir);
+#endif
+
+	for (std::vector<std::string>::iterator it = children.begin(); it != children.end(); ++it)
+		if (*it != "." && *it != "..")
+			CollectFiles(path + "/" + *it, excludes, files);
+}
+
+bool WritePadding(FILE* file, unsigned long long& offset)
+{
+	static const unsigned char zeros[PACK_ENTRY_ALIGNMENT] = {0};
+	const unsigned long long alignedOffset = (offset + PACK_ENTRY_ALIGNMENT - 1) & ~(unsigned long long) (PACK_ENTRY_ALIGNMENT - 1);
+	const size_t paddingSize = (size_t) (alignedOffset - offset);
+	offset = alignedOffset;
+	return !paddingSize || fwrite(zeros, 1, paddingSize, file) == paddingSize;
+}
+
+std::string GetExtension(const std::string& name)
+{
+	const size_t dotIndex = name.find_last_of("./");
+	return dotIndex != std::string::npos && name[dotIndex] == '.' ? name.substr(dotIndex) : "<none>";
+}
+
+bool LoadFile(const char* path, std::vector<unsigned char>& contents)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return false;
+
+	unsigned char buffer[4096];
+	size_t numRead;
+	while ((numRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.insert(contents.end(), buffer, buffer + numRead);
+	fclose(file);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("Usage: %s <output.pack> <dir or file>... [-exclude <suffix>]* [-store <suffix>]* [-nocompress]\n", argv[0]);
+		return 1;
+	}
+
+	const std::string outPath = argv[1];
+
+	// Parse options and collect input files
+
+	std::vector<std::string> inputs;
+	std::vector<std::string> excludes;
+	std::vector<std::string> stored;
+	stored.push_back(".png");
+	stored.push_back(".jpg");
+	stored.push_back(".jpeg");
+	stored.push_back(".ogg");
+	bool compress = true;
+
+	for (int i = 2; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		if (i + 1 < argc && option == "-exclude")
+			excludes.push_back(argv[++i]);
+		else if (i + 1 < argc && option == "-store")
+			stored.push_back(argv[++i]);
+		else if (option == "-nocompress")
+			compress = false;
+		else if (option[0] == '-')
+		{
+			fprintf(stderr, "Error: unknown option %s\n", argv[i]);
+			return 1;
+		}
+		else
+			inputs.push_back(option);
+	}
+
+	std::vector<InputFile> files;
+	for (std::vector<std::string>::iterator it = inputs.begin(); it != inputs.end(); ++it)
+	{
+		std::string input = *it;
+		string_replace_all(input, "\\", "/");
+		while (input.length() > 1 && input[input.length() - 1] == '/')
+			input.erase(input.length() - 1);
+		while (input.length() > 2 && !input.compare(0, 2, "./"))
+			input.erase(0, 2);
+		CollectFiles(input, excludes, files);
+	}
+
+	if (files.empty())
+	{
+		fprintf(stderr, "Error: no input files found\n");
+		return 1;
+	}
+
+	// Build table of contents; data is stored in name order (keeping files from the same directory close), table of contents in (hash, name) order
+
+	std::sort(files.begin(), files.end(), InputFile_NameLess);
+
+	std::string names;
+	std::vector<InputFile*> toc(files.size());
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		InputFile& file = files[i];
+		if (i > 0 && file.name == files[i - 1].name)
+		{
+			fprintf(stderr, "Error: duplicate entry %s\n", file.name.c_str());
+			return 1;
+		}
+		file.nameHash = string_hash(file.name.c_str(), file.name.length());
+		file.nameOffset = (unsigned int) names.length();
+		names.append(file.name.c_str(), file.name.length() + 1);
+		toc[i] = &file;
+	}
+	std::sort(toc.begin(), toc.end(), InputFile_TocLess);
+
+	// Write header, placeholder table of contents and names
+
+	FILE* out = fopen(outPath.c_str(), "wb");
+	if (!out)
+	{
+		fprintf(stderr, "Error: failed to open %s for writing\n", outPath.c_str());
+		return 1;
+	}
+
+	PackHeader header;
+	header.magic = PACK_MAGIC;
+	header.version = PACK_VERSION;
+	header.numEntries = (unsigned int) files.size();
+	header.namesSize = (unsigned int) names.length();
+
+	std::vector<PackEntry> entries(files.size());
+	memset(&entries[0], 0, entries.size() * sizeof(PackEntry));
+
+	bool success =
+		fwrite(&header, sizeof(header), 1, out) == 1 &&
+		fwrite(&entries[0], sizeof(PackEntry), entries.size(), out) == entries.size() &&
+		fwrite(names.c_str(), 1, names.length(), out) == names.length();
+	unsigned long long offset = sizeof(header) + entries.size() * sizeof(PackEntry) + names.length();
+
+	// Write (optionally compressed) file contents
+
+	std::map<std::string, CompressionStats> statsPerExtension;
+	std::vector<unsigned char> contents;
+	std::vector<unsigned char> compressedContents;
+	for (std::vector<InputFile>::iterator it = files.begin(); success && it != files.end(); ++it)
+	{
+		contents.clear();
+		if (!LoadFile(it->name.c_str(), contents))
+		{
+			fprintf(stderr, "Error: failed to open %s\n", it->name.c_str());
+			success = false;
+			break;
+		}
+		it->size = contents.size();
+		it->packedSize = contents.size();
+		it->compression = PackCompression_None;
+
+		const unsigned char* packedData = contents.empty() ? NULL : &contents[0];
+		if (compress && !contents.empty() && !HasSuffix(it->name, stored))
+		{
+			compressedContents.resize(LZ4_CompressBound(contents.size()));
+			const size_t compressedSize = LZ4_Compress(&contents[0], contents.size(), &compressedContents[0]);
+			if (compressedSize * 10 <= contents.size() * 9)
+			{
+				it->packedSize = compressedSize;
+				it->compression = PackCompression_LZ4;
+				packedData = &compressedContents[0];
+			}
+		}
+
+		success = WritePadding(out, offset) &&
+			fwrite(packedData, 1, (size_t) it->packedSize, out) == it->packedSize;
+		it->offset = offset;
+		offset += it->packedSize;
+
+		CompressionStats& stats = statsPerExtension[GetExtension(it->name)];
+		stats.numFiles++;
+		stats.size += it->size;
+		stats.packedSize += it->packedSize;
+	}
+
+	// Write final table of contents
+
+	if (success)
+	{
+		for (size_t i = 0; i < toc.size(); i++)
+		{
+			PackEntry& entry = entries[i];
+			entry.nameHash = toc[i]->nameHash;
+			entry.nameOffset = toc[i]->nameOffset;
+			entry.offset = toc[i]->offset;
+			entry.size = toc[i]->size;
+			entry.packedSize = toc[i]->packedSize;
+			entry.compression = toc[i]->compression;
+			entry.reserved = 0;
+		}
+		success =
+			fseek(out, sizeof(header), SEEK_SET) == 0 &&
+			fwrite(&entries[0], sizeof(PackEntry), entries.size(), out) == entries.size();
+	}
+
+	success = !fclose(out) && success;
+	if (!success)
+	{
+		fprintf(stderr, "Error: failed to write %s\n", outPath.c_str());
+		remove(outPath.c_str());
+		return 1;
+	}
+
+	// Report compression ratios
+
+	CompressionStats totalStats;
+	for (std::map<std::string, CompressionStats>::iterator it = statsPerExtension.begin(); it != statsPerExtension.end(); ++it)
+	{
+		const CompressionStats& stats = it->second;
+		printf("  %-12s %4u files %10llu -> %10llu bytes (%5.1f%%)\n", it->first.c_str(), stats.numFiles, stats.size, stats.packedSize, stats.size ? 100.0 * stats.packedSize / stats.size : 100.0);
+		totalStats.size += stats.size;
+		totalStats.packedSize += stats.packedSize;
+	}
+
+	printf("Packed %u files (%llu -> %llu bytes, %.1f%%) into %s\n", header.numEntries, totalStats.size, totalStats.packedSize, totalStats.size ? 100.0 * totalStats.packedSize / totalStats.size : 100.0, outPath.c_str());
+	return 0;
+}
@@ -0,0 +1,572 @@
+// Tiny2D shader compiler
+//
+// Offline shader validation and preprocessing tool. For every technique of given *.material.xml files it:
+// - extracts vertex and fragment shader entries from .fx files (expanding #includes and ###splitter### sections the same way the runtime does)
+// - strips comments and functions not reachable from the entry
+// - validates the shaders with ANGLE's GLSL ES front-end, translating them to both ESSL (GLES2) and desktop GLSL; shaders of techniques declaring
+//   keywords are validated without keywords, with each keyword alone and with all keywords #defined; frame constants declared by techniques
+//   are injected as plain uniforms (as done at runtime when uniform buffers aren't available)
+// - writes preprocessed <file>.fxc next to each .fx file (or into -outdir) which the runtime then picks up instead of the .fx file; each .fxc stores
+//   the hash of its .fx file and all of its includes, so the runtime ignores it (falling back to the .fx file) once any of them gets modified
+//
+// The ANGLE front-end only accepts GLSL ES, so shaders are validated after the same desktop-to-ES conversion the runtime applies on GLES devices.
+// The tool runs on the CPU only and returns non-zero on any failure, so it can also be used as a headless shader regression test.
+//
+// Usage:
+//   Tiny2D_ShaderCompiler <material.xml>+ [options]
+//
+// Options:
+//   -outdir <dir>      directory to write preprocessed files to (preserving relative paths); defaults to current directory
+//   -validateonly      don't write preprocessed files
+//   -nostrip           don't strip comments and unused functions
+//
+// Paths are the same as used at runtime relative to one of the root data directories, so the tool is best run from within it, e.g.:
+//   cd Data && Tiny2D_ShaderCompiler common/*.material.xml
+
+#include "Tiny2D.h"
+#include "Tiny2D_Common.h"
+#include "OpenGL/Tiny2D_OpenGL.h"
+
+#include "GLSLANG/ShaderLang.h"
+
+#include <set>
+
+using namespace Tiny2D;
+
+struct ShaderEntry
+{
+	std::string path;
+	std::string entry;
+	Shader::Type type;
+	std::vector<std::string> keywords; // Not part of the key; merged across all techniques using the entry
+	std::vector<std::string> frameConstants; // Not part of the key; merged across all techniques using the entry
+
+	bool operator < (const ShaderEntry& other) const
+	{
+		if (path != other.path) return path < other.path;
+		if (entry != other.entry) return entry < other.entry;
+		return type < other.type;
+	}
+};
+
+bool LoadFile(const std::string& path, std::string& contents)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	char buffer[4096];
+	size_t numRead;
+	while ((numRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.append(buffer, numRead);
+	fclose(file);
+	return true;
+}
+
+bool SaveFile(const std::string& path, const std::string& contents)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+		return false;
+
+	const bool success = fwrite(contents.c_str(), 1, contents.length(), file) == contents.length();
+	fclose(file);
+	return success;
+}
+
+// Material parsing
+
+std::string GetAttribute(const std::string& tag, const char* name)
+{
+	const std::string prefix = std::string(" ") + name + "=\"";
+	const size_t start = tag.find(prefix);
+	if (start == std::string::npos)
+		return std::string();
+	const size_t valueStart = start + prefix.length();
+	const size_t valueEnd = tag.find('\"', valueStart);
+	return valueEnd == std::string::npos ? std::string() : tag.substr(valueStart, valueEnd - valueStart);
+}
+
+bool ParseMaterial(const std::string& path, std::vector<ShaderEntry>& entries)
+{
+	std::string xml;
+	if (!LoadFile(path, xml))
+	{
+		fprintf(stderr, "Error: failed to load material %s\n", path.c_str());
+		return false;
+	}
+
+	// Techniques are stored as <technique name="..."><shader type="vertex|fragment" path="..." entry="..."/>...</technique>
+
+	size_t techniqueStart = 0;
+	while ((techniqueStart = xml.find("<technique", techniqueStart)) != std::string::npos)
+	{
+		size_t techniqueEnd = xml.find("</technique>", techniqueStart);
+		if (techniqueEnd == std::string::npos)
+			techniqueEnd = xml.length();
+		const std::string technique = xml.substr(techniqueStart, techniqueEnd - techniqueStart);
+		const std::string techniqueName = GetAttribute(technique.substr(0, technique.find('>')), "name");
+		std::vector<std::string> keywords;
+		string_split(keywords, GetAttribute(technique.substr(0, technique.find('>')), "keywords"));
+		std::vector<std::string> frameConstants;
+		string_split(frameConstants, GetAttribute(technique.substr(0, technique.find('>')), "frameConstants"));
+		for (std::vector<std::string>::iterator it = frameConstants.begin(); it != frameConstants.end(); ++it)
+			if (*it != "ScreenSize" && *it != "ProjectionScale")
+			{
+				fprintf(stderr, "Error: material %s technique %s uses unknown frame constant %s\n", path.c_str(), techniqueName.c_str(), it->c_str());
+				return false;
+			}
+
+		int numShaders = 0;
+		size_t shaderStart = 0;
+		while ((shaderStart = technique.find("<shader", shaderStart)) != std::string::npos)
+		{
+			const size_t shaderEnd = technique.find('>', shaderStart);
+			const std::string shader = technique.substr(shaderStart, shaderEnd - shaderStart);
+			shaderStart = shaderEnd;
+
+			const std::string type = GetAttribute(shader, "type");
+			ShaderEntry entry;
+			entry.path = GetAttribute(shader, "path");
+			entry.entry = GetAttribute(shader, "entry");
+			entry.keywords = keywords;
+			entry.frameConstants = frameConstants;
+			if (entry.entry.empty())
+				entry.entry = "main";
+			if (type == "vertex")
+				entry.type = Shader::Type_Vertex;
+			else if (type == "fragment")
+				entry.type = Shader::Type_Fragment;
+			else
+			{
+				fprintf(stderr, "Error: material %s technique %s specifies unsupported shader type '%s'\n", path.c_str(), techniqueName.c_str(), type.c_str());
+				return false;
+			}
+			if (entry.path.empty())
+			{
+				fprintf(stderr, "Error: material %s technique %s doesn't specify shader path\n", path.c_str(), techniqueName.c_str());
+				return false;
+			}
+
+			entries.push_back(entry);
+			numShaders++;
+		}
+
+		if (numShaders != 2)
+		{
+			fprintf(stderr, "Error: material %s technique %s doesn't specify both vertex and fragment shaders\n", path.c_str(), techniqueName.c_str());
+			return false;
+		}
+
+		techniqueStart = techniqueEnd;
+	}
+
+	return true;
+}
+
+// Shader source code extraction (mirrors the runtime shader source cache)
+
+bool ExpandIncludes(const std::string& path, std::string& sourceCode)
+{
+	static const std::string includePrefix = "#include \"";
+
+	size_t includeStart;
+	while ((includeStart = sourceCode.find(includePrefix)) != std::string::npos)
+	{
+		const size_t includeEnd = sourceCode.find('\"', includeStart + includePrefix.length());
+		if (includeEnd == std::string::npos)
+		{
+			fprintf(stderr, "Error: failed to parse #include in shader file %s\n", path.c_str());
+			return false;
+		}
+
+		const std::string includePath = sourceCode.substr(includeStart + includePrefix.length(), includeEnd - includeStart - includePrefix.length());
+
+		std::string includeFileContent;
+		if (!LoadFile(includePath, includeFileContent))
+		{
+			fprintf(stderr, "Error: failed to load shader file %s included from %s\n", includePath.c_str(), path.c_str());
+			return false;
+		}
+
+		sourceCode.replace(includeStart, includeEnd - includeStart + 1, includeFileContent);
+	}
+
+	return true;
+}
+
+bool GetEntrySourceCode(const ShaderEntry& entry, std::string& sourceCode)
+{
+	std::string fileContent;
+	if (!LoadFile(entry.path, fileContent))
+	{
+		fprintf(stderr, "Error: failed to load shader from %s\n", entry.path.c_str());
+		return false;
+	}
+
+	// Find section containing desired entry function
+
+	size_t start = 0;
+	while (true)
+	{
+		const size_t end = fileContent.find(SHADER_SPLITTER_STRING, start);
+		const std::string section = fileContent.substr(start, end == std::string::npos ? std::string::npos : end - start);
+		if (section.find(entry.entry) != std::string::npos)
+		{
+			sourceCode = section;
+			break;
+		}
+		if (end == std::string::npos)
+		{
+			fprintf(stderr, "Error: failed to find entry %s in shader %s\n", entry.entry.c_str(), entry.path.c_str());
+			return false;
+		}
+		start = end + strlen(SHADER_SPLITTER_STRING);
+	}
+
+	if (entry.entry != "main")
+		string_replace_all(sourceCode, entry.entry, "main");
+	return ExpandIncludes(entry.path, sourceCode);
+}
+
+// Stripping
+
+std::string StripComments(const std::string& code)
+{
+	// Remove comments
+
+	std::string noComments;
+	for (size_t i = 0; i < code.length(); i++)
+	{
+		if (code[i] == '/' && i + 1 < code.length() && code[i + 1] == '/')
+		{
+			while (i < code.length() && code[i] != '\n')
+				i++;
+			if (i < code.length())
+				noComments += '\n';
+		}
+		else if (code[i] == '/' && i + 1 < code.length() && code[i + 1] == '*')
+		{
+			const size_t end = code.find("*/", i + 2);
+			for (size_t j = i; j < end && j < code.length(); j++)
+				if (code[j] == '\n')
+					noComments += '\n';
+			i = end == std::string::npos ? code.length() : end + 1;
+		}
+		else if (code[i] != '\r')
+			noComments += code[i];
+	}
+
+	// Remove trailing white spaces and empty lines
+
+	std::string result;
+	size_t lineStart = 0;
+	while (lineStart < noComments.length())
+	{
+		size_t lineEnd = noComments.find('\n', lineStart);
+		if (lineEnd == std::string::npos)
+			lineEnd = noComments.length();
+
+		size_t contentEnd = lineEnd;
+		while (contentEnd > lineStart && (noComments[contentEnd - 1] == ' ' || noComments[contentEnd - 1] == '\t'))
+			contentEnd--;
+		if (contentEnd > lineStart)
+		{
+			result.append(noComments, lineStart, contentEnd - lineStart);
+			result += '\n';
+		}
+
+		lineStart = lineEnd + 1;
+	}
+	return result;
+}
+
+inline bool IsIdentifierChar(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+bool IsIdentifierUsed(const std::string& code, const std::string& name, size_t excludeStart, size_t excludeEnd)
+{
+	size_t pos = 0;
+	while ((pos = code.find(name, pos)) != std::string::npos)
+	{
+		const bool isWholeWord =
+			(pos == 0 || !IsIdentifierChar(code[pos - 1])) &&
+			(pos + name.length() == code.length() || !IsIdentifierChar(code[pos + name.length()]));
+		if (isWholeWord && (pos < excludeStart || pos >= excludeEnd))
+			return true;
+		pos += name.length();
+	}
+	return false;
+}
+
+std::string StripUnusedFunctions(const std::string& code)
+{
+	// Repeatedly remove top level functions (other than main) not referenced anywhere else
+
+	std::string result = code;
+	bool removedAny = true;
+	while (removedAny)
+	{
+		removedAny = false;
+
+		int depth = 0;
+		size_t statementStart = 0;
+		bool isLineStart = true;
+		for (size_t i = 0; i < result.length(); i++)
+		{
+			const char c = result[i];
+			if (depth == 0 && isLineStart && c == '#')
+			{
+				// Skip preprocessor directive
+
+				while (i < result.length() && result[i] != '\n')
+					i++;
+				statementStart = i + 1;
+				continue;
+			}
+			isLineStart = c == '\n' || (isLineStart && (c == ' ' || c == '\t'));
+
+			if (c == '{' && depth++ == 0)
+			{
+				// Find function name i.e. identifier preceding '(' in statement header
+
+				const std::string header = result.substr(statementStart, i - statementStart);
+				const size_t parenthesis = header.find('(');
+				if (parenthesis == std::string::npos || header.find('=') != std::string::npos)
+					continue;
+				size_t nameEnd = parenthesis;
+				while (nameEnd > 0 && !IsIdentifierChar(header[nameEnd - 1]))
+					nameEnd--;
+				size_t nameStart = nameEnd;
+				while (nameStart > 0 && IsIdentifierChar(header[nameStart - 1]))
+					nameStart--;
+				const std::string name = header.substr(nameStart, nameEnd - nameStart);
+				if (name.empty() || name == "main")
+					continue;
+
+				// Find function end
+
+				size_t end = i + 1;
+				for (int bodyDepth = 1; end < result.length() && bodyDepth > 0; end++)
+					if (result[end] == '{') bodyDepth++;
+					else if (result[end] == '}') bodyDepth--;
+
+				if (!IsIdentifierUsed(result, name, statementStart, end))
+				{
+					result.erase(statementStart, end - statementStart);
+					removedAny = true;
+					break;
+				}
+			}
+			else if (c == '}' && --depth == 0)
+				statementStart = i + 1;
+			else if (c == ';' && depth == 0)
+				statementStart = i + 1;
+		}
+	}
+	return StripComments(result);
+}
+
+// Validation
+
+std::string AddPreamble(const std::string& sourceCode, const std::vector<std::string>& keywords, const std::set<std::string>& frameConstants)
+{
+	// Same as at runtime: keyword defines and frame constant declarations follow #version directive (if any)
+
+	std::string defines;
+	for (std::vector<std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
+		defines += "#define " + *it + " 1\n";
+	for (std::set<std::string>::const_iterator it = frameConstants.begin(); it != frameConstants.end(); ++it)
+		defines += "uniform vec4 " + *it + ";\n#define " FRAME_CONSTANT_DEFINE_PREFIX + *it + "\n";
+
+	size_t insertPos = 0;
+	const size_t versionPos = sourceCode.find("#version");
+	if (versionPos != std::string::npos)
+	{
+		const size_t versionEnd = sourceCode.find('\n', versionPos);
+		insertPos = versionEnd == std::string::npos ? sourceCode.length() : versionEnd + 1;
+	}
+
+	std::string result = sourceCode;
+	result.insert(insertPos, defines);
+	return result;
+}
+
+bool ValidateShader(const ShaderEntry& entry, const std::string& sourceCode, const std::vector<std::string>& keywords, const std::set<std::string>& frameConstants)
+{
+	std::string esSourceCode = AddPreamble(sourceCode, keywords, frameConstants);
+	OpenGLES_ConvertFromOpenGL(esSourceCode);
+
+	ShBuiltInResources resources;
+	ShInitBuiltInResources(&resources);
+
+	const ShShaderOutput outputs[] = { SH_ESSL_OUTPUT, SH_GLSL_OUTPUT };
+	const char* outputNames[] = { "GLES2", "desktop GL" };
+
+	for (int i = 0; i < (int) ARRAYSIZE(outputs); i++)
+	{
+		ShHandle compiler = ShConstructCompiler(entry.type == Shader::Type_Vertex ? SH_VERTEX_SHADER : SH_FRAGMENT_SHADER, SH_GLES2_SPEC, outputs[i], &resources);
+		if (!compiler)
+		{
+			fprintf(stderr, "Error: failed to create ANGLE shader compiler\n");
+			return false;
+		}
+
+		const char* sourceCodeChars = esSourceCode.c_str();
+		const bool success = ShCompile(compiler, &sourceCodeChars, 1, SH_VALIDATE | SH_OBJECT_CODE) != 0;
+		if (!success)
+		{
+			int logLength = 0;
+			ShGetInfo(compiler, SH_INFO_LOG_LENGTH, &logLength);
+			std::string log(logLength > 0 ? logLength : 1, '\0');
+			ShGetInfoLog(compiler, &log[0]);
+			std::string keywordNames;
+			for (std::vector<std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
+				keywordNames += " " + *it;
+			fprintf(stderr, "Error: failed to compile %s shader %s:%s (keywords:%s) for %s, reason:\n%s\nGLSL ES source code:\n%s\n",
+				entry.type == Shader::Type_Vertex ? "vertex" : "fragment", entry.path.c_str(), entry.entry.c_str(), keywordNames.c_str(), outputNames[i], log.c_str(), esSourceCode.c_str());
+		}
+
+		ShDestruct(compiler);
+		if (!success)
+			return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s <material.xml>+ [-outdir <dir>] [-validateonly] [-nostrip]\n", argv[0]);
+		return 1;
+	}
+
+	// Parse options
+
+	std::string outDir;
+	bool writeOutput = true;
+	bool strip = true;
+	std::vector<std::string> materialPaths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		if (option == "-validateonly") writeOutput = false;
+		else if (option == "-nostrip") strip = false;
+		else if (i + 1 < argc && option == "-outdir")
+		{
+			outDir = argv[++i];
+			if (!outDir.empty() && outDir[outDir.length() - 1] != '/')
+				outDir += '/';
+		}
+		else if (option[0] == '-')
+		{
+			fprintf(stderr, "Error: unknown option %s\n", argv[i]);
+			return 1;
+		}
+		else
+			materialPaths.push_back(option);
+	}
+
+	// Collect shader entries used by all materials
+
+	std::set<ShaderEntry> entries;
+	std::map<std::string, std::set<std::string> > entryKeywords;
+	std::map<std::string, std::set<std::string> > entryFrameConstants;
+	for (std::vector<std::string>::iterator it = materialPaths.begin(); it != materialPaths.end(); ++it)
+	{
+		std::vector<ShaderEntry> materialEntries;
+		if (!ParseMaterial(*it, materialEntries))
+			return 1;
+		for (std::vector<ShaderEntry>::iterator entryIt = materialEntries.begin(); entryIt != materialEntries.end(); ++entryIt)
+		{
+			entries.insert(*entryIt);
+			entryKeywords[entryIt->path + ":" + entryIt->entry].insert(entryIt->keywords.begin(), entryIt->keywords.end());
+			entryFrameConstants[entryIt->path + ":" + entryIt->entry].insert(entryIt->frameConstants.begin(), entryIt->frameConstants.end());
+		}
+	}
+
+	// Preprocess and validate all entries
+
+	if (!ShInitialize())
+	{
+		fprintf(stderr, "Error: failed to initialize ANGLE shader compiler\n");
+		return 1;
+	}
+
+	int numFailed = 0;
+	std::map<std::string, std::string> outputFiles;
+	std::set<std::string> writtenEntries;
+	for (std::set<ShaderEntry>::iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		std::string sourceCode;
+		if (!GetEntrySourceCode(*it, sourceCode))
+		{
+			numFailed++;
+			continue;
+		}
+		if (strip)
+			sourceCode = StripUnusedFunctions(StripComments(sourceCode));
+
+		// Validate base variant, variant for each keyword and variant with all keywords
+
+		const std::set<std::string>& keywordSet = entryKeywords[it->path + ":" + it->entry];
+		const std::vector<std::string> allKeywords(keywordSet.begin(), keywordSet.end());
+		const std::set<std::string>& frameConstants = entryFrameConstants[it->path + ":" + it->entry];
+
+		bool success = ValidateShader(*it, sourceCode, std::vector<std::string>(), frameConstants);
+		for (std::vector<std::string>::const_iterator keywordIt = allKeywords.begin(); success && keywordIt != allKeywords.end(); ++keywordIt)
+			success = ValidateShader(*it, sourceCode, std::vector<std::string>(1, *keywordIt), frameConstants);
+		if (success && allKeywords.size() > 1)
+			success = ValidateShader(*it, sourceCode, allKeywords, frameConstants);
+		if (!success)
+		{
+			numFailed++;
+			continue;
+		}
+
+		// Same entry may be used as both vertex and fragment shader only if it's the same code
+
+		if (writtenEntries.insert(it->path + ":" + it->entry).second)
+			outputFiles[it->path] += std::string(SHADER_ENTRY_MARKER) + " " + it->entry + "\n" + sourceCode;
+	}
+
+	ShFinalize();
+
+	if (numFailed)
+	{
+		fprintf(stderr, "%d of %d shaders failed validation\n", numFailed, (int) entries.size());
+		return 1;
+	}
+
+	// Write preprocessed files
+
+	if (writeOutput)
+		for (std::map<std::string, std::string>::iterator it = outputFiles.begin(); it != outputFiles.end(); ++it)
+		{
+			unsigned long long sourceHash;
+			if (!ShaderSource_CalcHash(it->first, LoadFile, sourceHash))
+			{
+				fprintf(stderr, "Error: failed to calculate source hash of shader %s\n", it->first.c_str());
+				return 1;
+			}
+
+			char hashLine[64];
+			snprintf(hashLine, sizeof(hashLine), "%s %016llx\n", SHADER_SOURCE_HASH_MARKER, sourceHash);
+
+			const std::string outPath = outDir + it->first + SHADER_PREPROCESSED_SUFFIX;
+			if (!SaveFile(outPath, hashLine + it->second))
+			{
+				fprintf(stderr, "Error: failed to save preprocessed shader to %s\n", outPath.c_str());
+				return 1;
+			}
+			printf("Saved %s\n", outPath.c_str());
+		}
+
+	printf("%d shaders validated successfully\n", (int) entries.size());
+	return 0;
+}
@@ -0,0 +1,216 @@
+// Tiny2D XML cooker
+//
+// Converts XML resource files (materials, sprites, particle effects, sprite atlas infos) into cooked binary documents (see XMLCookedHeader)
+// stored next to each source as <file>.cooked. At runtime XMLDoc_Load() memory maps the cooked document and uses it instead of parsing the XML text
+// as long as the hash of the source file matches the one stored in the cooked document; the XML files remain the authoring format.
+//
+// Usage:
+//   Tiny2D_XMLCooker <dir or file>... [options]
+//
+// Options:
+//   -exclude <suffix>    skip files whose names end with given suffix; may be used multiple times
+//   -force               recook files even if cooked documents are up to date
+//
+// Directories are searched recursively for *.xml files. Requires the engine library to be built first (make in the root directory).
+// When shipping packs only, sources can be left out with Tiny2D_PackBuilder's -exclude .xml option.
+
+#include "Tiny2D.h"
+#include "Tiny2D_Common.h"
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+using namespace Tiny2D;
+
+bool HasSuffix(const std::string& name, const std::string& suffix)
+{
+	return name.length() >= suffix.length() && !name.compare(name.length() - suffix.length(), suffix.length(), suffix);
+}
+
+bool HasSuffix(const std::string& name, const std::vector<std::string>& suffixes)
+{
+	for (std::vector<std::string>::const_iterator it = suffixes.begin(); it != suffixes.end(); ++it)
+		if (HasSuffix(name, *it))
+			return true;
+	return false;
+}
+
+bool IsDirectory(const std::string& path)
+{
+#if defined(_WIN32)
+	const DWORD attributes = GetFileAttributesA(path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+	struct stat pathStat;
+	return stat(path.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode);
+#endif
+}
+
+void CollectFiles(const std::string& path, const std::vector<std::string>& excludes, bool isExplicit, std::vector<std::string>& files)
+{
+	if (!IsDirectory(path))
+	{
+		if ((isExplicit || HasSuffix(path, ".xml")) && !HasSuffix(path, excludes))
+			files.push_back(path);
+		return;
+	}
+
+	std::vector<std::string> children;
+#if defined(_WIN32)
+	WIN32_FIND_DATAA findData;
+	HANDLE findHandle = FindFirstFileA((path + "/*").c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE)
+		return;
+	do
+		children.push_back(findData.cFileName);
+	while (FindNextFileA(findHandle, &findData));
+	FindClose(findHandle);
+#else
+	DIR* dir = opendir(path.c_str());
+	if (!dir)
+		return;
+	while (struct dirent* entry = readdir(dir))
+		children.push_back(entry->d_name);
+	closedir(dir);
+#endif
+
+	for (std::vector<std::string>::iterator it = children.begin(); it != children.end(); ++it)
+		if (*it != "." && *it != "..")
+			CollectFiles(path + "/" + *it, excludes, false, files);
+}
+
+bool LoadFile(const std::string& path, std::vector<unsigned char>& contents)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	unsigned char buffer[4096];
+	size_t numRead;
+	while ((numRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.insert(contents.end(), buffer, buffer + numRead);
+	fclose(file);
+	return true;
+}
+
+bool IsUpToDate(const std::string& cookedPath, const std::vector<unsigned char>& source)
+{
+	std::vector<unsigned char> cooked;
+	if (!LoadFile(cookedPath, cooked) || cooked.size() < sizeof(XMLCookedHeader))
+		return false;
+
+	const XMLCookedHeader* header = (const XMLCookedHeader*) &cooked[0];
+	return header->magic == XML_COOKED_MAGIC &&
+		header->version == XML_COOKED_VERSION &&
+		header->sourceSize == source.size() &&
+		header->sourceHash == hash_fnv1a64(source.empty() ? NULL : &source[0], source.size());
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s <dir or file>... [-exclude <suffix>]* [-force]\n", argv[0]);
+		return 1;
+	}
+
+	// Parse options and collect input files
+
+	std::vector<std::string> inputs;
+	std::vector<std::string> excludes;
+	bool force = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		if (i + 1 < argc && option == "-exclude")
+			excludes.push_back(argv[++i]);
+		else if (option == "-force")
+			force = true;
+		else if (option[0] == '-')
+		{
+			fprintf(stderr, "Error: unknown option %s\n", argv[i]);
+			return 1;
+		}
+		else
+			inputs.push_back(option);
+	}
+
+	std::vector<std::string> files;
+	for (std::vector<std::string>::iterator it = inputs.begin(); it != inputs.end(); ++it)
+	{
+		std::string input = *it;
+		string_replace_all(input, "\\", "/");
+		while (input.length() > 1 && input[input.length() - 1] == '/')
+			input.erase(input.length() - 1);
+		CollectFiles(input, excludes, true, files);
+	}
+
+	if (files.empty())
+	{
+		fprintf(stderr, "Error: no input files found\n");
+		return 1;
+	}
+
+	// Cook files
+
+	unsigned int numCooked = 0;
+	unsigned int numUpToDate = 0;
+	unsigned long long sourceSize = 0;
+	unsigned long long cookedSize = 0;
+	std::vector<unsigned char> source;
+	std::vector<unsigned char> cooked;
+	for (std::vector<std::string>::iterator it = files.begin(); it != files.end(); ++it)
+	{
+		const std::string cookedPath = *it + XML_COOKED_SUFFIX;
+
+		source.clear();
+		if (!LoadFile(*it, source))
+		{
+			fprintf(stderr, "Error: failed to open %s\n", it->c_str());
+			return 1;
+		}
+
+		if (!force && IsUpToDate(cookedPath, source))
+		{
+			numUpToDate++;
+			continue;
+		}
+
+		// Parse with the same parser the runtime uses; document takes ownership of the copy
+
+		char* text = (char*) malloc(source.size() + 1);
+		if (!source.empty())
+			memcpy(text, &source[0], source.size());
+		text[source.size()] = '\0';
+
+		XMLDocObj* doc = XMLDoc_LoadFromString(text);
+		if (!doc)
+		{
+			fprintf(stderr, "Error: failed to parse %s\n", it->c_str());
+			return 1;
+		}
+		XMLDoc_Cook(doc, source.empty() ? NULL : &source[0], source.size(), cooked);
+		XMLDoc_Destroy(doc);
+
+		FILE* out = fopen(cookedPath.c_str(), "wb");
+		const bool success = out && fwrite(&cooked[0], 1, cooked.size(), out) == cooked.size();
+		if (!out || fclose(out) || !success)
+		{
+			fprintf(stderr, "Error: failed to write %s\n", cookedPath.c_str());
+			remove(cookedPath.c_str());
+			return 1;
+		}
+
+		numCooked++;
+		sourceSize += source.size();
+		cookedSize += cooked.size();
+	}
+
+	printf("Cooked %u files (%llu -> %llu bytes), %u up to date\n", numCooked, sourceSize, cookedSize, numUpToDate);
+	return 0;
+}